@@ -0,0 +1,17 @@
+#version 420 core
+
+in vec2 fragUV;
+
+layout(std140, binding = 0) uniform MaterialBlock
+{
+    vec4 uTransform;
+    vec4 uColor;
+};
+layout(binding = 1) uniform sampler2D uTexture;
+
+out vec4 outColor;
+
+void main()
+{
+    outColor = uColor * texture(uTexture, fragUV);
+}
@@ -0,0 +1,17 @@
+#version 420 core
+
+layout(location = 0) in vec2 inPosition;
+
+layout(std140, binding = 0) uniform MaterialBlock
+{
+    vec4 uTransform;
+    vec4 uColor;
+};
+
+out vec2 fragUV;
+
+void main()
+{
+    gl_Position = vec4(inPosition * uTransform.zw + uTransform.xy, 0.5, 1.0);
+    fragUV = inPosition * 0.5 + 0.5;
+}
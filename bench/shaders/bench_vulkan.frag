@@ -0,0 +1,17 @@
+#version 450
+
+layout(location = 0) in vec2 fragUV;
+
+layout(set = 0, binding = 0) uniform MaterialBlock
+{
+    vec4 uTransform;
+    vec4 uColor;
+};
+layout(set = 0, binding = 1) uniform sampler2D uTexture;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+    outColor = uColor * texture(uTexture, fragUV);
+}
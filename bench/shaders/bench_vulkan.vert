@@ -0,0 +1,17 @@
+#version 450
+
+layout(location = 0) in vec2 inPosition;
+
+layout(set = 0, binding = 0) uniform MaterialBlock
+{
+    vec4 uTransform;
+    vec4 uColor;
+};
+
+layout(location = 0) out vec2 fragUV;
+
+void main()
+{
+    gl_Position = vec4(inPosition * uTransform.zw + uTransform.xy, 0.5, 1.0);
+    fragUV = inPosition * 0.5 + 0.5;
+}
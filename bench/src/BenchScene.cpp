@@ -0,0 +1,236 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#include "BenchScene.h"
+
+#include <cmath>
+#include <JumaRE/RenderPipeline.h>
+#include <JumaRE/RenderTarget.h>
+#include <JumaRE/material/Material.h>
+#include <JumaRE/material/MaterialParamsStorage.h>
+#include <JumaRE/material/Shader.h>
+#include <JumaRE/material/SoftwareShader.h>
+#include <JumaRE/vertex/VertexBuffer.h>
+
+namespace JumaRenderEngine
+{
+    static const jstringID BenchPositionComponentID = JSTR("position");
+    static const jstringID BenchTransformParamID = JSTR("uTransform");
+    static const jstringID BenchColorParamID = JSTR("uColor");
+    static const jstringID BenchTextureParamID = JSTR("uTexture");
+
+    BenchScene::~BenchScene()
+    {
+        clear();
+    }
+
+    bool BenchScene::init(RenderEngine* renderEngine, const BenchSceneSettings& settings)
+    {
+        clear();
+
+        m_RenderEngine = renderEngine;
+        m_Settings = settings;
+        m_Settings.renderTargetsCount = math::max(m_Settings.renderTargetsCount, 1);
+        m_Settings.dependencyChainLength = math::max(m_Settings.dependencyChainLength, 1);
+        m_Settings.renderStagesCount = math::max(m_Settings.renderStagesCount, 1);
+        m_Settings.materialsCount = math::max(m_Settings.materialsCount, m_Settings.renderTargetsCount);
+        m_Settings.vertexBuffersCount = math::max(m_Settings.vertexBuffersCount, 1);
+        m_Settings.primitivesPerStage = math::max(m_Settings.primitivesPerStage, 0);
+        if (!createShader() || !createVertexBuffers() || !createRenderTargets() || !createMaterials())
+        {
+            clear();
+            return false;
+        }
+        // Allocated once, so updates don't affect allocations per frame
+        m_MaterialTransforms.resize(m_Materials.getSize(), { 0.0f, 0.0f, 1.0f, 1.0f });
+        return true;
+    }
+    bool BenchScene::createShader()
+    {
+        if (m_RenderEngine->getRenderAPI() == RenderAPI::Software)
+        {
+            RegisterSoftwareVertexShader(m_Settings.vertexShader, 2, [](const float* vertex, const float*, const MaterialParamsStorage& params, float* outVaryings)
+            {
+                math::vector4 transform = { 0.0f, 0.0f, 1.0f, 1.0f };
+                params.getValue<ShaderUniformType::Vec4>(BenchTransformParamID, transform);
+                outVaryings[0] = vertex[0] * 0.5f + 0.5f;
+                outVaryings[1] = vertex[1] * 0.5f + 0.5f;
+                return math::vector4{ vertex[0] * transform.z + transform.x, vertex[1] * transform.w + transform.y, 0.5f, 1.0f };
+            });
+            RegisterSoftwareFragmentShader(m_Settings.fragmentShader, [](const float* varyings, const MaterialParamsStorage& params)
+            {
+                math::vector4 color = { 1.0f, 1.0f, 1.0f, 1.0f };
+                TextureBase* texture = nullptr;
+                params.getValue<ShaderUniformType::Vec4>(BenchColorParamID, color);
+                params.getValue<ShaderUniformType::Texture>(BenchTextureParamID, texture);
+                const math::vector4 textureColor = SampleSoftwareTexture(texture, { varyings[0], varyings[1] });
+                return math::vector4{ color.x * textureColor.x, color.y * textureColor.y, color.z * textureColor.z, color.w * textureColor.w };
+            });
+        }
+
+        ShaderCreateInfo shaderInfo;
+        shaderInfo.fileNames = {
+            { SHADER_STAGE_VERTEX, m_Settings.vertexShader },
+            { SHADER_STAGE_FRAGMENT, m_Settings.fragmentShader }
+        };
+        shaderInfo.vertexComponents = { BenchPositionComponentID };
+        shaderInfo.uniforms = {
+            { BenchTransformParamID, { ShaderUniformType::Vec4, SHADER_STAGE_VERTEX | SHADER_STAGE_FRAGMENT, 0, 0 } },
+            { BenchColorParamID, { ShaderUniformType::Vec4, SHADER_STAGE_VERTEX | SHADER_STAGE_FRAGMENT, 0, 16 } },
+            { BenchTextureParamID, { ShaderUniformType::Texture, SHADER_STAGE_FRAGMENT, 1, 0 } }
+        };
+        m_Shader = m_RenderEngine->createShader(shaderInfo);
+        if (m_Shader == nullptr)
+        {
+            JUTILS_LOG(error, JSTR("Failed to create bench shader"));
+            return false;
+        }
+        return true;
+    }
+    bool BenchScene::createVertexBuffers()
+    {
+        m_RenderEngine->registerVertexComponent(BenchPositionComponentID, { VertexComponentType::Vec2, 0 });
+
+        VertexDescription vertexDescription;
+        vertexDescription.components = { BenchPositionComponentID };
+        for (int32 index = 0; index < m_Settings.vertexBuffersCount; index++)
+        {
+            // Polygons with different vertex count, so buffers differ in size
+            const int32 segmentsCount = 3 + index % 13;
+            jarray<math::vector2> vertices;
+            jarray<uint32> indices;
+            vertices.add({ 0.0f, 0.0f });
+            for (int32 segment = 0; segment < segmentsCount; segment++)
+            {
+                const float angle = 6.2831853f * static_cast<float>(segment) / static_cast<float>(segmentsCount);
+                vertices.add({ std::cos(angle), std::sin(angle) });
+                indices.add(0);
+                indices.add(static_cast<uint32>(segment + 1));
+                indices.add(static_cast<uint32>((segment + 1) % segmentsCount + 1));
+            }
+
+            VertexBuffer* vertexBuffer = m_RenderEngine->createVertexBuffer(MakeVertexBufferData(vertexDescription, vertices, indices));
+            if (vertexBuffer == nullptr)
+            {
+                JUTILS_LOG(error, JSTR("Failed to create bench vertex buffer"));
+                return false;
+            }
+            m_VertexBuffers.add(vertexBuffer);
+        }
+        return true;
+    }
+    bool BenchScene::createRenderTargets()
+    {
+        jarray<RenderStageProperties> renderStages;
+        renderStages.resize(m_Settings.renderStagesCount);
+        RenderPipeline* renderPipeline = m_RenderEngine->getRenderPipeline();
+        for (int32 index = 0; index < m_Settings.renderTargetsCount; index++)
+        {
+            RenderTarget* renderTarget = m_RenderEngine->createRenderTarget(TextureFormat::RGBA8, m_Settings.renderTargetSize, TextureSamples::X1);
+            if (renderTarget == nullptr)
+            {
+                JUTILS_LOG(error, JSTR("Failed to create bench render target"));
+                return false;
+            }
+            renderTarget->setupRenderStages(renderStages);
+            if ((index % m_Settings.dependencyChainLength) != 0)
+            {
+                renderPipeline->addRenderTargetDependecy(renderTarget->getID(), m_RenderTargets.getLast()->getID());
+            }
+            m_RenderTargets.add(renderTarget);
+        }
+        return true;
+    }
+    bool BenchScene::createMaterials()
+    {
+        m_RenderTargetMaterials.resize(m_Settings.renderTargetsCount);
+        for (int32 index = 0; index < m_Settings.materialsCount; index++)
+        {
+            Material* material = m_RenderEngine->createMaterial(m_Shader);
+            if (material == nullptr)
+            {
+                JUTILS_LOG(error, JSTR("Failed to create bench material"));
+                return false;
+            }
+
+            // Material samples the render target which its owner depends on
+            const int32 renderTargetIndex = index % m_Settings.renderTargetsCount;
+            const float tint = static_cast<float>(index % 7) / 7.0f;
+            material->setParamValue<ShaderUniformType::Vec4>(BenchTransformParamID, { 0.0f, 0.0f, 0.1f, 0.1f });
+            material->setParamValue<ShaderUniformType::Vec4>(BenchColorParamID, { 1.0f - tint, 0.5f, tint, 1.0f });
+            if ((renderTargetIndex % m_Settings.dependencyChainLength) != 0)
+            {
+                material->setParamValue<ShaderUniformType::Texture>(BenchTextureParamID, m_RenderTargets[renderTargetIndex - 1]);
+            }
+            m_Materials.add(material);
+            m_RenderTargetMaterials[renderTargetIndex].add(material);
+        }
+        return true;
+    }
+
+    void BenchScene::clear()
+    {
+        if (m_RenderEngine == nullptr)
+        {
+            return;
+        }
+
+        for (const auto& material : m_Materials)
+        {
+            m_RenderEngine->destroyMaterial(material);
+        }
+        for (const auto& renderTarget : m_RenderTargets)
+        {
+            m_RenderEngine->destroyRenderTarget(renderTarget);
+        }
+        for (const auto& vertexBuffer : m_VertexBuffers)
+        {
+            m_RenderEngine->destroyVertexBuffer(vertexBuffer);
+        }
+        if (m_Shader != nullptr)
+        {
+            m_RenderEngine->destroyShader(m_Shader);
+        }
+        m_RenderTargetMaterials.clear();
+        m_MaterialTransforms.clear();
+        m_Materials.clear();
+        m_RenderTargets.clear();
+        m_VertexBuffers.clear();
+        m_Shader = nullptr;
+        m_RenderEngine = nullptr;
+    }
+
+    void BenchScene::update(const uint64 frameIndex)
+    {
+        if (m_Settings.animateMaterials)
+        {
+            const float time = static_cast<float>(frameIndex % 360) * 0.0174533f;
+            for (int32 index = 0; index < m_Materials.getSize(); index++)
+            {
+                const float phase = time + static_cast<float>(index);
+                m_MaterialTransforms[index] = { std::cos(phase) * 0.5f, std::sin(phase) * 0.5f, 0.1f, 0.1f };
+            }
+            Material::setParamValues<ShaderUniformType::Vec4>(
+                m_Shader->findParam(BenchTransformParamID), m_Materials.getData(), m_MaterialTransforms.getData(), m_Materials.getSize()
+            );
+        }
+
+        // Primitives are spread in a grid, so every render target is fully covered
+        const int32 gridSize = math::max(static_cast<int32>(std::ceil(std::sqrt(static_cast<float>(m_Settings.primitivesPerStage)))), 1);
+        for (int32 renderTargetIndex = 0; renderTargetIndex < m_RenderTargets.getSize(); renderTargetIndex++)
+        {
+            RenderTarget* renderTarget = m_RenderTargets[renderTargetIndex];
+            const jarray<Material*>& materials = m_RenderTargetMaterials[renderTargetIndex];
+            for (int32 stageIndex = 0; stageIndex < m_Settings.renderStagesCount; stageIndex++)
+            {
+                for (int32 primitiveIndex = 0; primitiveIndex < m_Settings.primitivesPerStage; primitiveIndex++)
+                {
+                    RenderPrimitive primitive;
+                    primitive.vertexBuffer = m_VertexBuffers[(primitiveIndex + stageIndex) % m_VertexBuffers.getSize()];
+                    primitive.material = materials[primitiveIndex % materials.getSize()];
+                    primitive.sortDepth = static_cast<float>((primitiveIndex / gridSize) % gridSize);
+                    renderTarget->addPrimitiveToRenderStage(stageIndex, primitive);
+                }
+            }
+        }
+    }
+}
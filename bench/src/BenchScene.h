@@ -0,0 +1,58 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include <JumaRE/RenderEngine.h>
+
+namespace JumaRenderEngine
+{
+    struct BenchSceneSettings
+    {
+        jstring vertexShader;
+        jstring fragmentShader;
+
+        math::uvector2 renderTargetSize = { 256, 256 };
+        int32 renderTargetsCount = 8;
+        // Each render target depends on the previous one in its chain and samples its texture
+        int32 dependencyChainLength = 4;
+        int32 renderStagesCount = 2;
+        // Clamped to render targets count, so each render target has its own materials
+        int32 materialsCount = 32;
+        int32 vertexBuffersCount = 16;
+        int32 primitivesPerStage = 64;
+        // Update material params every frame
+        bool animateMaterials = true;
+    };
+
+    class BenchScene
+    {
+    public:
+        BenchScene() = default;
+        ~BenchScene();
+
+        bool init(RenderEngine* renderEngine, const BenchSceneSettings& settings);
+        void clear();
+
+        void update(uint64 frameIndex);
+
+    private:
+
+        RenderEngine* m_RenderEngine = nullptr;
+        BenchSceneSettings m_Settings;
+
+        Shader* m_Shader = nullptr;
+        jarray<Material*> m_Materials;
+        jarray<VertexBuffer*> m_VertexBuffers;
+        jarray<RenderTarget*> m_RenderTargets;
+        // Materials of each render target
+        jarray<jarray<Material*>> m_RenderTargetMaterials;
+        // Transform param values of materials, reused every update
+        jarray<ShaderUniformInfo<ShaderUniformType::Vec4>::value_type> m_MaterialTransforms;
+
+
+        bool createShader();
+        bool createVertexBuffers();
+        bool createRenderTargets();
+        bool createMaterials();
+    };
+}
@@ -0,0 +1,371 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <JumaRE/RenderEngineImpl.h>
+#include <JumaRE/RenderPipeline.h>
+
+#include "BenchScene.h"
+
+namespace
+{
+    std::atomic<JumaRenderEngine::uint64> BenchAllocationsCount = 0;
+    std::atomic<JumaRenderEngine::uint64> BenchAllocatedBytes = 0;
+}
+
+void* operator new(const std::size_t size)
+{
+    BenchAllocationsCount.fetch_add(1, std::memory_order_relaxed);
+    BenchAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    void* result = std::malloc(size > 0 ? size : 1);
+    if (result == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+void* operator new[](const std::size_t size) { return operator new(size); }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+
+// Over-aligned types are allocated through separate overloads
+void* operator new(const std::size_t size, const std::align_val_t alignment)
+{
+    BenchAllocationsCount.fetch_add(1, std::memory_order_relaxed);
+    BenchAllocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    const std::size_t alignmentSize = static_cast<std::size_t>(alignment);
+    const std::size_t alignedSize = size > 0 ? (size + alignmentSize - 1) & ~(alignmentSize - 1) : alignmentSize;
+#ifdef _WIN32
+    void* result = _aligned_malloc(alignedSize, alignmentSize);
+#else
+    void* result = std::aligned_alloc(alignmentSize, alignedSize);
+#endif
+    if (result == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return result;
+}
+void* operator new[](const std::size_t size, const std::align_val_t alignment) { return operator new(size, alignment); }
+void operator delete(void* ptr, std::align_val_t) noexcept
+{
+#ifdef _WIN32
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+void operator delete[](void* ptr, const std::align_val_t alignment) noexcept { operator delete(ptr, alignment); }
+void operator delete(void* ptr, std::size_t, const std::align_val_t alignment) noexcept { operator delete(ptr, alignment); }
+void operator delete[](void* ptr, std::size_t, const std::align_val_t alignment) noexcept { operator delete(ptr, alignment); }
+
+using namespace JumaRenderEngine;
+
+struct BenchSettings
+{
+    RenderAPI renderAPI = RenderAPI::OpenGL;
+    int32 warmupFrames = 60;
+    int32 frames = 600;
+    int32 renderRecordWorkers = 0;
+    bool gpuTimings = false;
+    jstring outputFile;
+    BenchSceneSettings scene;
+};
+
+struct BenchAllocations
+{
+    uint64 countMin = 0;
+    uint64 countMax = 0;
+    uint64 countTotal = 0;
+    uint64 bytesTotal = 0;
+};
+
+static bool ParseBenchSize(const char* str, math::uvector2& outSize)
+{
+    unsigned int width = 0, height = 0;
+    if ((std::sscanf(str, "%ux%u", &width, &height) != 2) || (width == 0) || (height == 0))
+    {
+        return false;
+    }
+    outSize = { width, height };
+    return true;
+}
+static bool ParseBenchArgs(const int argc, char** argv, BenchSettings& outSettings)
+{
+    bool customVertexShader = false, customFragmentShader = false;
+    for (int index = 1; index < argc; index++)
+    {
+        const char* arg = argv[index];
+        const char* value = (index + 1) < argc ? argv[index + 1] : nullptr;
+        if (value == nullptr)
+        {
+            if (std::strcmp(arg, "--gpu-timings") == 0)
+            {
+                outSettings.gpuTimings = true;
+                continue;
+            }
+            std::fprintf(stderr, "Missing value of argument %s\n", arg);
+            return false;
+        }
+
+        bool valid = true;
+        if (std::strcmp(arg, "--api") == 0)
+        {
+            if (std::strcmp(value, "opengl") == 0) { outSettings.renderAPI = RenderAPI::OpenGL; }
+            else if (std::strcmp(value, "vulkan") == 0) { outSettings.renderAPI = RenderAPI::Vulkan; }
+            else if (std::strcmp(value, "software") == 0) { outSettings.renderAPI = RenderAPI::Software; }
+            else { valid = false; }
+        }
+        else if (std::strcmp(arg, "--frames") == 0) { outSettings.frames = std::atoi(value); valid = outSettings.frames > 0; }
+        else if (std::strcmp(arg, "--warmup") == 0) { outSettings.warmupFrames = std::atoi(value); valid = outSettings.warmupFrames >= 0; }
+        else if (std::strcmp(arg, "--record-workers") == 0) { outSettings.renderRecordWorkers = std::atoi(value); }
+        else if (std::strcmp(arg, "--targets") == 0) { outSettings.scene.renderTargetsCount = std::atoi(value); }
+        else if (std::strcmp(arg, "--chain-length") == 0) { outSettings.scene.dependencyChainLength = std::atoi(value); }
+        else if (std::strcmp(arg, "--stages") == 0) { outSettings.scene.renderStagesCount = std::atoi(value); }
+        else if (std::strcmp(arg, "--materials") == 0) { outSettings.scene.materialsCount = std::atoi(value); }
+        else if (std::strcmp(arg, "--buffers") == 0) { outSettings.scene.vertexBuffersCount = std::atoi(value); }
+        else if (std::strcmp(arg, "--primitives") == 0) { outSettings.scene.primitivesPerStage = std::atoi(value); }
+        else if (std::strcmp(arg, "--static") == 0) { outSettings.scene.animateMaterials = std::atoi(value) == 0; }
+        else if (std::strcmp(arg, "--size") == 0) { valid = ParseBenchSize(value, outSettings.scene.renderTargetSize); }
+        else if (std::strcmp(arg, "--vertex-shader") == 0) { outSettings.scene.vertexShader = value; customVertexShader = true; }
+        else if (std::strcmp(arg, "--fragment-shader") == 0) { outSettings.scene.fragmentShader = value; customFragmentShader = true; }
+        else if (std::strcmp(arg, "--output") == 0) { outSettings.outputFile = value; }
+        else if (std::strcmp(arg, "--gpu-timings") == 0) { outSettings.gpuTimings = true; continue; }
+        else
+        {
+            std::fprintf(stderr, "Unknown argument %s\n", arg);
+            return false;
+        }
+        if (!valid)
+        {
+            std::fprintf(stderr, "Invalid value %s of argument %s\n", value, arg);
+            return false;
+        }
+        index++;
+    }
+
+    switch (outSettings.renderAPI)
+    {
+    case RenderAPI::Vulkan:
+        if (!customVertexShader) { outSettings.scene.vertexShader = "shaders/bench.vert.spv"; }
+        if (!customFragmentShader) { outSettings.scene.fragmentShader = "shaders/bench.frag.spv"; }
+        break;
+    case RenderAPI::Software:
+        if (!customVertexShader) { outSettings.scene.vertexShader = "bench.vert"; }
+        if (!customFragmentShader) { outSettings.scene.fragmentShader = "bench.frag"; }
+        break;
+    default:
+        if (!customVertexShader) { outSettings.scene.vertexShader = "shaders/bench.vert.glsl"; }
+        if (!customFragmentShader) { outSettings.scene.fragmentShader = "shaders/bench.frag.glsl"; }
+        break;
+    }
+    return true;
+}
+
+static const char* BenchCounterName(const RenderFrameCounter counter)
+{
+    switch (counter)
+    {
+    case RenderFrameCounter::DrawCalls: return "drawCalls";
+    case RenderFrameCounter::StateChanges: return "stateChanges";
+    case RenderFrameCounter::UploadedBytes: return "uploadedBytes";
+    case RenderFrameCounter::DescriptorUpdates: return "descriptorUpdates";
+    case RenderFrameCounter::PipelineCreations: return "pipelineCreations";
+    default: ;
+    }
+    return "unknown";
+}
+static const char* BenchPhaseName(const RenderFramePhase phase)
+{
+    switch (phase)
+    {
+    case RenderFramePhase::StartRender: return "startRender";
+    case RenderFramePhase::RecordRender: return "recordRender";
+    case RenderFramePhase::FinishRender: return "finishRender";
+    case RenderFramePhase::PostRender: return "postRender";
+    case RenderFramePhase::Total: return "total";
+    default: ;
+    }
+    return "unknown";
+}
+
+static void WriteBenchReport(std::FILE* file, const BenchSettings& settings, RenderEngine* renderEngine, 
+    const BenchAllocations& allocations, const int32 measuredFrames)
+{
+    const BenchSceneSettings& scene = settings.scene;
+    std::fprintf(file, "{\n");
+    std::fprintf(file, "  \"config\": {\n");
+    std::fprintf(file, "    \"api\": \"%s\",\n", RenderAPIToString(settings.renderAPI));
+    std::fprintf(file, "    \"frames\": %d,\n", settings.frames);
+    std::fprintf(file, "    \"warmupFrames\": %d,\n", settings.warmupFrames);
+    std::fprintf(file, "    \"recordWorkers\": %d,\n", settings.renderRecordWorkers);
+    std::fprintf(file, "    \"renderTargets\": %d,\n", scene.renderTargetsCount);
+    std::fprintf(file, "    \"chainLength\": %d,\n", scene.dependencyChainLength);
+    std::fprintf(file, "    \"renderStages\": %d,\n", scene.renderStagesCount);
+    std::fprintf(file, "    \"materials\": %d,\n", scene.materialsCount);
+    std::fprintf(file, "    \"vertexBuffers\": %d,\n", scene.vertexBuffersCount);
+    std::fprintf(file, "    \"primitivesPerStage\": %d,\n", scene.primitivesPerStage);
+    std::fprintf(file, "    \"animateMaterials\": %s,\n", scene.animateMaterials ? "true" : "false");
+    std::fprintf(file, "    \"size\": [%u, %u]\n", scene.renderTargetSize.x, scene.renderTargetSize.y);
+    std::fprintf(file, "  },\n");
+
+    const RenderFrameStatsHistory& statsHistory = renderEngine->getFrameStatsHistory();
+    std::fprintf(file, "  \"phases\": {\n");
+    for (uint8 phaseIndex = 0; phaseIndex < RenderFramePhaseCount; phaseIndex++)
+    {
+        const RenderFramePhase phase = static_cast<RenderFramePhase>(phaseIndex);
+        const RenderFramePhaseTimings timings = statsHistory.getPhaseTimings(phase);
+        std::fprintf(file, "    \"%s\": { \"min\": %.4f, \"avg\": %.4f, \"p99\": %.4f }%s\n", BenchPhaseName(phase),
+            timings.min, timings.avg, timings.p99, (phaseIndex + 1) < RenderFramePhaseCount ? "," : "");
+    }
+    std::fprintf(file, "  },\n");
+
+    std::fprintf(file, "  \"counters\": {\n");
+    for (uint8 counterIndex = 0; counterIndex < RenderFrameCounterCount; counterIndex++)
+    {
+        const RenderFrameCounter counter = static_cast<RenderFrameCounter>(counterIndex);
+        uint64 total = 0;
+        for (int32 index = 0; index < statsHistory.getSize(); index++)
+        {
+            total += statsHistory.getStats(index).getCounter(counter);
+        }
+        const double average = statsHistory.getSize() > 0 ? static_cast<double>(total) / statsHistory.getSize() : 0.0;
+        std::fprintf(file, "    \"%s\": %.2f%s\n", BenchCounterName(counter), average, (counterIndex + 1) < RenderFrameCounterCount ? "," : "");
+    }
+    std::fprintf(file, "  },\n");
+
+    const double frameCount = static_cast<double>(math::max(measuredFrames, 1));
+    std::fprintf(file, "  \"allocationsPerFrame\": { \"min\": %llu, \"avg\": %.2f, \"max\": %llu, \"bytesAvg\": %.2f },\n",
+        static_cast<unsigned long long>(allocations.countMin), static_cast<double>(allocations.countTotal) / frameCount,
+        static_cast<unsigned long long>(allocations.countMax), static_cast<double>(allocations.bytesTotal) / frameCount);
+    std::fprintf(file, "  \"frameArenaHighWaterMark\": %llu", static_cast<unsigned long long>(renderEngine->getFrameArena().getHighWaterMark()));
+
+    const RenderPipeline* renderPipeline = renderEngine->getRenderPipeline();
+    if (settings.gpuTimings && renderPipeline->isGPUProfilingEnabled())
+    {
+        const RenderGPUFrameTimings& gpuTimings = renderPipeline->getGPUFrameTimings();
+        std::fprintf(file, ",\n  \"gpuTimings\": {\n");
+        std::fprintf(file, "    \"frameIndex\": %llu,\n", static_cast<unsigned long long>(gpuTimings.frameIndex));
+        std::fprintf(file, "    \"timings\": [");
+        for (int32 index = 0; index < gpuTimings.timings.getSize(); index++)
+        {
+            const RenderGPUTiming& timing = gpuTimings.timings[index];
+            std::fprintf(file, "%s\n      { \"renderTarget\": %llu, \"stage\": %d, \"ms\": %.4f }", index > 0 ? "," : "",
+                static_cast<unsigned long long>(timing.renderTargetID), timing.renderStageIndex, timing.time);
+        }
+        std::fprintf(file, "\n    ]\n  }");
+    }
+    std::fprintf(file, "\n}\n");
+}
+
+int main(const int argc, char** argv)
+{
+    BenchSettings settings;
+    if (!ParseBenchArgs(argc, argv, settings))
+    {
+        std::fprintf(stderr, "Usage: JumaRE_bench [--api opengl|vulkan|software] [--frames N] [--warmup N] [--record-workers N]\n"
+            "    [--targets N] [--chain-length N] [--stages N] [--materials N] [--buffers N] [--primitives N] [--static 0|1]\n"
+            "    [--size WxH] [--vertex-shader FILE] [--fragment-shader FILE] [--gpu-timings] [--output FILE]\n");
+        return 1;
+    }
+    if (!IsSupportRenderAPI(settings.renderAPI))
+    {
+        std::fprintf(stderr, "Render API %s is not supported by this build\n", RenderAPIToString(settings.renderAPI));
+        return 1;
+    }
+
+    RenderEngine* renderEngine = CreateRenderEngine(settings.renderAPI);
+    RenderEngineCreateInfo createInfo;
+    createInfo.headless = true;
+    createInfo.renderRecordWorkerCount = settings.renderRecordWorkers;
+    createInfo.frameStatsHistorySize = settings.frames;
+    if ((renderEngine == nullptr) || !renderEngine->init(createInfo))
+    {
+        std::fprintf(stderr, "Failed to create render engine\n");
+        delete renderEngine;
+        return 1;
+    }
+
+    int result = 0;
+    BenchScene scene;
+    if (!scene.init(renderEngine, settings.scene))
+    {
+        std::fprintf(stderr, "Failed to create bench scene\n");
+        result = 1;
+    }
+    else
+    {
+        if (settings.gpuTimings && !renderEngine->getRenderPipeline()->setGPUProfilingEnabled(true))
+        {
+            std::fprintf(stderr, "GPU timings are not supported by render API %s\n", RenderAPIToString(settings.renderAPI));
+        }
+
+        uint64 frameIndex = 0;
+        for (int32 index = 0; index < settings.warmupFrames; index++)
+        {
+            scene.update(frameIndex++);
+            if (!renderEngine->render())
+            {
+                result = 1;
+                break;
+            }
+        }
+
+        BenchAllocations allocations;
+        allocations.countMin = ~0ull;
+        int32 measuredFrames = 0;
+        for (; (result == 0) && (measuredFrames < settings.frames); measuredFrames++)
+        {
+            const uint64 allocationsCount = BenchAllocationsCount.load(std::memory_order_relaxed);
+            const uint64 allocatedBytes = BenchAllocatedBytes.load(std::memory_order_relaxed);
+            scene.update(frameIndex++);
+            if (!renderEngine->render())
+            {
+                result = 1;
+                break;
+            }
+            const uint64 frameAllocationsCount = BenchAllocationsCount.load(std::memory_order_relaxed) - allocationsCount;
+            allocations.countMin = math::min(allocations.countMin, frameAllocationsCount);
+            allocations.countMax = math::max(allocations.countMax, frameAllocationsCount);
+            allocations.countTotal += frameAllocationsCount;
+            allocations.bytesTotal += BenchAllocatedBytes.load(std::memory_order_relaxed) - allocatedBytes;
+        }
+        if (measuredFrames == 0)
+        {
+            allocations.countMin = 0;
+        }
+        renderEngine->getRenderPipeline()->waitForRenderFinished();
+
+        if (result != 0)
+        {
+            std::fprintf(stderr, "Render failed after %d measured frames\n", measuredFrames);
+        }
+        else
+        {
+            std::FILE* outputFile = settings.outputFile.isEmpty() ? stdout : std::fopen(*settings.outputFile, "w");
+            if (outputFile == nullptr)
+            {
+                std::fprintf(stderr, "Failed to open output file %s\n", *settings.outputFile);
+                result = 1;
+            }
+            else
+            {
+                WriteBenchReport(outputFile, settings, renderEngine, allocations, measuredFrames);
+                if (outputFile != stdout)
+                {
+                    std::fclose(outputFile);
+                }
+            }
+        }
+    }
+
+    scene.clear();
+    renderEngine->clear();
+    delete renderEngine;
+    return result;
+}
@@ -0,0 +1,146 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "core.h"
+
+#include <jutils/jarray.h>
+#include <new>
+
+namespace JumaRenderEngine
+{
+    // Bump allocator for transient render data. Memory is released all at once in reset(), which
+    // render engine calls at the end of each frame. Should be used only from main thread.
+    class FrameArena
+    {
+    public:
+        FrameArena() = default;
+        FrameArena(const FrameArena&) = delete;
+        ~FrameArena();
+
+        FrameArena& operator=(const FrameArena&) = delete;
+
+        void init(size_t blockSize);
+        void clear();
+
+        void* allocate(size_t size, size_t alignment);
+        template<typename T>
+        T* allocate(const int32 count) { return count > 0 ? static_cast<T*>(allocate(sizeof(T) * count, alignof(T))) : nullptr; }
+
+        void reset();
+
+        size_t getUsedSize() const { return m_UsedSize; }
+        size_t getReservedSize() const;
+        // Max amount of memory used during one frame
+        size_t getHighWaterMark() const { return m_HighWaterMark; }
+
+    private:
+
+        struct Block
+        {
+            uint8* data = nullptr;
+            size_t size = 0;
+        };
+
+        jarray<Block> m_Blocks;
+        int32 m_BlockIndex = 0;
+        size_t m_BlockOffset = 0;
+        size_t m_BlockSize = 64 * 1024;
+
+        size_t m_UsedSize = 0;
+        size_t m_HighWaterMark = 0;
+
+
+        bool addBlock(size_t minSize);
+        void clearBlocks();
+    };
+
+    // Array in frame arena memory, valid until the end of the frame
+    template<typename T>
+    class FrameArray
+    {
+        static_assert(std::is_trivially_destructible_v<T>, "FrameArray supports only trivially destructible types");
+
+    public:
+        FrameArray() = delete;
+        explicit FrameArray(FrameArena& arena, const int32 capacity = 0) : m_Arena(&arena) { reserve(capacity); }
+        FrameArray(FrameArena& arena, const int32 size, const T& value)
+            : m_Arena(&arena)
+        {
+            if (!reserve(size))
+            {
+                return;
+            }
+            for (int32 index = 0; index < size; index++)
+            {
+                new (m_Data + index) T(value);
+            }
+            m_Size = size;
+        }
+
+        int32 getSize() const { return m_Size; }
+        bool isEmpty() const { return m_Size == 0; }
+        bool isValidIndex(const int32 index) const { return (index >= 0) && (index < m_Size); }
+
+        T* getData() { return m_Data; }
+        const T* getData() const { return m_Data; }
+
+        T& operator[](const int32 index) { return m_Data[index]; }
+        const T& operator[](const int32 index) const { return m_Data[index]; }
+
+        T* begin() { return m_Data; }
+        T* end() { return m_Data + m_Size; }
+        const T* begin() const { return m_Data; }
+        const T* end() const { return m_Data + m_Size; }
+
+        // Keeps current data if failed to allocate memory
+        bool reserve(const int32 capacity)
+        {
+            if (capacity <= m_Capacity)
+            {
+                return true;
+            }
+            T* data = m_Arena->allocate<T>(capacity);
+            if (data == nullptr)
+            {
+                JUTILS_LOG(error, JSTR("Failed to allocate frame array of {} elements"), capacity);
+                return false;
+            }
+            for (int32 index = 0; index < m_Size; index++)
+            {
+                new (data + index) T(m_Data[index]);
+            }
+            m_Data = data;
+            m_Capacity = capacity;
+            return true;
+        }
+
+        T& add(const T& value)
+        {
+            ensureCapacity();
+            return *(new (m_Data + m_Size++) T(value));
+        }
+        T& addDefault()
+        {
+            ensureCapacity();
+            return *(new (m_Data + m_Size++) T());
+        }
+        void clear() { m_Size = 0; }
+
+    private:
+
+        FrameArena* m_Arena = nullptr;
+        T* m_Data = nullptr;
+        int32 m_Size = 0;
+        int32 m_Capacity = 0;
+
+
+        void ensureCapacity()
+        {
+            if (m_Size == m_Capacity)
+            {
+                reserve(m_Capacity > 0 ? m_Capacity * 2 : 8);
+            }
+        }
+    };
+}
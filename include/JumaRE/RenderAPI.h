@@ -11,7 +11,8 @@ namespace JumaRenderEngine
         Vulkan,
         OpenGL,
         DirectX11,
-        DirectX12
+        DirectX12,
+        Software
     };
 
     constexpr const char* RenderAPIToString(const RenderAPI api)
@@ -22,6 +23,7 @@ namespace JumaRenderEngine
         case RenderAPI::OpenGL: return JSTR("OpenGL");
         case RenderAPI::DirectX11: return JSTR("DirectX11");
         case RenderAPI::DirectX12: return JSTR("DirectX12");
+        case RenderAPI::Software: return JSTR("Software");
         default: ;
         }
         return JSTR("NONE");
@@ -5,9 +5,15 @@
 #include "core.h"
 
 #include <jutils/jasync_task_queue.h>
+#include <jutils/jset.h>
+#include <atomic>
+#include <chrono>
 
+#include "FrameArena.h"
 #include "RenderAPI.h"
+#include "RenderFrameStats.h"
 #include "RenderPrimitivesList.h"
+#include "RenderTrace.h"
 #include "render_target_id.h"
 #include "material/ShaderCreateInfo.h"
 #include "texture/TextureFormat.h"
@@ -19,6 +25,8 @@ namespace JumaRenderEngine
 	class Material;
     class RenderEngine;
 	class RenderEngineAsset;
+    class RenderFrameOutput;
+    struct RenderFrameOutputCreateInfo;
     class RenderPipeline;
     class RenderTarget;
     class Shader;
@@ -29,12 +37,22 @@ namespace JumaRenderEngine
     {
         VertexDescription description;
         uint32 vertexSize = 0;
+        VertexComponentInputRate inputRate = VertexComponentInputRate::Vertex;
     };
 
     struct RenderEngineCreateInfo
     {
         WindowCreateInfo mainWindowInfo;
         int32 assetTaskWorkerCount = 2;
+        // 0 - render targets are recorded on main thread
+        int32 renderRecordWorkerCount = 0;
+        // Clamped by the max frames in flight count of render API
+        int32 framesInFlightCount = 2;
+        uint32 frameArenaBlockSize = 256 * 1024;
+        // Count of last frames kept in frame stats history
+        int32 frameStatsHistorySize = 240;
+        // Render without windows, only to offscreen render targets. Main window info is ignored
+        bool headless = false;
     };
 
     JUTILS_CREATE_MULTICAST_DELEGATE1(OnRenderEngineEvent, RenderEngine*, renderEngine);
@@ -72,6 +90,14 @@ namespace JumaRenderEngine
         bool isValid() const { return m_Initialized; }
         void clear();
 
+        bool isHeadless() const { return m_Headless; }
+        // Shaders with BindlessTexture uniforms could be created only if it's supported
+        virtual bool isBindlessTexturesSupported() const { return false; }
+
+        // Amount of frames that could be recorded on CPU while GPU is rendering previous ones
+        int32 getFramesInFlightCount() const { return m_FramesInFlightCount; }
+        uint64 getRenderedFramesCount() const { return m_RenderedFramesCount; }
+
         WindowController* getWindowController() const { return m_WindowController; }
         template<typename T> requires is_base_class<WindowController, T>
         T* getWindowController() const { return dynamic_cast<T*>(this->getWindowController()); }
@@ -80,8 +106,20 @@ namespace JumaRenderEngine
         T* createObject() { return new T(); }
 
         jasync_task_queue_base& getAsyncAssetTaksQueue() { return m_AsyncAssetTaskQueue; }
+        // Memory for transient data of current frame, main thread only
+        FrameArena& getFrameArena() { return m_FrameArena; }
         RenderPipeline* getRenderPipeline() const { return m_RenderPipeline; }
 
+        // Could be called from any thread
+        void addFrameCounter(const RenderFrameCounter counter, const uint64 value = 1)
+        {
+            m_FrameCounters[static_cast<uint8>(counter)].fetch_add(value, std::memory_order_relaxed);
+        }
+        // Adds CPU time passed since previous phase to the phase time of current frame, main thread only
+        void finishFramePhase(RenderFramePhase phase);
+        const RenderFrameStats& getLastFrameStats() const { return m_LastFrameStats; }
+        const RenderFrameStatsHistory& getFrameStatsHistory() const { return m_FrameStatsHistory; }
+
         // Create functions should be called only from main thread
 
         bool createShaderAsync(const ShaderCreateInfo& createInfo, const std::function<void(Shader*)>& callback);
@@ -90,6 +128,8 @@ namespace JumaRenderEngine
         void destroyShader(Shader* shader);
 
         Material* createMaterial(Shader* shader);
+        // Instance inherits params of parent material and uses its render data until it overrides them
+        Material* createMaterialInstance(Material* parentMaterial);
         void destroyMaterial(Material* material);
 
         void registerVertexComponent(const jstringID& vertexComponentID, const VertexComponentDescription& description);
@@ -108,11 +148,18 @@ namespace JumaRenderEngine
 
         void destroyAsset(RenderEngineAsset* asset);
 
+        // Streams frames of offscreen render target, render is blocked while output queue is full
+        RenderFrameOutput* createFrameOutput(const RenderFrameOutputCreateInfo& createInfo);
+        // Frames which are already requested are still written, output is deleted after that
+        void destroyFrameOutput(RenderFrameOutput* frameOutput);
+
         bool render();
 
     protected:
 
         virtual bool initInternal(const WindowCreateInfo& mainWindowInfo);
+        virtual int32 getMaxFramesInFlightCount() const { return 1; }
+        virtual bool isHeadlessModeSupported() const { return false; }
         virtual bool initAsyncAssetTaskQueueWorker(int32 workerIndex) { return true; }
         virtual bool initAsyncAssetTaskQueueWorkerThread(int32 workerIndex) { return true; }
         virtual void clearAsyncAssetTaskQueueWorkerThread(int32 workerIndex) {}
@@ -147,7 +194,11 @@ namespace JumaRenderEngine
             AsyncAssetWorker(RenderEngine* renderEngine) : m_RenderEngine(renderEngine) {}
 
             bool onStart_MainThread() const { return m_RenderEngine->initAsyncAssetTaskQueueWorker(getWorkerIndex()); }
-            bool onStart_WorkerThread() const { return m_RenderEngine->initAsyncAssetTaskQueueWorkerThread(getWorkerIndex()); }
+            bool onStart_WorkerThread() const
+            {
+                SetRenderTraceThreadName("Asset worker");
+                return m_RenderEngine->initAsyncAssetTaskQueueWorkerThread(getWorkerIndex());
+            }
             void onStop_WorkerThread() const { m_RenderEngine->clearAsyncAssetTaskQueueWorkerThread(getWorkerIndex()); }
             void onStop_MainThread() const { m_RenderEngine->clearAsyncAssetTaskQueueWorker(getWorkerIndex()); }
 
@@ -204,12 +255,21 @@ namespace JumaRenderEngine
         };
 
         jasync_task_queue<AsyncAssetWorker> m_AsyncAssetTaskQueue;
+        FrameArena m_FrameArena;
         std::mutex m_RenderAssets_MarkedForDestroyMutex;
-        jlist<std::pair<RenderEngineAsset*, uint8>> m_RenderAssets_MarkedForDestroy;
+        // Ring of assets marked for destroy during last frames, indexed by frame number
+        jarray<jarray<RenderEngineAsset*>> m_RenderAssets_MarkedForDestroy;
+        jarray<RenderEngineAsset*> m_RenderAssets_RetiredTemp;
+        // Marked for destroy assets which could be used by retained primitives
+        jset<const RenderEngineAsset*> m_RenderAssets_DestroyedPrimitiveAssets;
+        jset<const RenderEngineAsset*> m_RenderAssets_DestroyedPrimitiveAssetsTemp;
+        jarray<RenderEngineAsset*> m_RenderAssets_NotReadyForDestroy;
         jlist<AsyncAssetDestroyTask> m_RenderAssets_DestroyTasks;
         jarray<jasync_task*> m_RenderAssets_DestroyTasksTemp;
 
         jmap<render_target_id, RenderTarget*> m_RenderTargets;
+        jarray<RenderFrameOutput*> m_FrameOutputs;
+        jarray<RenderFrameOutput*> m_FrameOutputs_Destroying;
         jmap<jstringID, VertexComponentDescription> m_RegisteredVertexComponents;
         jmap<VertexDescription, vertex_id> m_RegisteredVertices;
         jmap<vertex_id, RegisteredVertexDescription> m_RegisteredVerticesData;
@@ -220,18 +280,37 @@ namespace JumaRenderEngine
         
         juid<render_target_id> m_RenderTagetIDs;
         juid<vertex_id> m_VertexIDGenerator;
-        
+
+        std::atomic<uint64> m_FrameCounters[RenderFrameCounterCount];
+        float m_FramePhaseTimes[RenderFramePhaseCount] = {};
+        std::chrono::steady_clock::time_point m_FrameStartTime;
+        std::chrono::steady_clock::time_point m_FramePhaseStartTime;
+        RenderFrameStats m_LastFrameStats;
+        RenderFrameStatsHistory m_FrameStatsHistory;
+
+        int32 m_FramesInFlightCount = 1;
+        uint64 m_RenderedFramesCount = 0;
+        bool m_Headless = false;
         bool m_Initialized = false;
 
 
-        bool createRenderAssets();
+        bool createRenderAssets(const RenderEngineCreateInfo& createInfo);
         
         RenderTarget* createWindowRenderTarget(window_id windowID, TextureSamples samples);
         
         vertex_id registerVertex(const VertexDescription& description);
 
+        jarray<RenderEngineAsset*>& getMarkedForDestroyAssets(const uint64 frameNumber)
+        {
+            return m_RenderAssets_MarkedForDestroy[static_cast<int32>(frameNumber % m_RenderAssets_MarkedForDestroy.getSize())];
+        }
         void processMarkedForDestroyAssets();
         void processFinishedDestroyAssetTasks();
+        void processDestroyingFrameOutputs();
+        void clearFrameOutputs();
+
+        void startFrameStats();
+        void finishFrameStats();
     };
     
     template<RenderAPI API>
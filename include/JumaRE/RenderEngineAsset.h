@@ -21,14 +21,17 @@ namespace JumaRenderEngine
 
     protected:
         RenderEngineAsset() = default;
-        RenderEngineAsset(const RenderEngineAssetType type) : m_AssetType(type) {}
+        RenderEngineAsset(const RenderEngineAssetType type) : m_AssetType(type), m_AssetIndex(GenerateAssetIndex(type)) {}
     public:
-        virtual ~RenderEngineAsset() override = default;
+        virtual ~RenderEngineAsset() override;
 
         OnRenderEngineAssetEvent onDestroying;
 
 
         RenderEngineAssetType getType() const { return m_AssetType; }
+        // Unique among existing objects of the same type, pooled objects keep it after reuse.
+        // Indices of deleted objects are reused, so they stay lower than max count of objects
+        uint32 getAssetIndex() const { return m_AssetIndex; }
 
     protected:
 
@@ -38,8 +41,12 @@ namespace JumaRenderEngine
     private:
 
         RenderEngineAssetType m_AssetType = RenderEngineAssetType::None;
+        uint32 m_AssetIndex = 0;
 
 
+        static uint32 GenerateAssetIndex(RenderEngineAssetType type);
+        static void ReleaseAssetIndex(RenderEngineAssetType type, uint32 index);
+
         void clearAsset();
     };
 }
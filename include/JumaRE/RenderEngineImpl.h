@@ -6,6 +6,7 @@
 #include "RenderEngineImpl_Vulkan.h"
 #include "RenderEngineImpl_DirectX11.h"
 #include "RenderEngineImpl_DirectX12.h"
+#include "RenderEngineImpl_Software.h"
 
 namespace JumaRenderEngine
 {
@@ -17,6 +18,7 @@ namespace JumaRenderEngine
 	    case RenderAPI::OpenGL: return IsSupportRenderAPI<RenderAPI::OpenGL>();
 	    case RenderAPI::DirectX11: return IsSupportRenderAPI<RenderAPI::DirectX11>();
 	    case RenderAPI::DirectX12: return IsSupportRenderAPI<RenderAPI::DirectX12>();
+	    case RenderAPI::Software: return IsSupportRenderAPI<RenderAPI::Software>();
 	    default: ;
 	    }
         return false;
@@ -30,6 +32,7 @@ namespace JumaRenderEngine
         case RenderAPI::OpenGL: return CreateRenderEngine<RenderAPI::OpenGL>();
         case RenderAPI::DirectX11: return CreateRenderEngine<RenderAPI::DirectX11>();
         case RenderAPI::DirectX12: return CreateRenderEngine<RenderAPI::DirectX12>();
+        case RenderAPI::Software: return CreateRenderEngine<RenderAPI::Software>();
         default: ;
         }
         return nullptr;
@@ -0,0 +1,16 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "RenderEngine.h"
+
+namespace JumaRenderEngine
+{
+    extern bool IsSupportRenderAPI_Software();
+    extern RenderEngine* CreateRenderEngine_Software();
+
+    template<>
+    inline bool IsSupportRenderAPI<RenderAPI::Software>() { return IsSupportRenderAPI_Software(); }
+    template<>
+    inline RenderEngine* CreateRenderEngine<RenderAPI::Software>() { return CreateRenderEngine_Software(); }
+}
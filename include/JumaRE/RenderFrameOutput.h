@@ -0,0 +1,166 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "core.h"
+
+#include <jutils/jasync_task_queue.h>
+#include <jutils/jstring.h>
+#include <jutils/math/vector2.h>
+#include <condition_variable>
+#include <cstdio>
+#include <functional>
+#include <mutex>
+
+#include "RenderTargetReadback.h"
+#include "RenderTrace.h"
+#include "render_target_id.h"
+
+namespace JumaRenderEngine
+{
+    class RenderEngine;
+
+    enum class RenderFrameOutputFormat : uint8
+    {
+        // Sequence of binary PPM images
+        PPM,
+        // YUV 4:2:0 stream, frame size should not change
+        Y4M,
+        // Frames are passed to the encoder callback
+        Custom
+    };
+
+    struct RenderFrameOutputFrame
+    {
+        render_target_id renderTargetID = render_target_id_INVALID;
+        // Index of the frame in which render target was rendered
+        uint64 frameIndex = 0;
+        // Index of the frame in output sequence
+        uint64 sequenceIndex = 0;
+
+        math::uvector2 size = { 0, 0 };
+        // Tightly packed RGBA8 rows, ordered from the top one
+        const uint8* pixels = nullptr;
+    };
+
+    // Called from frame output worker thread in sequence order, returns false on failure
+    using RenderFrameOutputEncoder = std::function<bool(const RenderFrameOutputFrame& frame)>;
+
+    struct RenderFrameOutputCreateInfo
+    {
+        render_target_id renderTargetID = render_target_id_INVALID;
+        RenderFrameOutputFormat format = RenderFrameOutputFormat::PPM;
+        // Output file or named pipe, "-" - stdout. For PPM format "{}" is replaced by sequence index,
+        // without it all images are written to the same stream
+        jstring path;
+        // Required for Custom format
+        RenderFrameOutputEncoder encoder;
+
+        int32 workerCount = 2;
+        // Frames waiting for conversion and writing, render is blocked when all of them are used
+        int32 maxQueuedFrames = 8;
+        uint32 frameRate = 30;
+    };
+
+    class RenderFrameOutput
+    {
+        friend RenderEngine;
+
+    public:
+        RenderFrameOutput() = default;
+        ~RenderFrameOutput();
+
+        bool isValid() const { return m_Initialized; }
+        const RenderFrameOutputCreateInfo& getCreateInfo() const { return m_CreateInfo; }
+
+        uint64 getSubmittedFramesCount() const;
+        uint64 getWrittenFramesCount() const;
+        uint64 getDroppedFramesCount() const;
+
+        // Waits until all submitted frames are written
+        void flush();
+
+    private:
+
+        struct FrameSlot
+        {
+            RenderFrameOutputFrame frame;
+            jarray<uint8> pixels;
+            jarray<uint8> encodedData;
+            bool converted = false;
+            bool valid = false;
+        };
+
+        class FrameOutputWorker : public jasync_worker
+        {
+        public:
+            FrameOutputWorker() = delete;
+            FrameOutputWorker(RenderFrameOutput* frameOutput) : m_FrameOutput(frameOutput) {}
+
+            bool onStart_MainThread() const { return true; }
+            bool onStart_WorkerThread() const
+            {
+                SetRenderTraceThreadName("Frame output worker");
+                return true;
+            }
+            void onStop_WorkerThread() const {}
+            void onStop_MainThread() const {}
+
+        private:
+
+            RenderFrameOutput* m_FrameOutput = nullptr;
+        };
+        class FrameOutputTask : public jasync_task
+        {
+        public:
+            FrameOutputTask() = delete;
+            FrameOutputTask(RenderFrameOutput* frameOutput, const int32 slotIndex)
+                : m_FrameOutput(frameOutput), m_SlotIndex(slotIndex)
+            {}
+
+            virtual void run() override;
+
+        private:
+
+            RenderFrameOutput* m_FrameOutput = nullptr;
+            int32 m_SlotIndex = 0;
+        };
+
+        RenderFrameOutputCreateInfo m_CreateInfo;
+        bool m_PathHasSequenceIndex = false;
+
+        jasync_task_queue<FrameOutputWorker> m_TaskQueue;
+        jarray<FrameSlot> m_FrameSlots;
+        mutable std::mutex m_FrameSlotsMutex;
+        std::condition_variable m_FrameSlotsCondition;
+        uint64 m_SubmittedFramesCount = 0;
+        // Frames which slots are free again, written or dropped
+        uint64 m_FinishedFramesCount = 0;
+        uint64 m_WrittenFramesCount = 0;
+        uint64 m_DroppedFramesCount = 0;
+        int32 m_PendingReadbacksCount = 0;
+        bool m_Writing = false;
+
+        std::FILE* m_OutputFile = nullptr;
+        math::uvector2 m_StreamFrameSize = { 0, 0 };
+        bool m_StreamHeaderWritten = false;
+
+        bool m_Stopping = false;
+        bool m_Initialized = false;
+
+
+        bool init(const RenderFrameOutputCreateInfo& createInfo);
+        void clear();
+
+        void requestFrame(const RenderEngine* renderEngine);
+        void onFrameReadback(const RenderTargetReadbackData& data);
+        bool hasPendingReadbacks() const;
+
+        void convertFrame(FrameSlot& slot) const;
+        void onFrameConverted(int32 slotIndex);
+        bool writeFrame(FrameSlot& slot);
+
+        std::FILE* openOutputFile(const char* path) const;
+        void closeOutputFile(std::FILE* file) const;
+    };
+}
@@ -0,0 +1,76 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "core.h"
+
+#include <jutils/jarray.h>
+
+namespace JumaRenderEngine
+{
+    enum class RenderFrameCounter : uint8
+    {
+        DrawCalls,
+        // Shader program or pipeline binds
+        StateChanges,
+        UploadedBytes,
+        DescriptorUpdates,
+        PipelineCreations
+    };
+    constexpr uint8 RenderFrameCounterCount = 5;
+
+    enum class RenderFramePhase : uint8
+    {
+        // Render targets queue building and render pipeline start (waiting for frame resources, acquiring swapchain images)
+        StartRender,
+        RecordRender,
+        // Submitting and presenting
+        FinishRender,
+        // Windows update and assets destroying
+        PostRender,
+        Total
+    };
+    constexpr uint8 RenderFramePhaseCount = 5;
+
+    struct RenderFrameStats
+    {
+        uint64 frameIndex = 0;
+        uint64 counters[RenderFrameCounterCount] = {};
+        // Milliseconds of CPU time
+        float phaseTimes[RenderFramePhaseCount] = {};
+
+        uint64 getCounter(const RenderFrameCounter counter) const { return counters[static_cast<uint8>(counter)]; }
+        float getPhaseTime(const RenderFramePhase phase) const { return phaseTimes[static_cast<uint8>(phase)]; }
+    };
+
+    struct RenderFramePhaseTimings
+    {
+        float min = 0.0f;
+        float avg = 0.0f;
+        float p99 = 0.0f;
+    };
+
+    // Ring of stats of the last frames
+    class RenderFrameStatsHistory
+    {
+    public:
+        RenderFrameStatsHistory() = default;
+
+        void init(int32 capacity);
+        void clear();
+
+        void add(const RenderFrameStats& stats);
+
+        int32 getSize() const { return m_Stats.getSize(); }
+        // 0 - oldest frame in history
+        const RenderFrameStats& getStats(int32 index) const;
+
+        RenderFramePhaseTimings getPhaseTimings(RenderFramePhase phase) const;
+
+    private:
+
+        jarray<RenderFrameStats> m_Stats;
+        int32 m_Capacity = 0;
+        int32 m_NextIndex = 0;
+    };
+}
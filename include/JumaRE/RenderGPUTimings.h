@@ -0,0 +1,28 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "core.h"
+
+#include <jutils/jarray.h>
+
+#include "render_target_id.h"
+
+namespace JumaRenderEngine
+{
+    struct RenderGPUTiming
+    {
+        render_target_id renderTargetID = render_target_id_INVALID;
+        // -1 - whole render target
+        int32 renderStageIndex = -1;
+        // Milliseconds of GPU time
+        float time = 0.0f;
+    };
+
+    struct RenderGPUFrameTimings
+    {
+        // Index of the frame in which timings were recorded
+        uint64 frameIndex = 0;
+        jarray<RenderGPUTiming> timings;
+    };
+}
@@ -17,5 +17,11 @@ namespace JumaRenderEngine
         RenderTarget* renderTarget = nullptr;
 
         RenderStageProperties renderStageProperties;
+
+        // Index of the render target's first GPU timing in current frame, -1 if GPU profiling is inactive
+        int32 gpuTimingIndex = -1;
+
+        // True when primitives are recorded on render record worker thread
+        bool recordingOnWorkerThread = false;
     };
 }
@@ -5,9 +5,17 @@
 #include "core.h"
 #include "RenderEngineContextObject.h"
 
+#include "FrameArena.h"
+#include "RenderFrameStats.h"
+#include "RenderGPUTimings.h"
+#include "RenderTrace.h"
+
+#include <jutils/jasync_task_queue.h>
 #include <jutils/jmap.h>
 #include <jutils/jset.h>
 #include <jutils/jstringID.h>
+#include <condition_variable>
+#include <mutex>
 
 #include "render_target_id.h"
 
@@ -31,18 +39,86 @@ namespace JumaRenderEngine
         bool isRenderTargetsQueueValid() const { return m_RenderTargetsQueueValid; }
         bool buildRenderTargetsQueue();
 
+        int32 getFrameInFlightIndex() const { return m_FrameInFlightIndex; }
+
         virtual void waitForRenderFinished() {}
 
+        bool isGPUProfilingSupported() const { return isGPUTimestampsSupported(); }
+        bool isGPUProfilingEnabled() const { return m_GPUProfilingEnabled; }
+        bool setGPUProfilingEnabled(bool enabled);
+        // Timings are resolved without waiting for GPU, so they are a few frames behind
+        const RenderGPUFrameTimings& getGPUFrameTimings() const { return m_GPUFrameTimings; }
+
     protected:
 
         virtual bool initInternal();
+        virtual bool isParallelRecordingSupported() const { return false; }
+        virtual bool initRenderRecordWorker(int32 workerIndex) { return true; }
+        virtual bool initRenderRecordWorkerThread(int32 workerIndex) { return true; }
+        virtual void clearRenderRecordWorkerThread(int32 workerIndex) {}
+        virtual void clearRenderRecordWorker(int32 workerIndex) {}
+
+        // Timestamps are grouped in slots, each slot is used by one frame and reused only after GPU finished it
+        virtual bool isGPUTimestampsSupported() const { return false; }
+        // Called from main thread after onStartRender, all timestamps of the slot should be reset here
+        virtual bool startGPUTimestamps(RenderOptions* renderOptions, int32 slotIndex, uint32 count) { return false; }
+        // Could be called from render record worker thread
+        virtual void writeGPUTimestamp(const RenderOptions* renderOptions, int32 slotIndex, uint32 timestampIndex) const {}
+        // Shouldn't wait for GPU, returns false if timestamps are not available yet. Timestamps are in nanoseconds
+        virtual bool readGPUTimestamps(int32 slotIndex, uint32 count, jarray<uint64>& outTimestamps) { return false; }
+
+        bool isParallelRecordingEnabled() const { return m_RenderRecordWorkersStarted; }
+        void stopRenderRecordWorkers();
+        static int32 getRenderRecordWorkerIndex() { return s_RenderRecordWorkerIndex; }
 
         virtual void renderInternal();
         template<typename T> requires is_base_class<RenderOptions, T>
         void callRender()
         {
             T renderOptions;
-            this->callRender(&renderOptions);
+            bool renderStarted;
+            {
+                JUMARE_TRACE_SCOPE("RenderPipeline::startRender", "render");
+                renderStarted = this->startRender(&renderOptions);
+            }
+            this->finishFramePhase(RenderFramePhase::StartRender);
+            if (!renderStarted)
+            {
+                return;
+            }
+
+            FrameArena& frameArena = getFrameArena();
+            for (const auto& renderQueueLevel : m_RenderTargetsQueueLevels)
+            {
+                JUMARE_TRACE_SCOPE("RenderPipeline::renderQueueLevel", "render");
+                bool success;
+                if (!shouldRecordInParallel(renderQueueLevel))
+                {
+                    success = this->renderQueueLevel(&renderOptions, renderQueueLevel);
+                }
+                else
+                {
+                    FrameArray<T> levelRenderOptions(frameArena, renderQueueLevel.entriesCount, renderOptions);
+                    FrameArray<RenderOptions*> levelRenderOptionsPtrs(frameArena, renderQueueLevel.entriesCount);
+                    for (auto& levelOptions : levelRenderOptions)
+                    {
+                        levelRenderOptionsPtrs.add(&levelOptions);
+                    }
+                    success = this->recordQueueLevel(&renderOptions, renderQueueLevel, levelRenderOptionsPtrs);
+                }
+                if (!success)
+                {
+                    break;
+                }
+            }
+
+            this->finishFramePhase(RenderFramePhase::RecordRender);
+
+            {
+                JUMARE_TRACE_SCOPE("RenderPipeline::finishRender", "render");
+                this->finishRender(&renderOptions);
+            }
+            this->finishFramePhase(RenderFramePhase::FinishRender);
         }
 
         virtual bool onStartRender(RenderOptions* renderOptions);
@@ -50,6 +126,19 @@ namespace JumaRenderEngine
         virtual void onFinishRenderToRenderTarget(RenderOptions* renderOptions, RenderTarget* renderTarget);
         virtual void onFinishRender(RenderOptions* renderOptions);
 
+        // Called from main thread before recording tasks started
+        virtual bool onStartRecordRenderTarget(RenderOptions* renderOptions, RenderOptions* recordRenderOptions, RenderTarget* renderTarget);
+        // Called from render record worker thread
+        virtual void recordRenderTarget(RenderOptions* recordRenderOptions, RenderTarget* renderTarget);
+        // Called from main thread after all recording tasks of the level are finished
+        virtual bool onFinishRecordRenderTarget(RenderOptions* renderOptions, RenderOptions* recordRenderOptions, RenderTarget* renderTarget);
+        virtual void submitRecordedRenderTarget(RenderOptions* renderOptions, RenderOptions* recordRenderOptions, RenderTarget* renderTarget) {}
+
+        void renderPrimitives(RenderOptions* renderOptions, const RenderTarget* renderTarget) const;
+
+        FrameArena& getFrameArena() const;
+        void finishFramePhase(RenderFramePhase phase) const;
+
     private:
 
         struct RenderTargetsQueueEntry
@@ -57,13 +146,87 @@ namespace JumaRenderEngine
             render_target_id renderTargetID = render_target_id_INVALID;
             jarray<render_target_id> syncRenderTargets;
         };
+        struct RenderTargetsQueueLevel
+        {
+            int32 firstEntryIndex = 0;
+            int32 entriesCount = 0;
+        };
+        struct GPUTimestampsSlot
+        {
+            uint64 frameIndex = 0;
+            // Each timing uses 2 timestamps, start and finish
+            jarray<RenderGPUTiming> timings;
+            // First timing of each render targets queue entry
+            jarray<int32> queueEntryTimingIndices;
+            bool pending = false;
+        };
+
+        class RenderRecordWorker : public jasync_worker
+        {
+        public:
+            RenderRecordWorker() = delete;
+            RenderRecordWorker(RenderPipeline* renderPipeline) : m_RenderPipeline(renderPipeline) {}
+
+            bool onStart_MainThread() const { return m_RenderPipeline->initRenderRecordWorker(getWorkerIndex()); }
+            bool onStart_WorkerThread() const
+            {
+                s_RenderRecordWorkerIndex = getWorkerIndex();
+                SetRenderTraceThreadName("Render record worker");
+                return m_RenderPipeline->initRenderRecordWorkerThread(getWorkerIndex());
+            }
+            void onStop_WorkerThread() const
+            {
+                m_RenderPipeline->clearRenderRecordWorkerThread(getWorkerIndex());
+                s_RenderRecordWorkerIndex = -1;
+            }
+            void onStop_MainThread() const { m_RenderPipeline->clearRenderRecordWorker(getWorkerIndex()); }
+
+        private:
+
+            RenderPipeline* m_RenderPipeline = nullptr;
+        };
+        class RenderRecordTask : public jasync_task
+        {
+        public:
+            RenderRecordTask() = delete;
+            RenderRecordTask(RenderPipeline* renderPipeline, RenderOptions* renderOptions, RenderTarget* renderTarget)
+                : m_RenderPipeline(renderPipeline), m_RenderOptions(renderOptions), m_RenderTarget(renderTarget)
+            {}
+
+            virtual void run() override;
+
+        private:
+
+            RenderPipeline* m_RenderPipeline = nullptr;
+            RenderOptions* m_RenderOptions = nullptr;
+            RenderTarget* m_RenderTarget = nullptr;
+        };
+
+        static thread_local int32 s_RenderRecordWorkerIndex;
 
         jmap<render_target_id, jset<render_target_id>> m_RenderTargetsDependecies;
         jarray<RenderTargetsQueueEntry> m_RenderTargetsQueue;
+        jarray<RenderTargetsQueueLevel> m_RenderTargetsQueueLevels;
         bool m_RenderTargetsQueueValid = false;
 
+        int32 m_FrameInFlightIndex = 0;
+
+        jasync_task_queue<RenderRecordWorker> m_RenderRecordTaskQueue;
+        jarray<jasync_task*> m_RenderRecordTasksTemp;
+        std::mutex m_RenderRecordTasksMutex;
+        std::condition_variable m_RenderRecordTasksCondition;
+        int32 m_RenderRecordTasksLeft = 0;
+        bool m_RenderRecordWorkersStarted = false;
+
+        jarray<GPUTimestampsSlot> m_GPUTimestampsSlots;
+        jarray<uint64> m_GPUTimestampsTemp;
+        RenderGPUFrameTimings m_GPUFrameTimings;
+        int32 m_GPUTimestampsSlotIndex = -1;
+        bool m_GPUProfilingEnabled = false;
+        bool m_GPUTimestampsActive = false;
+
 
-        bool init();
+        bool init(int32 recordWorkerCount);
 
         void onRenderTargetCreated(RenderTarget* renderTarget);
         void onRenderTargetDestroying(RenderEngineAsset* renderTargetAsset);
@@ -71,6 +234,17 @@ namespace JumaRenderEngine
         void clearData();
         
         bool render();
-        void callRender(RenderOptions* renderOptions);
+        bool startRender(RenderOptions* renderOptions);
+        void startGPUTimestamps(RenderOptions* renderOptions);
+        void resolveGPUTimestamps();
+        int32 getQueueEntryGPUTimingIndex(int32 queueEntryIndex) const;
+        void writeRenderTargetGPUTimestamp(const RenderOptions* renderOptions, bool finished) const;
+        void writeRenderStageGPUTimestamp(const RenderOptions* renderOptions, int32 renderStageIndex, bool finished) const;
+        bool shouldRecordInParallel(const RenderTargetsQueueLevel& queueLevel) const;
+        bool renderQueueLevel(RenderOptions* renderOptions, const RenderTargetsQueueLevel& queueLevel);
+        bool recordQueueLevel(RenderOptions* renderOptions, const RenderTargetsQueueLevel& queueLevel, const FrameArray<RenderOptions*>& levelRenderOptions);
+        void finishRender(RenderOptions* renderOptions);
+
+        void onRenderRecordTaskFinished();
     };
 }
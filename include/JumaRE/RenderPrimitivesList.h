@@ -6,23 +6,55 @@
 
 #include <jutils/jarray.h>
 
+#include "render_primitive_id.h"
+
 namespace JumaRenderEngine
 {
 	class Material;
 	class VertexBuffer;
 
+    enum class RenderStageSortMode : uint8 { None, State, FrontToBack, BackToFront };
+
 	struct RenderPrimitive
     {
         VertexBuffer* vertexBuffer = nullptr;
         Material* material = nullptr;
+
+        uint32 instanceCount = 1;
+        // Optional buffer with per-instance vertex components
+        VertexBuffer* instanceBuffer = nullptr;
+        // Data of shader primitive constants, it's copied when primitive is rendered, so it should stay valid while primitive is
+        // in the render stage. Zeroes are used if it's null
+        const void* constants = nullptr;
+
+        // View space depth, used by FrontToBack and BackToFront sort modes
+        float sortDepth = 0.0f;
+        // Filled by render target
+        uint64 sortKey = 0;
+        render_primitive_id primitiveID = render_primitive_id_INVALID;
     };
     struct RenderStageProperties
     {
         bool depthEnabled = true;
+        RenderStageSortMode sortMode = RenderStageSortMode::None;
+        // Primitives of retained stage are kept between frames and changed only by handles
+        bool retained = false;
     };
     struct RenderStage
     {
 	    jarray<RenderPrimitive> primitivesList;
         RenderStageProperties properties;
+
+        // Index in primitivesList for each primitive slot of retained stage, -1 for free slots
+        jarray<int32> retainedPrimitiveIndices;
+        // IDs with next generation of freed slots
+        jarray<render_primitive_id> freeRetainedPrimitiveIDs;
+        // Removed primitives of unsorted stage are kept in list with invalid ID until compacting
+        int32 removedRetainedPrimitivesCount = 0;
+        bool primitivesListSorted = true;
     };
+
+    const void* GetRenderPrimitiveConstants(const RenderPrimitive& primitive);
+    uint64 MakeRenderPrimitiveSortKey(const RenderPrimitive& primitive, RenderStageSortMode sortMode);
+    void SortRenderPrimitives(jarray<RenderPrimitive>& primitives, jarray<RenderPrimitive>& tempBuffer);
 }
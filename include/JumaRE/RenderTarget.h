@@ -5,7 +5,10 @@
 #include "core.h"
 #include "texture/TextureBase.h"
 
+#include <jutils/jset.h>
+
 #include "RenderPrimitivesList.h"
+#include "RenderTargetReadback.h"
 #include "render_target_id.h"
 #include "texture/TextureFormat.h"
 #include "texture/TextureSamples.h"
@@ -49,6 +52,18 @@ namespace JumaRenderEngine
         void setupRenderStages(const jarray<RenderStageProperties>& stages);
         bool addPrimitiveToRenderStage(int32 renderStageIndex, const RenderPrimitive& primitive);
         void clearPrimitivesList();
+        void sortPrimitivesLists();
+
+        // Retained stages keep primitives until they removed or any of their assets is destroyed,
+        // handle is invalid after that and never matches primitives added later
+        render_primitive_id addRetainedPrimitive(int32 renderStageIndex, const RenderPrimitive& primitive);
+        bool updateRetainedPrimitive(int32 renderStageIndex, render_primitive_id primitiveID, const RenderPrimitive& primitive);
+        bool removeRetainedPrimitive(int32 renderStageIndex, render_primitive_id primitiveID);
+
+        // Pixels are copied after the next render of the render target and delivered a few frames later without waiting for GPU.
+        // Supported only for offscreen render targets
+        bool requestReadback(const RenderTargetReadbackCallback& callback, RenderTargetReadbackFormat format = RenderTargetReadbackFormat::RGBA8, 
+            const RenderTargetReadbackRegion& region = {});
 
         virtual bool onStartRender(RenderOptions* renderOptions);
         virtual void onFinishRender(RenderOptions* renderOptions);
@@ -64,8 +79,26 @@ namespace JumaRenderEngine
 
         virtual bool recreateRenderTarget() { return false; }
 
+        virtual bool isReadbackSupported() const { return false; }
+        // Called from main thread after render target is rendered and resolved, copies RGBA8 pixels of the region to readback buffer.
+        // Buffer is not used by other readbacks until it's unmapped
+        virtual bool copyToReadbackBuffer(RenderOptions* renderOptions, int32 bufferIndex, const math::uvector2& offset, const math::uvector2& size) { return false; }
+        // Shouldn't wait for GPU, returns false if copy is not finished yet. Row pitch could be negative for bottom-up rows
+        virtual bool mapReadbackBuffer(int32 bufferIndex, const uint8*& outData, int32& outRowPitch) { return false; }
+        virtual void unmapReadbackBuffer(int32 bufferIndex) {}
+
     private:
 
+        struct ReadbackRequest
+        {
+            RenderTargetReadbackCallback callback;
+            RenderTargetReadbackFormat format = RenderTargetReadbackFormat::RGBA8;
+            RenderTargetReadbackRegion region;
+
+            uint64 frameIndex = 0;
+            int32 bufferIndex = -1;
+        };
+
         render_target_id m_RenderTargetID = render_target_id_INVALID;
 
         window_id m_WindowID = window_id_INVALID;
@@ -76,6 +109,15 @@ namespace JumaRenderEngine
         bool m_Invalid = true;
         
         jarray<RenderStage> m_RenderStages;
+        jarray<RenderPrimitive> m_SortBuffer;
+        bool m_PrimitivesListsSorted = true;
+
+        jarray<ReadbackRequest> m_ReadbackRequests;
+        // Ordered by frame index
+        jarray<ReadbackRequest> m_ReadbacksInFlight;
+        jarray<int32> m_FreeReadbackBuffers;
+        int32 m_ReadbackBuffersCount = 0;
+        jarray<uint8> m_ReadbackPixels;
 
 
         bool init(render_target_id renderTargetID, window_id windowID, TextureSamples samples);
@@ -83,6 +125,18 @@ namespace JumaRenderEngine
 
         void clearData();
 
+        bool isPrimitiveValid(const RenderPrimitive& primitive) const;
+        RenderStage* findRetainedRenderStage(int32 renderStageIndex);
+        int32* findRetainedPrimitiveIndex(RenderStage& renderStage, render_primitive_id primitiveID) const;
+        void freeRetainedPrimitive(RenderStage& renderStage, RenderPrimitive& primitive);
+        void compactRetainedPrimitives(RenderStage& renderStage);
+        void removeRetainedPrimitivesWithAssets(const jset<const RenderEngineAsset*>& assets);
+
         void onWindowPropertiesChanged(WindowController* windowController, const WindowData* windowData);
+
+        void startReadbacks(RenderOptions* renderOptions);
+        void finishReadbacks();
+        void finishReadback(const ReadbackRequest& readback, const uint8* data, int32 rowPitch);
+        void failReadbacks();
     };
 }
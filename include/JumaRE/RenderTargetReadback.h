@@ -0,0 +1,58 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "core.h"
+
+#include <functional>
+#include <jutils/math/vector2.h>
+
+#include "render_target_id.h"
+
+namespace JumaRenderEngine
+{
+    enum class RenderTargetReadbackFormat : uint8
+    {
+        RGBA8,
+        BGRA8,
+        RGB8
+    };
+
+    constexpr uint32 GetRenderTargetReadbackFormatSize(const RenderTargetReadbackFormat format)
+    {
+        switch (format)
+        {
+        case RenderTargetReadbackFormat::RGBA8:
+        case RenderTargetReadbackFormat::BGRA8:
+            return 4;
+        case RenderTargetReadbackFormat::RGB8:
+            return 3;
+        default: ;
+        }
+        return 0;
+    }
+
+    struct RenderTargetReadbackRegion
+    {
+        // Offset from the top left corner
+        math::uvector2 offset = { 0, 0 };
+        // Zero size - whole render target
+        math::uvector2 size = { 0, 0 };
+    };
+
+    struct RenderTargetReadbackData
+    {
+        render_target_id renderTargetID = render_target_id_INVALID;
+        // Index of the frame in which pixels were copied
+        uint64 frameIndex = 0;
+
+        RenderTargetReadbackFormat format = RenderTargetReadbackFormat::RGBA8;
+        math::uvector2 size = { 0, 0 };
+        uint32 rowPitch = 0;
+        // Rows are ordered from the top one, nullptr if readback failed
+        const uint8* pixels = nullptr;
+    };
+
+    // Called on main thread, pixels are valid only during the call
+    using RenderTargetReadbackCallback = std::function<void(const RenderTargetReadbackData& data)>;
+}
@@ -0,0 +1,51 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "core.h"
+
+#include <jutils/jstring.h>
+
+namespace JumaRenderEngine
+{
+    // Trace events are recorded only if engine is built with JUMARE_ENABLE_TRACE, otherwise these functions do nothing
+    void StartRenderTrace();
+    void StopRenderTrace();
+    bool IsRenderTraceActive();
+    // Should be called only when trace is stopped and traced threads are idle
+    void ClearRenderTrace();
+    // Writes recorded events in Chrome trace event format (chrome://tracing, Perfetto UI)
+    bool ExportRenderTrace(const jstring& fileName);
+
+    // Name must be a string literal
+    void SetRenderTraceThreadName(const char* name);
+
+#ifdef JUMARE_ENABLE_TRACE
+    class RenderTraceScope
+    {
+    public:
+        RenderTraceScope() = delete;
+        // Name and category must be string literals
+        RenderTraceScope(const char* name, const char* category);
+        ~RenderTraceScope();
+
+        RenderTraceScope(const RenderTraceScope&) = delete;
+        RenderTraceScope& operator=(const RenderTraceScope&) = delete;
+
+    private:
+
+        const char* m_Name = nullptr;
+        const char* m_Category = nullptr;
+        // 0 - trace wasn't active at scope start
+        uint64 m_StartTime = 0;
+    };
+#endif
+}
+
+#ifdef JUMARE_ENABLE_TRACE
+    #define JUMARE_TRACE_SCOPE_NAME_INTERNAL(line) renderTraceScope##line
+    #define JUMARE_TRACE_SCOPE_INTERNAL(name, category, line) const JumaRenderEngine::RenderTraceScope JUMARE_TRACE_SCOPE_NAME_INTERNAL(line)(name, category)
+    #define JUMARE_TRACE_SCOPE(name, category) JUMARE_TRACE_SCOPE_INTERNAL(name, category, __LINE__)
+#else
+    #define JUMARE_TRACE_SCOPE(name, category)
+#endif
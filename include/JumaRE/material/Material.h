@@ -5,7 +5,8 @@
 #include "../core.h"
 #include "../RenderEngineAsset.h"
 
-#include <jutils/jset.h>
+#include <atomic>
+#include <mutex>
 
 #include "MaterialParamsStorage.h"
 #include "MaterialProperties.h"
@@ -25,50 +26,124 @@ namespace JumaRenderEngine
         virtual ~Material() override;
 
         Shader* getShader() const { return m_Shader; }
+        // Instance reads params from parent until they are overridden
+        Material* getParentMaterial() const { return m_ParentMaterial; }
         const MaterialProperties& getMaterialProperties() const { return m_Properties; }
         const MaterialParamsStorage& getMaterialParams() const { return m_MaterialParams; }
 
         template<ShaderUniformType Type>
         bool setParamValue(const jstringID& name, const typename ShaderUniformInfo<Type>::value_type& value)
         {
-            if (!checkParamType(name, Type) || !m_MaterialParams.setValue<Type>(name, value))
+            const MaterialParamsLayoutEntry* entry = findParamEntry(name);
+            return (entry != nullptr) && setParamValue<Type>(*entry, value);
+        }
+        // Handle should be taken from the shader of this material
+        template<ShaderUniformType Type>
+        bool setParamValue(const MaterialParamHandle& handle, const typename ShaderUniformInfo<Type>::value_type& value)
+        {
+            return (handle.layout == m_MaterialParams.getLayout()) && setParamValue<Type>(handle.entry, value);
+        }
+        // Sets param of many materials at once, values[index] is written to materials[index], materials of other shaders are skipped.
+        // Could be called from several threads for different materials if none of them is a parent of another one.
+        // Returns count of materials which param was changed
+        template<ShaderUniformType Type>
+        static int32 setParamValues(const MaterialParamHandle& handle, Material* const* materials, 
+            const typename ShaderUniformInfo<Type>::value_type* values, const int32 count)
+        {
+            if (!handle.isValid() || (handle.entry.type != Type) || (materials == nullptr) || (values == nullptr))
             {
-	            return false;
+                return 0;
             }
-            m_MaterialParamsForUpdate.add(name);
-            return true;
+            int32 changedCount = 0;
+            for (int32 index = 0; index < count; index++)
+            {
+                Material* material = materials[index];
+                if ((material != nullptr) && (material->m_MaterialParams.getLayout() == handle.layout) 
+                    && material->setParamValue<Type>(handle.entry, values[index]))
+                {
+                    changedCount++;
+                }
+            }
+            return changedCount;
         }
         bool resetParamValue(const jstringID& name);
+        bool resetParamValue(const MaterialParamHandle& handle);
         template<ShaderUniformType Type>
         bool getParamValue(const jstringID& name, typename ShaderUniformInfo<Type>::value_type& outValue) const
         {
-            return checkParamType(name, Type) && m_MaterialParams.getValue<Type>(name, outValue);
+            return m_MaterialParams.getValue<Type>(name, outValue);
+        }
+        template<ShaderUniformType Type>
+        bool getParamValue(const MaterialParamHandle& handle, typename ShaderUniformInfo<Type>::value_type& outValue) const
+        {
+            return (handle.layout == m_MaterialParams.getLayout()) && m_MaterialParams.getValue<Type>(handle.entry, outValue);
         }
 
     protected:
 
         virtual bool initInternal() = 0;
+        virtual bool isReadyForDestroy() override { return m_ChildMaterialsCount == 0; }
         virtual void onClearAsset() override;
 
         template<typename T> requires is_base_class<Shader, T>
         T* getShader() const { return dynamic_cast<T*>(getShader()); }
+
+        // Parent which uniform buffers are used by this instance until it overrides any scalar param, nullptr if material uses own buffers
+        Material* getUniformDataParent() const;
+        template<typename T> requires is_base_class<Material, T>
+        T* getUniformDataParent() const { return dynamic_cast<T*>(getUniformDataParent()); }
+        // Parent which render data (uniform buffers and textures) is used by this instance until it overrides any param,
+        // nullptr if material uses own render data
+        Material* getRenderDataParent() const;
+        template<typename T> requires is_base_class<Material, T>
+        T* getRenderDataParent() const { return dynamic_cast<T*>(getRenderDataParent()); }
         
-        const jset<jstringID>& getNotUpdatedParams() const { return m_MaterialParamsForUpdate; }
+        // Indices of changed params in material params layout
+        const MaterialParamsMask& getNotUpdatedParams() const { return m_MaterialParamsForUpdate; }
         void clearParamsForUpdate() { m_MaterialParamsForUpdate.clear(); }
+        bool isUniformBufferChanged(const MaterialParamsMask& notUpdatedParams, uint32 shaderLocation) const;
 
     private:
 
         Shader* m_Shader = nullptr;
+        Material* m_ParentMaterial = nullptr;
         MaterialProperties m_Properties;
         MaterialParamsStorage m_MaterialParams;
 
-        jset<jstringID> m_MaterialParamsForUpdate;
+        MaterialParamsMask m_MaterialParamsForUpdate;
+        // Once instance overrides any param it keeps using own render data
+        bool m_ParamsOverridden = false;
+        bool m_UniformDataOverridden = false;
+
+        std::mutex m_ChildMaterialsMutex;
+        jarray<Material*> m_ChildMaterials;
+        std::atomic<uint32> m_ChildMaterialsCount = 0;
 
 
-        bool init(Shader* shader);
+        bool init(Shader* shader, Material* parentMaterial = nullptr);
 
         void clearData();
 
-        bool checkParamType(const jstringID& name, ShaderUniformType type) const;
+        const MaterialParamsLayoutEntry* findParamEntry(const jstringID& name) const
+        {
+            const MaterialParamsLayout* layout = m_MaterialParams.getLayout();
+            return layout != nullptr ? layout->findParam(name) : nullptr;
+        }
+        template<ShaderUniformType Type>
+        bool setParamValue(const MaterialParamsLayoutEntry& entry, const typename ShaderUniformInfo<Type>::value_type& value)
+        {
+            if (!m_MaterialParams.setValue<Type>(entry, value))
+            {
+	            return false;
+            }
+            onParamValueChanged(entry);
+            return true;
+        }
+        bool resetParamValue(const MaterialParamsLayoutEntry& entry);
+
+        void onParamValueChanged(const MaterialParamsLayoutEntry& entry);
+        void onParentParamValueChanged(const MaterialParamsLayoutEntry& entry);
+        void updateChildMaterialsParam(const MaterialParamsLayoutEntry& entry);
+        void markAllParamsForUpdate();
     };
 }
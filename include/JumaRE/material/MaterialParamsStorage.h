@@ -4,150 +4,293 @@
 
 #include "../core.h"
 
+#include <jutils/jarray.h>
 #include <jutils/jmap.h>
 #include <jutils/jstringID.h>
 #include <jutils/math/math_matrix.h>
+#include <bit>
+#include <cstring>
 
 #include "ShaderUniformInfo.h"
 
 namespace JumaRenderEngine
 {
+    struct MaterialParamsLayoutEntry
+    {
+        ShaderUniformType type = ShaderUniformType::Float;
+        // Offset in uniform data block for scalar params, index of texture slot for textures
+        uint32 offset = 0;
+        uint32 index = 0;
+    };
+
+    class MaterialParamsLayout;
+
+    // Resolved param of the shader, valid while the shader is valid
+    struct MaterialParamHandle
+    {
+        const MaterialParamsLayout* layout = nullptr;
+        MaterialParamsLayoutEntry entry;
+
+        bool isValid() const { return layout != nullptr; }
+    };
+
+    // Set of param indices, used to track changed params
+    class MaterialParamsMask final
+    {
+    public:
+        class iterator
+        {
+        public:
+            iterator(const uint64* words, const int32 wordsCount, const int32 wordIndex)
+                : m_Words(words), m_WordsCount(wordsCount), m_WordIndex(wordIndex), m_Word(wordIndex < wordsCount ? words[wordIndex] : 0)
+            {
+                skipEmptyWords();
+            }
+
+            uint32 operator*() const { return static_cast<uint32>(m_WordIndex * 64 + std::countr_zero(m_Word)); }
+            iterator& operator++()
+            {
+                m_Word &= m_Word - 1;
+                skipEmptyWords();
+                return *this;
+            }
+            bool operator==(const iterator& other) const { return (m_WordIndex == other.m_WordIndex) && (m_Word == other.m_Word); }
+
+        private:
+
+            const uint64* m_Words = nullptr;
+            int32 m_WordsCount = 0;
+            int32 m_WordIndex = 0;
+            uint64 m_Word = 0;
+
+            void skipEmptyWords()
+            {
+                while ((m_Word == 0) && (m_WordIndex < m_WordsCount))
+                {
+                    if (++m_WordIndex < m_WordsCount)
+                    {
+                        m_Word = m_Words[m_WordIndex];
+                    }
+                }
+            }
+        };
+
+        MaterialParamsMask() = default;
+
+        bool isEmpty() const { return m_Count == 0; }
+        int32 getSize() const { return m_Count; }
+        bool contains(const uint32 index) const
+        {
+            const int32 wordIndex = static_cast<int32>(index / 64);
+            return m_Bits.isValidIndex(wordIndex) && ((m_Bits[wordIndex] >> (index % 64)) & 1);
+        }
+
+        void add(const uint32 index)
+        {
+            const int32 wordIndex = static_cast<int32>(index / 64);
+            if (wordIndex >= m_Bits.getSize())
+            {
+                m_Bits.resize(wordIndex + 1, 0);
+            }
+            uint64& word = m_Bits[wordIndex];
+            const uint64 bit = static_cast<uint64>(1) << (index % 64);
+            if ((word & bit) == 0)
+            {
+                word |= bit;
+                m_Count++;
+            }
+        }
+        void add(const MaterialParamsMask& mask);
+        void addAll(int32 paramsCount);
+        void clear();
+
+        iterator begin() const { return iterator(m_Bits.getData(), m_Bits.getSize(), 0); }
+        iterator end() const { return iterator(m_Bits.getData(), m_Bits.getSize(), m_Bits.getSize()); }
+
+    private:
+
+        jarray<uint64> m_Bits;
+        int32 m_Count = 0;
+    };
+
+    // Shared by all materials of the shader, uniform buffers are placed one after another in the data block
+    class MaterialParamsLayout final
+    {
+    public:
+        MaterialParamsLayout() = default;
+
+        void init(const jmap<jstringID, ShaderUniform>& uniforms, const jmap<uint32, ShaderUniformBufferDescription>& uniformBuffers);
+        void clear();
+
+        const MaterialParamsLayoutEntry* findParam(const jstringID& name) const { return m_Params.find(name); }
+        int32 getParamsCount() const { return static_cast<int32>(m_Params.getSize()); }
+        const MaterialParamsLayoutEntry& getParam(const uint32 index) const { return m_ParamEntries[static_cast<int32>(index)]; }
+        const jstringID& getParamName(const uint32 index) const { return m_ParamNames[static_cast<int32>(index)]; }
+        const ShaderUniform& getParamUniform(const uint32 index) const { return m_ParamUniforms[static_cast<int32>(index)]; }
+        // Returns offset of the uniform buffer in data block, -1 if there is no such buffer
+        int32 getUniformBufferOffset(const uint32 shaderLocation) const
+        {
+            const uint32* offset = m_UniformBufferOffsets.find(shaderLocation);
+            return offset != nullptr ? static_cast<int32>(*offset) : -1;
+        }
+
+        const jarray<uint8>& getDefaultUniformData() const { return m_DefaultUniformData; }
+        int32 getTexturesCount() const { return m_TexturesCount; }
+        // Indexed by texture slot
+        const jarray<uint32>& getTextureParamIndices() const { return m_TextureParamIndices; }
+
+    private:
+
+        jmap<jstringID, MaterialParamsLayoutEntry> m_Params;
+        // Indexed by MaterialParamsLayoutEntry::index
+        jarray<MaterialParamsLayoutEntry> m_ParamEntries;
+        jarray<jstringID> m_ParamNames;
+        jarray<ShaderUniform> m_ParamUniforms;
+        jmap<uint32, uint32> m_UniformBufferOffsets;
+        jarray<uint8> m_DefaultUniformData;
+        jarray<uint32> m_TextureParamIndices;
+        int32 m_TexturesCount = 0;
+    };
+
     class MaterialParamsStorage final
     {
     public:
         MaterialParamsStorage() = default;
         ~MaterialParamsStorage();
 
+        // Layout should be valid while storage is used, all params are set to default values
+        void init(const MaterialParamsLayout* layout);
+        // Params are read from parent storage until they are overridden, parent should be valid while storage is used
+        void initInstance(const MaterialParamsStorage* parentParams);
+        const MaterialParamsLayout* getLayout() const { return m_Layout; }
+        const MaterialParamsStorage* getParent() const { return m_Parent; }
+
         template<ShaderUniformType Type>
         bool setValue(const jstringID& name, const typename ShaderUniformInfo<Type>::value_type& value)
         {
-            return (name != jstringID_NONE) && this->setValueInternal<Type>(name, value);
+            const MaterialParamsLayoutEntry* entry = name != jstringID_NONE ? findParam(name, Type) : nullptr;
+            return (entry != nullptr) && this->setValueInternal<Type>(*entry, value);
         }
+        // Entry should be taken from the layout of this storage
+        template<ShaderUniformType Type>
+        bool setValue(const MaterialParamsLayoutEntry& entry, const typename ShaderUniformInfo<Type>::value_type& value)
+        {
+            return (entry.type == Type) && this->setValueInternal<Type>(entry, value);
+        }
+        // Resets param to default value, for instance it's inherited from parent again
         bool setDefaultValue(const jstringID& name, ShaderUniformType type);
-        bool removeValue(const jstringID& name, ShaderUniformType type);
+        bool setDefaultValue(const MaterialParamsLayoutEntry& entry);
+        // Copies inherited value from parent after it was changed, returns false if param is overridden
+        bool updateInheritedValue(const jstringID& name);
+        bool updateInheritedValue(const MaterialParamsLayoutEntry& entry);
 
         template<ShaderUniformType Type>
         bool getValue(const jstringID& name, typename ShaderUniformInfo<Type>::value_type& outValue) const
         {
-            const typename ShaderUniformInfo<Type>::value_type* value = findValue<Type>(name);
-            if (value == nullptr)
+            const MaterialParamsLayoutEntry* entry = findParam(name, Type);
+            if (entry == nullptr)
+            {
+                return false;
+            }
+            getValueInternal<Type>(*entry, outValue);
+            return true;
+        }
+        template<ShaderUniformType Type>
+        bool getValue(const MaterialParamsLayoutEntry& entry, typename ShaderUniformInfo<Type>::value_type& outValue) const
+        {
+            if (entry.type != Type)
             {
                 return false;
             }
-            outValue = *value;
+            getValueInternal<Type>(entry, outValue);
             return true;
         }
-        bool contains(const jstringID& name, ShaderUniformType type) const;
+        bool contains(const jstringID& name, const ShaderUniformType type) const { return findParam(name, type) != nullptr; }
+        bool isOverridden(const jstringID& name) const;
+        // Instance has own uniform data after any of scalar params was overridden
+        bool hasOwnUniformData() const { return (m_Parent == nullptr) || !m_UniformData.isEmpty(); }
+
+        // Data of the uniform buffer laid out as in shader, nullptr if there is no such buffer
+        const uint8* getUniformBufferData(uint32 shaderLocation) const;
         
         void clear();
 
     private:
 
-        template<ShaderUniformType Type>
-        using material_params_map = jmap<jstringID, typename ShaderUniformInfo<Type>::value_type>;
+        const MaterialParamsLayout* m_Layout = nullptr;
+        const MaterialParamsStorage* m_Parent = nullptr;
+        // Empty for instance until it overrides any scalar param
+        jarray<uint8> m_UniformData;
+        // Empty for instance until it overrides any texture
+        jarray<TextureBase*> m_Textures;
+        // Bit mask of overridden params, empty if storage is not an instance
+        jarray<uint64> m_OverriddenParams;
 
-        // TODO: Replace with global objects pool in render engine, it took too much memory for each material
-        material_params_map<ShaderUniformType::Float> m_MaterialParams_Float;
-        material_params_map<ShaderUniformType::Vec2> m_MaterialParams_Vec2;
-        material_params_map<ShaderUniformType::Vec4> m_MaterialParams_Vec4;
-        material_params_map<ShaderUniformType::Mat4> m_MaterialParams_Mat4;
-        material_params_map<ShaderUniformType::Texture> m_MaterialParams_Texture;
 
+        const MaterialParamsLayoutEntry* findParam(const jstringID& name, ShaderUniformType type) const;
+        const uint8* getUniformData() const { return hasOwnUniformData() ? m_UniformData.getData() : m_Parent->getUniformData(); }
 
-        template<ShaderUniformType Type>
-        bool setValueInternal(const jstringID& name, const typename ShaderUniformInfo<Type>::value_type& value) { return false; }
-        template<>
-        bool setValueInternal<ShaderUniformType::Float>(const jstringID& name, const ShaderUniformInfo<ShaderUniformType::Float>::value_type& value)
+        bool isOverridden(const MaterialParamsLayoutEntry& entry) const
         {
-            ShaderUniformInfo<ShaderUniformType::Float>::value_type* valuePtr = m_MaterialParams_Float.find(name);
-            if (valuePtr == nullptr)
-            {
-                m_MaterialParams_Float.add(name, value);
-                return true;
-            }
-            if (!math::isEqual(value, *valuePtr))
-            {
-                *valuePtr = value;
-                return true;
-            }
-            return false;
+            return m_OverriddenParams.isEmpty() || ((m_OverriddenParams[static_cast<int32>(entry.index / 64)] >> (entry.index % 64)) & 1);
         }
-        template<>
-        bool setValueInternal<ShaderUniformType::Vec2>(const jstringID& name, const ShaderUniformInfo<ShaderUniformType::Vec2>::value_type& value)
+        void markAsOverridden(const MaterialParamsLayoutEntry& entry, bool overridden);
+
+        template<ShaderUniformType Type>
+        void getValueInternal(const MaterialParamsLayoutEntry& entry, typename ShaderUniformInfo<Type>::value_type& outValue) const
         {
-            ShaderUniformInfo<ShaderUniformType::Vec2>::value_type* valuePtr = m_MaterialParams_Vec2.find(name);
-            if (valuePtr == nullptr)
+            if (!isOverridden(entry))
             {
-                m_MaterialParams_Vec2.add(name, value);
-                return true;
+                m_Parent->getValueInternal<Type>(entry, outValue);
             }
-            if (value != *valuePtr)
+            else if constexpr (Type == ShaderUniformType::Texture)
             {
-                *valuePtr = value;
-                return true;
+                outValue = m_Textures[static_cast<int32>(entry.offset)];
             }
-            return false;
-        }
-        template<>
-        bool setValueInternal<ShaderUniformType::Vec4>(const jstringID& name, const ShaderUniformInfo<ShaderUniformType::Vec4>::value_type& value)
-        {
-            ShaderUniformInfo<ShaderUniformType::Vec4>::value_type* valuePtr = m_MaterialParams_Vec4.find(name);
-            if (valuePtr == nullptr)
+            else
             {
-                m_MaterialParams_Vec4.add(name, value);
-                return true;
+                std::memcpy(&outValue, m_UniformData.getData() + entry.offset, sizeof(outValue));
             }
-            if (value != *valuePtr)
-            {
-                *valuePtr = value;
-                return true;
-            }
-            return false;
         }
-        template<>
-        bool setValueInternal<ShaderUniformType::Mat4>(const jstringID& name, const ShaderUniformInfo<ShaderUniformType::Mat4>::value_type& value)
+
+        template<ShaderUniformType Type>
+        bool setValueInternal(const MaterialParamsLayoutEntry& entry, const typename ShaderUniformInfo<Type>::value_type& value)
         {
-            ShaderUniformInfo<ShaderUniformType::Mat4>::value_type* valuePtr = m_MaterialParams_Mat4.find(name);
-            if (valuePtr == nullptr)
+            // Same value as inherited one doesn't override param
+            typename ShaderUniformInfo<Type>::value_type currentValue;
+            getValueInternal<Type>(entry, currentValue);
+            if constexpr (Type == ShaderUniformType::Float)
             {
-                m_MaterialParams_Mat4.add(name, value);
-                return true;
+                if (math::isEqual(value, currentValue))
+                {
+                    return false;
+                }
             }
-            if (value != *valuePtr)
+            else if (value == currentValue)
             {
-                *valuePtr = value;
-                return true;
+                return false;
             }
-            return false;
-        }
-        template<>
-        bool setValueInternal<ShaderUniformType::Texture>(const jstringID& name, const ShaderUniformInfo<ShaderUniformType::Texture>::value_type& value)
-        {
-            ShaderUniformInfo<ShaderUniformType::Texture>::value_type* valuePtr = m_MaterialParams_Texture.find(name);
-            if (valuePtr == nullptr)
+
+            if constexpr (Type == ShaderUniformType::Texture)
             {
-                m_MaterialParams_Texture.add(name, value);
-                return true;
+                if (m_Textures.isEmpty())
+                {
+                    m_Textures.resize(m_Layout->getTexturesCount(), nullptr);
+                }
+                m_Textures[static_cast<int32>(entry.offset)] = value;
             }
-            if (value != *valuePtr)
+            else
             {
-                *valuePtr = value;
-                return true;
+                if (m_UniformData.isEmpty())
+                {
+                    // Copy on write, inherited values are kept up to date by updateInheritedValue()
+                    m_UniformData.resize(m_Layout->getDefaultUniformData().getSize());
+                    std::memcpy(m_UniformData.getData(), m_Parent->getUniformData(), m_UniformData.getSize());
+                }
+                std::memcpy(m_UniformData.getData() + entry.offset, &value, sizeof(value));
             }
-            return false;
+            markAsOverridden(entry, true);
+            return true;
         }
-
-        template<ShaderUniformType Type>
-        const typename ShaderUniformInfo<Type>::value_type* findValue(const jstringID& name) const { return nullptr; }
-        template<>
-        const ShaderUniformInfo<ShaderUniformType::Float>::value_type* findValue<ShaderUniformType::Float>(const jstringID& name) const { return m_MaterialParams_Float.find(name); }
-        template<>
-        const ShaderUniformInfo<ShaderUniformType::Vec2>::value_type* findValue<ShaderUniformType::Vec2>(const jstringID& name) const { return m_MaterialParams_Vec2.find(name); }
-        template<>
-        const ShaderUniformInfo<ShaderUniformType::Vec4>::value_type* findValue<ShaderUniformType::Vec4>(const jstringID& name) const { return m_MaterialParams_Vec4.find(name); }
-        template<>
-        const ShaderUniformInfo<ShaderUniformType::Mat4>::value_type* findValue<ShaderUniformType::Mat4>(const jstringID& name) const { return m_MaterialParams_Mat4.find(name); }
-        template<>
-        const ShaderUniformInfo<ShaderUniformType::Texture>::value_type* findValue<ShaderUniformType::Texture>(const jstringID& name) const { return m_MaterialParams_Texture.find(name); }
     };
 }
@@ -11,6 +11,7 @@
 #include <jutils/jset.h>
 #include <jutils/jstringID.h>
 
+#include "MaterialParamsStorage.h"
 #include "ShaderCreateInfo.h"
 #include "ShaderUniform.h"
 
@@ -18,12 +19,6 @@ namespace JumaRenderEngine
 {
     class Material;
 
-    struct ShaderUniformBufferDescription
-    {
-        uint32 size = 0;
-        uint8 shaderStages = 0;
-    };
-
     class Shader : public RenderEngineAsset
     {
         friend Material;
@@ -39,6 +34,17 @@ namespace JumaRenderEngine
 
         const jmap<jstringID, ShaderUniform>& getUniforms() const { return m_ShaderUniforms; }
         const jmap<uint32, ShaderUniformBufferDescription>& getUniformBufferDescriptions() const { return m_CachedUniformBufferDescriptions; }
+        const MaterialParamsLayout& getMaterialParamsLayout() const { return m_MaterialParamsLayout; }
+        // Resolves param once, so materials could be updated without name lookups
+        MaterialParamHandle findParam(const jstringID& name) const
+        {
+            const MaterialParamsLayoutEntry* entry = m_MaterialParamsLayout.findParam(name);
+            return entry != nullptr ? MaterialParamHandle{ &m_MaterialParamsLayout, *entry } : MaterialParamHandle();
+        }
+        bool hasBindlessTextures() const { return m_BindlessTexturesUsed; }
+
+        const ShaderPrimitiveConstants& getPrimitiveConstants() const { return m_PrimitiveConstants; }
+        bool hasPrimitiveConstants() const { return m_PrimitiveConstants.size > 0; }
 
     protected:
 
@@ -53,6 +59,9 @@ namespace JumaRenderEngine
         jset<jstringID> m_VertexComponents;
         jmap<jstringID, ShaderUniform> m_ShaderUniforms;
         jmap<uint32, ShaderUniformBufferDescription> m_CachedUniformBufferDescriptions;
+        MaterialParamsLayout m_MaterialParamsLayout;
+        bool m_BindlessTexturesUsed = false;
+        ShaderPrimitiveConstants m_PrimitiveConstants;
 
         std::atomic<uint32> m_ChildMaterialsCount = 0;
 
@@ -17,5 +17,6 @@ namespace JumaRenderEngine
         jmap<ShaderStageFlags, jstring> fileNames;
         jset<jstringID> vertexComponents;
         jmap<jstringID, ShaderUniform> uniforms;
+        ShaderPrimitiveConstants primitiveConstants;
     };
 }
@@ -12,7 +12,10 @@ namespace JumaRenderEngine
         Vec2,
         Vec4,
         Mat4,
-        Texture
+        Texture,
+        // Texture from global texture table, placed in uniform buffer as 8 bytes:
+        // bindless handle on OpenGL, table index (uint, padded to 8 bytes) on Vulkan
+        BindlessTexture
     };
     enum ShaderStageFlags : uint8
     {
@@ -27,4 +30,22 @@ namespace JumaRenderEngine
         uint32 shaderLocation = 0;
         uint32 shaderBlockOffset = 0;
     };
+    struct ShaderUniformBufferDescription
+    {
+        uint32 size = 0;
+        uint8 shaderStages = 0;
+    };
+
+    // Minimal push constants size guaranteed by Vulkan
+    constexpr uint32 ShaderPrimitiveConstantsMaxSize = 128;
+
+    // Small block of data set for each render primitive without changing material. It's placed in
+    // push constants on Vulkan, root constants on DirectX12 and uniform buffer at shaderLocation on OpenGL and DirectX11
+    struct ShaderPrimitiveConstants
+    {
+        // 0 if shader doesn't use primitive constants, should be a multiple of 4
+        uint32 size = 0;
+        uint8 shaderStages = SHADER_STAGE_VERTEX;
+        uint32 shaderLocation = 0;
+    };
 }
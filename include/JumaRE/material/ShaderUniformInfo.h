@@ -42,6 +42,11 @@ namespace JumaRenderEngine
     {
         using value_type = TextureBase*;
     };
+    template<>
+    struct ShaderUniformInfo<ShaderUniformType::BindlessTexture> : std::true_type
+    {
+        using value_type = TextureBase*;
+    };
 
     constexpr bool IsShaderUniformScalar(const ShaderUniformType type)
     {
@@ -55,6 +60,8 @@ namespace JumaRenderEngine
         case ShaderUniformType::Vec2: return sizeof(ShaderUniformInfo<ShaderUniformType::Vec2>::value_type);
         case ShaderUniformType::Vec4: return sizeof(ShaderUniformInfo<ShaderUniformType::Vec4>::value_type);
         case ShaderUniformType::Mat4: return sizeof(ShaderUniformInfo<ShaderUniformType::Mat4>::value_type);
+        // Texture pointer is stored in uniform data, render API replaces it with handle on upload
+        case ShaderUniformType::BindlessTexture: return sizeof(uint64);
         default: ;
         }
         return 0;
@@ -0,0 +1,32 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "../core.h"
+
+#include <functional>
+#include <jutils/jstring.h>
+#include <jutils/math/vector2.h>
+#include <jutils/math/vector4.h>
+
+namespace JumaRenderEngine
+{
+    class MaterialParamsStorage;
+    class TextureBase;
+
+    constexpr uint8 SoftwareShaderMaxVaryingsCount = 16;
+
+    // Shaders of software render API are C++ callables registered by name, ShaderCreateInfo::fileNames contains these names.
+    // Vertex components are floats in vertex description order, instance is nullptr if there is no instance buffer.
+    // Returned position is in OpenGL clip space
+    using SoftwareVertexShaderFunction = std::function<math::vector4(const float* vertex, const float* instance, 
+        const MaterialParamsStorage& params, float* outVaryings)>;
+    // Called from rasterizer threads, must be thread safe
+    using SoftwareFragmentShaderFunction = std::function<math::vector4(const float* varyings, const MaterialParamsStorage& params)>;
+
+    bool RegisterSoftwareVertexShader(const jstring& name, uint8 varyingsCount, const SoftwareVertexShaderFunction& function);
+    bool RegisterSoftwareFragmentShader(const jstring& name, const SoftwareFragmentShaderFunction& function);
+
+    // Could be used only from software fragment shaders
+    math::vector4 SampleSoftwareTexture(const TextureBase* texture, const math::vector2& uv);
+}
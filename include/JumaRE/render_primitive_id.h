@@ -0,0 +1,26 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "core.h"
+
+#include <jutils/juid.h>
+
+namespace JumaRenderEngine
+{
+    using render_primitive_id = uint32;
+    constexpr render_primitive_id render_primitive_id_INVALID = juid<render_primitive_id>::invalidUID;
+
+    // Low bits of retained primitive ID are index of the slot, high bits are generation of the slot.
+    // Generation is changed when slot is freed, so old IDs don't match primitive which reused the slot
+    constexpr uint32 render_primitive_id_SLOT_BITS = 20;
+    constexpr render_primitive_id render_primitive_id_SLOT_MASK = (1u << render_primitive_id_SLOT_BITS) - 1;
+    // Last slot index is not used, so valid ID never equals render_primitive_id_INVALID
+    constexpr int32 render_primitive_id_MAX_SLOTS = static_cast<int32>(render_primitive_id_SLOT_MASK);
+
+    constexpr int32 GetRenderPrimitiveSlot(const render_primitive_id primitiveID) { return static_cast<int32>(primitiveID & render_primitive_id_SLOT_MASK); }
+    constexpr render_primitive_id GetNextRenderPrimitiveGeneration(const render_primitive_id primitiveID)
+    {
+        return primitiveID + (1u << render_primitive_id_SLOT_BITS);
+    }
+}
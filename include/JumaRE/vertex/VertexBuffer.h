@@ -10,7 +10,7 @@
 namespace JumaRenderEngine
 {
     struct RenderOptions;
-    class Material;
+    struct RenderPrimitive;
 
     class VertexBuffer : public RenderEngineAsset
     {
@@ -23,8 +23,9 @@ namespace JumaRenderEngine
         virtual ~VertexBuffer() override;
 
         vertex_id getVertexID() const { return m_VertexID; }
+        uint32 getVertexCount() const { return m_VertexCount; }
 
-        virtual void render(const RenderOptions* renderOptions, Material* material) = 0;
+        virtual void render(const RenderOptions* renderOptions, const RenderPrimitive& primitive) = 0;
 
     protected:
 
@@ -34,6 +35,7 @@ namespace JumaRenderEngine
     private:
 
         vertex_id m_VertexID = vertex_id_NONE;
+        uint32 m_VertexCount = 0;
 
 
         bool init(vertex_id vertexID, const VertexBufferData& data);
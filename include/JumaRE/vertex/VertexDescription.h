@@ -29,10 +29,17 @@ namespace JumaRenderEngine
         return 0;
     }
 
+    enum class VertexComponentInputRate : uint8
+    {
+        Vertex,
+        Instance
+    };
+
     struct VertexComponentDescription
     {
         VertexComponentType type = VertexComponentType::Float;
         uint32 shaderLocation = 0;
+        VertexComponentInputRate inputRate = VertexComponentInputRate::Vertex;
     };
     struct VertexDescription
     {
@@ -78,7 +78,7 @@ namespace JumaRenderEngine
         bool isMainWindowClosed() const { return shouldCloseWindow(getMainWindowID()); }
 
         bool isWindowMinimized(window_id windowID) const;
-        bool isAllWindowsMinimized() const { return static_cast<uint8>(m_CreatedWindowIDs.getSize()) == m_MinimizedWindowsCount; }
+        bool isAllWindowsMinimized() const { return !m_CreatedWindowIDs.isEmpty() && (static_cast<uint8>(m_CreatedWindowIDs.getSize()) == m_MinimizedWindowsCount); }
 
         bool setMainWindowMode(WindowMode windowMode);
         WindowMode getMainWindowMode() const { return m_MainWindowMode; }
@@ -20,6 +20,15 @@ namespace JumaRenderEngine
     }
 
     bool Material_DirectX11::initInternal()
+    {
+        // Instance uses uniform buffers of parent, own buffers are created after it overrides any param
+        if (getUniformDataParent() == nullptr)
+        {
+            createUniformBuffers();
+        }
+        return true;
+    }
+    void Material_DirectX11::createUniformBuffers()
     {
         ID3D11Device* device = getRenderEngine<RenderEngine_DirectX11>()->getDevice();
 
@@ -48,7 +57,6 @@ namespace JumaRenderEngine
                 m_UniformBuffers.add(bufferID, { uniformBuffer, bufferDescription.shaderStages });
             }
         }
-        return true;
     }
 
     void Material_DirectX11::onClearAsset()
@@ -65,9 +73,10 @@ namespace JumaRenderEngine
         m_UniformBuffers.clear();
     }
 
-    bool Material_DirectX11::bindMaterial(const RenderOptions* renderOptions, VertexBuffer_DirectX11* vertexBuffer)
+    bool Material_DirectX11::bindMaterial(const RenderOptions* renderOptions, VertexBuffer_DirectX11* vertexBuffer, 
+        VertexBuffer_DirectX11* instanceBuffer)
     {
-        if (!getShader<Shader_DirectX11>()->bindShader(renderOptions, vertexBuffer))
+        if (!getShader<Shader_DirectX11>()->bindShader(renderOptions, vertexBuffer, instanceBuffer))
         {
             return false;
         }
@@ -117,13 +126,13 @@ namespace JumaRenderEngine
             }
         }
         ID3D11Buffer* emptyBuffer = nullptr;
-        for (const auto& [bufferID, uniformBuffer] : m_UniformBuffers)
+        for (const auto& [bufferID, bufferDescription] : getShader()->getUniformBufferDescriptions())
         {
-            if (uniformBuffer.shaderStages & SHADER_STAGE_VERTEX)
+            if (bufferDescription.shaderStages & SHADER_STAGE_VERTEX)
             {
                 deviceContext->VSSetConstantBuffers(bufferID, 1, &emptyBuffer);
             }
-            if (uniformBuffer.shaderStages & SHADER_STAGE_FRAGMENT)
+            if (bufferDescription.shaderStages & SHADER_STAGE_FRAGMENT)
             {
                 deviceContext->PSSetConstantBuffers(bufferID, 1, &emptyBuffer);
             }
@@ -134,9 +143,15 @@ namespace JumaRenderEngine
     
     void Material_DirectX11::bindUniforms(ID3D11DeviceContext* deviceContext)
     {
-        updateUniformBuffersData(deviceContext);
+        Material_DirectX11* uniformDataParent = getUniformDataParent<Material_DirectX11>();
+        Material_DirectX11* uniformDataOwner = uniformDataParent != nullptr ? uniformDataParent : this;
+        uniformDataOwner->updateUniformBuffersData(deviceContext);
+        if (uniformDataParent != nullptr)
+        {
+            clearParamsForUpdate();
+        }
 
-        for (const auto& [bufferID, uniformBuffer] : m_UniformBuffers)
+        for (const auto& [bufferID, uniformBuffer] : uniformDataOwner->m_UniformBuffers)
         {
             if (uniformBuffer.shaderStages & SHADER_STAGE_VERTEX)
             {
@@ -151,14 +166,12 @@ namespace JumaRenderEngine
         RenderEngine_DirectX11* renderEngine = getRenderEngine<RenderEngine_DirectX11>();
         const Texture_DirectX11* defaultTexture = dynamic_cast<const Texture_DirectX11*>(renderEngine->getDefaultTexture());
         const MaterialParamsStorage& materialParams = getMaterialParams();
-        for (const auto& [uniformID, uniform] : getShader()->getUniforms())
+        const MaterialParamsLayout& paramsLayout = getShader()->getMaterialParamsLayout();
+        for (const auto& paramIndex : paramsLayout.getTextureParamIndices())
         {
-            if (uniform.type != ShaderUniformType::Texture)
-            {
-                continue;
-            }
+            const ShaderUniform& uniform = paramsLayout.getParamUniform(paramIndex);
             ShaderUniformInfo<ShaderUniformType::Texture>::value_type value;
-            if (!materialParams.getValue<ShaderUniformType::Texture>(uniformID, value))
+            if (!materialParams.getValue<ShaderUniformType::Texture>(paramsLayout.getParam(paramIndex), value))
             {
                 continue;
             }
@@ -210,87 +223,43 @@ namespace JumaRenderEngine
     }
     void Material_DirectX11::updateUniformBuffersData(ID3D11DeviceContext* deviceContext)
     {
-        const jset<jstringID>& notUpdatedParams = getNotUpdatedParams();
+        const MaterialParamsMask& notUpdatedParams = getNotUpdatedParams();
         if (notUpdatedParams.isEmpty())
         {
             return;
         }
 
-        jmap<uint32, D3D11_MAPPED_SUBRESOURCE> uniformBuffersData;
-        const jmap<jstringID, ShaderUniform>& uniforms = getShader()->getUniforms();
-        for (const auto& paramName : notUpdatedParams)
+        if (m_UniformBuffers.isEmpty())
         {
-            const ShaderUniform* uniformPtr = uniforms.find(paramName);
-            const uint32 shaderLocation = uniformPtr != nullptr ? uniformPtr->shaderLocation : 0;
-            if ((uniformPtr != nullptr) && !uniformBuffersData.contains(shaderLocation))
-            {
-                const UniformBufferDescription* bufferDescription = m_UniformBuffers.find(shaderLocation);
-                if (bufferDescription != nullptr)
-                {
-                    D3D11_MAPPED_SUBRESOURCE& mappedData = uniformBuffersData.add(shaderLocation);
-                    const HRESULT result = deviceContext->Map(bufferDescription->buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData);
-                    if (FAILED(result))
-                    {
-                        JUTILS_ERROR_LOG(result, JSTR("Failed to map DirectX11 uniform buffer data"));
-                    }
-                }
-            }
+            // Instance overrides params of parent, all params are already marked for update
+            createUniformBuffers();
         }
 
+        const jmap<uint32, ShaderUniformBufferDescription>& uniformBufferDescriptions = getShader()->getUniformBufferDescriptions();
         const MaterialParamsStorage& materialParams = getMaterialParams();
-        for (const auto& [uniformID, uniform] : uniforms)
+        uint64 uploadedBytes = 0;
+        for (const auto& [bufferLocation, uniformBuffer] : m_UniformBuffers)
         {
-            const D3D11_MAPPED_SUBRESOURCE* mappedData = uniformBuffersData.find(uniform.shaderLocation);
-            if (mappedData == nullptr)
+            const ShaderUniformBufferDescription* bufferDescription = uniformBufferDescriptions.find(bufferLocation);
+            const uint8* bufferData = materialParams.getUniformBufferData(bufferLocation);
+            if ((bufferDescription == nullptr) || (bufferData == nullptr) || !isUniformBufferChanged(notUpdatedParams, bufferLocation))
             {
                 continue;
             }
 
-            switch (uniform.type)
+            // Whole buffer is written, discarded data could not be kept
+            D3D11_MAPPED_SUBRESOURCE mappedData;
+            const HRESULT result = deviceContext->Map(uniformBuffer.buffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData);
+            if (FAILED(result))
             {
-            case ShaderUniformType::Float:
-                {
-                    ShaderUniformInfo<ShaderUniformType::Float>::value_type value;
-                    if (materialParams.getValue<ShaderUniformType::Float>(uniformID, value))
-                    {
-                        std::memcpy(static_cast<uint8*>(mappedData->pData) + uniform.shaderBlockOffset, &value, sizeof(value));
-                    }
-                }
-                break;
-            case ShaderUniformType::Vec2:
-                {
-                    ShaderUniformInfo<ShaderUniformType::Vec2>::value_type value;
-                    if (materialParams.getValue<ShaderUniformType::Vec2>(uniformID, value))
-                    {
-                        std::memcpy(static_cast<uint8*>(mappedData->pData) + uniform.shaderBlockOffset, &value[0], sizeof(value));
-                    }
-                }
-                break;
-            case ShaderUniformType::Vec4:
-                {
-                    ShaderUniformInfo<ShaderUniformType::Vec4>::value_type value;
-                    if (materialParams.getValue<ShaderUniformType::Vec4>(uniformID, value))
-                    {
-                        std::memcpy(static_cast<uint8*>(mappedData->pData) + uniform.shaderBlockOffset, &value[0], sizeof(value));
-                    }
-                }
-                break;
-            case ShaderUniformType::Mat4:
-                {
-                    ShaderUniformInfo<ShaderUniformType::Mat4>::value_type value;
-                    if (materialParams.getValue<ShaderUniformType::Mat4>(uniformID, value))
-                    {
-                        std::memcpy(static_cast<uint8*>(mappedData->pData) + uniform.shaderBlockOffset, &value[0][0], sizeof(value));
-                    }
-                }
-                break;
-            default: ;
+                JUTILS_ERROR_LOG(result, JSTR("Failed to map DirectX11 uniform buffer data"));
+                continue;
             }
+            std::memcpy(mappedData.pData, bufferData, bufferDescription->size);
+            deviceContext->Unmap(uniformBuffer.buffer, 0);
+            uploadedBytes += bufferDescription->size;
         }
-        for (const auto& bufferLocation : uniformBuffersData.keys())
-        {
-            deviceContext->Unmap(m_UniformBuffers[bufferLocation].buffer, 0);
-        }
+        getRenderEngine()->addFrameCounter(RenderFrameCounter::UploadedBytes, uploadedBytes);
 
         clearParamsForUpdate();
     }
@@ -22,7 +22,7 @@ namespace JumaRenderEngine
         Material_DirectX11() = default;
         virtual ~Material_DirectX11() override;
 
-        bool bindMaterial(const RenderOptions* renderOptions, VertexBuffer_DirectX11* vertexBuffer);
+        bool bindMaterial(const RenderOptions* renderOptions, VertexBuffer_DirectX11* vertexBuffer, VertexBuffer_DirectX11* instanceBuffer);
         void unbindMaterial(const RenderOptions* renderOptions, VertexBuffer_DirectX11* vertexBuffer);
 
     protected:
@@ -41,6 +41,7 @@ namespace JumaRenderEngine
         jmap<uint32, UniformBufferDescription> m_UniformBuffers;
 
 
+        void createUniformBuffers();
         void clearDirectX();
 
         void bindUniforms(ID3D11DeviceContext* deviceContext);
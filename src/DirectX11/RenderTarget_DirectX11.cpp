@@ -277,8 +277,20 @@ namespace JumaRenderEngine
     }
     void RenderTarget_DirectX11::clearDirectX11()
     {
+        clearReadbackImages();
         clearRenderTarget();
     }
+    void RenderTarget_DirectX11::clearReadbackImages()
+    {
+        for (const auto& readbackImage : m_ReadbackImages)
+        {
+            if (readbackImage.image != nullptr)
+            {
+                readbackImage.image->Release();
+            }
+        }
+        m_ReadbackImages.clear();
+    }
     void RenderTarget_DirectX11::clearRenderTarget()
     {
         if (m_ResultImageView != nullptr)
@@ -361,6 +373,86 @@ namespace JumaRenderEngine
 
         Super::onFinishRender(renderOptions);
     }
+
+    bool RenderTarget_DirectX11::copyToReadbackBuffer(RenderOptions* renderOptions, const int32 bufferIndex, const math::uvector2& offset, 
+        const math::uvector2& size)
+    {
+        ID3D11Texture2D* resultImage = m_ResolveAttachmentImage != nullptr ? m_ResolveAttachmentImage : m_ColorAttachmentImage;
+        if (resultImage == nullptr)
+        {
+            return false;
+        }
+        if (!m_ReadbackImages.isValidIndex(bufferIndex))
+        {
+            m_ReadbackImages.resize(bufferIndex + 1);
+        }
+
+        const RenderEngine_DirectX11* renderEngine = getRenderEngine<RenderEngine_DirectX11>();
+        ReadbackImage& readbackImage = m_ReadbackImages[bufferIndex];
+        if ((readbackImage.image != nullptr) && ((readbackImage.size != size) || (readbackImage.format != getColorFormat())))
+        {
+            readbackImage.image->Release();
+            readbackImage.image = nullptr;
+        }
+        if (readbackImage.image == nullptr)
+        {
+            D3D11_TEXTURE2D_DESC imageDescription{};
+            imageDescription.Width = size.x;
+            imageDescription.Height = size.y;
+            imageDescription.MipLevels = 1;
+            imageDescription.ArraySize = 1;
+            imageDescription.Format = GetDirectXFormatByTextureFormat(getColorFormat());
+            imageDescription.SampleDesc.Count = 1;
+            imageDescription.SampleDesc.Quality = 0;
+            imageDescription.Usage = D3D11_USAGE_STAGING;
+            imageDescription.BindFlags = 0;
+            imageDescription.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+            imageDescription.MiscFlags = 0;
+            const HRESULT result = renderEngine->getDevice()->CreateTexture2D(&imageDescription, nullptr, &readbackImage.image);
+            if (FAILED(result))
+            {
+                JUTILS_ERROR_LOG(result, JSTR("Failed to create DirectX11 readback image"));
+                readbackImage.image = nullptr;
+                return false;
+            }
+            readbackImage.size = size;
+            readbackImage.format = getColorFormat();
+        }
+
+        D3D11_BOX sourceBox;
+        sourceBox.left = offset.x;
+        sourceBox.top = offset.y;
+        sourceBox.front = 0;
+        sourceBox.right = offset.x + size.x;
+        sourceBox.bottom = offset.y + size.y;
+        sourceBox.back = 1;
+        renderEngine->getDeviceContext()->CopySubresourceRegion(readbackImage.image, 0, 0, 0, 0, resultImage, 0, &sourceBox);
+        return true;
+    }
+    bool RenderTarget_DirectX11::mapReadbackBuffer(const int32 bufferIndex, const uint8*& outData, int32& outRowPitch)
+    {
+        D3D11_MAPPED_SUBRESOURCE mappedImage;
+        const HRESULT result = getRenderEngine<RenderEngine_DirectX11>()->getDeviceContext()->Map(
+            m_ReadbackImages[bufferIndex].image, 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &mappedImage
+        );
+        if (result == DXGI_ERROR_WAS_STILL_DRAWING)
+        {
+            return false;
+        }
+        if (FAILED(result))
+        {
+            JUTILS_ERROR_LOG(result, JSTR("Failed to map DirectX11 readback image"));
+            outData = nullptr;
+            return true;
+        }
+        outData = static_cast<const uint8*>(mappedImage.pData);
+        outRowPitch = static_cast<int32>(mappedImage.RowPitch);
+        return true;
+    }
+    void RenderTarget_DirectX11::unmapReadbackBuffer(const int32 bufferIndex)
+    {
+        getRenderEngine<RenderEngine_DirectX11>()->getDeviceContext()->Unmap(m_ReadbackImages[bufferIndex].image, 0);
+    }
 }
 
 #endif
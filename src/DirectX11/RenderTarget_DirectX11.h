@@ -38,8 +38,20 @@ namespace JumaRenderEngine
 
         virtual bool recreateRenderTarget() override;
 
+        virtual bool isReadbackSupported() const override { return true; }
+        virtual bool copyToReadbackBuffer(RenderOptions* renderOptions, int32 bufferIndex, const math::uvector2& offset, const math::uvector2& size) override;
+        virtual bool mapReadbackBuffer(int32 bufferIndex, const uint8*& outData, int32& outRowPitch) override;
+        virtual void unmapReadbackBuffer(int32 bufferIndex) override;
+
     private:
 
+        struct ReadbackImage
+        {
+            ID3D11Texture2D* image = nullptr;
+            math::uvector2 size = { 0, 0 };
+            TextureFormat format = TextureFormat::NONE;
+        };
+
         ID3D11Texture2D* m_ColorAttachmentImage = nullptr;
         ID3D11Texture2D* m_DepthAttachmentImage = nullptr;
         ID3D11Texture2D* m_ResolveAttachmentImage = nullptr;
@@ -47,12 +59,15 @@ namespace JumaRenderEngine
         ID3D11DepthStencilView* m_DepthAttachmentView = nullptr;
         ID3D11ShaderResourceView* m_ResultImageView = nullptr;
 
+        jarray<ReadbackImage> m_ReadbackImages;
+
 
         bool initWindowRenderTarget();
         bool initRenderTarget(ID3D11Texture2D* resultImage);
 
         void clearDirectX11();
         void clearRenderTarget();
+        void clearReadbackImages();
     };
 }
 
@@ -4,6 +4,7 @@
 
 #include "Shader_DirectX11.h"
 
+#include <cstring>
 #include <d3d11.h>
 
 #include "RenderEngine_DirectX11.h"
@@ -102,9 +103,32 @@ namespace JumaRenderEngine
 
         fragmentShaderBlob->Release();
 
+        ID3D11Buffer* primitiveConstantsBuffer = nullptr;
+        if (hasPrimitiveConstants())
+        {
+            static constexpr uint32 mask = 15;
+            D3D11_BUFFER_DESC description{};
+            description.ByteWidth = (getPrimitiveConstants().size + mask) & ~mask;
+            description.Usage = D3D11_USAGE_DYNAMIC;
+            description.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+            description.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+            description.MiscFlags = 0;
+            description.StructureByteStride = description.ByteWidth;
+            result = device->CreateBuffer(&description, nullptr, &primitiveConstantsBuffer);
+            if (FAILED(result))
+            {
+                JUTILS_ERROR_LOG(result, JSTR("Failed to create DirectX11 primitive constants buffer"));
+                fragmentShader->Release();
+                vertexShader->Release();
+                vertexShaderBlob->Release();
+                return false;
+            }
+        }
+
         m_VertexShaderBlob = vertexShaderBlob;
         m_VertexShader = vertexShader;
         m_FragmentShader = fragmentShader;
+        m_PrimitiveConstantsBuffer = primitiveConstantsBuffer;
         return true;
     }
 
@@ -121,6 +145,11 @@ namespace JumaRenderEngine
         }
         m_VertexInputLayouts.clear();
 
+        if (m_PrimitiveConstantsBuffer != nullptr)
+        {
+            m_PrimitiveConstantsBuffer->Release();
+            m_PrimitiveConstantsBuffer = nullptr;
+        }
         if (m_FragmentShader != nullptr)
         {
             m_FragmentShader->Release();
@@ -138,9 +167,10 @@ namespace JumaRenderEngine
         }
     }
 
-    ID3D11InputLayout* Shader_DirectX11::getVertexInputLayout(const vertex_id vertexID)
+    ID3D11InputLayout* Shader_DirectX11::getVertexInputLayout(const vertex_id vertexID, const vertex_id instanceVertexID)
     {
-        ID3D11InputLayout** existingInputLayoutPtr = m_VertexInputLayouts.find(vertexID);
+        const uint32 inputLayoutID = (static_cast<uint32>(instanceVertexID) << 16) | vertexID;
+        ID3D11InputLayout** existingInputLayoutPtr = m_VertexInputLayouts.find(inputLayoutID);
         if (existingInputLayoutPtr != nullptr)
         {
             return *existingInputLayoutPtr;
@@ -156,30 +186,47 @@ namespace JumaRenderEngine
         {
             return nullptr;
         }
+        const RegisteredVertexDescription* instanceDescription = nullptr;
+        if (instanceVertexID != vertex_id_NONE)
+        {
+            instanceDescription = renderEngine->findVertex(instanceVertexID);
+            if (instanceDescription == nullptr)
+            {
+                return nullptr;
+            }
+        }
 
-        uint32 componentOffset = 0;
-        jarray<jstring> semanticNames;
         jarray<D3D11_INPUT_ELEMENT_DESC> vertexLayoutDescriptions;
-        vertexLayoutDescriptions.reserve(vertexDescription->description.components.getSize());
-        for (const auto& componentID : vertexDescription->description.components)
+        for (const RegisteredVertexDescription* description : { vertexDescription, instanceDescription })
         {
-            const VertexComponentDescription* componentDescription = renderEngine->findVertexComponent(componentID);
-            DXGI_FORMAT componentFormat;
-            switch (componentDescription->type)
+            if (description == nullptr)
             {
-            case VertexComponentType::Float: componentFormat = DXGI_FORMAT_R32_FLOAT; break;
-            case VertexComponentType::Vec2: componentFormat = DXGI_FORMAT_R32G32_FLOAT; break;
-            case VertexComponentType::Vec3: componentFormat = DXGI_FORMAT_R32G32B32_FLOAT; break;
-            case VertexComponentType::Vec4: componentFormat = DXGI_FORMAT_R32G32B32A32_FLOAT; break;
-            default: 
-                JUTILS_LOG(error, JSTR("Unsupported vertex component type!"));
                 continue;
             }
 
-            vertexLayoutDescriptions.add({
-                JSTR("TEXCOORD"), componentDescription->shaderLocation, componentFormat, 0, componentOffset, D3D11_INPUT_PER_VERTEX_DATA, 0
-            });
-            componentOffset += GetVertexComponentSize(componentDescription->type);
+            const bool instanceData = description->inputRate == VertexComponentInputRate::Instance;
+            uint32 componentOffset = 0;
+            for (const auto& componentID : description->description.components)
+            {
+                const VertexComponentDescription* componentDescription = renderEngine->findVertexComponent(componentID);
+                DXGI_FORMAT componentFormat;
+                switch (componentDescription->type)
+                {
+                case VertexComponentType::Float: componentFormat = DXGI_FORMAT_R32_FLOAT; break;
+                case VertexComponentType::Vec2: componentFormat = DXGI_FORMAT_R32G32_FLOAT; break;
+                case VertexComponentType::Vec3: componentFormat = DXGI_FORMAT_R32G32B32_FLOAT; break;
+                case VertexComponentType::Vec4: componentFormat = DXGI_FORMAT_R32G32B32A32_FLOAT; break;
+                default: 
+                    JUTILS_LOG(error, JSTR("Unsupported vertex component type!"));
+                    continue;
+                }
+
+                vertexLayoutDescriptions.add({
+                    JSTR("TEXCOORD"), componentDescription->shaderLocation, componentFormat, instanceData ? 1u : 0u, componentOffset, 
+                    instanceData ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA, instanceData ? 1u : 0u
+                });
+                componentOffset += GetVertexComponentSize(componentDescription->type);
+            }
         }
 
         ID3D11InputLayout* inputLayout = nullptr;
@@ -193,12 +240,15 @@ namespace JumaRenderEngine
             JUTILS_ERROR_LOG(result, JSTR("Failed to create DirectX11 input layout for vertex {}"), vertexID);
             return nullptr;
         }
-        return m_VertexInputLayouts.add(vertexID, inputLayout);
+        return m_VertexInputLayouts.add(inputLayoutID, inputLayout);
     }
 
-    bool Shader_DirectX11::bindShader(const RenderOptions* renderOptions, VertexBuffer_DirectX11* vertexBuffer)
+    bool Shader_DirectX11::bindShader(const RenderOptions* renderOptions, VertexBuffer_DirectX11* vertexBuffer, 
+        VertexBuffer_DirectX11* instanceBuffer)
     {
-        ID3D11InputLayout* inputLayout = getVertexInputLayout(vertexBuffer->getVertexID());
+        ID3D11InputLayout* inputLayout = getVertexInputLayout(
+            vertexBuffer->getVertexID(), instanceBuffer != nullptr ? instanceBuffer->getVertexID() : vertex_id_NONE
+        );
         if (inputLayout == nullptr)
         {
             return false;
@@ -208,11 +258,54 @@ namespace JumaRenderEngine
         deviceContext->VSSetShader(m_VertexShader, nullptr, 0);
         deviceContext->PSSetShader(m_FragmentShader, nullptr, 0);
         deviceContext->IASetInputLayout(inputLayout);
+        getRenderEngine()->addFrameCounter(RenderFrameCounter::StateChanges);
         return true;
     }
+    void Shader_DirectX11::bindPrimitiveConstants(const void* data) const
+    {
+        if (m_PrimitiveConstantsBuffer == nullptr)
+        {
+            return;
+        }
+
+        ID3D11DeviceContext* deviceContext = getRenderEngine<RenderEngine_DirectX11>()->getDeviceContext();
+        const ShaderPrimitiveConstants& primitiveConstants = getPrimitiveConstants();
+        D3D11_MAPPED_SUBRESOURCE mappedData;
+        const HRESULT result = deviceContext->Map(m_PrimitiveConstantsBuffer, 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedData);
+        if (FAILED(result))
+        {
+            JUTILS_ERROR_LOG(result, JSTR("Failed to map DirectX11 primitive constants buffer"));
+            return;
+        }
+        std::memcpy(mappedData.pData, data, primitiveConstants.size);
+        deviceContext->Unmap(m_PrimitiveConstantsBuffer, 0);
+
+        if (primitiveConstants.shaderStages & SHADER_STAGE_VERTEX)
+        {
+            deviceContext->VSSetConstantBuffers(primitiveConstants.shaderLocation, 1, &m_PrimitiveConstantsBuffer);
+        }
+        if (primitiveConstants.shaderStages & SHADER_STAGE_FRAGMENT)
+        {
+            deviceContext->PSSetConstantBuffers(primitiveConstants.shaderLocation, 1, &m_PrimitiveConstantsBuffer);
+        }
+        getRenderEngine()->addFrameCounter(RenderFrameCounter::UploadedBytes, primitiveConstants.size);
+    }
     void Shader_DirectX11::unbindShader(const RenderOptions* renderOptions, VertexBuffer_DirectX11* vertexBuffer)
     {
         ID3D11DeviceContext* deviceContext = getRenderEngine<RenderEngine_DirectX11>()->getDeviceContext();
+        if (m_PrimitiveConstantsBuffer != nullptr)
+        {
+            const ShaderPrimitiveConstants& primitiveConstants = getPrimitiveConstants();
+            ID3D11Buffer* emptyBuffer = nullptr;
+            if (primitiveConstants.shaderStages & SHADER_STAGE_VERTEX)
+            {
+                deviceContext->VSSetConstantBuffers(primitiveConstants.shaderLocation, 1, &emptyBuffer);
+            }
+            if (primitiveConstants.shaderStages & SHADER_STAGE_FRAGMENT)
+            {
+                deviceContext->PSSetConstantBuffers(primitiveConstants.shaderLocation, 1, &emptyBuffer);
+            }
+        }
         deviceContext->IASetInputLayout(nullptr);
         deviceContext->PSSetShader(nullptr, nullptr, 0);
         deviceContext->VSSetShader(nullptr, nullptr, 0);
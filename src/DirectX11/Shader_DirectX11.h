@@ -13,6 +13,7 @@
 struct ID3D11VertexShader;
 struct ID3D11PixelShader;
 struct ID3D11InputLayout;
+struct ID3D11Buffer;
 
 namespace JumaRenderEngine
 {
@@ -27,8 +28,9 @@ namespace JumaRenderEngine
         Shader_DirectX11() = default;
         virtual ~Shader_DirectX11() override;
 
-        bool bindShader(const RenderOptions* renderOptions, VertexBuffer_DirectX11* vertexBuffer);
+        bool bindShader(const RenderOptions* renderOptions, VertexBuffer_DirectX11* vertexBuffer, VertexBuffer_DirectX11* instanceBuffer);
         void unbindShader(const RenderOptions* renderOptions, VertexBuffer_DirectX11* vertexBuffer);
+        void bindPrimitiveConstants(const void* data) const;
 
     protected:
 
@@ -40,13 +42,15 @@ namespace JumaRenderEngine
         ID3DBlob* m_VertexShaderBlob = nullptr;
         ID3D11VertexShader* m_VertexShader = nullptr;
         ID3D11PixelShader* m_FragmentShader = nullptr;
+        ID3D11Buffer* m_PrimitiveConstantsBuffer = nullptr;
 
-        jmap<vertex_id, ID3D11InputLayout*> m_VertexInputLayouts;
+        // Key is a pair of vertex and instance vertex IDs
+        jmap<uint32, ID3D11InputLayout*> m_VertexInputLayouts;
 
 
         void clearDirectX();
         
-        ID3D11InputLayout* getVertexInputLayout(vertex_id vertexID);
+        ID3D11InputLayout* getVertexInputLayout(vertex_id vertexID, vertex_id instanceVertexID);
     };
 }
 
@@ -8,6 +8,8 @@
 
 #include "Material_DirectX11.h"
 #include "RenderEngine_DirectX11.h"
+#include "Shader_DirectX11.h"
+#include "JumaRE/RenderPrimitivesList.h"
 #include "JumaRE/vertex/VertexBufferData.h"
 
 namespace JumaRenderEngine
@@ -99,23 +101,38 @@ namespace JumaRenderEngine
         m_VertexSize = 0;
     }
 
-    void VertexBuffer_DirectX11::render(const RenderOptions* renderOptions, Material* material)
+    void VertexBuffer_DirectX11::render(const RenderOptions* renderOptions, const RenderPrimitive& primitive)
     {
-        Material_DirectX11* materialDirectX = dynamic_cast<Material_DirectX11*>(material);
-        if ((materialDirectX == nullptr) || !materialDirectX->bindMaterial(renderOptions, this))
+        VertexBuffer_DirectX11* instanceBuffer = dynamic_cast<VertexBuffer_DirectX11*>(primitive.instanceBuffer);
+        Material_DirectX11* materialDirectX = dynamic_cast<Material_DirectX11*>(primitive.material);
+        if ((materialDirectX == nullptr) || !materialDirectX->bindMaterial(renderOptions, this, instanceBuffer))
         {
             return;
         }
 
         ID3D11DeviceContext* deviceContext = getRenderEngine<RenderEngine_DirectX11>()->getDeviceContext();
+        dynamic_cast<const Shader_DirectX11*>(materialDirectX->getShader())->bindPrimitiveConstants(GetRenderPrimitiveConstants(primitive));
 
-        static constexpr UINT vertexOffet = 0;
-        deviceContext->IASetVertexBuffers(0, 1, &m_VertexBuffer, &m_VertexSize, &vertexOffet);
+        ID3D11Buffer* const vertexBuffers[2] = { m_VertexBuffer, instanceBuffer != nullptr ? instanceBuffer->getDirectXVertexBuffer() : nullptr };
+        const UINT vertexSizes[2] = { m_VertexSize, instanceBuffer != nullptr ? instanceBuffer->getVertexSize() : 0 };
+        static constexpr UINT vertexOffets[2] = { 0, 0 };
+        deviceContext->IASetVertexBuffers(0, instanceBuffer != nullptr ? 2 : 1, vertexBuffers, vertexSizes, vertexOffets);
         deviceContext->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
         if (m_IndexBuffer != nullptr)
         {
             deviceContext->IASetIndexBuffer(m_IndexBuffer, DXGI_FORMAT_R32_UINT, 0);
-            deviceContext->DrawIndexed(m_RenderElementsCount, 0, 0);
+            if (primitive.instanceCount > 1)
+            {
+                deviceContext->DrawIndexedInstanced(m_RenderElementsCount, primitive.instanceCount, 0, 0, 0);
+            }
+            else
+            {
+                deviceContext->DrawIndexed(m_RenderElementsCount, 0, 0);
+            }
+        }
+        else if (primitive.instanceCount > 1)
+        {
+            deviceContext->DrawInstanced(m_RenderElementsCount, primitive.instanceCount, 0, 0);
         }
         else
         {
@@ -123,6 +140,7 @@ namespace JumaRenderEngine
         }
 
         materialDirectX->unbindMaterial(renderOptions, this);
+        getRenderEngine()->addFrameCounter(RenderFrameCounter::DrawCalls);
     }
 }
 
@@ -18,7 +18,10 @@ namespace JumaRenderEngine
         VertexBuffer_DirectX11() = default;
         virtual ~VertexBuffer_DirectX11() override;
 
-        virtual void render(const RenderOptions* renderOptions, Material* material) override;
+        ID3D11Buffer* getDirectXVertexBuffer() const { return m_VertexBuffer; }
+        uint32 getVertexSize() const { return m_VertexSize; }
+
+        virtual void render(const RenderOptions* renderOptions, const RenderPrimitive& primitive) override;
 
     protected:
 
@@ -175,6 +175,53 @@ namespace JumaRenderEngine
         return true;
     }
 
+    bool DirectX12Buffer::initReadback(const uint32 size)
+    {
+        if (isValid())
+        {
+            JUTILS_LOG(error, JSTR("DirectX12 buffer already initialized"));
+            return false;
+        }
+        if (size == 0)
+        {
+            JUTILS_LOG(error, JSTR("Size param is zero"));
+            return false;
+        }
+
+        const RenderEngine_DirectX12* renderEngine = getRenderEngine<RenderEngine_DirectX12>();
+
+        D3D12_RESOURCE_DESC resourceDescription{};
+        resourceDescription.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+        resourceDescription.Alignment = 0;
+        resourceDescription.Width = size;
+        resourceDescription.Height = 1;
+        resourceDescription.DepthOrArraySize = 1;
+        resourceDescription.MipLevels = 1;
+        resourceDescription.Format = DXGI_FORMAT_UNKNOWN;
+        resourceDescription.SampleDesc.Count = 1;
+        resourceDescription.SampleDesc.Quality = 0;
+        resourceDescription.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+        resourceDescription.Flags = D3D12_RESOURCE_FLAG_NONE;
+        D3D12MA::ALLOCATION_DESC allocationDescription{};
+        allocationDescription.HeapType = D3D12_HEAP_TYPE_READBACK;
+        const HRESULT result = renderEngine->getResourceAllocator()->CreateResource(
+            &allocationDescription, &resourceDescription, 
+            D3D12_RESOURCE_STATE_COPY_DEST, nullptr, 
+            &m_Allocation, IID_PPV_ARGS(&m_Buffer)
+        );
+        if (FAILED(result))
+        {
+            JUTILS_ERROR_LOG(result, JSTR("Failed to create readback DirectX12 buffer"));
+            return false;
+        }
+
+        m_BufferSize = size;
+        m_BufferState = D3D12_RESOURCE_STATE_COPY_DEST;
+        m_Mapable = true;
+        markAsInitialized();
+        return true;
+    }
+
     void DirectX12Buffer::clearDirectX()
     {
         m_MappedData = nullptr;
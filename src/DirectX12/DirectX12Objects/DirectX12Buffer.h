@@ -24,6 +24,8 @@ namespace JumaRenderEngine
         bool initGPU(uint32 size, const void* data, D3D12_RESOURCE_STATES bufferState);
         // GPU buffer, frequently writing from CPU. GPU with staging buffer
         bool initAccessedGPU(uint32 size, D3D12_RESOURCE_STATES bufferState);
+        // Temp buffer for reading data from GPU
+        bool initReadback(uint32 size);
 
         ID3D12Resource* get() const { return m_Buffer; }
         uint32 getSize() const { return m_BufferSize; }
@@ -19,6 +19,11 @@ namespace JumaRenderEngine
     }
 
     bool Material_DirectX12::initInternal()
+    {
+        // Instance uses render data of parent, own data is created after it overrides any param
+        return (getRenderDataParent() != nullptr) || createMaterialData();
+    }
+    bool Material_DirectX12::createMaterialData()
     {
         const Shader_DirectX12* shader = getShader<Shader_DirectX12>();
         const jmap<jstringID, uint32>& descriptorHeapOffsets = shader->getTextureDescriptorHeapOffsets();
@@ -70,6 +75,7 @@ namespace JumaRenderEngine
         m_UniformBuffers = std::move(buffers);
         m_TextureDescriptorHeap = textureDescriptorHeap;
         m_SamplerDescriptorHeap = samplerDescriptorHeap;
+        m_MaterialDataCreated = true;
         return true;
     }
 
@@ -100,20 +106,28 @@ namespace JumaRenderEngine
             m_TextureDescriptorHeap->Release();
             m_TextureDescriptorHeap = nullptr;
         }
+        m_MaterialDataCreated = false;
     }
 
-    bool Material_DirectX12::bindMaterial(const RenderOptions_DirectX12* renderOptions, VertexBuffer_DirectX12* vertexBuffer)
+    bool Material_DirectX12::bindMaterial(const RenderOptions_DirectX12* renderOptions, VertexBuffer_DirectX12* vertexBuffer, 
+        VertexBuffer_DirectX12* instanceBuffer)
     {
-        if (!updateUniformData())
+        Material_DirectX12* renderDataParent = getRenderDataParent<Material_DirectX12>();
+        Material_DirectX12* renderDataOwner = renderDataParent != nullptr ? renderDataParent : this;
+        if (!renderDataOwner->updateUniformData())
         {
             return false;
         }
+        if (renderDataParent != nullptr)
+        {
+            clearParamsForUpdate();
+        }
 
         MaterialProperties properties = getMaterialProperties();
         properties.depthEnabled &= renderOptions->renderTarget->isDepthEnabled() && renderOptions->renderStageProperties.depthEnabled;
 
         Shader_DirectX12* shader = getShader<Shader_DirectX12>();
-        if (!shader->bindShader(renderOptions, vertexBuffer, properties))
+        if (!shader->bindShader(renderOptions, vertexBuffer, instanceBuffer, properties))
         {
             return false;
         }
@@ -121,28 +135,33 @@ namespace JumaRenderEngine
         ID3D12GraphicsCommandList2* commandList = renderOptions->renderCommandList->get();
         for (const auto& [bufferIndex, bufferLocation] : shader->getUniformBufferParamIndices())
         {
-            commandList->SetGraphicsRootConstantBufferView(bufferIndex, m_UniformBuffers[bufferLocation]->get()->GetGPUVirtualAddress());
+            commandList->SetGraphicsRootConstantBufferView(bufferIndex, renderDataOwner->m_UniformBuffers[bufferLocation]->get()->GetGPUVirtualAddress());
         }
 
-        if (m_TextureDescriptorHeap != nullptr)
+        if (renderDataOwner->m_TextureDescriptorHeap != nullptr)
         {
-            const uint32 paramIndex = static_cast<uint32>(m_UniformBuffers.getSize());
+            const uint32 paramIndex = static_cast<uint32>(renderDataOwner->m_UniformBuffers.getSize());
 
-            ID3D12DescriptorHeap* const descriptorHeaps[2] = { m_TextureDescriptorHeap, m_SamplerDescriptorHeap };
+            ID3D12DescriptorHeap* const descriptorHeaps[2] = { renderDataOwner->m_TextureDescriptorHeap, renderDataOwner->m_SamplerDescriptorHeap };
             commandList->SetDescriptorHeaps(2, descriptorHeaps);
-            commandList->SetGraphicsRootDescriptorTable(paramIndex, m_TextureDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
-            commandList->SetGraphicsRootDescriptorTable(paramIndex + 1, m_SamplerDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+            commandList->SetGraphicsRootDescriptorTable(paramIndex, renderDataOwner->m_TextureDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
+            commandList->SetGraphicsRootDescriptorTable(paramIndex + 1, renderDataOwner->m_SamplerDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
         }
         return true;
     }
 
     bool Material_DirectX12::updateUniformData()
     {
-        const jset<jstringID>& notUpdatedParams = getNotUpdatedParams();
+        const MaterialParamsMask& notUpdatedParams = getNotUpdatedParams();
         if (notUpdatedParams.isEmpty())
         {
             return true;
         }
+        // Instance overrides params of parent, all params are already marked for update
+        if (!m_MaterialDataCreated && !createMaterialData())
+        {
+            return false;
+        }
 
         const RenderEngine_DirectX12* renderEngine = getRenderEngine<RenderEngine_DirectX12>();
         ID3D12Device2* device = renderEngine->getDevice();
@@ -151,21 +170,18 @@ namespace JumaRenderEngine
         const Shader_DirectX12* shader = getShader<Shader_DirectX12>();
         const jmap<jstringID, uint32>& descriptorHeapOffsets = shader->getTextureDescriptorHeapOffsets();
         const MaterialParamsStorage& params = getMaterialParams();
-        const jmap<jstringID, ShaderUniform>& uniforms = getShader()->getUniforms();
+        const MaterialParamsLayout& paramsLayout = shader->getMaterialParamsLayout();
 
-        for (const auto& paramName : notUpdatedParams)
+        uint64 uploadedBytes = 0;
+        uint64 descriptorUpdates = 0;
+        for (const auto& paramIndex : notUpdatedParams)
         {
-            const ShaderUniform* uniformPtr = uniforms.find(paramName);
-            if (uniformPtr == nullptr)
-            {
-                continue;
-            }
-            const ShaderUniform& uniform = *uniformPtr;
-
+            const ShaderUniform& uniform = paramsLayout.getParamUniform(paramIndex);
             if (uniform.type == ShaderUniformType::Texture)
             {
+                const jstringID& paramName = paramsLayout.getParamName(paramIndex);
                 ShaderUniformInfo<ShaderUniformType::Texture>::value_type value;
-                if (params.getValue<ShaderUniformType::Texture>(paramName, value))
+                if (params.getValue<ShaderUniformType::Texture>(paramsLayout.getParam(paramIndex), value))
                 {
                     const uint32* descriptorHeapIndex = descriptorHeapOffsets.find(paramName);
                     if (descriptorHeapIndex == nullptr)
@@ -212,59 +228,24 @@ namespace JumaRenderEngine
                         m_SamplerDescriptorHeap, *descriptorHeapIndex
                     );
                     device->CopyDescriptorsSimple(1, dstSamplerDescriptor, srcSamplerDescriptor, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+                    descriptorUpdates++;
                 }
             }
-            else
+        }
+        for (const auto& [bufferLocation, buffer] : m_UniformBuffers)
+        {
+            const uint8* bufferData = params.getUniformBufferData(bufferLocation);
+            if ((bufferData == nullptr) || !isUniformBufferChanged(notUpdatedParams, bufferLocation))
             {
-                DirectX12Buffer* buffer = m_UniformBuffers[uniform.shaderLocation];
-                switch (uniform.type)
-                {
-                case ShaderUniformType::Float:
-                    {
-                        ShaderUniformInfo<ShaderUniformType::Float>::value_type value;
-                        if (params.getValue<ShaderUniformType::Float>(paramName, value))
-                        {
-                            buffer->initMappedData();
-                            buffer->setMappedData(&value, sizeof(value), uniform.shaderBlockOffset);
-                        }
-                    }
-                    break;
-                case ShaderUniformType::Vec2:
-                    {
-                        ShaderUniformInfo<ShaderUniformType::Vec2>::value_type value;
-                        if (params.getValue<ShaderUniformType::Vec2>(paramName, value))
-                        {
-                            buffer->initMappedData();
-                            buffer->setMappedData(&value, sizeof(value), uniform.shaderBlockOffset);
-                        }
-                    }
-                    break;
-                case ShaderUniformType::Vec4:
-                    {
-                        ShaderUniformInfo<ShaderUniformType::Vec4>::value_type value;
-                        if (params.getValue<ShaderUniformType::Vec4>(paramName, value))
-                        {
-                            buffer->initMappedData();
-                            buffer->setMappedData(&value, sizeof(value), uniform.shaderBlockOffset);
-                        }
-                    }
-                    break;
-                case ShaderUniformType::Mat4:
-                    {
-                        ShaderUniformInfo<ShaderUniformType::Mat4>::value_type value;
-                        if (params.getValue<ShaderUniformType::Mat4>(paramName, value))
-                        {
-                            buffer->initMappedData();
-                            buffer->setMappedData(&value, sizeof(value), uniform.shaderBlockOffset);
-                        }
-                    }
-                    break;
-
-                default: ;
-                }
+                continue;
             }
+            buffer->initMappedData();
+            buffer->setMappedData(bufferData, buffer->getSize(), 0);
+            uploadedBytes += buffer->getSize();
         }
         clearParamsForUpdate();
+        getRenderEngine()->addFrameCounter(RenderFrameCounter::UploadedBytes, uploadedBytes);
+        getRenderEngine()->addFrameCounter(RenderFrameCounter::DescriptorUpdates, descriptorUpdates);
 
         DirectX12CommandQueue* commandQueue = renderEngine->getCommandQueue(D3D12_COMMAND_LIST_TYPE_COMPUTE);
         DirectX12CommandList* commandList = commandQueue->getCommandList();
@@ -22,7 +22,7 @@ namespace JumaRenderEngine
         Material_DirectX12() = default;
         virtual ~Material_DirectX12() override;
 
-        bool bindMaterial(const RenderOptions_DirectX12* renderOptions, VertexBuffer_DirectX12* vertexBuffer);
+        bool bindMaterial(const RenderOptions_DirectX12* renderOptions, VertexBuffer_DirectX12* vertexBuffer, VertexBuffer_DirectX12* instanceBuffer);
         void unbindMaterial(const RenderOptions_DirectX12* renderOptions, VertexBuffer_DirectX12* vertexBuffer) {}
 
     protected:
@@ -35,8 +35,10 @@ namespace JumaRenderEngine
         jmap<uint32, DirectX12Buffer*> m_UniformBuffers;
         ID3D12DescriptorHeap* m_TextureDescriptorHeap = nullptr;
         ID3D12DescriptorHeap* m_SamplerDescriptorHeap = nullptr;
+        bool m_MaterialDataCreated = false;
 
 
+        bool createMaterialData();
         void clearDirectX();
 
         bool updateUniformData();
@@ -6,6 +6,8 @@
 
 #include "RenderEngine_DirectX12.h"
 #include "RenderOptions_DirectX12.h"
+#include "DirectX12Objects/DirectX12Buffer.h"
+#include "DirectX12Objects/DirectX12CommandList.h"
 #include "DirectX12Objects/DirectX12MipGenerator.h"
 #include "DirectX12Objects/DirectX12Swapchain.h"
 #include "DirectX12Objects/DirectX12Texture.h"
@@ -273,8 +275,21 @@ namespace JumaRenderEngine
     }
     void RenderTarget_DirectX12::clearDirectX()
     {
+        clearReadbackBuffers();
         clearRenderTarget();
     }
+    void RenderTarget_DirectX12::clearReadbackBuffers()
+    {
+        RenderEngine_DirectX12* renderEngine = getRenderEngine<RenderEngine_DirectX12>();
+        for (const auto& readbackBuffer : m_ReadbackBuffers)
+        {
+            if (readbackBuffer.buffer != nullptr)
+            {
+                renderEngine->returnBuffer(readbackBuffer.buffer);
+            }
+        }
+        m_ReadbackBuffers.clear();
+    }
     void RenderTarget_DirectX12::clearRenderTarget()
     {
         clearMipGeneratorTarget();
@@ -464,6 +479,80 @@ namespace JumaRenderEngine
 
         Super::onFinishRender(renderOptions);
     }
+
+    bool RenderTarget_DirectX12::copyToReadbackBuffer(RenderOptions* renderOptions, const int32 bufferIndex, const math::uvector2& offset, 
+        const math::uvector2& size)
+    {
+        DirectX12Texture* resultTexture = getMipGeneratorTargetTexture();
+        if (resultTexture == nullptr)
+        {
+            return false;
+        }
+        if (!m_ReadbackBuffers.isValidIndex(bufferIndex))
+        {
+            m_ReadbackBuffers.resize(bufferIndex + 1);
+        }
+
+        // Buffer is reused only after previous readback from it is finished
+        RenderEngine_DirectX12* renderEngine = getRenderEngine<RenderEngine_DirectX12>();
+        ReadbackBuffer& readbackBuffer = m_ReadbackBuffers[bufferIndex];
+        const uint32 rowPitch = (size.x * 4 + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+        const uint32 dataSize = rowPitch * size.y;
+        if ((readbackBuffer.buffer != nullptr) && (readbackBuffer.buffer->getSize() < dataSize))
+        {
+            renderEngine->returnBuffer(readbackBuffer.buffer);
+            readbackBuffer.buffer = nullptr;
+        }
+        if (readbackBuffer.buffer == nullptr)
+        {
+            DirectX12Buffer* buffer = renderEngine->getBuffer();
+            if (!buffer->initReadback(dataSize))
+            {
+                JUTILS_LOG(error, JSTR("Failed to create DirectX12 readback buffer"));
+                renderEngine->returnBuffer(buffer);
+                return false;
+            }
+            readbackBuffer.buffer = buffer;
+        }
+        readbackBuffer.rowPitch = rowPitch;
+
+        D3D12_TEXTURE_COPY_LOCATION sourceLocation{};
+        sourceLocation.pResource = resultTexture->getResource();
+        sourceLocation.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        sourceLocation.SubresourceIndex = 0;
+        D3D12_TEXTURE_COPY_LOCATION destinationLocation{};
+        destinationLocation.pResource = readbackBuffer.buffer->get();
+        destinationLocation.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+        destinationLocation.PlacedFootprint.Offset = 0;
+        destinationLocation.PlacedFootprint.Footprint.Format = resultTexture->getFormat();
+        destinationLocation.PlacedFootprint.Footprint.Width = size.x;
+        destinationLocation.PlacedFootprint.Footprint.Height = size.y;
+        destinationLocation.PlacedFootprint.Footprint.Depth = 1;
+        destinationLocation.PlacedFootprint.Footprint.RowPitch = rowPitch;
+        D3D12_BOX sourceBox;
+        sourceBox.left = offset.x;
+        sourceBox.top = offset.y;
+        sourceBox.front = 0;
+        sourceBox.right = offset.x + size.x;
+        sourceBox.bottom = offset.y + size.y;
+        sourceBox.back = 1;
+
+        DirectX12CommandList* commandListObject = reinterpret_cast<RenderOptions_DirectX12*>(renderOptions)->renderCommandList;
+        commandListObject->changeTextureState(resultTexture, D3D12_RESOURCE_STATE_COPY_SOURCE, 0);
+        commandListObject->applyStateChanges();
+        commandListObject->get()->CopyTextureRegion(&destinationLocation, 0, 0, 0, &sourceLocation, &sourceBox);
+        commandListObject->changeTextureState(resultTexture, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 0);
+        commandListObject->applyStateChanges();
+        return true;
+    }
+    bool RenderTarget_DirectX12::mapReadbackBuffer(const int32 bufferIndex, const uint8*& outData, int32& outRowPitch)
+    {
+        // Frame of the copy is already finished at this point, buffer stays mapped until it's destroyed
+        const ReadbackBuffer& readbackBuffer = m_ReadbackBuffers[bufferIndex];
+        outData = readbackBuffer.buffer->initMappedData() ? static_cast<const uint8*>(readbackBuffer.buffer->getMappedData(0)) : nullptr;
+        outRowPitch = static_cast<int32>(readbackBuffer.rowPitch);
+        return true;
+    }
 }
 
 #endif
@@ -12,6 +12,7 @@
 
 namespace JumaRenderEngine
 {
+    class DirectX12Buffer;
     class DirectX12Swapchain;
     class DirectX12Texture;
 
@@ -46,8 +47,18 @@ namespace JumaRenderEngine
 
         virtual bool recreateRenderTarget() override;
 
+        virtual bool isReadbackSupported() const override { return true; }
+        virtual bool copyToReadbackBuffer(RenderOptions* renderOptions, int32 bufferIndex, const math::uvector2& offset, const math::uvector2& size) override;
+        virtual bool mapReadbackBuffer(int32 bufferIndex, const uint8*& outData, int32& outRowPitch) override;
+
     private:
 
+        struct ReadbackBuffer
+        {
+            DirectX12Buffer* buffer = nullptr;
+            uint32 rowPitch = 0;
+        };
+
         DirectX12Texture* m_ColorTexture = nullptr;
         jarray<DirectX12Texture*> m_ResultTextures;
         ID3D12DescriptorHeap* m_DescriptorHeapRTV = nullptr;
@@ -56,12 +67,15 @@ namespace JumaRenderEngine
         DirectX12Texture* m_DepthTexture = nullptr;
         ID3D12DescriptorHeap* m_DescriptorHeapDSV = nullptr;
 
+        jarray<ReadbackBuffer> m_ReadbackBuffers;
+
 
         bool initWindowRenderTarget();
         bool initRenderTarget();
 
         void clearDirectX();
         void clearRenderTarget();
+        void clearReadbackBuffers();
     };
 }
 
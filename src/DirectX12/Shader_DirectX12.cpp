@@ -88,8 +88,8 @@ namespace JumaRenderEngine
         return fragmentShaderVisible ? D3D12_SHADER_VISIBILITY_PIXEL : D3D12_SHADER_VISIBILITY_VERTEX;
     }
     ID3DBlob* CreateDirectX12RootSignatureBlob(const jmap<uint32, ShaderUniformBufferDescription>& uniformBuffers, 
-        const jmap<jstringID, ShaderUniform>& uniforms, jmap<uint32, uint32>& outBufferParamIndices, 
-        jmap<jstringID, uint32>& outDescriptorHeapOffsets)
+        const jmap<jstringID, ShaderUniform>& uniforms, const ShaderPrimitiveConstants& primitiveConstants, 
+        jmap<uint32, uint32>& outBufferParamIndices, jmap<jstringID, uint32>& outDescriptorHeapOffsets, int32& outPrimitiveConstantsParamIndex)
     {
         ID3DBlob* resultBlob = nullptr;
         HRESULT result = 0;
@@ -149,6 +149,17 @@ namespace JumaRenderEngine
                 samplerParameter.DescriptorTable.NumDescriptorRanges = samplerDescriptorRanges.getSize();
                 samplerParameter.DescriptorTable.pDescriptorRanges = samplerDescriptorRanges.getData();
             }
+            if (primitiveConstants.size > 0)
+            {
+                outPrimitiveConstantsParamIndex = rootSignatureParams.getSize();
+
+                D3D12_ROOT_PARAMETER1& constantsParameter = rootSignatureParams.addDefault();
+                constantsParameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+                constantsParameter.ShaderVisibility = GetDirectX12ShaderParamVisibility(primitiveConstants.shaderStages);
+                constantsParameter.Constants.ShaderRegister = primitiveConstants.shaderLocation;
+                constantsParameter.Constants.RegisterSpace = 0;
+                constantsParameter.Constants.Num32BitValues = primitiveConstants.size / sizeof(uint32);
+            }
 
             D3D12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDescription{};
             rootSignatureDescription.Version = D3D_ROOT_SIGNATURE_VERSION_1_1;
@@ -215,6 +226,17 @@ namespace JumaRenderEngine
                 samplerParameter.DescriptorTable.NumDescriptorRanges = samplerDescriptorRanges.getSize();
                 samplerParameter.DescriptorTable.pDescriptorRanges = samplerDescriptorRanges.getData();
             }
+            if (primitiveConstants.size > 0)
+            {
+                outPrimitiveConstantsParamIndex = rootSignatureParams.getSize();
+
+                D3D12_ROOT_PARAMETER& constantsParameter = rootSignatureParams.addDefault();
+                constantsParameter.ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+                constantsParameter.ShaderVisibility = GetDirectX12ShaderParamVisibility(primitiveConstants.shaderStages);
+                constantsParameter.Constants.ShaderRegister = primitiveConstants.shaderLocation;
+                constantsParameter.Constants.RegisterSpace = 0;
+                constantsParameter.Constants.Num32BitValues = primitiveConstants.size / sizeof(uint32);
+            }
 
             D3D12_VERSIONED_ROOT_SIGNATURE_DESC rootSignatureDescription{};
             rootSignatureDescription.Version = D3D_ROOT_SIGNATURE_VERSION_1_0;
@@ -269,7 +291,11 @@ namespace JumaRenderEngine
 
         jmap<uint32, uint32> bufferParamIndices;
         jmap<jstringID, uint32> descriptorHeapOffsets;
-        ID3DBlob* rootSignatureBlob = CreateDirectX12RootSignatureBlob(getUniformBufferDescriptions(), getUniforms(), bufferParamIndices, descriptorHeapOffsets);
+        int32 primitiveConstantsParamIndex = -1;
+        ID3DBlob* rootSignatureBlob = CreateDirectX12RootSignatureBlob(
+            getUniformBufferDescriptions(), getUniforms(), getPrimitiveConstants(), 
+            bufferParamIndices, descriptorHeapOffsets, primitiveConstantsParamIndex
+        );
         if (rootSignatureBlob == nullptr)
         {
             JUTILS_LOG(error, JSTR("Failed to create DirectX12 root signature blob"));
@@ -296,6 +322,7 @@ namespace JumaRenderEngine
         m_ShaderBytecodes = { { SHADER_STAGE_VERTEX, vertexShaderBlob }, { SHADER_STAGE_FRAGMENT, fragmentShaderBlob } };
         m_UniformBufferParamIndices = std::move(bufferParamIndices);
         m_TextureDescriptorHeapOffsets = std::move(descriptorHeapOffsets);
+        m_PrimitiveConstantsParamIndex = primitiveConstantsParamIndex;
         return true;
     }
 
@@ -314,6 +341,7 @@ namespace JumaRenderEngine
 
         m_TextureDescriptorHeapOffsets.clear();
         m_UniformBufferParamIndices.clear();
+        m_PrimitiveConstantsParamIndex = -1;
 
         for (const auto& bytecode : m_ShaderBytecodes.values())
         {
@@ -329,14 +357,15 @@ namespace JumaRenderEngine
     }
 
     bool Shader_DirectX12::bindShader(const RenderOptions_DirectX12* renderOptions, VertexBuffer_DirectX12* vertexBuffer, 
-        const MaterialProperties& materialProperties)
+        VertexBuffer_DirectX12* instanceBuffer, const MaterialProperties& materialProperties)
     {
         const RenderTarget* renderTarget = renderOptions->renderTarget;
         const TextureFormat colorFormat = renderTarget->getColorFormat();
         const TextureFormat depthFormat = TextureFormat::DEPTH24_STENCIL8;
         const TextureSamples samples = renderTarget->getSampleCount();
         ID3D12PipelineState* pipelineState = getPipelineState({ 
-            vertexBuffer->getVertexID(), colorFormat, depthFormat, samples, materialProperties
+            vertexBuffer->getVertexID(), instanceBuffer != nullptr ? instanceBuffer->getVertexID() : vertex_id_NONE, 
+            colorFormat, depthFormat, samples, materialProperties
         });
         if (pipelineState == nullptr)
         {
@@ -346,6 +375,7 @@ namespace JumaRenderEngine
         ID3D12GraphicsCommandList2* commandList = renderOptions->renderCommandList->get();
         commandList->SetGraphicsRootSignature(m_RootSignature);
         commandList->SetPipelineState(pipelineState);
+        getRenderEngine()->addFrameCounter(RenderFrameCounter::StateChanges);
         return true;
     }
     ID3D12PipelineState* Shader_DirectX12::getPipelineState(const PipelineStateID& pipelineStateID)
@@ -363,33 +393,52 @@ namespace JumaRenderEngine
             JUTILS_LOG(error, JSTR("Failed to get description for vertex {}"), pipelineStateID.vertexID);
             return nullptr;
         }
+        const RegisteredVertexDescription* instanceDescription = nullptr;
+        if (pipelineStateID.instanceVertexID != vertex_id_NONE)
+        {
+            instanceDescription = renderEngine->findVertex(pipelineStateID.instanceVertexID);
+            if (instanceDescription == nullptr)
+            {
+                JUTILS_LOG(error, JSTR("Failed to get description for instance vertex {}"), pipelineStateID.instanceVertexID);
+                return nullptr;
+            }
+        }
         const jset<jstringID>& requiredComponents = getRequiredVertexComponents();
 
-        uint32 componentOffset = 0;
         jarray<D3D12_INPUT_ELEMENT_DESC> inputLayouts;
         inputLayouts.reserve(getRequiredVertexComponents().getSize());
-        for (const auto& componentID : vertexDescription->description.components)
+        for (const RegisteredVertexDescription* description : { vertexDescription, instanceDescription })
         {
-            const VertexComponentDescription* componentDescription = renderEngine->findVertexComponent(componentID);
-            if (requiredComponents.contains(componentID))
+            if (description == nullptr)
+            {
+                continue;
+            }
+
+            const bool instanceData = description->inputRate == VertexComponentInputRate::Instance;
+            uint32 componentOffset = 0;
+            for (const auto& componentID : description->description.components)
             {
-                DXGI_FORMAT componentFormat = DXGI_FORMAT_UNKNOWN;
-                switch (componentDescription->type)
+                const VertexComponentDescription* componentDescription = renderEngine->findVertexComponent(componentID);
+                if (requiredComponents.contains(componentID))
                 {
-                case VertexComponentType::Float: componentFormat = DXGI_FORMAT_R32_FLOAT; break;
-                case VertexComponentType::Vec2:  componentFormat = DXGI_FORMAT_R32G32_FLOAT; break;
-                case VertexComponentType::Vec3:  componentFormat = DXGI_FORMAT_R32G32B32_FLOAT; break;
-                case VertexComponentType::Vec4:  componentFormat = DXGI_FORMAT_R32G32B32A32_FLOAT; break;
-                default: 
-                    JUTILS_LOG(error, JSTR("Unsupported type of vertex component {} in vertex {}"), componentDescription->shaderLocation, pipelineStateID.vertexID);
-                    return nullptr;
+                    DXGI_FORMAT componentFormat = DXGI_FORMAT_UNKNOWN;
+                    switch (componentDescription->type)
+                    {
+                    case VertexComponentType::Float: componentFormat = DXGI_FORMAT_R32_FLOAT; break;
+                    case VertexComponentType::Vec2:  componentFormat = DXGI_FORMAT_R32G32_FLOAT; break;
+                    case VertexComponentType::Vec3:  componentFormat = DXGI_FORMAT_R32G32B32_FLOAT; break;
+                    case VertexComponentType::Vec4:  componentFormat = DXGI_FORMAT_R32G32B32A32_FLOAT; break;
+                    default: 
+                        JUTILS_LOG(error, JSTR("Unsupported type of vertex component {} in vertex {}"), componentDescription->shaderLocation, pipelineStateID.vertexID);
+                        return nullptr;
+                    }
+                    inputLayouts.add({ 
+                        "TEXCOORD", componentDescription->shaderLocation, componentFormat, instanceData ? 1u : 0u, componentOffset, 
+                        instanceData ? D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA : D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, instanceData ? 1u : 0u
+                    });
                 }
-                inputLayouts.add({ 
-                    "TEXCOORD", componentDescription->shaderLocation, componentFormat, 0,
-                    componentOffset, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0
-                });
+                componentOffset += GetVertexComponentSize(componentDescription->type);
             }
-            componentOffset += GetVertexComponentSize(componentDescription->type);
         }
         if (inputLayouts.getSize() != requiredComponents.getSize())
         {
@@ -475,6 +524,7 @@ namespace JumaRenderEngine
             JUTILS_ERROR_LOG(result, JSTR("Failed to create DirectX12 pipeline state"));
             return nullptr;
         }
+        getRenderEngine()->addFrameCounter(RenderFrameCounter::PipelineCreations);
         return m_PipelineStates[pipelineStateID] = pipelineState;
     }
 }
@@ -30,9 +30,11 @@ namespace JumaRenderEngine
 
         const jmap<uint32, uint32>& getUniformBufferParamIndices() const { return m_UniformBufferParamIndices; }
         const jmap<jstringID, uint32>& getTextureDescriptorHeapOffsets() const { return m_TextureDescriptorHeapOffsets; }
+        // -1 if shader doesn't use primitive constants
+        int32 getPrimitiveConstantsParamIndex() const { return m_PrimitiveConstantsParamIndex; }
 
         bool bindShader(const RenderOptions_DirectX12* renderOptions, VertexBuffer_DirectX12* vertexBuffer, 
-            const MaterialProperties& materialProperties);
+            VertexBuffer_DirectX12* instanceBuffer, const MaterialProperties& materialProperties);
 
     protected:
 
@@ -44,6 +46,7 @@ namespace JumaRenderEngine
         struct PipelineStateID
         {
             vertex_id vertexID = vertex_id_NONE;
+            vertex_id instanceVertexID = vertex_id_NONE;
             TextureFormat colorFormat = TextureFormat::RGBA8;
             TextureFormat depthFormat = TextureFormat::DEPTH24_STENCIL8;
             TextureSamples samplesCount = TextureSamples::X1;
@@ -59,6 +62,7 @@ namespace JumaRenderEngine
         jmap<ShaderStageFlags, ID3DBlob*> m_ShaderBytecodes;
         jmap<uint32, uint32> m_UniformBufferParamIndices;
         jmap<jstringID, uint32> m_TextureDescriptorHeapOffsets;
+        int32 m_PrimitiveConstantsParamIndex = -1;
 
 
         void clearDirectX();
@@ -72,6 +76,10 @@ namespace JumaRenderEngine
         {
             return vertexID < otherID.vertexID;
         }
+        if (instanceVertexID != otherID.instanceVertexID)
+        {
+            return instanceVertexID < otherID.instanceVertexID;
+        }
         if (colorFormat != otherID.colorFormat)
         {
             return colorFormat < otherID.colorFormat;
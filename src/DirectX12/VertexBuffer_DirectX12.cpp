@@ -7,6 +7,8 @@
 #include "Material_DirectX12.h"
 #include "RenderEngine_DirectX12.h"
 #include "RenderOptions_DirectX12.h"
+#include "Shader_DirectX12.h"
+#include "JumaRE/RenderPrimitivesList.h"
 #include "JumaRE/vertex/VertexBufferData.h"
 
 namespace JumaRenderEngine
@@ -72,23 +74,38 @@ namespace JumaRenderEngine
         }
     }
 
-    void VertexBuffer_DirectX12::render(const RenderOptions* renderOptions, Material* material)
+    void VertexBuffer_DirectX12::render(const RenderOptions* renderOptions, const RenderPrimitive& primitive)
     {
         const RenderOptions_DirectX12* renderOptionsDirectX = reinterpret_cast<const RenderOptions_DirectX12*>(renderOptions);
-        Material_DirectX12* materialDirectX = dynamic_cast<Material_DirectX12*>(material);
-        if ((materialDirectX == nullptr) || !materialDirectX->bindMaterial(renderOptionsDirectX, this))
+        VertexBuffer_DirectX12* instanceBuffer = dynamic_cast<VertexBuffer_DirectX12*>(primitive.instanceBuffer);
+        Material_DirectX12* materialDirectX = dynamic_cast<Material_DirectX12*>(primitive.material);
+        if ((materialDirectX == nullptr) || !materialDirectX->bindMaterial(renderOptionsDirectX, this, instanceBuffer))
         {
             return;
         }
 
         ID3D12GraphicsCommandList2* commandList = renderOptionsDirectX->renderCommandList->get();
 
+        const Shader_DirectX12* shader = dynamic_cast<const Shader_DirectX12*>(materialDirectX->getShader());
+        const int32 primitiveConstantsParamIndex = shader->getPrimitiveConstantsParamIndex();
+        if (primitiveConstantsParamIndex != -1)
+        {
+            commandList->SetGraphicsRoot32BitConstants(static_cast<UINT>(primitiveConstantsParamIndex), 
+                shader->getPrimitiveConstants().size / sizeof(uint32), GetRenderPrimitiveConstants(primitive), 0);
+        }
+
         commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-        D3D12_VERTEX_BUFFER_VIEW vertexBufferView{};
-        vertexBufferView.BufferLocation = m_VertexBuffer->get()->GetGPUVirtualAddress();
-        vertexBufferView.SizeInBytes = m_VertexBuffer->getSize();
-        vertexBufferView.StrideInBytes = m_CachedVertexSize;
-        commandList->IASetVertexBuffers(0, 1, &vertexBufferView);
+        D3D12_VERTEX_BUFFER_VIEW vertexBufferViews[2]{};
+        vertexBufferViews[0].BufferLocation = m_VertexBuffer->get()->GetGPUVirtualAddress();
+        vertexBufferViews[0].SizeInBytes = m_VertexBuffer->getSize();
+        vertexBufferViews[0].StrideInBytes = m_CachedVertexSize;
+        if (instanceBuffer != nullptr)
+        {
+            vertexBufferViews[1].BufferLocation = instanceBuffer->getDirectXVertexBuffer()->get()->GetGPUVirtualAddress();
+            vertexBufferViews[1].SizeInBytes = instanceBuffer->getDirectXVertexBuffer()->getSize();
+            vertexBufferViews[1].StrideInBytes = instanceBuffer->getVertexSize();
+        }
+        commandList->IASetVertexBuffers(0, instanceBuffer != nullptr ? 2 : 1, vertexBufferViews);
         if (m_IndexBuffer != nullptr)
         {
             D3D12_INDEX_BUFFER_VIEW indexBufferView{};
@@ -97,14 +114,15 @@ namespace JumaRenderEngine
             indexBufferView.Format = DXGI_FORMAT_R32_UINT;
             commandList->IASetIndexBuffer(&indexBufferView);
 
-            commandList->DrawIndexedInstanced(m_RenderElementsCount, 1, 0, 0, 0);
+            commandList->DrawIndexedInstanced(m_RenderElementsCount, primitive.instanceCount, 0, 0, 0);
         }
         else
         {
-            commandList->DrawInstanced(m_RenderElementsCount, 1, 0, 0);
+            commandList->DrawInstanced(m_RenderElementsCount, primitive.instanceCount, 0, 0);
         }
 
         materialDirectX->unbindMaterial(renderOptionsDirectX, this);
+        getRenderEngine()->addFrameCounter(RenderFrameCounter::DrawCalls);
     }
 }
 
@@ -18,7 +18,10 @@ namespace JumaRenderEngine
         VertexBuffer_DirectX12() = default;
         virtual ~VertexBuffer_DirectX12() override;
 
-        virtual void render(const RenderOptions* renderOptions, Material* material) override;
+        DirectX12Buffer* getDirectXVertexBuffer() const { return m_VertexBuffer; }
+        uint32 getVertexSize() const { return m_CachedVertexSize; }
+
+        virtual void render(const RenderOptions* renderOptions, const RenderPrimitive& primitive) override;
 
     protected:
 
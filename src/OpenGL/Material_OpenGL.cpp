@@ -5,10 +5,15 @@
 #include "Material_OpenGL.h"
 
 #include <GL/glew.h>
+#include <cstring>
 
+#include "RenderEngine_OpenGL.h"
+#include "RenderPipeline_OpenGL.h"
 #include "RenderTarget_OpenGL.h"
 #include "Shader_OpenGL.h"
+#include "StateCache_OpenGL.h"
 #include "Texture_OpenGL.h"
+#include "UniformRing_OpenGL.h"
 #include "JumaRE/RenderEngine.h"
 #include "JumaRE/RenderOptions.h"
 
@@ -21,7 +26,9 @@ namespace JumaRenderEngine
 
     bool Material_OpenGL::initInternal()
     {
-        if (getShader()->getUniformBufferDescriptions().isEmpty())
+        // Instance uses uniform buffers of parent, own buffers are created after it overrides any param.
+        // Uniform ring makes own buffers unnecessary, they are created lazily if ring is not available
+        if (getShader()->getUniformBufferDescriptions().isEmpty() || (getUniformDataParent() != nullptr) || UniformRing_OpenGL::IsSupported())
         {
             m_MaterialCreated = true;
             return true;
@@ -51,7 +58,8 @@ namespace JumaRenderEngine
         for (const auto& [bufferID, bufferDescription] : uniformBufferDescriptions)
         {
             const uint32 bufferIndex = uniformBuffers.getLast();
-            m_UniformBufferIndices.add(bufferID, bufferIndex);
+            // Whole buffer should be uploaded after creation
+            m_UniformBuffers.add(bufferID, { bufferIndex, 0, bufferDescription.size });
             uniformBuffers.removeLast();
 
             glBindBuffer(GL_UNIFORM_BUFFER, bufferIndex);
@@ -67,171 +75,296 @@ namespace JumaRenderEngine
     }
     void Material_OpenGL::clearOpenGL()
     {
-        for (const auto& buffer : m_UniformBufferIndices.values())
+        for (const auto& buffer : m_UniformBuffers.values())
         {
-            glDeleteBuffers(1, &buffer);
+            glDeleteBuffers(1, &buffer.index);
         }
-        m_UniformBufferIndices.clear();
+        m_UniformBuffers.clear();
+        m_UniformRingOffsets.clear();
+        m_UniformRingFrameIndex = 0;
+        m_BindlessTextureHandlesVersion = 0;
     }
 
-    bool Material_OpenGL::bindMaterial(const RenderOptions* renderOptions)
+    bool Material_OpenGL::bindMaterial(const RenderOptions* renderOptions, StateCache_OpenGL* stateCache)
     {
         const Shader_OpenGL* shader = getShader<Shader_OpenGL>();
-        if (!m_MaterialCreated)
+        Material_OpenGL* uniformDataParent = getUniformDataParent<Material_OpenGL>();
+        Material_OpenGL* uniformDataOwner = uniformDataParent != nullptr ? uniformDataParent : this;
+        if (!uniformDataOwner->m_MaterialCreated)
         {
-            if (m_CreateTaskActive)
+            if (uniformDataOwner->m_CreateTaskActive)
             {
                 return false;
             }
-            m_MaterialCreated = true;
+            uniformDataOwner->m_MaterialCreated = true;
         }
 
-        if (!shader->activateShader())
+        if (!shader->activateShader(stateCache))
         {
             return false;
         }
+        getRenderEngine()->addFrameCounter(RenderFrameCounter::StateChanges);
 
-        updateUniformData();
-        for (const auto& [bufferID, bufferIndex] : m_UniformBufferIndices)
+        bindTextures(stateCache);
+        if (shader->hasBindlessTextures())
+        {
+            makeBindlessTexturesResident(stateCache);
+        }
+        const RenderPipeline_OpenGL* renderPipeline = dynamic_cast<const RenderPipeline_OpenGL*>(getRenderEngine()->getRenderPipeline());
+        UniformRing_OpenGL* uniformRing = renderPipeline != nullptr ? renderPipeline->getUniformRing() : nullptr;
+        if (uniformRing != nullptr)
+        {
+            if (!uniformDataOwner->bindUniformRingData(uniformRing, stateCache))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            uniformDataOwner->updateUniformBuffers();
+            for (const auto& [bufferID, buffer] : uniformDataOwner->m_UniformBuffers)
+            {
+                stateCache->bindUniformBuffer(bufferID, buffer.index);
+            }
+        }
+        if (uniformDataParent != nullptr)
         {
-            glBindBufferBase(GL_UNIFORM_BUFFER, bufferID, bufferIndex);
+            clearParamsForUpdate();
         }
 
         MaterialProperties properties = getMaterialProperties();
         properties.depthEnabled &= renderOptions->renderStageProperties.depthEnabled;
-        if (properties.depthEnabled)
+        stateCache->setEnabled(StateCapability_OpenGL::DepthTest, properties.depthEnabled);
+        stateCache->setDepthMask(properties.depthEnabled);
+        stateCache->setEnabled(StateCapability_OpenGL::StencilTest, properties.stencilEnabled);
+        stateCache->setPolygonMode(properties.wireframe ? GL_LINE : GL_FILL);
+        stateCache->setCullFace(properties.cullBackFaces ? GL_BACK : GL_FRONT);
+        stateCache->setEnabled(StateCapability_OpenGL::Blend, properties.blendEnabled);
+        if (properties.blendEnabled)
         {
-            glEnable(GL_DEPTH_TEST);
-            glDepthMask(GL_TRUE);
+            stateCache->setBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
         }
-        else
+
+        return true;
+    }
+    void Material_OpenGL::bindTextures(StateCache_OpenGL* stateCache) const
+    {
+        const MaterialParamsStorage& materialParams = getMaterialParams();
+        const MaterialParamsLayout* paramsLayout = materialParams.getLayout();
+        if ((paramsLayout == nullptr) || (paramsLayout->getTexturesCount() == 0))
+        {
+            return;
+        }
+
+        const Texture_OpenGL* defaultTexture = dynamic_cast<const Texture_OpenGL*>(getRenderEngine()->getDefaultTexture());
+        for (const auto& paramIndex : paramsLayout->getTextureParamIndices())
         {
-            glDisable(GL_DEPTH_TEST);
-            glDepthMask(GL_FALSE);
+            const ShaderUniform& uniform = paramsLayout->getParamUniform(paramIndex);
+            ShaderUniformInfo<ShaderUniformType::Texture>::value_type value = nullptr;
+            materialParams.getValue<ShaderUniformType::Texture>(paramsLayout->getParam(paramIndex), value);
+
+            const Texture_OpenGL* texture = dynamic_cast<Texture_OpenGL*>(value);
+            if (texture != nullptr)
+            {
+                texture->bindToShader(stateCache, uniform.shaderLocation);
+            }
+            else
+            {
+                const RenderTarget_OpenGL* renderTarget = dynamic_cast<RenderTarget_OpenGL*>(value);
+                if (renderTarget != nullptr)
+                {
+                    renderTarget->bindToShader(stateCache, uniform.shaderLocation);
+                }
+                else if (defaultTexture != nullptr)
+                {
+                    defaultTexture->bindToShader(stateCache, uniform.shaderLocation);
+                }
+                else
+                {
+                    throw std::logic_error("Invalid default texture");
+                }
+            }
         }
-        if (properties.stencilEnabled)
+    }
+    void Material_OpenGL::updateUniformBuffers()
+    {
+        const MaterialParamsMask& notUpdatedParams = getNotUpdatedParams();
+        const bool bindlessTexturesUsed = getShader()->hasBindlessTextures();
+        // Bindless handles could be released without changing params, e.g. when render target recreates its texture
+        const uint64 bindlessHandlesVersion = getRenderEngine<RenderEngine_OpenGL>()->getBindlessTextureHandlesVersion();
+        const bool bindlessHandlesChanged = bindlessTexturesUsed && (m_BindlessTextureHandlesVersion != bindlessHandlesVersion);
+        if (m_UniformBuffers.isEmpty() && !getShader()->getUniformBufferDescriptions().isEmpty())
         {
-            glEnable(GL_STENCIL_TEST);
+            // Instance overrides params of parent or uniform ring is not available
+            createUniformBuffers();
         }
-        else
+        else if (notUpdatedParams.isEmpty() && !bindlessHandlesChanged)
         {
-            glDisable(GL_STENCIL_TEST);
+            return;
         }
-        glPolygonMode(GL_FRONT_AND_BACK, properties.wireframe ? GL_LINE : GL_FILL);
-        glCullFace(properties.cullBackFaces ? GL_BACK : GL_FRONT);
-        if (properties.blendEnabled)
+
+        const MaterialParamsLayout& paramsLayout = getShader()->getMaterialParamsLayout();
+        for (const auto& paramIndex : notUpdatedParams)
         {
-            glEnable(GL_BLEND);
-            glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+            markUniformDataDirty(paramsLayout.getParamUniform(paramIndex));
         }
-        else
+        if (bindlessHandlesChanged)
         {
-            glDisable(GL_BLEND);
+            for (int32 paramIndex = 0; paramIndex < paramsLayout.getParamsCount(); paramIndex++)
+            {
+                const ShaderUniform& uniform = paramsLayout.getParamUniform(paramIndex);
+                if (uniform.type == ShaderUniformType::BindlessTexture)
+                {
+                    markUniformDataDirty(uniform);
+                }
+            }
         }
+        m_BindlessTextureHandlesVersion = bindlessHandlesVersion;
 
-        return true;
-    }
-    void Material_OpenGL::updateUniformData()
-    {
-        const Texture_OpenGL* defaultTexture = dynamic_cast<const Texture_OpenGL*>(getRenderEngine()->getDefaultTexture());
-        const jset<jstringID>& notUpdatedParams = getNotUpdatedParams();
         const MaterialParamsStorage& materialParams = getMaterialParams();
-        for (const auto& [uniformID, uniform] : getShader()->getUniforms())
+        uint64 uploadedBytes = 0;
+        for (auto& [bufferLocation, buffer] : m_UniformBuffers)
         {
-            if (uniform.type == ShaderUniformType::Texture)
+            if (buffer.dirtyBegin == buffer.dirtyEnd)
             {
-                ShaderUniformInfo<ShaderUniformType::Texture>::value_type value = nullptr;
-                materialParams.getValue<ShaderUniformType::Texture>(uniformID, value);
-
-                const Texture_OpenGL* texture = dynamic_cast<Texture_OpenGL*>(value);
-                if (texture != nullptr)
+                continue;
+            }
+            const uint8* bufferData = materialParams.getUniformBufferData(bufferLocation);
+            if (bufferData != nullptr)
+            {
+                const uint32 size = buffer.dirtyEnd - buffer.dirtyBegin;
+                glBindBuffer(GL_UNIFORM_BUFFER, buffer.index);
+                if (!bindlessTexturesUsed)
                 {
-                    texture->bindToShader(uniform.shaderLocation);
+                    glBufferSubData(GL_UNIFORM_BUFFER, buffer.dirtyBegin, size, bufferData + buffer.dirtyBegin);
                 }
                 else
                 {
-                    const RenderTarget_OpenGL* renderTarget = dynamic_cast<RenderTarget_OpenGL*>(value);
-                    if (renderTarget != nullptr)
-                    {
-                        renderTarget->bindToShader(uniform.shaderLocation);
-                    }
-                    else if (defaultTexture != nullptr)
-                    {
-                        defaultTexture->bindToShader(uniform.shaderLocation);
-                    }
-                    else
-                    {
-                        throw std::logic_error("Invalid default texture");
-                    }
+                    FrameArray<uint8> data(getRenderEngine()->getFrameArena(), static_cast<int32>(size), 0);
+                    std::memcpy(data.getData(), bufferData + buffer.dirtyBegin, size);
+                    writeBindlessTextureHandles(bufferLocation, data.getData(), buffer.dirtyBegin, buffer.dirtyEnd);
+                    glBufferSubData(GL_UNIFORM_BUFFER, buffer.dirtyBegin, size, data.getData());
                 }
+                uploadedBytes += size;
             }
-            else if (notUpdatedParams.contains(uniformID))
+            buffer.dirtyBegin = buffer.dirtyEnd = 0;
+        }
+        if (uploadedBytes > 0)
+        {
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+        clearParamsForUpdate();
+        if (uploadedBytes > 0)
+        {
+            getRenderEngine()->addFrameCounter(RenderFrameCounter::UploadedBytes, uploadedBytes);
+        }
+    }
+
+    void Material_OpenGL::markUniformDataDirty(const ShaderUniform& uniform)
+    {
+        UniformBuffer* buffer = IsShaderUniformScalar(uniform.type) ? m_UniformBuffers.find(uniform.shaderLocation) : nullptr;
+        if (buffer == nullptr)
+        {
+            return;
+        }
+        const uint32 paramEnd = uniform.shaderBlockOffset + GetShaderUniformValueSize(uniform.type);
+        if (buffer->dirtyBegin == buffer->dirtyEnd)
+        {
+            buffer->dirtyBegin = uniform.shaderBlockOffset;
+            buffer->dirtyEnd = paramEnd;
+        }
+        else
+        {
+            buffer->dirtyBegin = math::min(buffer->dirtyBegin, uniform.shaderBlockOffset);
+            buffer->dirtyEnd = math::max(buffer->dirtyEnd, paramEnd);
+        }
+    }
+
+    bool Material_OpenGL::bindUniformRingData(UniformRing_OpenGL* uniformRing, StateCache_OpenGL* stateCache)
+    {
+        const jmap<uint32, ShaderUniformBufferDescription>& uniformBufferDescriptions = getShader()->getUniformBufferDescriptions();
+        // Data is written once per frame, changed params get a new copy so previous draws are not affected
+        const bool bindlessTexturesUsed = getShader()->hasBindlessTextures();
+        const uint64 bindlessHandlesVersion = getRenderEngine<RenderEngine_OpenGL>()->getBindlessTextureHandlesVersion();
+        if ((m_UniformRingFrameIndex != uniformRing->getFrameIndex()) || !getNotUpdatedParams().isEmpty()
+            || (bindlessTexturesUsed && (m_BindlessTextureHandlesVersion != bindlessHandlesVersion)))
+        {
+            const MaterialParamsStorage& materialParams = getMaterialParams();
+            m_BindlessTextureHandlesVersion = bindlessHandlesVersion;
+            uint64 uploadedBytes = 0;
+            for (const auto& [bufferLocation, bufferDescription] : uniformBufferDescriptions)
             {
-                switch (uniform.type)
+                const uint8* bufferData = materialParams.getUniformBufferData(bufferLocation);
+                uint32 offset = 0;
+                uint8* ringData = bufferData != nullptr ? uniformRing->allocate(bufferDescription.size, offset) : nullptr;
+                if (ringData == nullptr)
+                {
+                    m_UniformRingFrameIndex = 0;
+                    return false;
+                }
+                std::memcpy(ringData, bufferData, bufferDescription.size);
+                if (bindlessTexturesUsed)
                 {
-                case ShaderUniformType::Float:
-                    {
-                        ShaderUniformInfo<ShaderUniformType::Float>::value_type value;
-                        if (materialParams.getValue<ShaderUniformType::Float>(uniformID, value))
-                        {
-                            glBindBuffer(GL_UNIFORM_BUFFER, m_UniformBufferIndices[uniform.shaderLocation]);
-                            glBufferSubData(GL_UNIFORM_BUFFER, uniform.shaderBlockOffset, sizeof(value), &value);
-                        }
-                    }
-                    break;
-                case ShaderUniformType::Vec2:
-                    {
-                        ShaderUniformInfo<ShaderUniformType::Vec2>::value_type value;
-                        if (materialParams.getValue<ShaderUniformType::Vec2>(uniformID, value))
-                        {
-                            glBindBuffer(GL_UNIFORM_BUFFER, m_UniformBufferIndices[uniform.shaderLocation]);
-                            glBufferSubData(GL_UNIFORM_BUFFER, uniform.shaderBlockOffset, sizeof(value), &value[0]);
-                        }
-                    }
-                    break;
-                case ShaderUniformType::Vec4:
-                    {
-                        ShaderUniformInfo<ShaderUniformType::Vec4>::value_type value;
-                        if (materialParams.getValue<ShaderUniformType::Vec4>(uniformID, value))
-                        {
-                            glBindBuffer(GL_UNIFORM_BUFFER, m_UniformBufferIndices[uniform.shaderLocation]);
-                            glBufferSubData(GL_UNIFORM_BUFFER, uniform.shaderBlockOffset, sizeof(value), &value[0]);
-                        }
-                    }
-                    break;
-                case ShaderUniformType::Mat4:
-                    {
-                        ShaderUniformInfo<ShaderUniformType::Mat4>::value_type value;
-                        if (materialParams.getValue<ShaderUniformType::Mat4>(uniformID, value))
-                        {
-                            glBindBuffer(GL_UNIFORM_BUFFER, m_UniformBufferIndices[uniform.shaderLocation]);
-                            glBufferSubData(GL_UNIFORM_BUFFER, uniform.shaderBlockOffset, sizeof(value), &value[0][0]);
-                        }
-                    }
-                    break;
-
-                default: ;
+                    writeBindlessTextureHandles(bufferLocation, ringData, 0, bufferDescription.size);
                 }
-            }  
+                m_UniformRingOffsets[bufferLocation] = offset;
+                uploadedBytes += bufferDescription.size;
+            }
+            m_UniformRingFrameIndex = uniformRing->getFrameIndex();
+            clearParamsForUpdate();
+            if (uploadedBytes > 0)
+            {
+                getRenderEngine()->addFrameCounter(RenderFrameCounter::UploadedBytes, uploadedBytes);
+            }
         }
-        glBindBuffer(GL_UNIFORM_BUFFER, 0);
-        clearParamsForUpdate();
+
+        for (const auto& [bufferLocation, bufferDescription] : uniformBufferDescriptions)
+        {
+            const uint32* offset = m_UniformRingOffsets.find(bufferLocation);
+            if (offset != nullptr)
+            {
+                stateCache->bindUniformBufferRange(bufferLocation, uniformRing->get(), *offset, bufferDescription.size);
+            }
+        }
+        return true;
     }
 
-    void Material_OpenGL::unbindMaterial()
+    void Material_OpenGL::makeBindlessTexturesResident(StateCache_OpenGL* stateCache) const
     {
-        for (const auto& uniformBuffer : m_UniformBufferIndices.keys())
+        // Residency is per context, material could be rendered to windows with different contexts
+        RenderEngine_OpenGL* renderEngine = getRenderEngine<RenderEngine_OpenGL>();
+        const MaterialParamsStorage& materialParams = getMaterialParams();
+        const MaterialParamsLayout& paramsLayout = getShader()->getMaterialParamsLayout();
+        for (int32 paramIndex = 0; paramIndex < paramsLayout.getParamsCount(); paramIndex++)
         {
-            glBindBufferBase(GL_UNIFORM_BUFFER, uniformBuffer, 0);
+            const MaterialParamsLayoutEntry& entry = paramsLayout.getParam(paramIndex);
+            if (entry.type == ShaderUniformType::BindlessTexture)
+            {
+                ShaderUniformInfo<ShaderUniformType::BindlessTexture>::value_type value = nullptr;
+                materialParams.getValue<ShaderUniformType::BindlessTexture>(entry, value);
+                stateCache->makeTextureHandleResident(renderEngine->getBindlessTextureHandle(value));
+            }
         }
-        for (const auto& uniform : getShader()->getUniforms().values())
+    }
+    void Material_OpenGL::writeBindlessTextureHandles(const uint32 bufferLocation, uint8* data, const uint32 dataBegin, const uint32 dataEnd) const
+    {
+        RenderEngine_OpenGL* renderEngine = getRenderEngine<RenderEngine_OpenGL>();
+        const MaterialParamsStorage& materialParams = getMaterialParams();
+        const MaterialParamsLayout& paramsLayout = getShader()->getMaterialParamsLayout();
+        for (int32 paramIndex = 0; paramIndex < paramsLayout.getParamsCount(); paramIndex++)
         {
-            if (uniform.type == ShaderUniformType::Texture)
+            const ShaderUniform& uniform = paramsLayout.getParamUniform(paramIndex);
+            if ((uniform.type != ShaderUniformType::BindlessTexture) || (uniform.shaderLocation != bufferLocation) || 
+                (uniform.shaderBlockOffset < dataBegin) || (uniform.shaderBlockOffset + sizeof(uint64) > dataEnd))
             {
-                Texture_OpenGL::unbindTexture(uniform.shaderLocation);
+                continue;
             }
+
+            ShaderUniformInfo<ShaderUniformType::BindlessTexture>::value_type value = nullptr;
+            materialParams.getValue<ShaderUniformType::BindlessTexture>(paramsLayout.getParam(paramIndex), value);
+            const uint64 handle = renderEngine->getBindlessTextureHandle(value);
+            std::memcpy(data + (uniform.shaderBlockOffset - dataBegin), &handle, sizeof(handle));
         }
-        Shader_OpenGL::deactivateAnyShader();
     }
 }
 
@@ -6,11 +6,15 @@
 
 #include "JumaRE/material/Material.h"
 
+#include "JumaRE/RenderTrace.h"
+
 #include <jutils/jasync_task_queue.h>
 
 namespace JumaRenderEngine
 {
 	struct RenderOptions;
+    class StateCache_OpenGL;
+    class UniformRing_OpenGL;
 
 	class Material_OpenGL final : public Material
     {
@@ -20,14 +24,13 @@ namespace JumaRenderEngine
         Material_OpenGL() = default;
         virtual ~Material_OpenGL() override;
 
-        bool bindMaterial(const RenderOptions* renderOptions);
-        void unbindMaterial();
+        bool bindMaterial(const RenderOptions* renderOptions, StateCache_OpenGL* stateCache);
 
     protected:
 
         virtual bool initInternal() override;
 
-        virtual bool isReadyForDestroy() override { return !m_CreateTaskActive; }
+        virtual bool isReadyForDestroy() override { return Super::isReadyForDestroy() && !m_CreateTaskActive; }
         virtual void onClearAsset() override;
 
     private:
@@ -39,14 +42,32 @@ namespace JumaRenderEngine
             CreateMaterialTask(Material_OpenGL* material) : m_Material(material) {}
             virtual ~CreateMaterialTask() override { m_Material->m_CreateTaskActive = false; }
 
-            virtual void run() override { m_Material->createUniformBuffers(); }
+            virtual void run() override
+            {
+                JUMARE_TRACE_SCOPE("Material_OpenGL::CreateMaterialTask", "asset");
+                m_Material->createUniformBuffers();
+            }
 
         private:
             
             Material_OpenGL* m_Material = nullptr;
         };
 
-        jmap<uint32, uint32> m_UniformBufferIndices;
+        struct UniformBuffer
+        {
+            uint32 index = 0;
+            // Range of changed data, uploaded with one call
+            uint32 dirtyBegin = 0;
+            uint32 dirtyEnd = 0;
+        };
+
+        // Own buffers are used only if uniform ring is not available
+        jmap<uint32, UniformBuffer> m_UniformBuffers;
+
+        jmap<uint32, uint32> m_UniformRingOffsets;
+        uint64 m_UniformRingFrameIndex = 0;
+        // Version of bindless handles written to uniform data
+        uint64 m_BindlessTextureHandlesVersion = 0;
         
         std::atomic_bool m_CreateTaskActive = false;
         bool m_MaterialCreated = false;
@@ -56,7 +77,13 @@ namespace JumaRenderEngine
 
 	    void clearOpenGL();
 
-        void updateUniformData();
+        void bindTextures(StateCache_OpenGL* stateCache) const;
+        void updateUniformBuffers();
+        void markUniformDataDirty(const ShaderUniform& uniform);
+        bool bindUniformRingData(UniformRing_OpenGL* uniformRing, StateCache_OpenGL* stateCache);
+        void makeBindlessTexturesResident(StateCache_OpenGL* stateCache) const;
+        // Replaces texture pointers in copy of uniform buffer data with bindless handles
+        void writeBindlessTextureHandles(uint32 bufferLocation, uint8* data, uint32 dataBegin, uint32 dataEnd) const;
     };
 }
 
@@ -6,6 +6,7 @@
 
 #include <GL/glew.h>
 
+#include "RenderPipeline_OpenGL.h"
 #include "window/WindowControllerImpl_OpenGL.h"
 
 namespace JumaRenderEngine
@@ -46,6 +47,8 @@ namespace JumaRenderEngine
         m_VertexBuffersPool.clear();
         m_RenderTargetsPool.clear();
 
+        m_BindlessTextureHandles.clear();
+        m_ValidBindlessTextureHandles.clear();
         for (const auto& sampler : m_SamplerObjectIndices.values())
         {
             glDeleteSamplers(1, &sampler);
@@ -55,7 +58,11 @@ namespace JumaRenderEngine
 
     WindowController* RenderEngine_OpenGL::createWindowController()
     {
-        return CreateWindowController_OpenGL();
+        return CreateWindowController_OpenGL(isHeadless());
+    }
+    RenderPipeline* RenderEngine_OpenGL::createRenderPipelineInternal()
+    {
+        return createObject<RenderPipeline_OpenGL>();
     }
 
     uint32 RenderEngine_OpenGL::getTextureSamplerIndex(const TextureSamplerType sampler)
@@ -125,6 +132,76 @@ namespace JumaRenderEngine
         }
         return m_SamplerObjectIndices[sampler] = samplerIndex;
     }
+
+    bool RenderEngine_OpenGL::isBindlessTexturesSupported() const
+    {
+        return GLEW_ARB_bindless_texture;
+    }
+    uint64 RenderEngine_OpenGL::getBindlessTextureHandle(const TextureBase* texture)
+    {
+        uint32 textureIndex = 0;
+        const Texture_OpenGL* textureOpenGL = dynamic_cast<const Texture_OpenGL*>(texture);
+        if (textureOpenGL != nullptr)
+        {
+            textureIndex = textureOpenGL->getTextureIndex();
+        }
+        else
+        {
+            const RenderTarget_OpenGL* renderTarget = dynamic_cast<const RenderTarget_OpenGL*>(texture);
+            if (renderTarget != nullptr)
+            {
+                textureIndex = renderTarget->getResultTextureIndex();
+            }
+        }
+        if (textureIndex == 0)
+        {
+            const Texture_OpenGL* defaultTexture = dynamic_cast<const Texture_OpenGL*>(getDefaultTexture());
+            if ((defaultTexture == nullptr) || (defaultTexture == texture))
+            {
+                return 0;
+            }
+            return getBindlessTextureHandle(defaultTexture);
+        }
+
+        const TextureSamplerType sampler = texture->getSamplerType();
+        std::lock_guard lock(m_BindlessTextureHandlesMutex);
+        jmap<TextureSamplerType, uint64>& textureHandles = m_BindlessTextureHandles[textureIndex];
+        const uint64* handlePtr = textureHandles.find(sampler);
+        if (handlePtr != nullptr)
+        {
+            return *handlePtr;
+        }
+
+        const uint64 handle = glGetTextureSamplerHandleARB(textureIndex, getTextureSamplerIndex(sampler));
+        if (handle == 0)
+        {
+            JUTILS_LOG(error, JSTR("Failed to get bindless handle of texture {}"), textureIndex);
+            return 0;
+        }
+        m_ValidBindlessTextureHandles.add(handle);
+        return textureHandles[sampler] = handle;
+    }
+    void RenderEngine_OpenGL::releaseBindlessTextureHandles(const uint32 textureIndex)
+    {
+        std::lock_guard lock(m_BindlessTextureHandlesMutex);
+        const jmap<TextureSamplerType, uint64>* textureHandles = m_BindlessTextureHandles.find(textureIndex);
+        if (textureHandles == nullptr)
+        {
+            return;
+        }
+        // Handles are resident per context and this could be called from any context, so contexts release them by themselves
+        for (const auto& handle : textureHandles->values())
+        {
+            m_ValidBindlessTextureHandles.remove(handle);
+        }
+        m_BindlessTextureHandles.remove(textureIndex);
+        m_BindlessTextureHandlesVersion++;
+    }
+    void RenderEngine_OpenGL::updateBindlessTextureResidency(StateCache_OpenGL* stateCache)
+    {
+        std::lock_guard lock(m_BindlessTextureHandlesMutex);
+        stateCache->updateResidentTextureHandles(m_BindlessTextureHandlesVersion, m_ValidBindlessTextureHandles);
+    }
 }
 
 #endif
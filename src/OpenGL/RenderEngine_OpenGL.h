@@ -7,6 +7,9 @@
 #include "JumaRE/RenderEngine.h"
 
 #include <jutils/jpool_simple.h>
+#include <jutils/jset.h>
+#include <atomic>
+#include <mutex>
 
 #include "Material_OpenGL.h"
 #include "RenderTarget_OpenGL.h"
@@ -28,6 +31,17 @@ namespace JumaRenderEngine
 
         uint32 getTextureSamplerIndex(TextureSamplerType sampler);
 
+        virtual bool isBindlessTexturesSupported() const override;
+        // Returns bindless handle of the texture, default texture is used if it's nullptr. Should be called from main thread.
+        // Handle should be made resident in the current context by state cache before draw
+        uint64 getBindlessTextureHandle(const TextureBase* texture);
+        // Could be called from any thread before texture is deleted, handles become non-resident in each context
+        // on its next updateBindlessTextureResidency() call
+        void releaseBindlessTextureHandles(uint32 textureIndex);
+        // Changed after any handle was released
+        uint64 getBindlessTextureHandlesVersion() const { return m_BindlessTextureHandlesVersion; }
+        void updateBindlessTextureResidency(StateCache_OpenGL* stateCache);
+
     protected:
 
         virtual bool initAsyncAssetTaskQueueWorker(int32 workerIndex) override;
@@ -35,8 +49,12 @@ namespace JumaRenderEngine
         virtual void clearAsyncAssetTaskQueueWorkerThread(int32 workerIndex) override;
         virtual void clearAsyncAssetTaskQueueWorker(int32 workerIndex) override;
         virtual void clearInternal() override;
+#if defined(EGL_ENABLED)
+        virtual bool isHeadlessModeSupported() const override { return true; }
+#endif
 
         virtual WindowController* createWindowController() override;
+        virtual RenderPipeline* createRenderPipelineInternal() override;
         virtual RenderTarget* allocateRenderTarget() override { return m_RenderTargetsPool.getPoolObject(); }
         virtual VertexBuffer* allocateVertexBuffer() override { return m_VertexBuffersPool.getPoolObject(); }
         virtual Shader* allocateShader() override { return m_ShadersPool.getPoolObject(); }
@@ -52,6 +70,11 @@ namespace JumaRenderEngine
     private:
 
         jmap<TextureSamplerType, uint32> m_SamplerObjectIndices;
+
+        jmap<uint32, jmap<TextureSamplerType, uint64>> m_BindlessTextureHandles;
+        jset<uint64> m_ValidBindlessTextureHandles;
+        std::atomic<uint64> m_BindlessTextureHandlesVersion = 0;
+        std::mutex m_BindlessTextureHandlesMutex;
         
         jpool_simple<RenderTarget_OpenGL> m_RenderTargetsPool;
         jpool_simple<VertexBuffer_OpenGL> m_VertexBuffersPool;
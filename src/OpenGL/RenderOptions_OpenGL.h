@@ -0,0 +1,35 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_OPENGL)
+
+#include "JumaRE/RenderOptions.h"
+
+#include <jutils/jarray.h>
+
+namespace JumaRenderEngine
+{
+    class Material_OpenGL;
+    class VertexBuffer_OpenGL;
+
+    struct RenderCommand_OpenGL
+    {
+        // Timestamp command if vertex buffer is null
+        VertexBuffer_OpenGL* vertexBuffer = nullptr;
+        Material_OpenGL* material = nullptr;
+        uint32 instanceCount = 1;
+        VertexBuffer_OpenGL* instanceBuffer = nullptr;
+        const void* primitiveConstants = nullptr;
+        RenderStageProperties renderStageProperties;
+        uint32 timestampQuery = 0;
+    };
+
+    struct RenderOptions_OpenGL final : RenderOptions
+    {
+        // Commands recorded on worker thread, they will be replayed on context's thread
+        jarray<RenderCommand_OpenGL>* renderCommands = nullptr;
+    };
+}
+
+#endif
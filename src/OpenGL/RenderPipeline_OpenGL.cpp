@@ -0,0 +1,187 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#if defined(JUMARE_ENABLE_OPENGL)
+
+#include "RenderPipeline_OpenGL.h"
+
+#include <GL/glew.h>
+
+#include "JumaRE/RenderTarget.h"
+
+#include "UniformRing_OpenGL.h"
+#include "VertexBuffer_OpenGL.h"
+
+namespace JumaRenderEngine
+{
+    RenderPipeline_OpenGL::~RenderPipeline_OpenGL()
+    {
+        clearOpenGL();
+    }
+
+    void RenderPipeline_OpenGL::clearOpenGL()
+    {
+        stopRenderRecordWorkers();
+        m_RecordedRenderCommands.clear();
+
+        for (const auto& queries : m_TimestampQueries)
+        {
+            if (!queries.isEmpty())
+            {
+                glDeleteQueries(queries.getSize(), queries.getData());
+            }
+        }
+        m_TimestampQueries.clear();
+
+        if (m_UniformRing != nullptr)
+        {
+            delete m_UniformRing;
+            m_UniformRing = nullptr;
+        }
+        m_UniformRingCreated = false;
+    }
+
+    void RenderPipeline_OpenGL::renderInternal()
+    {
+        callRender<RenderOptions_OpenGL>();
+    }
+
+    bool RenderPipeline_OpenGL::onStartRender(RenderOptions* renderOptions)
+    {
+        if (!Super::onStartRender(renderOptions))
+        {
+            return false;
+        }
+
+        if (!m_UniformRingCreated)
+        {
+            // Context is current only here, so ring is created with the first frame
+            m_UniformRingCreated = true;
+            if (UniformRing_OpenGL::IsSupported())
+            {
+                UniformRing_OpenGL* uniformRing = getRenderEngine()->createObject<UniformRing_OpenGL>();
+                // Driver could buffer a few frames ahead
+                if (uniformRing->init(1024 * 1024, 3))
+                {
+                    m_UniformRing = uniformRing;
+                }
+                else
+                {
+                    JUTILS_LOG(warning, JSTR("Failed to create uniform ring, materials will use own uniform buffers"));
+                    delete uniformRing;
+                }
+            }
+        }
+        if ((m_UniformRing != nullptr) && !m_UniformRing->startFrame())
+        {
+            JUTILS_LOG(error, JSTR("Failed to start uniform ring frame"));
+            delete m_UniformRing;
+            m_UniformRing = nullptr;
+        }
+        return true;
+    }
+    void RenderPipeline_OpenGL::onFinishRender(RenderOptions* renderOptions)
+    {
+        if (m_UniformRing != nullptr)
+        {
+            m_UniformRing->finishFrame();
+        }
+        Super::onFinishRender(renderOptions);
+    }
+
+    bool RenderPipeline_OpenGL::onStartRecordRenderTarget(RenderOptions* renderOptions, RenderOptions* recordRenderOptions, RenderTarget* renderTarget)
+    {
+        if (!Super::onStartRecordRenderTarget(renderOptions, recordRenderOptions, renderTarget))
+        {
+            return false;
+        }
+
+        jarray<RenderCommand_OpenGL>& renderCommands = m_RecordedRenderCommands[renderTarget->getID()];
+        renderCommands.clear();
+        reinterpret_cast<RenderOptions_OpenGL*>(recordRenderOptions)->renderCommands = &renderCommands;
+        return true;
+    }
+    void RenderPipeline_OpenGL::submitRecordedRenderTarget(RenderOptions* renderOptions, RenderOptions* recordRenderOptions, RenderTarget* renderTarget)
+    {
+        const jarray<RenderCommand_OpenGL>* renderCommands = reinterpret_cast<RenderOptions_OpenGL*>(recordRenderOptions)->renderCommands;
+        if (renderCommands != nullptr)
+        {
+            for (const auto& renderCommand : *renderCommands)
+            {
+                if (renderCommand.vertexBuffer == nullptr)
+                {
+                    glQueryCounter(renderCommand.timestampQuery, GL_TIMESTAMP);
+                    continue;
+                }
+                renderOptions->renderStageProperties = renderCommand.renderStageProperties;
+                renderCommand.vertexBuffer->draw(
+                    renderOptions, renderCommand.material, renderCommand.instanceCount, renderCommand.instanceBuffer, renderCommand.primitiveConstants
+                );
+            }
+        }
+    }
+
+    bool RenderPipeline_OpenGL::isGPUTimestampsSupported() const
+    {
+        return GLEW_VERSION_3_3 || GLEW_ARB_timer_query;
+    }
+    bool RenderPipeline_OpenGL::startGPUTimestamps(RenderOptions* renderOptions, const int32 slotIndex, const uint32 count)
+    {
+        if (!m_TimestampQueries.isValidIndex(slotIndex))
+        {
+            m_TimestampQueries.resize(slotIndex + 1);
+        }
+
+        // Queries are reset by writing new timestamps, so only new ones should be generated
+        jarray<uint32>& queries = m_TimestampQueries[slotIndex];
+        const int32 queriesCount = queries.getSize();
+        if (queriesCount < static_cast<int32>(count))
+        {
+            queries.resize(static_cast<int32>(count), 0);
+            glGenQueries(static_cast<GLsizei>(count) - queriesCount, queries.getData() + queriesCount);
+        }
+        return true;
+    }
+    void RenderPipeline_OpenGL::writeGPUTimestamp(const RenderOptions* renderOptions, const int32 slotIndex, const uint32 timestampIndex) const
+    {
+        const uint32 query = m_TimestampQueries[slotIndex][static_cast<int32>(timestampIndex)];
+        if (renderOptions->recordingOnWorkerThread)
+        {
+            // Context is bound to main thread, timestamp will be written on replay
+            jarray<RenderCommand_OpenGL>* renderCommands = reinterpret_cast<const RenderOptions_OpenGL*>(renderOptions)->renderCommands;
+            if (renderCommands != nullptr)
+            {
+                RenderCommand_OpenGL& renderCommand = renderCommands->addDefault();
+                renderCommand.timestampQuery = query;
+            }
+            return;
+        }
+        glQueryCounter(query, GL_TIMESTAMP);
+    }
+    bool RenderPipeline_OpenGL::readGPUTimestamps(const int32 slotIndex, const uint32 count, jarray<uint64>& outTimestamps)
+    {
+        if (!m_TimestampQueries.isValidIndex(slotIndex) || (count == 0) || (m_TimestampQueries[slotIndex].getSize() < static_cast<int32>(count)))
+        {
+            return false;
+        }
+
+        // Queries are finished in order, so if the last one is available then all of them are
+        const jarray<uint32>& queries = m_TimestampQueries[slotIndex];
+        GLint available = GL_FALSE;
+        glGetQueryObjectiv(queries[static_cast<int32>(count) - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (available != GL_TRUE)
+        {
+            return false;
+        }
+
+        outTimestamps.resize(static_cast<int32>(count));
+        for (int32 index = 0; index < static_cast<int32>(count); index++)
+        {
+            GLuint64 timestamp = 0;
+            glGetQueryObjectui64v(queries[index], GL_QUERY_RESULT, &timestamp);
+            outTimestamps[index] = timestamp;
+        }
+        return true;
+    }
+}
+
+#endif
@@ -0,0 +1,56 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_OPENGL)
+
+#include "JumaRE/RenderPipeline.h"
+
+#include "RenderOptions_OpenGL.h"
+
+namespace JumaRenderEngine
+{
+    class UniformRing_OpenGL;
+
+    class RenderPipeline_OpenGL final : public RenderPipeline
+    {
+        using Super = RenderPipeline;
+
+    public:
+        RenderPipeline_OpenGL() = default;
+        virtual ~RenderPipeline_OpenGL() override;
+
+        // Valid only if persistent mapped buffers are supported
+        UniformRing_OpenGL* getUniformRing() const { return m_UniformRing; }
+
+    protected:
+
+        virtual bool isParallelRecordingSupported() const override { return true; }
+
+        virtual bool isGPUTimestampsSupported() const override;
+        virtual bool startGPUTimestamps(RenderOptions* renderOptions, int32 slotIndex, uint32 count) override;
+        virtual void writeGPUTimestamp(const RenderOptions* renderOptions, int32 slotIndex, uint32 timestampIndex) const override;
+        virtual bool readGPUTimestamps(int32 slotIndex, uint32 count, jarray<uint64>& outTimestamps) override;
+
+        virtual void renderInternal() override;
+
+        virtual bool onStartRender(RenderOptions* renderOptions) override;
+        virtual void onFinishRender(RenderOptions* renderOptions) override;
+
+        virtual bool onStartRecordRenderTarget(RenderOptions* renderOptions, RenderOptions* recordRenderOptions, RenderTarget* renderTarget) override;
+        virtual void submitRecordedRenderTarget(RenderOptions* renderOptions, RenderOptions* recordRenderOptions, RenderTarget* renderTarget) override;
+
+    private:
+
+        jmap<render_target_id, jarray<RenderCommand_OpenGL>> m_RecordedRenderCommands;
+        jarray<jarray<uint32>> m_TimestampQueries;
+
+        UniformRing_OpenGL* m_UniformRing = nullptr;
+        bool m_UniformRingCreated = false;
+
+
+        void clearOpenGL();
+    };
+}
+
+#endif
@@ -8,6 +8,7 @@
 
 #include "JumaRE/RenderEngine.h"
 
+#include "RenderEngine_OpenGL.h"
 #include "TextureFormat_OpenGL.h"
 #include "Texture_OpenGL.h"
 #include "window/WindowController_OpenGL.h"
@@ -128,6 +129,7 @@ namespace JumaRenderEngine
             }
             else
             {
+                getRenderEngine<RenderEngine_OpenGL>()->releaseBindlessTextureHandles(m_ColorAttachment);
                 glDeleteTextures(1, &m_ColorAttachment);
             }
             m_ColorAttachment = 0;
@@ -139,6 +141,7 @@ namespace JumaRenderEngine
             }
             if (m_ResolveColorAttachment != 0)
             {
+                getRenderEngine<RenderEngine_OpenGL>()->releaseBindlessTextureHandles(m_ResolveColorAttachment);
                 glDeleteTextures(1, &m_ResolveColorAttachment);
                 m_ResolveColorAttachment = 0;
             }
@@ -152,8 +155,24 @@ namespace JumaRenderEngine
     }
     void RenderTarget_OpenGL::clearOpenGL()
     {
+        clearReadbackBuffers();
         clearFramebuffers();
     }
+    void RenderTarget_OpenGL::clearReadbackBuffers()
+    {
+        for (const auto& readbackBuffer : m_ReadbackBuffers)
+        {
+            if (readbackBuffer.copyFence != nullptr)
+            {
+                glDeleteSync(static_cast<GLsync>(readbackBuffer.copyFence));
+            }
+            if (readbackBuffer.pixelBuffer != 0)
+            {
+                glDeleteBuffers(1, &readbackBuffer.pixelBuffer);
+            }
+        }
+        m_ReadbackBuffers.clear();
+    }
 
     bool RenderTarget_OpenGL::recreateRenderTarget()
     {
@@ -169,14 +188,23 @@ namespace JumaRenderEngine
             return false;
         }
 
-        getRenderEngine()->getWindowController<WindowController_OpenGL>()->setActiveWindowID(getWindowID());
+        WindowController_OpenGL* windowController = getRenderEngine()->getWindowController<WindowController_OpenGL>();
+        windowController->setActiveWindowID(getWindowID());
+        StateCache_OpenGL* stateCache = windowController->getActiveStateCache();
+        if (stateCache == nullptr)
+        {
+            JUTILS_LOG(error, JSTR("Failed to get OpenGL state cache for window {}"), windowController->getActiveWindowID());
+            return false;
+        }
+        stateCache->reset();
+        getRenderEngine<RenderEngine_OpenGL>()->updateBindlessTextureResidency(stateCache);
         glBindFramebuffer(GL_FRAMEBUFFER, m_Framebuffer);
 
-        glDepthMask(GL_TRUE);
+        stateCache->setDepthMask(true);
         glClearColor(1.0f, 1.0f, 1.0f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
         glFrontFace(GL_CW);
-        glEnable(GL_CULL_FACE);
+        stateCache->setEnabled(StateCapability_OpenGL::CullFace, true);
 
         const math::uvector2 size = getSize();
         glViewport(0, 0, static_cast<GLsizei>(size.x), static_cast<GLsizei>(size.y));
@@ -184,6 +212,9 @@ namespace JumaRenderEngine
     }
     void RenderTarget_OpenGL::onFinishRender(RenderOptions* renderOptions)
     {
+        StateCache_OpenGL* stateCache = getRenderEngine()->getWindowController<WindowController_OpenGL>()->getActiveStateCache();
+        // Element buffer bindings outside of render are stored in bound VAO, so it should be unbound here
+        stateCache->bindVertexArray(0);
         glBindFramebuffer(GL_FRAMEBUFFER, 0);
         if (getSampleCount() != TextureSamples::X1)
         {
@@ -201,18 +232,102 @@ namespace JumaRenderEngine
         const uint32 resultTextureIndex = getResultTextureIndex();
         if (resultTextureIndex != 0)
         {
-            glBindTexture(GL_TEXTURE_2D, resultTextureIndex);
+            stateCache->bindTexture(0, resultTextureIndex);
             glGenerateMipmap(GL_TEXTURE_2D);
-            glBindTexture(GL_TEXTURE_2D, 0);
+            stateCache->bindTexture(0, 0);
         }
 
         Super::onFinishRender(renderOptions);
     }
 
-    bool RenderTarget_OpenGL::bindToShader(const uint32 bindIndex) const
+    bool RenderTarget_OpenGL::bindToShader(StateCache_OpenGL* stateCache, const uint32 bindIndex) const
     {
         const uint32 resultTextureIndex = getResultTextureIndex();
-        return resultTextureIndex != 0 ? Texture_OpenGL::bindToShader(this, resultTextureIndex, bindIndex, getSamplerType()) : false;
+        return resultTextureIndex != 0 ? Texture_OpenGL::bindToShader(stateCache, this, resultTextureIndex, bindIndex, getSamplerType()) : false;
+    }
+
+    bool RenderTarget_OpenGL::copyToReadbackBuffer(RenderOptions* renderOptions, const int32 bufferIndex, const math::uvector2& offset, 
+        const math::uvector2& size)
+    {
+        const GLuint framebuffer = m_ResolveFramebuffer != 0 ? m_ResolveFramebuffer : m_Framebuffer;
+        if (framebuffer == 0)
+        {
+            return false;
+        }
+        if (!m_ReadbackBuffers.isValidIndex(bufferIndex))
+        {
+            m_ReadbackBuffers.resize(bufferIndex + 1);
+        }
+
+        ReadbackBuffer& readbackBuffer = m_ReadbackBuffers[bufferIndex];
+        const uint32 dataSize = size.x * size.y * 4;
+        if (readbackBuffer.pixelBuffer == 0)
+        {
+            glGenBuffers(1, &readbackBuffer.pixelBuffer);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffer.pixelBuffer);
+        if (readbackBuffer.bufferSize < dataSize)
+        {
+            glBufferData(GL_PIXEL_PACK_BUFFER, dataSize, nullptr, GL_STREAM_READ);
+            readbackBuffer.bufferSize = dataSize;
+        }
+
+        // OpenGL framebuffer origin is the bottom left corner
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, framebuffer);
+        glPixelStorei(GL_PACK_ALIGNMENT, 4);
+        glReadPixels(
+            static_cast<GLint>(offset.x), static_cast<GLint>(getSize().y - offset.y - size.y), 
+            static_cast<GLsizei>(size.x), static_cast<GLsizei>(size.y), 
+            GL_RGBA, GL_UNSIGNED_BYTE, nullptr
+        );
+        glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        if (readbackBuffer.copyFence != nullptr)
+        {
+            glDeleteSync(static_cast<GLsync>(readbackBuffer.copyFence));
+        }
+        readbackBuffer.copyFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        readbackBuffer.dataSize = size;
+        return true;
+    }
+    bool RenderTarget_OpenGL::mapReadbackBuffer(const int32 bufferIndex, const uint8*& outData, int32& outRowPitch)
+    {
+        ReadbackBuffer& readbackBuffer = m_ReadbackBuffers[bufferIndex];
+        if (readbackBuffer.copyFence != nullptr)
+        {
+            const GLenum waitResult = glClientWaitSync(static_cast<GLsync>(readbackBuffer.copyFence), 0, 0);
+            if (waitResult == GL_TIMEOUT_EXPIRED)
+            {
+                return false;
+            }
+            glDeleteSync(static_cast<GLsync>(readbackBuffer.copyFence));
+            readbackBuffer.copyFence = nullptr;
+        }
+
+        const int32 rowPitch = static_cast<int32>(readbackBuffer.dataSize.x * 4);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readbackBuffer.pixelBuffer);
+        const uint8* data = static_cast<const uint8*>(glMapBufferRange(GL_PIXEL_PACK_BUFFER, 
+            0, static_cast<GLsizeiptr>(rowPitch) * readbackBuffer.dataSize.y, GL_MAP_READ_BIT
+        ));
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        if (data == nullptr)
+        {
+            JUTILS_LOG(error, JSTR("Failed to map OpenGL readback buffer"));
+            outData = nullptr;
+            return true;
+        }
+
+        // Rows are bottom-up, so start from the last one
+        outData = data + static_cast<int64>(rowPitch) * (readbackBuffer.dataSize.y - 1);
+        outRowPitch = -rowPitch;
+        return true;
+    }
+    void RenderTarget_OpenGL::unmapReadbackBuffer(const int32 bufferIndex)
+    {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, m_ReadbackBuffers[bufferIndex].pixelBuffer);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
     }
 }
 
@@ -8,6 +8,8 @@
 
 namespace JumaRenderEngine
 {
+    class StateCache_OpenGL;
+
     class RenderTarget_OpenGL final : public RenderTarget
     {
         using Super = RenderTarget;
@@ -21,7 +23,7 @@ namespace JumaRenderEngine
         virtual bool onStartRender(RenderOptions* renderOptions) override;
         virtual void onFinishRender(RenderOptions* renderOptions) override;
 
-        bool bindToShader(uint32 bindIndex) const;
+        bool bindToShader(StateCache_OpenGL* stateCache, uint32 bindIndex) const;
 
     protected:
 
@@ -30,8 +32,22 @@ namespace JumaRenderEngine
 
         virtual bool recreateRenderTarget() override;
 
+        virtual bool isReadbackSupported() const override { return true; }
+        virtual bool copyToReadbackBuffer(RenderOptions* renderOptions, int32 bufferIndex, const math::uvector2& offset, const math::uvector2& size) override;
+        virtual bool mapReadbackBuffer(int32 bufferIndex, const uint8*& outData, int32& outRowPitch) override;
+        virtual void unmapReadbackBuffer(int32 bufferIndex) override;
+
     private:
 
+        struct ReadbackBuffer
+        {
+            uint32 pixelBuffer = 0;
+            uint32 bufferSize = 0;
+            math::uvector2 dataSize = { 0, 0 };
+            // GLsync of the copy
+            void* copyFence = nullptr;
+        };
+
         uint32 m_ColorAttachment = 0;
         uint32 m_DepthAttachment = 0;
         uint32 m_ResolveColorAttachment = 0;
@@ -39,9 +55,12 @@ namespace JumaRenderEngine
         uint32 m_Framebuffer = 0;
         uint32 m_ResolveFramebuffer = 0;
 
+        jarray<ReadbackBuffer> m_ReadbackBuffers;
+
 
         void createFramebuffers();
         void clearFramebuffers();
+        void clearReadbackBuffers();
 
         void clearOpenGL();
     };
@@ -4,9 +4,15 @@
 
 #include "Shader_OpenGL.h"
 
+#include <cstring>
 #include <fstream>
 #include <GL/glew.h>
 
+#include "RenderPipeline_OpenGL.h"
+#include "StateCache_OpenGL.h"
+#include "UniformRing_OpenGL.h"
+#include "JumaRE/RenderEngine.h"
+
 namespace JumaRenderEngine
 {
     jarray<jstring> LoadOpenGLShaderFile(const jstring& fileName, const bool shouldLogErrors)
@@ -214,6 +220,11 @@ namespace JumaRenderEngine
     }
     void Shader_OpenGL::clearOpenGL()
     {
+        if (m_PrimitiveConstantsBuffer != 0)
+        {
+            glDeleteBuffers(1, &m_PrimitiveConstantsBuffer);
+            m_PrimitiveConstantsBuffer = 0;
+        }
         if (m_ShaderProgramIndex != 0)
         {
             glDeleteProgram(m_ShaderProgramIndex);
@@ -221,18 +232,55 @@ namespace JumaRenderEngine
         }
     }
 
-    bool Shader_OpenGL::activateShader() const
+    bool Shader_OpenGL::activateShader(StateCache_OpenGL* stateCache) const
     {
         if (m_ShaderProgramIndex != 0)
         {
-            glUseProgram(m_ShaderProgramIndex);
+            stateCache->useProgram(m_ShaderProgramIndex);
             return true;
         }
         return false;
     }
-    void Shader_OpenGL::deactivateAnyShader()
+    bool Shader_OpenGL::bindPrimitiveConstants(const void* data, StateCache_OpenGL* stateCache)
     {
-        glUseProgram(0);
+        if (!hasPrimitiveConstants())
+        {
+            return true;
+        }
+
+        const ShaderPrimitiveConstants& primitiveConstants = getPrimitiveConstants();
+        const RenderPipeline_OpenGL* renderPipeline = dynamic_cast<const RenderPipeline_OpenGL*>(getRenderEngine()->getRenderPipeline());
+        UniformRing_OpenGL* uniformRing = renderPipeline != nullptr ? renderPipeline->getUniformRing() : nullptr;
+        if (uniformRing != nullptr)
+        {
+            uint32 offset = 0;
+            uint8* ringData = uniformRing->allocate(primitiveConstants.size, offset);
+            if (ringData == nullptr)
+            {
+                return false;
+            }
+            std::memcpy(ringData, data, primitiveConstants.size);
+            stateCache->bindUniformBufferRange(primitiveConstants.shaderLocation, uniformRing->get(), offset, primitiveConstants.size);
+        }
+        else
+        {
+            // Driver handles synchronization of the buffer between draws
+            if (m_PrimitiveConstantsBuffer == 0)
+            {
+                glGenBuffers(1, &m_PrimitiveConstantsBuffer);
+                glBindBuffer(GL_UNIFORM_BUFFER, m_PrimitiveConstantsBuffer);
+                glBufferData(GL_UNIFORM_BUFFER, primitiveConstants.size, data, GL_STREAM_DRAW);
+            }
+            else
+            {
+                glBindBuffer(GL_UNIFORM_BUFFER, m_PrimitiveConstantsBuffer);
+                glBufferSubData(GL_UNIFORM_BUFFER, 0, primitiveConstants.size, data);
+            }
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            stateCache->bindUniformBuffer(primitiveConstants.shaderLocation, m_PrimitiveConstantsBuffer);
+        }
+        getRenderEngine()->addFrameCounter(RenderFrameCounter::UploadedBytes, primitiveConstants.size);
+        return true;
     }
 }
 
@@ -8,6 +8,8 @@
 
 namespace JumaRenderEngine
 {
+    class StateCache_OpenGL;
+
     class Shader_OpenGL final : public Shader
     {
         using Super = Shader;
@@ -16,8 +18,9 @@ namespace JumaRenderEngine
         Shader_OpenGL() = default;
         virtual ~Shader_OpenGL() override;
 
-        bool activateShader() const;
-        static void deactivateAnyShader();
+        bool activateShader(StateCache_OpenGL* stateCache) const;
+        // Returns false if data could not be uploaded, so primitive shouldn't be drawn
+        bool bindPrimitiveConstants(const void* data, StateCache_OpenGL* stateCache);
 
     protected:
 
@@ -27,6 +30,8 @@ namespace JumaRenderEngine
     private:
 
         uint32 m_ShaderProgramIndex = 0;
+        // Used only if uniform ring is not available
+        uint32 m_PrimitiveConstantsBuffer = 0;
 
 
         void clearOpenGL();
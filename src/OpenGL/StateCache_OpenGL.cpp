@@ -0,0 +1,205 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#if defined(JUMARE_ENABLE_OPENGL)
+
+#include "StateCache_OpenGL.h"
+
+#include <GL/glew.h>
+
+namespace JumaRenderEngine
+{
+    template<typename T>
+    static T& GetCachedValue(jarray<T>& values, const uint32 index, const T& unknownValue)
+    {
+        if (!values.isValidIndex(static_cast<int32>(index)))
+        {
+            values.resize(static_cast<int32>(index) + 1, unknownValue);
+        }
+        return values[static_cast<int32>(index)];
+    }
+
+    void StateCache_OpenGL::reset()
+    {
+        for (int32 index = 0; index < m_Textures.getSize(); index++)
+        {
+            if ((m_Textures[index] != 0) && (m_Textures[index] != UnknownValue))
+            {
+                bindTexture(static_cast<uint32>(index), 0);
+            }
+        }
+
+        m_Program = UnknownValue;
+        m_VertexArray = UnknownValue;
+        m_ActiveTextureUnit = UnknownValue;
+        m_UniformBuffers.clear();
+        m_Samplers.clear();
+        for (auto& capability : m_Capabilities)
+        {
+            capability = UnknownFlag;
+        }
+        m_DepthMask = UnknownFlag;
+        m_PolygonMode = UnknownValue;
+        m_CullFace = UnknownValue;
+        m_BlendSourceFactor = UnknownValue;
+        m_BlendDestinationFactor = UnknownValue;
+    }
+
+    void StateCache_OpenGL::useProgram(const uint32 program)
+    {
+        if (m_Program != program)
+        {
+            glUseProgram(program);
+            m_Program = program;
+        }
+    }
+    void StateCache_OpenGL::bindVertexArray(const uint32 vertexArray)
+    {
+        if (m_VertexArray != vertexArray)
+        {
+            glBindVertexArray(vertexArray);
+            m_VertexArray = vertexArray;
+        }
+    }
+
+    void StateCache_OpenGL::bindUniformBuffer(const uint32 bindIndex, const uint32 buffer)
+    {
+        UniformBufferBinding& binding = GetCachedValue(m_UniformBuffers, bindIndex, UniformBufferBinding());
+        if ((binding.buffer != buffer) || (binding.size != 0))
+        {
+            glBindBufferBase(GL_UNIFORM_BUFFER, bindIndex, buffer);
+            binding = { buffer, 0, 0 };
+        }
+    }
+    void StateCache_OpenGL::bindUniformBufferRange(const uint32 bindIndex, const uint32 buffer, const uint32 offset, const uint32 size)
+    {
+        UniformBufferBinding& binding = GetCachedValue(m_UniformBuffers, bindIndex, UniformBufferBinding());
+        if ((binding.buffer != buffer) || (binding.offset != offset) || (binding.size != size))
+        {
+            glBindBufferRange(GL_UNIFORM_BUFFER, bindIndex, buffer, offset, size);
+            binding = { buffer, offset, size };
+        }
+    }
+
+    void StateCache_OpenGL::setActiveTextureUnit(const uint32 bindIndex)
+    {
+        if (m_ActiveTextureUnit != bindIndex)
+        {
+            glActiveTexture(GL_TEXTURE0 + bindIndex);
+            m_ActiveTextureUnit = bindIndex;
+        }
+    }
+    void StateCache_OpenGL::bindTexture(const uint32 bindIndex, const uint32 texture)
+    {
+        uint32& cachedTexture = GetCachedValue(m_Textures, bindIndex, UnknownValue);
+        if (cachedTexture != texture)
+        {
+            setActiveTextureUnit(bindIndex);
+            glBindTexture(GL_TEXTURE_2D, texture);
+            cachedTexture = texture;
+        }
+    }
+    void StateCache_OpenGL::bindSampler(const uint32 bindIndex, const uint32 sampler)
+    {
+        uint32& cachedSampler = GetCachedValue(m_Samplers, bindIndex, UnknownValue);
+        if (cachedSampler != sampler)
+        {
+            glBindSampler(bindIndex, sampler);
+            cachedSampler = sampler;
+        }
+    }
+
+    void StateCache_OpenGL::setEnabled(const StateCapability_OpenGL capability, const bool enabled)
+    {
+        int8& cachedEnabled = m_Capabilities[static_cast<uint8>(capability)];
+        if (cachedEnabled == static_cast<int8>(enabled))
+        {
+            return;
+        }
+
+        GLenum capabilityOpenGL;
+        switch (capability)
+        {
+        case StateCapability_OpenGL::DepthTest: capabilityOpenGL = GL_DEPTH_TEST; break;
+        case StateCapability_OpenGL::StencilTest: capabilityOpenGL = GL_STENCIL_TEST; break;
+        case StateCapability_OpenGL::Blend: capabilityOpenGL = GL_BLEND; break;
+        case StateCapability_OpenGL::CullFace: capabilityOpenGL = GL_CULL_FACE; break;
+        default: return;
+        }
+        if (enabled)
+        {
+            glEnable(capabilityOpenGL);
+        }
+        else
+        {
+            glDisable(capabilityOpenGL);
+        }
+        cachedEnabled = static_cast<int8>(enabled);
+    }
+    void StateCache_OpenGL::setDepthMask(const bool enabled)
+    {
+        if (m_DepthMask != static_cast<int8>(enabled))
+        {
+            glDepthMask(enabled ? GL_TRUE : GL_FALSE);
+            m_DepthMask = static_cast<int8>(enabled);
+        }
+    }
+    void StateCache_OpenGL::setPolygonMode(const uint32 mode)
+    {
+        if (m_PolygonMode != mode)
+        {
+            glPolygonMode(GL_FRONT_AND_BACK, mode);
+            m_PolygonMode = mode;
+        }
+    }
+    void StateCache_OpenGL::setCullFace(const uint32 mode)
+    {
+        if (m_CullFace != mode)
+        {
+            glCullFace(mode);
+            m_CullFace = mode;
+        }
+    }
+    void StateCache_OpenGL::setBlendFunc(const uint32 sourceFactor, const uint32 destinationFactor)
+    {
+        if ((m_BlendSourceFactor != sourceFactor) || (m_BlendDestinationFactor != destinationFactor))
+        {
+            glBlendFunc(sourceFactor, destinationFactor);
+            m_BlendSourceFactor = sourceFactor;
+            m_BlendDestinationFactor = destinationFactor;
+        }
+    }
+
+    void StateCache_OpenGL::makeTextureHandleResident(const uint64 handle)
+    {
+        if ((handle != 0) && !m_ResidentTextureHandles.contains(handle))
+        {
+            glMakeTextureHandleResidentARB(handle);
+            m_ResidentTextureHandles.add(handle);
+        }
+    }
+    void StateCache_OpenGL::updateResidentTextureHandles(const uint64 validHandlesVersion, const jset<uint64>& validHandles)
+    {
+        if (m_ValidTextureHandlesVersion == validHandlesVersion)
+        {
+            return;
+        }
+        m_ValidTextureHandlesVersion = validHandlesVersion;
+
+        // Memory of deleted texture is freed only after its handles are non-resident in every context
+        jarray<uint64> releasedHandles;
+        for (const auto& handle : m_ResidentTextureHandles)
+        {
+            if (!validHandles.contains(handle))
+            {
+                releasedHandles.add(handle);
+            }
+        }
+        for (const auto& handle : releasedHandles)
+        {
+            glMakeTextureHandleNonResidentARB(handle);
+            m_ResidentTextureHandles.remove(handle);
+        }
+    }
+}
+
+#endif
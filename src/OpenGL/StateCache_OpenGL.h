@@ -0,0 +1,80 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_OPENGL)
+
+#include "JumaRE/core.h"
+
+#include <jutils/jarray.h>
+#include <jutils/jset.h>
+
+namespace JumaRenderEngine
+{
+    enum class StateCapability_OpenGL : uint8 { DepthTest, StencilTest, Blend, CullFace };
+
+    // Shadow copy of the state of one OpenGL context, only real changes are passed to the driver.
+    // State is reset when render target starts, so changes made outside of the cache between render targets are allowed
+    class StateCache_OpenGL final
+    {
+    public:
+        StateCache_OpenGL() = default;
+
+        // Unbinds textures which could be attached to the next render target and forgets the rest of the state
+        void reset();
+
+        void useProgram(uint32 program);
+        void bindVertexArray(uint32 vertexArray);
+        void bindUniformBuffer(uint32 bindIndex, uint32 buffer);
+        void bindUniformBufferRange(uint32 bindIndex, uint32 buffer, uint32 offset, uint32 size);
+        void bindTexture(uint32 bindIndex, uint32 texture);
+        void bindSampler(uint32 bindIndex, uint32 sampler);
+
+        void setEnabled(StateCapability_OpenGL capability, bool enabled);
+        void setDepthMask(bool enabled);
+        void setPolygonMode(uint32 mode);
+        void setCullFace(uint32 mode);
+        void setBlendFunc(uint32 sourceFactor, uint32 destinationFactor);
+
+        // Residency of bindless texture handles is the state of context, it's not changed by reset()
+        void makeTextureHandleResident(uint64 handle);
+        // Makes non-resident handles which are not in the valid set, if they were changed since last call
+        void updateResidentTextureHandles(uint64 validHandlesVersion, const jset<uint64>& validHandles);
+
+    private:
+
+        static constexpr uint32 UnknownValue = ~static_cast<uint32>(0);
+        static constexpr int8 UnknownFlag = -1;
+        static constexpr int32 CapabilitiesCount = 4;
+
+        struct UniformBufferBinding
+        {
+            uint32 buffer = UnknownValue;
+            // Size 0 means the whole buffer is bound
+            uint32 offset = 0;
+            uint32 size = 0;
+        };
+
+        uint32 m_Program = UnknownValue;
+        uint32 m_VertexArray = UnknownValue;
+        jarray<UniformBufferBinding> m_UniformBuffers;
+        uint32 m_ActiveTextureUnit = UnknownValue;
+        jarray<uint32> m_Textures;
+        jarray<uint32> m_Samplers;
+
+        int8 m_Capabilities[CapabilitiesCount] = { UnknownFlag, UnknownFlag, UnknownFlag, UnknownFlag };
+        int8 m_DepthMask = UnknownFlag;
+        uint32 m_PolygonMode = UnknownValue;
+        uint32 m_CullFace = UnknownValue;
+        uint32 m_BlendSourceFactor = UnknownValue;
+        uint32 m_BlendDestinationFactor = UnknownValue;
+
+        jset<uint64> m_ResidentTextureHandles;
+        uint64 m_ValidTextureHandlesVersion = 0;
+
+
+        void setActiveTextureUnit(uint32 bindIndex);
+    };
+}
+
+#endif
@@ -7,6 +7,7 @@
 #include <GL/glew.h>
 
 #include "RenderEngine_OpenGL.h"
+#include "StateCache_OpenGL.h"
 #include "TextureFormat_OpenGL.h"
 
 namespace JumaRenderEngine
@@ -39,13 +40,14 @@ namespace JumaRenderEngine
     {
         if (m_TextureIndex != 0)
         {
+            getRenderEngine<RenderEngine_OpenGL>()->releaseBindlessTextureHandles(m_TextureIndex);
             glDeleteTextures(1, &m_TextureIndex);
             m_TextureIndex = 0;
         }
     }
 
-    bool Texture_OpenGL::bindToShader(const RenderEngineContextObjectBase* contextObject, const uint32 textureIndex, const uint32 bindIndex, 
-        const TextureSamplerType sampler)
+    bool Texture_OpenGL::bindToShader(StateCache_OpenGL* stateCache, const RenderEngineContextObjectBase* contextObject, const uint32 textureIndex, 
+        const uint32 bindIndex, const TextureSamplerType sampler)
     {
         if (textureIndex == 0)
         {
@@ -54,17 +56,10 @@ namespace JumaRenderEngine
 
         const uint32 samplerIndex = contextObject->getRenderEngine<RenderEngine_OpenGL>()->getTextureSamplerIndex(sampler);
 
-        glActiveTexture(GL_TEXTURE0 + bindIndex);
-        glBindTexture(GL_TEXTURE_2D, textureIndex);
-        glBindSampler(bindIndex, samplerIndex);
+        stateCache->bindTexture(bindIndex, textureIndex);
+        stateCache->bindSampler(bindIndex, samplerIndex);
         return true;
     }
-    void Texture_OpenGL::unbindTexture(const uint32 bindIndex)
-    {
-        glActiveTexture(GL_TEXTURE0 + bindIndex);
-        glBindTexture(GL_TEXTURE_2D, 0);
-        glBindSampler(bindIndex, 0);
-    }
 }
 
 #endif
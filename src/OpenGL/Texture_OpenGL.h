@@ -8,6 +8,8 @@
 
 namespace JumaRenderEngine
 {
+    class StateCache_OpenGL;
+
     class Texture_OpenGL final : public Texture
     {
         using Super = Texture;
@@ -16,9 +18,11 @@ namespace JumaRenderEngine
         Texture_OpenGL() = default;
         virtual ~Texture_OpenGL() override;
 
-        bool bindToShader(const uint32 bindIndex) const { return bindToShader(this, m_TextureIndex, bindIndex, getSamplerType()); }
-        static bool bindToShader(const RenderEngineContextObjectBase* contextObject, uint32 textureIndex, uint32 bindIndex, TextureSamplerType sampler);
-        static void unbindTexture(uint32 bindIndex);
+        uint32 getTextureIndex() const { return m_TextureIndex; }
+
+        bool bindToShader(StateCache_OpenGL* stateCache, const uint32 bindIndex) const { return bindToShader(stateCache, this, m_TextureIndex, bindIndex, getSamplerType()); }
+        static bool bindToShader(StateCache_OpenGL* stateCache, const RenderEngineContextObjectBase* contextObject, uint32 textureIndex, uint32 bindIndex, 
+            TextureSamplerType sampler);
 
     protected:
 
@@ -0,0 +1,176 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#if defined(JUMARE_ENABLE_OPENGL)
+
+#include "UniformRing_OpenGL.h"
+
+#include <GL/glew.h>
+
+namespace JumaRenderEngine
+{
+    UniformRing_OpenGL::~UniformRing_OpenGL()
+    {
+        clearOpenGL();
+    }
+
+    bool UniformRing_OpenGL::IsSupported()
+    {
+        return GLEW_VERSION_4_4 || GLEW_ARB_buffer_storage;
+    }
+
+    bool UniformRing_OpenGL::init(const uint32 segmentSize, const int32 segmentsCount)
+    {
+        if (isValid())
+        {
+            JUTILS_LOG(error, JSTR("Uniform ring already initialized"));
+            return false;
+        }
+        if ((segmentSize == 0) || (segmentsCount <= 0) || !IsSupported())
+        {
+            return false;
+        }
+
+        GLint alignment = 0;
+        glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+        m_Alignment = static_cast<uint32>(math::max(alignment, 1));
+        m_SegmentFences.resize(segmentsCount, nullptr);
+        if (!createBuffer(segmentSize))
+        {
+            m_SegmentFences.clear();
+            return false;
+        }
+
+        markAsInitialized();
+        return true;
+    }
+    bool UniformRing_OpenGL::createBuffer(const uint32 segmentSize)
+    {
+        const uint32 alignedSegmentSize = (segmentSize + m_Alignment - 1) / m_Alignment * m_Alignment;
+        const GLsizeiptr bufferSize = static_cast<GLsizeiptr>(alignedSegmentSize) * m_SegmentFences.getSize();
+        constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+        glGenBuffers(1, &m_Buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, m_Buffer);
+        glBufferStorage(GL_UNIFORM_BUFFER, bufferSize, nullptr, flags);
+        m_MappedData = static_cast<uint8*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, bufferSize, flags));
+        glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        if (m_MappedData == nullptr)
+        {
+            JUTILS_LOG(error, JSTR("Failed to map uniform ring buffer"));
+            clearBuffer();
+            return false;
+        }
+
+        m_SegmentSize = alignedSegmentSize;
+        m_Offset = m_SegmentEnd = 0;
+        return true;
+    }
+
+    void UniformRing_OpenGL::clearOpenGL()
+    {
+        for (auto& fence : m_SegmentFences)
+        {
+            WaitForFence(fence);
+        }
+        m_SegmentFences.clear();
+        clearBuffer();
+
+        m_Alignment = 0;
+        m_SegmentIndex = -1;
+        m_RequiredSegmentSize = 0;
+        m_FrameIndex = 0;
+    }
+    void UniformRing_OpenGL::clearBuffer()
+    {
+        if (m_Buffer != 0)
+        {
+            if (m_MappedData != nullptr)
+            {
+                glBindBuffer(GL_UNIFORM_BUFFER, m_Buffer);
+                glUnmapBuffer(GL_UNIFORM_BUFFER);
+                glBindBuffer(GL_UNIFORM_BUFFER, 0);
+                m_MappedData = nullptr;
+            }
+            glDeleteBuffers(1, &m_Buffer);
+            m_Buffer = 0;
+        }
+        m_SegmentSize = 0;
+        m_Offset = m_SegmentEnd = 0;
+    }
+
+    void UniformRing_OpenGL::WaitForFence(void*& fence)
+    {
+        if (fence == nullptr)
+        {
+            return;
+        }
+        GLenum waitResult = GL_TIMEOUT_EXPIRED;
+        while (waitResult == GL_TIMEOUT_EXPIRED)
+        {
+            waitResult = glClientWaitSync(static_cast<GLsync>(fence), GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }
+        glDeleteSync(static_cast<GLsync>(fence));
+        fence = nullptr;
+    }
+
+    bool UniformRing_OpenGL::startFrame()
+    {
+        if (!isValid())
+        {
+            return false;
+        }
+
+        if (m_RequiredSegmentSize > m_SegmentSize)
+        {
+            // Whole buffer is recreated, so all segments should be finished
+            const uint32 segmentSize = math::max(m_SegmentSize * 2, m_RequiredSegmentSize);
+            JUTILS_LOG(warning, JSTR("Uniform ring is full, enlarging segment to {} bytes"), segmentSize);
+            for (auto& fence : m_SegmentFences)
+            {
+                WaitForFence(fence);
+            }
+            clearBuffer();
+            if (!createBuffer(segmentSize))
+            {
+                clear();
+                return false;
+            }
+        }
+
+        m_SegmentIndex = (m_SegmentIndex + 1) % m_SegmentFences.getSize();
+        WaitForFence(m_SegmentFences[m_SegmentIndex]);
+        m_Offset = m_SegmentSize * static_cast<uint32>(m_SegmentIndex);
+        m_SegmentEnd = m_Offset + m_SegmentSize;
+        m_RequiredSegmentSize = 0;
+        m_FrameIndex++;
+        return true;
+    }
+    void UniformRing_OpenGL::finishFrame()
+    {
+        if (isValid() && (m_SegmentIndex >= 0))
+        {
+            void*& fence = m_SegmentFences[m_SegmentIndex];
+            if (fence != nullptr)
+            {
+                glDeleteSync(static_cast<GLsync>(fence));
+            }
+            fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+            m_Offset = m_SegmentEnd;
+        }
+    }
+
+    uint8* UniformRing_OpenGL::allocate(const uint32 size, uint32& outOffset)
+    {
+        const uint32 alignedSize = (size + m_Alignment - 1) / m_Alignment * m_Alignment;
+        m_RequiredSegmentSize += alignedSize;
+        if ((m_MappedData == nullptr) || (size == 0) || ((m_Offset + alignedSize) > m_SegmentEnd))
+        {
+            return nullptr;
+        }
+        outOffset = m_Offset;
+        m_Offset += alignedSize;
+        return m_MappedData + outOffset;
+    }
+}
+
+#endif
@@ -0,0 +1,61 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_OPENGL)
+
+#include "JumaRE/RenderEngineContextObject.h"
+
+#include <jutils/jarray.h>
+
+namespace JumaRenderEngine
+{
+    // Persistently mapped uniform buffer split into segments, one segment is written per frame
+    class UniformRing_OpenGL final : public RenderEngineContextObject
+    {
+    public:
+        UniformRing_OpenGL() = default;
+        virtual ~UniformRing_OpenGL() override;
+
+        static bool IsSupported();
+
+        bool init(uint32 segmentSize, int32 segmentsCount);
+
+        uint32 get() const { return m_Buffer; }
+        uint64 getFrameIndex() const { return m_FrameIndex; }
+
+        // Waits until GPU finished reading the next segment
+        bool startFrame();
+        void finishFrame();
+
+        // Returns nullptr if segment is full, it will be enlarged in the next frame
+        uint8* allocate(uint32 size, uint32& outOffset);
+
+    protected:
+
+        virtual void clearInternal() override { clearOpenGL(); }
+
+    private:
+
+        uint32 m_Buffer = 0;
+        uint8* m_MappedData = nullptr;
+        jarray<void*> m_SegmentFences;
+
+        uint32 m_SegmentSize = 0;
+        uint32 m_Alignment = 0;
+        int32 m_SegmentIndex = -1;
+        uint32 m_Offset = 0;
+        uint32 m_SegmentEnd = 0;
+        uint32 m_RequiredSegmentSize = 0;
+        uint64 m_FrameIndex = 0;
+
+
+        bool createBuffer(uint32 segmentSize);
+        void clearBuffer();
+        void clearOpenGL();
+
+        static void WaitForFence(void*& fence);
+    };
+}
+
+#endif
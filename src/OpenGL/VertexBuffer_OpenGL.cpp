@@ -8,10 +8,13 @@
 
 #include "JumaRE/RenderEngine.h"
 #include "JumaRE/RenderOptions.h"
+#include "JumaRE/RenderPrimitivesList.h"
 #include "JumaRE/RenderTarget.h"
 #include "JumaRE/vertex/VertexBufferData.h"
 
 #include "Material_OpenGL.h"
+#include "RenderOptions_OpenGL.h"
+#include "Shader_OpenGL.h"
 #include "window/WindowController_OpenGL.h"
 
 namespace JumaRenderEngine
@@ -85,40 +88,75 @@ namespace JumaRenderEngine
         m_RenderElementsCount = 0;
     }
 
-    void VertexBuffer_OpenGL::render(const RenderOptions* renderOptions, Material* material)
+    void VertexBuffer_OpenGL::render(const RenderOptions* renderOptions, const RenderPrimitive& primitive)
     {
         if (renderOptions == nullptr)
         {
             return;
         }
 
-        Material_OpenGL* materialOpenGL = dynamic_cast<Material_OpenGL*>(material);
+        Material_OpenGL* materialOpenGL = dynamic_cast<Material_OpenGL*>(primitive.material);
         if (materialOpenGL == nullptr)
         {
             return;
         }
+        VertexBuffer_OpenGL* instanceBuffer = dynamic_cast<VertexBuffer_OpenGL*>(primitive.instanceBuffer);
+        const void* primitiveConstants = GetRenderPrimitiveConstants(primitive);
 
+        if (renderOptions->recordingOnWorkerThread)
+        {
+            // OpenGL context is bound to main thread, so just record command for replay
+            const RenderOptions_OpenGL* renderOptionsOpenGL = reinterpret_cast<const RenderOptions_OpenGL*>(renderOptions);
+            renderOptionsOpenGL->renderCommands->add({
+                this, materialOpenGL, primitive.instanceCount, instanceBuffer, primitiveConstants, renderOptions->renderStageProperties
+            });
+            return;
+        }
+        draw(renderOptions, materialOpenGL, primitive.instanceCount, instanceBuffer, primitiveConstants);
+    }
+    void VertexBuffer_OpenGL::draw(const RenderOptions* renderOptions, Material_OpenGL* material, const uint32 instanceCount, 
+        VertexBuffer_OpenGL* instanceBuffer, const void* primitiveConstants)
+    {
         const window_id windowID = renderOptions->renderTarget->getWindowID();
-        const uint32 VAO = getVerticesVAO(windowID);
-        if ((VAO != 0) && materialOpenGL->bindMaterial(renderOptions))
+        StateCache_OpenGL* stateCache = getRenderEngine()->getWindowController<WindowController_OpenGL>()->getActiveStateCache();
+        const uint32 VAO = stateCache != nullptr ? getVerticesVAO(windowID, stateCache) : 0;
+        if ((VAO != 0) && material->bindMaterial(renderOptions, stateCache) && 
+            dynamic_cast<Shader_OpenGL*>(material->getShader())->bindPrimitiveConstants(primitiveConstants, stateCache))
         {
-            glBindVertexArray(VAO);
+            stateCache->bindVertexArray(VAO);
+            if (instanceBuffer != nullptr)
+            {
+                // Per-instance attributes are set for each draw, so VAO can be shared between instance buffers
+                instanceBuffer->bindVertexAttributes(1);
+            }
+            const GLsizei renderInstanceCount = static_cast<GLsizei>(instanceCount);
             if (m_IndicesBufferIndex != 0)
             {
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndicesBufferIndex);
-                glDrawElements(GL_TRIANGLES, m_RenderElementsCount, GL_UNSIGNED_INT, nullptr);
-                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+                if (renderInstanceCount > 1)
+                {
+                    glDrawElementsInstanced(GL_TRIANGLES, m_RenderElementsCount, GL_UNSIGNED_INT, nullptr, renderInstanceCount);
+                }
+                else
+                {
+                    glDrawElements(GL_TRIANGLES, m_RenderElementsCount, GL_UNSIGNED_INT, nullptr);
+                }
+            }
+            else if (renderInstanceCount > 1)
+            {
+                glDrawArraysInstanced(GL_TRIANGLES, 0, m_RenderElementsCount, renderInstanceCount);
             }
             else
             {
                 glDrawArrays(GL_TRIANGLES, 0, m_RenderElementsCount);
             }
-            glBindVertexArray(0);
-
-            materialOpenGL->unbindMaterial();
+            if (instanceBuffer != nullptr)
+            {
+                instanceBuffer->unbindVertexAttributes();
+            }
+            getRenderEngine()->addFrameCounter(RenderFrameCounter::DrawCalls);
         }
     }
-    uint32 VertexBuffer_OpenGL::getVerticesVAO(const window_id windowID)
+    uint32 VertexBuffer_OpenGL::getVerticesVAO(const window_id windowID, StateCache_OpenGL* stateCache)
     {
         const uint32* VAOPtr = m_VertexArrayIndices.find(windowID);
         if (VAOPtr != nullptr)
@@ -126,19 +164,28 @@ namespace JumaRenderEngine
             return *VAOPtr;
         }
 
-        const uint32 VAO = createVerticesVAO();
+        const uint32 VAO = createVerticesVAO(stateCache);
         return VAO != 0 ? (m_VertexArrayIndices[windowID] = VAO) : 0;
     }
-    uint32 VertexBuffer_OpenGL::createVerticesVAO() const
+    uint32 VertexBuffer_OpenGL::createVerticesVAO(StateCache_OpenGL* stateCache) const
+    {
+        uint32 VAO = 0;
+        glGenVertexArrays(1, &VAO);
+        stateCache->bindVertexArray(VAO);
+        bindVertexAttributes(0);
+        if (m_IndicesBufferIndex != 0)
+        {
+            // Element buffer binding is stored in VAO, so it's not rebound for each draw
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_IndicesBufferIndex);
+        }
+        return VAO;
+    }
+    void VertexBuffer_OpenGL::bindVertexAttributes(const uint32 divisor) const
     {
         const RenderEngine* renderEngine = getRenderEngine();
         const RegisteredVertexDescription* vertexDescription = renderEngine->findVertex(getVertexID());
 
-        uint32 VAO = 0;
-        glGenVertexArrays(1, &VAO);
         glBindBuffer(GL_ARRAY_BUFFER, m_VerticesBufferIndex);
-        glBindVertexArray(VAO);
-
         uint32 componentOffset = 0;
         for (const auto& componentID : vertexDescription->description.components)
         {
@@ -172,12 +219,25 @@ namespace JumaRenderEngine
                 static_cast<GLsizei>(vertexDescription->vertexSize), (const void*)static_cast<std::uintptr_t>(componentOffset)
             );
             glEnableVertexAttribArray(componentDescriprion->shaderLocation);
+            if (divisor > 0)
+            {
+                glVertexAttribDivisor(componentDescriprion->shaderLocation, divisor);
+            }
 
-            componentOffset = GetVertexComponentSize(componentDescriprion->type);
+            componentOffset += GetVertexComponentSize(componentDescriprion->type);
         }
-        glBindVertexArray(0);
         glBindBuffer(GL_ARRAY_BUFFER, 0);
-        return VAO;
+    }
+    void VertexBuffer_OpenGL::unbindVertexAttributes() const
+    {
+        const RenderEngine* renderEngine = getRenderEngine();
+        const RegisteredVertexDescription* vertexDescription = renderEngine->findVertex(getVertexID());
+        for (const auto& componentID : vertexDescription->description.components)
+        {
+            const VertexComponentDescription* componentDescriprion = renderEngine->findVertexComponent(componentID);
+            glVertexAttribDivisor(componentDescriprion->shaderLocation, 0);
+            glDisableVertexAttribArray(componentDescriprion->shaderLocation);
+        }
     }
 }
 
@@ -12,6 +12,9 @@
 
 namespace JumaRenderEngine
 {
+    class Material_OpenGL;
+    class StateCache_OpenGL;
+
     class VertexBuffer_OpenGL final : public VertexBuffer
     {
         using Super = VertexBuffer;
@@ -20,7 +23,9 @@ namespace JumaRenderEngine
         VertexBuffer_OpenGL() = default;
         virtual ~VertexBuffer_OpenGL() override;
 
-        virtual void render(const RenderOptions* renderOptions, Material* material) override;
+        virtual void render(const RenderOptions* renderOptions, const RenderPrimitive& primitive) override;
+        void draw(const RenderOptions* renderOptions, Material_OpenGL* material, uint32 instanceCount, VertexBuffer_OpenGL* instanceBuffer, 
+            const void* primitiveConstants);
 
     protected:
 
@@ -38,8 +43,11 @@ namespace JumaRenderEngine
 
         void clearOpenGL();
 
-        uint32 getVerticesVAO(window_id windowID);
-        uint32 createVerticesVAO() const;
+        uint32 getVerticesVAO(window_id windowID, StateCache_OpenGL* stateCache);
+        uint32 createVerticesVAO(StateCache_OpenGL* stateCache) const;
+
+        void bindVertexAttributes(uint32 divisor) const;
+        void unbindVertexAttributes() const;
     };
 }
 
@@ -4,12 +4,19 @@
 
 #include "WindowControllerImpl_OpenGL.h"
 
+#include "WindowController_OpenGL_EGL.h"
 #include "WindowController_OpenGL_GLFW.h"
 
 namespace JumaRenderEngine
 {
-    WindowController_OpenGL* CreateWindowController_OpenGL()
+    WindowController_OpenGL* CreateWindowController_OpenGL(const bool headless)
     {
+#if defined(EGL_ENABLED)
+        if (headless)
+        {
+            return new WindowController_OpenGL_EGL();
+        }
+#endif
 #if defined(GLFW_ENABLED)
         return new WindowController_OpenGL_GLFW();
 #else
@@ -8,7 +8,7 @@
 
 namespace JumaRenderEngine
 {
-    extern WindowController_OpenGL* CreateWindowController_OpenGL();
+    extern WindowController_OpenGL* CreateWindowController_OpenGL(bool headless);
 }
 
 #endif
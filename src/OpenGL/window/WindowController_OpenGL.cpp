@@ -6,6 +6,8 @@
 
 #include <GL/glew.h>
 
+#include "JumaRE/RenderEngine.h"
+
 namespace JumaRenderEngine
 {
     WindowController_OpenGL::~WindowController_OpenGL()
@@ -21,6 +23,13 @@ namespace JumaRenderEngine
     bool WindowController_OpenGL::initOpenGL()
     {
         const GLenum glewInitResult = glewInit();
+#if defined(GLEW_ERROR_NO_GLX_DISPLAY)
+        if ((glewInitResult == GLEW_ERROR_NO_GLX_DISPLAY) && getRenderEngine()->isHeadless())
+        {
+            // There is no X display for EGL context, but OpenGL functions are already loaded
+            return true;
+        }
+#endif
         if (glewInitResult != GLEW_OK)
         {
             JUTILS_LOG(error, reinterpret_cast<const char*>(glewGetErrorString(glewInitResult)));
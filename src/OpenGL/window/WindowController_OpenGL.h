@@ -7,6 +7,7 @@
 #include "../../../include/JumaRE/window/WindowController.h"
 
 #include "../../../include/JumaRE/RenderAPI.h"
+#include "../StateCache_OpenGL.h"
 
 namespace JumaRenderEngine
 {
@@ -14,6 +15,7 @@ namespace JumaRenderEngine
 
     struct WindowData_OpenGL : WindowData
     {
+        StateCache_OpenGL stateCache;
     };
 
     class WindowController_OpenGL : public WindowController
@@ -32,6 +34,8 @@ namespace JumaRenderEngine
         window_id getActiveWindowID() const { return m_ActiveWindowID; }
         void setActiveWindowID(window_id windowID);
 
+        StateCache_OpenGL* getActiveStateCache() { return getStateCache(m_ActiveWindowID); }
+
     protected:
 
         static constexpr RenderAPI API = RenderAPI::OpenGL;
@@ -40,6 +44,11 @@ namespace JumaRenderEngine
         bool initOpenGL();
 
         virtual bool setActiveWindowInternal(window_id windowID) = 0;
+        virtual StateCache_OpenGL* getStateCache(const window_id windowID)
+        {
+            WindowData_OpenGL* windowData = getWindowData<WindowData_OpenGL>(windowID);
+            return windowData != nullptr ? &windowData->stateCache : nullptr;
+        }
 
         virtual bool createContextForAsyncAssetTaskQueueWorker(int32 workerIndex) = 0;
         virtual bool initAsyncAssetTaskQueueWorkerThread(int32 workerIndex) = 0;
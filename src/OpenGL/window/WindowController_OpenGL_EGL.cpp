@@ -0,0 +1,231 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#if defined(JUMARE_ENABLE_OPENGL) && defined(EGL_ENABLED)
+
+#include "WindowController_OpenGL_EGL.h"
+
+#include <cstring>
+#include <EGL/eglext.h>
+
+namespace JumaRenderEngine
+{
+    WindowController_OpenGL_EGL::~WindowController_OpenGL_EGL()
+    {
+        clearData_OpenGL_EGL();
+    }
+
+    bool WindowController_OpenGL_EGL::initWindowController()
+    {
+        if (!Super::initWindowController())
+        {
+            return false;
+        }
+
+        if (!initDisplay())
+        {
+            JUTILS_LOG(error, JSTR("Failed to initialize EGL display"));
+            return false;
+        }
+        if (!createContext(m_DefaultContext, EGL_NO_CONTEXT))
+        {
+            JUTILS_LOG(error, JSTR("Failed to create default EGL context"));
+            return false;
+        }
+        if (!makeContextCurrent(m_DefaultContext) || !initOpenGL())
+        {
+            JUTILS_LOG(error, JSTR("Failed to initialize OpenGL"));
+            return false;
+        }
+        return true;
+    }
+    bool WindowController_OpenGL_EGL::initDisplay()
+    {
+        // Surfaceless platform doesn't need any window system at all
+        const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+        if ((clientExtensions != nullptr) && (std::strstr(clientExtensions, "EGL_MESA_platform_surfaceless") != nullptr))
+        {
+            const auto getPlatformDisplayFunc = reinterpret_cast<PFNEGLGETPLATFORMDISPLAYEXTPROC>(eglGetProcAddress("eglGetPlatformDisplayEXT"));
+            if (getPlatformDisplayFunc != nullptr)
+            {
+                m_Display = getPlatformDisplayFunc(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+            }
+        }
+        if (m_Display == EGL_NO_DISPLAY)
+        {
+            m_Display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+            if (m_Display == EGL_NO_DISPLAY)
+            {
+                JUTILS_LOG(error, JSTR("Failed to get EGL display"));
+                return false;
+            }
+        }
+        if (eglInitialize(m_Display, nullptr, nullptr) != EGL_TRUE)
+        {
+            JUTILS_LOG(error, JSTR("Failed to initialize EGL. Code: {:#x}"), eglGetError());
+            m_Display = EGL_NO_DISPLAY;
+            return false;
+        }
+
+        const char* displayExtensions = eglQueryString(m_Display, EGL_EXTENSIONS);
+        m_SurfacelessContextSupported = (displayExtensions != nullptr) && (std::strstr(displayExtensions, "EGL_KHR_surfaceless_context") != nullptr);
+        if (eglBindAPI(EGL_OPENGL_API) != EGL_TRUE)
+        {
+            JUTILS_LOG(error, JSTR("Failed to bind OpenGL API to EGL. Code: {:#x}"), eglGetError());
+            return false;
+        }
+
+        const EGLint configAttributes[] = {
+            EGL_SURFACE_TYPE, m_SurfacelessContextSupported ? 0 : EGL_PBUFFER_BIT,
+            EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,
+            EGL_NONE
+        };
+        EGLint configCount = 0;
+        if ((eglChooseConfig(m_Display, configAttributes, &m_Config, 1, &configCount) != EGL_TRUE) || (configCount == 0))
+        {
+            JUTILS_LOG(error, JSTR("Failed to find suitable EGL config"));
+            return false;
+        }
+        return true;
+    }
+
+    void WindowController_OpenGL_EGL::clearData_OpenGL_EGL()
+    {
+        for (auto& contextData : m_AsyncAssetTaskQueueWorkerContexts)
+        {
+            destroyContext(contextData);
+        }
+        m_AsyncAssetTaskQueueWorkerContexts.clear();
+
+        if (m_Display != EGL_NO_DISPLAY)
+        {
+            eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            destroyContext(m_DefaultContext);
+            eglTerminate(m_Display);
+            m_Display = EGL_NO_DISPLAY;
+        }
+        m_Config = nullptr;
+        m_SurfacelessContextSupported = false;
+    }
+
+    bool WindowController_OpenGL_EGL::createContext(ContextData_EGL& outContextData, EGLContext sharedContext) const
+    {
+        const EGLint contextAttributes[] = {
+            EGL_CONTEXT_MAJOR_VERSION, 4,
+            EGL_CONTEXT_MINOR_VERSION, 5,
+            EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+            EGL_NONE
+        };
+        const EGLContext context = eglCreateContext(m_Display, m_Config, sharedContext, contextAttributes);
+        if (context == EGL_NO_CONTEXT)
+        {
+            JUTILS_LOG(error, JSTR("Failed to create EGL context. Code: {:#x}"), eglGetError());
+            return false;
+        }
+
+        EGLSurface surface = EGL_NO_SURFACE;
+        if (!m_SurfacelessContextSupported)
+        {
+            const EGLint pbufferAttributes[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+            surface = eglCreatePbufferSurface(m_Display, m_Config, pbufferAttributes);
+            if (surface == EGL_NO_SURFACE)
+            {
+                JUTILS_LOG(error, JSTR("Failed to create EGL pbuffer surface. Code: {:#x}"), eglGetError());
+                eglDestroyContext(m_Display, context);
+                return false;
+            }
+        }
+
+        outContextData.context = context;
+        outContextData.surface = surface;
+        return true;
+    }
+    void WindowController_OpenGL_EGL::destroyContext(ContextData_EGL& contextData) const
+    {
+        if (contextData.surface != EGL_NO_SURFACE)
+        {
+            eglDestroySurface(m_Display, contextData.surface);
+            contextData.surface = EGL_NO_SURFACE;
+        }
+        if (contextData.context != EGL_NO_CONTEXT)
+        {
+            eglDestroyContext(m_Display, contextData.context);
+            contextData.context = EGL_NO_CONTEXT;
+        }
+    }
+    bool WindowController_OpenGL_EGL::makeContextCurrent(const ContextData_EGL& contextData) const
+    {
+        if (eglMakeCurrent(m_Display, contextData.surface, contextData.surface, contextData.context) != EGL_TRUE)
+        {
+            JUTILS_LOG(error, JSTR("Failed to make EGL context current. Code: {:#x}"), eglGetError());
+            return false;
+        }
+        return true;
+    }
+
+    bool WindowController_OpenGL_EGL::setActiveWindowInternal(const window_id windowID)
+    {
+        return makeContextCurrent(m_DefaultContext);
+    }
+
+    bool WindowController_OpenGL_EGL::createContextForAsyncAssetTaskQueueWorker(const int32 workerIndex)
+    {
+        if (workerIndex < 0)
+        {
+            JUTILS_LOG(error, JSTR("Invalid worker index {}"), workerIndex);
+            return false;
+        }
+        if (m_DefaultContext.context == EGL_NO_CONTEXT)
+        {
+            JUTILS_LOG(error, JSTR("Failed to create OpenGL asset loading contexts: empty default context"));
+            return false;
+        }
+        if (!m_AsyncAssetTaskQueueWorkerContexts.isValidIndex(workerIndex))
+        {
+            m_AsyncAssetTaskQueueWorkerContexts.resize(workerIndex + 1);
+        }
+        if (!createContext(m_AsyncAssetTaskQueueWorkerContexts[workerIndex], m_DefaultContext.context))
+        {
+            JUTILS_LOG(error, JSTR("Failed to create OpenGL asset loading contexts: failed to create EGL context"));
+            return false;
+        }
+        return true;
+    }
+    bool WindowController_OpenGL_EGL::initAsyncAssetTaskQueueWorkerThread(const int32 workerIndex)
+    {
+        if (!m_AsyncAssetTaskQueueWorkerContexts.isValidIndex(workerIndex))
+        {
+            return false;
+        }
+        const ContextData_EGL& contextData = m_AsyncAssetTaskQueueWorkerContexts[workerIndex];
+        if ((contextData.context == EGL_NO_CONTEXT) || !makeContextCurrent(contextData))
+        {
+            return false;
+        }
+        if (!initOpenGL())
+        {
+            eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            return false;
+        }
+        return true;
+    }
+    void WindowController_OpenGL_EGL::clearAsyncAssetTaskQueueWorkerThread(const int32 workerIndex)
+    {
+        eglMakeCurrent(m_Display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglReleaseThread();
+    }
+    void WindowController_OpenGL_EGL::destroyContextForAsyncAssetTaskQueueWorker(const int32 workerIndex)
+    {
+        if (!m_AsyncAssetTaskQueueWorkerContexts.isValidIndex(workerIndex))
+        {
+            JUTILS_LOG(warning, JSTR("Can't find context for worker {}"), workerIndex);
+            return;
+        }
+        destroyContext(m_AsyncAssetTaskQueueWorkerContexts[workerIndex]);
+    }
+}
+
+#endif
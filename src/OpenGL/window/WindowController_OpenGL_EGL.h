@@ -0,0 +1,62 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_OPENGL) && defined(EGL_ENABLED)
+
+#include "WindowController_OpenGL.h"
+#include "../../headless/WindowController_Headless.h"
+
+#include <EGL/egl.h>
+
+namespace JumaRenderEngine
+{
+    class WindowController_OpenGL_EGL final : public WindowController_Headless<WindowController_OpenGL>
+    {
+        using Super = WindowController_Headless<WindowController_OpenGL>;
+
+    public:
+        WindowController_OpenGL_EGL() = default;
+        virtual ~WindowController_OpenGL_EGL() override;
+
+    protected:
+
+        virtual bool initWindowController() override;
+
+        virtual bool setActiveWindowInternal(window_id windowID) override;
+        // All windows are rendered with default context
+        virtual StateCache_OpenGL* getStateCache(window_id windowID) override { return &m_DefaultStateCache; }
+
+        virtual bool createContextForAsyncAssetTaskQueueWorker(int32 workerIndex) override;
+        virtual bool initAsyncAssetTaskQueueWorkerThread(int32 workerIndex) override;
+        virtual void clearAsyncAssetTaskQueueWorkerThread(int32 workerIndex) override;
+        virtual void destroyContextForAsyncAssetTaskQueueWorker(int32 workerIndex) override;
+
+    private:
+
+        struct ContextData_EGL
+        {
+            EGLContext context = EGL_NO_CONTEXT;
+            // Stays empty if EGL_KHR_surfaceless_context is supported
+            EGLSurface surface = EGL_NO_SURFACE;
+        };
+
+        EGLDisplay m_Display = EGL_NO_DISPLAY;
+        EGLConfig m_Config = nullptr;
+        bool m_SurfacelessContextSupported = false;
+
+        ContextData_EGL m_DefaultContext;
+        StateCache_OpenGL m_DefaultStateCache;
+        jarray<ContextData_EGL> m_AsyncAssetTaskQueueWorkerContexts;
+
+
+        void clearData_OpenGL_EGL();
+
+        bool initDisplay();
+        bool createContext(ContextData_EGL& outContextData, EGLContext sharedContext) const;
+        void destroyContext(ContextData_EGL& contextData) const;
+        bool makeContextCurrent(const ContextData_EGL& contextData) const;
+    };
+}
+
+#endif
@@ -0,0 +1,26 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+
+#include "JumaRE/material/Material.h"
+
+namespace JumaRenderEngine
+{
+    // Software shaders read params directly from material params storage
+    class Material_Software final : public Material
+    {
+        using Super = Material;
+
+    public:
+        Material_Software() = default;
+        virtual ~Material_Software() override = default;
+
+    protected:
+
+        virtual bool initInternal() override { return true; }
+    };
+}
+
+#endif
@@ -0,0 +1,26 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#include "JumaRE/RenderEngineImpl_Software.h"
+
+#include "RenderEngine_Software.h"
+
+namespace JumaRenderEngine
+{
+    bool IsSupportRenderAPI_Software()
+    {
+#if defined(JUMARE_ENABLE_SOFTWARE)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    RenderEngine* CreateRenderEngine_Software()
+    {
+#if defined(JUMARE_ENABLE_SOFTWARE)
+        return new RenderEngine_Software();
+#else
+        return nullptr;
+#endif
+    }
+}
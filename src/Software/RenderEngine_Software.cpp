@@ -0,0 +1,125 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+
+#include "RenderEngine_Software.h"
+
+#include <thread>
+
+#include "window/WindowController_Software_Headless.h"
+
+namespace JumaRenderEngine
+{
+    RenderEngine_Software::~RenderEngine_Software()
+    {
+        clearSoftware();
+    }
+
+    bool RenderEngine_Software::initInternal(const WindowCreateInfo& mainWindowInfo)
+    {
+        if (!isHeadless())
+        {
+            JUTILS_LOG(error, JSTR("Software render API supports only headless mode"));
+            return false;
+        }
+        if (!Super::initInternal(mainWindowInfo))
+        {
+            return false;
+        }
+
+        const int32 workersCount = static_cast<int32>(std::thread::hardware_concurrency());
+        if (workersCount > 1)
+        {
+            if (!m_RasterizeTaskQueue.init(workersCount, this))
+            {
+                JUTILS_LOG(warning, JSTR("Failed to start rasterize workers, tiles will be rasterized on main thread"));
+            }
+            else
+            {
+                m_RasterizeWorkersStarted = true;
+            }
+        }
+        return true;
+    }
+
+    void RenderEngine_Software::clearInternal()
+    {
+        clearSoftware();
+        Super::clearInternal();
+    }
+    void RenderEngine_Software::clearSoftware()
+    {
+        if (m_RasterizeWorkersStarted)
+        {
+            m_RasterizeTaskQueue.stop();
+            m_RasterizeWorkersStarted = false;
+        }
+
+        clearAssets();
+        m_MaterialsPool.clear();
+        m_TexturesPool.clear();
+        m_ShadersPool.clear();
+        m_VertexBuffersPool.clear();
+        m_RenderTargetsPool.clear();
+    }
+
+    WindowController* RenderEngine_Software::createWindowController()
+    {
+        return new WindowController_Software_Headless();
+    }
+
+    void RenderEngine_Software::rasterizeTiles(const SoftwareRasterizer* rasterizer, const jarray<int32>& tiles)
+    {
+        if (!m_RasterizeWorkersStarted || (tiles.getSize() == 1))
+        {
+            for (const auto& tileIndex : tiles)
+            {
+                rasterizer->rasterizeTile(tileIndex);
+            }
+            return;
+        }
+
+        m_RasterizeTasksTemp.clear();
+        for (const auto& tileIndex : tiles)
+        {
+            m_RasterizeTasksTemp.add(new RasterizeTileTask(this, rasterizer, tileIndex));
+        }
+
+        m_RasterizeTasksLeft = m_RasterizeTasksTemp.getSize();
+        if (!m_RasterizeTaskQueue.addTasks(m_RasterizeTasksTemp))
+        {
+            JUTILS_LOG(warning, JSTR("Failed to start rasterize tasks, rasterizing on main thread"));
+            for (const auto& task : m_RasterizeTasksTemp)
+            {
+                delete task;
+            }
+            m_RasterizeTasksTemp.clear();
+            m_RasterizeTasksLeft = 0;
+
+            for (const auto& tileIndex : tiles)
+            {
+                rasterizer->rasterizeTile(tileIndex);
+            }
+            return;
+        }
+        m_RasterizeTasksTemp.clear();
+
+        std::unique_lock lock(m_RasterizeTasksMutex);
+        m_RasterizeTasksCondition.wait(lock, [this]() { return m_RasterizeTasksLeft == 0; });
+    }
+    void RenderEngine_Software::RasterizeTileTask::run()
+    {
+        m_Rasterizer->rasterizeTile(m_TileIndex);
+        m_RenderEngine->onRasterizeTaskFinished();
+    }
+    void RenderEngine_Software::onRasterizeTaskFinished()
+    {
+        std::lock_guard lock(m_RasterizeTasksMutex);
+        if (--m_RasterizeTasksLeft == 0)
+        {
+            m_RasterizeTasksCondition.notify_all();
+        }
+    }
+}
+
+#endif
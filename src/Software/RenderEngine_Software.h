@@ -0,0 +1,108 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+
+#include "JumaRE/RenderEngine.h"
+
+#include <jutils/jasync_task_queue.h>
+#include <jutils/jpool_simple.h>
+#include <condition_variable>
+#include <mutex>
+
+#include "Material_Software.h"
+#include "RenderTarget_Software.h"
+#include "Shader_Software.h"
+#include "Texture_Software.h"
+#include "VertexBuffer_Software.h"
+
+namespace JumaRenderEngine
+{
+    class RenderEngine_Software final : public RenderEngine
+    {
+        using Super = RenderEngine;
+
+    public:
+        RenderEngine_Software() = default;
+        virtual ~RenderEngine_Software() override;
+
+        virtual RenderAPI getRenderAPI() const override { return RenderAPI::Software; }
+
+        // Blocks until all tiles are rasterized, main thread only
+        void rasterizeTiles(const SoftwareRasterizer* rasterizer, const jarray<int32>& tiles);
+
+    protected:
+
+        virtual bool initInternal(const WindowCreateInfo& mainWindowInfo) override;
+        virtual bool isHeadlessModeSupported() const override { return true; }
+        virtual void clearInternal() override;
+
+        virtual WindowController* createWindowController() override;
+        virtual RenderTarget* allocateRenderTarget() override { return m_RenderTargetsPool.getPoolObject(); }
+        virtual VertexBuffer* allocateVertexBuffer() override { return m_VertexBuffersPool.getPoolObject(); }
+        virtual Shader* allocateShader() override { return m_ShadersPool.getPoolObject(); }
+        virtual Material* allocateMaterial() override { return m_MaterialsPool.getPoolObject(); }
+        virtual Texture* allocateTexture() override { return m_TexturesPool.getPoolObject(); }
+
+        virtual void deallocateRenderTarget(RenderTarget* renderTarget) override { m_RenderTargetsPool.returnPoolObject(dynamic_cast<RenderTarget_Software*>(renderTarget)); }
+        virtual void deallocateVertexBuffer(VertexBuffer* vertexBuffer) override { m_VertexBuffersPool.returnPoolObject(dynamic_cast<VertexBuffer_Software*>(vertexBuffer)); }
+        virtual void deallocateShader(Shader* shader) override { m_ShadersPool.returnPoolObject(dynamic_cast<Shader_Software*>(shader)); }
+        virtual void deallocateMaterial(Material* material) override { m_MaterialsPool.returnPoolObject(dynamic_cast<Material_Software*>(material)); }
+        virtual void deallocateTexture(Texture* texture) override { m_TexturesPool.returnPoolObject(dynamic_cast<Texture_Software*>(texture)); }
+
+    private:
+
+        class RasterizeWorker : public jasync_worker
+        {
+        public:
+            RasterizeWorker() = delete;
+            RasterizeWorker(RenderEngine_Software* renderEngine) : m_RenderEngine(renderEngine) {}
+
+            bool onStart_MainThread() const { return true; }
+            bool onStart_WorkerThread() const { return true; }
+            void onStop_WorkerThread() const {}
+            void onStop_MainThread() const {}
+
+        private:
+
+            RenderEngine_Software* m_RenderEngine = nullptr;
+        };
+        class RasterizeTileTask : public jasync_task
+        {
+        public:
+            RasterizeTileTask() = delete;
+            RasterizeTileTask(RenderEngine_Software* renderEngine, const SoftwareRasterizer* rasterizer, const int32 tileIndex)
+                : m_RenderEngine(renderEngine), m_Rasterizer(rasterizer), m_TileIndex(tileIndex)
+            {}
+
+            virtual void run() override;
+
+        private:
+
+            RenderEngine_Software* m_RenderEngine = nullptr;
+            const SoftwareRasterizer* m_Rasterizer = nullptr;
+            int32 m_TileIndex = 0;
+        };
+
+        jasync_task_queue<RasterizeWorker> m_RasterizeTaskQueue;
+        jarray<jasync_task*> m_RasterizeTasksTemp;
+        std::mutex m_RasterizeTasksMutex;
+        std::condition_variable m_RasterizeTasksCondition;
+        int32 m_RasterizeTasksLeft = 0;
+        bool m_RasterizeWorkersStarted = false;
+
+        jpool_simple<RenderTarget_Software> m_RenderTargetsPool;
+        jpool_simple<VertexBuffer_Software> m_VertexBuffersPool;
+        jpool_simple<Shader_Software> m_ShadersPool;
+        jpool_simple<Material_Software> m_MaterialsPool;
+        jpool_simple<Texture_Software> m_TexturesPool;
+
+
+        void clearSoftware();
+
+        void onRasterizeTaskFinished();
+    };
+}
+
+#endif
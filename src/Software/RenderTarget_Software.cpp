@@ -0,0 +1,121 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+
+#include "RenderTarget_Software.h"
+
+#include "RenderEngine_Software.h"
+
+namespace JumaRenderEngine
+{
+    RenderTarget_Software::~RenderTarget_Software()
+    {
+        clearSoftware();
+    }
+
+    bool RenderTarget_Software::initInternal()
+    {
+        if (isWindowRenderTarget())
+        {
+            JUTILS_LOG(error, JSTR("Software render API doesn't support window render targets"));
+            return false;
+        }
+        if ((getColorFormat() != TextureFormat::RGBA8) && (getColorFormat() != TextureFormat::RGBA8_SRGB))
+        {
+            JUTILS_LOG(error, JSTR("Unsupported render target format for software render API"));
+            return false;
+        }
+
+        createBuffers();
+        return true;
+    }
+    void RenderTarget_Software::createBuffers()
+    {
+        // Multisampling is not supported, render target is always rendered with 1 sample
+        const math::uvector2 size = getSize();
+        const int32 pixelsCount = static_cast<int32>(size.x * size.y);
+        m_ColorImage.size = size;
+        m_ColorImage.pixels.resize(pixelsCount);
+        if (isDepthEnabled())
+        {
+            m_DepthData.resize(pixelsCount);
+        }
+        else
+        {
+            m_DepthData.clear();
+        }
+    }
+
+    void RenderTarget_Software::clearAssetInternal()
+    {
+        clearSoftware();
+        Super::clearAssetInternal();
+    }
+    void RenderTarget_Software::clearSoftware()
+    {
+        m_ReadbackBuffers.clear();
+        m_DepthData.clear();
+        m_ColorImage.pixels.clear();
+        m_ColorImage.size = { 0, 0 };
+    }
+
+    bool RenderTarget_Software::recreateRenderTarget()
+    {
+        createBuffers();
+        return true;
+    }
+
+    bool RenderTarget_Software::onStartRender(RenderOptions* renderOptions)
+    {
+        if (!Super::onStartRender(renderOptions))
+        {
+            return false;
+        }
+
+        m_Rasterizer.begin(m_ColorImage.pixels.getData(), !m_DepthData.isEmpty() ? m_DepthData.getData() : nullptr, m_ColorImage.size);
+        return true;
+    }
+    void RenderTarget_Software::onFinishRender(RenderOptions* renderOptions)
+    {
+        m_Rasterizer.flush(getRenderEngine<RenderEngine_Software>());
+        Super::onFinishRender(renderOptions);
+    }
+
+    bool RenderTarget_Software::copyToReadbackBuffer(RenderOptions* renderOptions, const int32 bufferIndex, const math::uvector2& offset, 
+        const math::uvector2& size)
+    {
+        if (!m_ReadbackBuffers.isValidIndex(bufferIndex))
+        {
+            m_ReadbackBuffers.resize(bufferIndex + 1);
+        }
+
+        // Rasterizer is already flushed, so pixels are ready
+        ReadbackBuffer& readbackBuffer = m_ReadbackBuffers[bufferIndex];
+        readbackBuffer.rowPitch = size.x * 4;
+        readbackBuffer.pixels.resize(static_cast<int32>(readbackBuffer.rowPitch * size.y));
+        uint8* dstPixel = readbackBuffer.pixels.getData();
+        for (uint32 y = 0; y < size.y; y++)
+        {
+            const uint32* srcRow = m_ColorImage.pixels.getData() + (offset.y + y) * m_ColorImage.size.x + offset.x;
+            for (uint32 x = 0; x < size.x; x++)
+            {
+                const uint32 color = srcRow[x];
+                dstPixel[0] = static_cast<uint8>(color & 0xFF);
+                dstPixel[1] = static_cast<uint8>((color >> 8) & 0xFF);
+                dstPixel[2] = static_cast<uint8>((color >> 16) & 0xFF);
+                dstPixel[3] = static_cast<uint8>(color >> 24);
+                dstPixel += 4;
+            }
+        }
+        return true;
+    }
+    bool RenderTarget_Software::mapReadbackBuffer(const int32 bufferIndex, const uint8*& outData, int32& outRowPitch)
+    {
+        const ReadbackBuffer& readbackBuffer = m_ReadbackBuffers[bufferIndex];
+        outData = readbackBuffer.pixels.getData();
+        outRowPitch = static_cast<int32>(readbackBuffer.rowPitch);
+        return true;
+    }
+}
+
+#endif
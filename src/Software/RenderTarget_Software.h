@@ -0,0 +1,61 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+
+#include "JumaRE/RenderTarget.h"
+
+#include "SoftwareImage.h"
+#include "SoftwareRasterizer.h"
+
+namespace JumaRenderEngine
+{
+    class RenderTarget_Software final : public RenderTarget
+    {
+        using Super = RenderTarget;
+
+    public:
+        RenderTarget_Software() = default;
+        virtual ~RenderTarget_Software() override;
+
+        const SoftwareImage& getColorImage() const { return m_ColorImage; }
+        SoftwareRasterizer& getRasterizer() { return m_Rasterizer; }
+
+        virtual bool onStartRender(RenderOptions* renderOptions) override;
+        virtual void onFinishRender(RenderOptions* renderOptions) override;
+
+    protected:
+
+        virtual bool initInternal() override;
+        virtual void clearAssetInternal() override;
+
+        virtual bool recreateRenderTarget() override;
+
+        virtual bool isReadbackSupported() const override { return true; }
+        virtual bool copyToReadbackBuffer(RenderOptions* renderOptions, int32 bufferIndex, const math::uvector2& offset, const math::uvector2& size) override;
+        virtual bool mapReadbackBuffer(int32 bufferIndex, const uint8*& outData, int32& outRowPitch) override;
+
+    private:
+
+        struct ReadbackBuffer
+        {
+            jarray<uint8> pixels;
+            uint32 rowPitch = 0;
+        };
+
+        SoftwareImage m_ColorImage;
+        jarray<float> m_DepthData;
+
+        SoftwareRasterizer m_Rasterizer;
+
+        jarray<ReadbackBuffer> m_ReadbackBuffers;
+
+
+        void createBuffers();
+
+        void clearSoftware();
+    };
+}
+
+#endif
@@ -0,0 +1,54 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+
+#include "Shader_Software.h"
+
+namespace JumaRenderEngine
+{
+    Shader_Software::~Shader_Software()
+    {
+        clearSoftware();
+    }
+
+    bool Shader_Software::initInternal(const jmap<ShaderStageFlags, jstring>& fileNames)
+    {
+        const jstring* vertexShaderName = fileNames.find(SHADER_STAGE_VERTEX);
+        const jstring* fragmentShaderName = fileNames.find(SHADER_STAGE_FRAGMENT);
+        if ((vertexShaderName == nullptr) || (fragmentShaderName == nullptr))
+        {
+            JUTILS_LOG(error, JSTR("Software shader requires vertex and fragment stages"));
+            return false;
+        }
+        if (hasPrimitiveConstants())
+        {
+            JUTILS_LOG(error, JSTR("Primitive constants are not supported by software shaders"));
+            return false;
+        }
+        if (!FindSoftwareVertexShader(*vertexShaderName, m_VertexShader))
+        {
+            JUTILS_LOG(error, JSTR("Software vertex shader {} is not registered"), *vertexShaderName);
+            return false;
+        }
+        if (!FindSoftwareFragmentShader(*fragmentShaderName, m_FragmentShader))
+        {
+            JUTILS_LOG(error, JSTR("Software fragment shader {} is not registered"), *fragmentShaderName);
+            clearSoftware();
+            return false;
+        }
+        return true;
+    }
+
+    void Shader_Software::onClearAsset()
+    {
+        clearSoftware();
+        Super::onClearAsset();
+    }
+    void Shader_Software::clearSoftware()
+    {
+        m_VertexShader = {};
+        m_FragmentShader = nullptr;
+    }
+}
+
+#endif
@@ -0,0 +1,39 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+
+#include "JumaRE/material/Shader.h"
+
+#include "SoftwareShaderRegistry.h"
+
+namespace JumaRenderEngine
+{
+    class Shader_Software final : public Shader
+    {
+        using Super = Shader;
+
+    public:
+        Shader_Software() = default;
+        virtual ~Shader_Software() override;
+
+        const SoftwareVertexShader& getVertexShader() const { return m_VertexShader; }
+        const SoftwareFragmentShaderFunction& getFragmentShader() const { return m_FragmentShader; }
+
+    protected:
+
+        virtual bool initInternal(const jmap<ShaderStageFlags, jstring>& fileNames) override;
+        virtual void onClearAsset() override;
+
+    private:
+
+        SoftwareVertexShader m_VertexShader;
+        SoftwareFragmentShaderFunction m_FragmentShader;
+
+
+        void clearSoftware();
+    };
+}
+
+#endif
@@ -0,0 +1,92 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+
+#include "SoftwareImage.h"
+
+#include <cmath>
+
+namespace JumaRenderEngine
+{
+    uint32 PackSoftwareColor(const math::vector4& color)
+    {
+        const uint32 r = static_cast<uint32>(math::clamp(color.x, 0.0f, 1.0f) * 255.0f + 0.5f);
+        const uint32 g = static_cast<uint32>(math::clamp(color.y, 0.0f, 1.0f) * 255.0f + 0.5f);
+        const uint32 b = static_cast<uint32>(math::clamp(color.z, 0.0f, 1.0f) * 255.0f + 0.5f);
+        const uint32 a = static_cast<uint32>(math::clamp(color.w, 0.0f, 1.0f) * 255.0f + 0.5f);
+        return r | (g << 8) | (b << 16) | (a << 24);
+    }
+    math::vector4 UnpackSoftwareColor(const uint32 color)
+    {
+        constexpr float scale = 1.0f / 255.0f;
+        return {
+            static_cast<float>(color & 0xFF) * scale,
+            static_cast<float>((color >> 8) & 0xFF) * scale,
+            static_cast<float>((color >> 16) & 0xFF) * scale,
+            static_cast<float>(color >> 24) * scale
+        };
+    }
+
+    static int32 WrapSoftwareTexelCoord(int32 coord, const int32 size, const TextureWrapMode wrapMode)
+    {
+        switch (wrapMode)
+        {
+        case TextureWrapMode::Repeat:
+            coord %= size;
+            return coord < 0 ? coord + size : coord;
+        case TextureWrapMode::Mirror:
+            {
+                const int32 period = size * 2;
+                coord %= period;
+                if (coord < 0)
+                {
+                    coord += period;
+                }
+                return coord < size ? coord : period - 1 - coord;
+            }
+        default: ;
+        }
+        return math::clamp(coord, 0, size - 1);
+    }
+
+    math::vector4 SoftwareImage::sample(const math::vector2& uv, const TextureSamplerType sampler) const
+    {
+        if (pixels.isEmpty())
+        {
+            return { 0.0f, 0.0f, 0.0f, 0.0f };
+        }
+
+        const int32 width = static_cast<int32>(size.x);
+        const int32 height = static_cast<int32>(size.y);
+        const float texelX = uv.x * static_cast<float>(width);
+        const float texelY = uv.y * static_cast<float>(height);
+        if (sampler.filterType == TextureFilterType::Point)
+        {
+            const int32 x = WrapSoftwareTexelCoord(static_cast<int32>(std::floor(texelX)), width, sampler.wrapMode);
+            const int32 y = WrapSoftwareTexelCoord(static_cast<int32>(std::floor(texelY)), height, sampler.wrapMode);
+            return UnpackSoftwareColor(pixels[y * width + x]);
+        }
+
+        // There are no mip levels, all other filters are bilinear
+        const float centerX = texelX - 0.5f;
+        const float centerY = texelY - 0.5f;
+        const float floorX = std::floor(centerX);
+        const float floorY = std::floor(centerY);
+        const float fractionX = centerX - floorX;
+        const float fractionY = centerY - floorY;
+        const int32 x0 = WrapSoftwareTexelCoord(static_cast<int32>(floorX), width, sampler.wrapMode);
+        const int32 x1 = WrapSoftwareTexelCoord(static_cast<int32>(floorX) + 1, width, sampler.wrapMode);
+        const int32 y0 = WrapSoftwareTexelCoord(static_cast<int32>(floorY), height, sampler.wrapMode);
+        const int32 y1 = WrapSoftwareTexelCoord(static_cast<int32>(floorY) + 1, height, sampler.wrapMode);
+
+        const math::vector4 c00 = UnpackSoftwareColor(pixels[y0 * width + x0]);
+        const math::vector4 c10 = UnpackSoftwareColor(pixels[y0 * width + x1]);
+        const math::vector4 c01 = UnpackSoftwareColor(pixels[y1 * width + x0]);
+        const math::vector4 c11 = UnpackSoftwareColor(pixels[y1 * width + x1]);
+        const math::vector4 top = c00 + (c10 - c00) * fractionX;
+        const math::vector4 bottom = c01 + (c11 - c01) * fractionX;
+        return top + (bottom - top) * fractionY;
+    }
+}
+
+#endif
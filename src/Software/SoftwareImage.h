@@ -0,0 +1,30 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+
+#include "JumaRE/core.h"
+
+#include <jutils/jarray.h>
+#include <jutils/math/vector2.h>
+#include <jutils/math/vector4.h>
+
+#include "JumaRE/texture/TextureSamplerType.h"
+
+namespace JumaRenderEngine
+{
+    struct SoftwareImage
+    {
+        math::uvector2 size = { 0, 0 };
+        // RGBA8 pixels, first row is the top one
+        jarray<uint32> pixels;
+
+        math::vector4 sample(const math::vector2& uv, TextureSamplerType sampler) const;
+    };
+
+    uint32 PackSoftwareColor(const math::vector4& color);
+    math::vector4 UnpackSoftwareColor(uint32 color);
+}
+
+#endif
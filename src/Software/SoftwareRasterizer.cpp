@@ -0,0 +1,308 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+
+#include "SoftwareRasterizer.h"
+
+#include <cmath>
+#include <utility>
+
+#include "RenderEngine_Software.h"
+#include "SoftwareImage.h"
+
+namespace JumaRenderEngine
+{
+    // Triangles with vertices behind this W are dropped, near plane clipping is not implemented
+    constexpr float SoftwareRasterizerMinClipW = 0.00001f;
+
+    void SoftwareRasterizer::begin(uint32* colorData, float* depthData, const math::uvector2& size)
+    {
+        m_ColorData = colorData;
+        m_DepthData = depthData;
+        m_Size = size;
+        m_TilesCountX = (static_cast<int32>(size.x) + TileSize - 1) / TileSize;
+        m_TilesCountY = (static_cast<int32>(size.y) + TileSize - 1) / TileSize;
+        m_TileTriangles.resize(m_TilesCountX * m_TilesCountY);
+
+        const int32 pixelsCount = static_cast<int32>(size.x * size.y);
+        const uint32 clearColor = PackSoftwareColor({ 1.0f, 1.0f, 1.0f, 1.0f });
+        for (int32 index = 0; index < pixelsCount; index++)
+        {
+            m_ColorData[index] = clearColor;
+        }
+        if (m_DepthData != nullptr)
+        {
+            for (int32 index = 0; index < pixelsCount; index++)
+            {
+                m_DepthData[index] = 1.0f;
+            }
+        }
+    }
+
+    void SoftwareRasterizer::draw(const SoftwareDrawInfo& drawInfo)
+    {
+        if ((drawInfo.vertexShader == nullptr) || (drawInfo.vertexShader->function == nullptr) || (drawInfo.fragmentShader == nullptr) || 
+            (drawInfo.params == nullptr) || (drawInfo.vertexCount == 0) || (m_ColorData == nullptr))
+        {
+            return;
+        }
+
+        const SoftwareVertexShader& vertexShader = *drawInfo.vertexShader;
+        const int32 drawIndex = m_DrawCalls.getSize();
+        m_DrawCalls.add({ 
+            drawInfo.fragmentShader, drawInfo.params, vertexShader.varyingsCount, 
+            drawInfo.depthTest && (m_DepthData != nullptr), drawInfo.blend
+        });
+
+        const int32 vertexStride = 4 + vertexShader.varyingsCount;
+        const int32 vertexCount = static_cast<int32>(drawInfo.vertexCount);
+        const uint32 triangleCount = (drawInfo.indices != nullptr ? drawInfo.indexCount : drawInfo.vertexCount) / 3;
+        const float halfWidth = 0.5f * static_cast<float>(m_Size.x);
+        const float halfHeight = 0.5f * static_cast<float>(m_Size.y);
+        m_ClipPositions.resize(vertexCount);
+        for (uint32 instanceIndex = 0; instanceIndex < drawInfo.instanceCount; instanceIndex++)
+        {
+            const float* instance = drawInfo.instances != nullptr ? drawInfo.instances + instanceIndex * drawInfo.instanceStride : nullptr;
+            const int32 firstVertexOffset = m_Vertices.getSize();
+            m_Vertices.resize(firstVertexOffset + vertexCount * vertexStride);
+            for (int32 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex++)
+            {
+                float* vertex = &m_Vertices[firstVertexOffset + vertexIndex * vertexStride];
+                const math::vector4 position = vertexShader.function(
+                    drawInfo.vertices + vertexIndex * drawInfo.vertexStride, instance, *drawInfo.params, vertex + 4
+                );
+                m_ClipPositions[vertexIndex] = position;
+                if (position.w > SoftwareRasterizerMinClipW)
+                {
+                    const float invW = 1.0f / position.w;
+                    vertex[0] = (position.x * invW + 1.0f) * halfWidth;
+                    vertex[1] = (1.0f - position.y * invW) * halfHeight;
+                    vertex[2] = (position.z * invW + 1.0f) * 0.5f;
+                    vertex[3] = invW;
+                    for (int32 index = 4; index < vertexStride; index++)
+                    {
+                        vertex[index] *= invW;
+                    }
+                }
+            }
+
+            for (uint32 triangleIndex = 0; triangleIndex < triangleCount; triangleIndex++)
+            {
+                const uint32 firstIndex = triangleIndex * 3;
+                uint32 indices[3] = { firstIndex, firstIndex + 1, firstIndex + 2 };
+                if (drawInfo.indices != nullptr)
+                {
+                    indices[0] = drawInfo.indices[firstIndex];
+                    indices[1] = drawInfo.indices[firstIndex + 1];
+                    indices[2] = drawInfo.indices[firstIndex + 2];
+                    if ((indices[0] >= drawInfo.vertexCount) || (indices[1] >= drawInfo.vertexCount) || (indices[2] >= drawInfo.vertexCount))
+                    {
+                        continue;
+                    }
+                }
+                addTriangle(drawIndex, firstVertexOffset, vertexStride, indices, drawInfo.cullBackFaces);
+            }
+        }
+    }
+    void SoftwareRasterizer::addTriangle(const int32 drawIndex, const int32 firstVertexOffset, const int32 vertexStride, 
+        const uint32 (&indices)[3], const bool cullBackFaces)
+    {
+        const math::vector4& p0 = m_ClipPositions[static_cast<int32>(indices[0])];
+        const math::vector4& p1 = m_ClipPositions[static_cast<int32>(indices[1])];
+        const math::vector4& p2 = m_ClipPositions[static_cast<int32>(indices[2])];
+        if ((p0.w <= SoftwareRasterizerMinClipW) || (p1.w <= SoftwareRasterizerMinClipW) || (p2.w <= SoftwareRasterizerMinClipW))
+        {
+            return;
+        }
+        if (((p0.x > p0.w) && (p1.x > p1.w) && (p2.x > p2.w)) || ((p0.x < -p0.w) && (p1.x < -p1.w) && (p2.x < -p2.w)) ||
+            ((p0.y > p0.w) && (p1.y > p1.w) && (p2.y > p2.w)) || ((p0.y < -p0.w) && (p1.y < -p1.w) && (p2.y < -p2.w)) ||
+            ((p0.z > p0.w) && (p1.z > p1.w) && (p2.z > p2.w)) || ((p0.z < -p0.w) && (p1.z < -p1.w) && (p2.z < -p2.w)))
+        {
+            return;
+        }
+
+        Triangle triangle;
+        triangle.drawIndex = drawIndex;
+        for (int32 index = 0; index < 3; index++)
+        {
+            triangle.vertexOffsets[index] = firstVertexOffset + static_cast<int32>(indices[index]) * vertexStride;
+        }
+        const float* vertices[3] = { 
+            &m_Vertices[triangle.vertexOffsets[0]], &m_Vertices[triangle.vertexOffsets[1]], &m_Vertices[triangle.vertexOffsets[2]]
+        };
+
+        // Front faces are clockwise in clip space like in other render APIs, screen Y is flipped so they have positive area here
+        float area = (vertices[1][0] - vertices[0][0]) * (vertices[2][1] - vertices[0][1]) - (vertices[2][0] - vertices[0][0]) * (vertices[1][1] - vertices[0][1]);
+        if ((area == 0.0f) || (cullBackFaces && (area < 0.0f)))
+        {
+            return;
+        }
+        if (area < 0.0f)
+        {
+            std::swap(triangle.vertexOffsets[1], triangle.vertexOffsets[2]);
+            std::swap(vertices[1], vertices[2]);
+            area = -area;
+        }
+        triangle.invArea = 1.0f / area;
+        for (int32 edgeIndex = 0; edgeIndex < 3; edgeIndex++)
+        {
+            // Edge opposite to vertex, so edge function gives barycentric weight of this vertex
+            const float* edgeStart = vertices[(edgeIndex + 1) % 3];
+            const float* edgeEnd = vertices[(edgeIndex + 2) % 3];
+            const float edgeA = edgeStart[1] - edgeEnd[1];
+            const float edgeB = edgeEnd[0] - edgeStart[0];
+            triangle.edgeA[edgeIndex] = edgeA;
+            triangle.edgeB[edgeIndex] = edgeB;
+            triangle.edgeC[edgeIndex] = -(edgeA * edgeStart[0] + edgeB * edgeStart[1]);
+            triangle.includeEdge[edgeIndex] = (edgeA > 0.0f) || ((edgeA == 0.0f) && (edgeB > 0.0f));
+        }
+
+        const float width = static_cast<float>(m_Size.x);
+        const float height = static_cast<float>(m_Size.y);
+        const float minX = math::min(vertices[0][0], math::min(vertices[1][0], vertices[2][0]));
+        const float maxX = math::max(vertices[0][0], math::max(vertices[1][0], vertices[2][0]));
+        const float minY = math::min(vertices[0][1], math::min(vertices[1][1], vertices[2][1]));
+        const float maxY = math::max(vertices[0][1], math::max(vertices[1][1], vertices[2][1]));
+        if ((maxX < 0.0f) || (maxY < 0.0f) || (minX > width) || (minY > height))
+        {
+            return;
+        }
+        triangle.minX = static_cast<int32>(math::clamp(std::floor(minX), 0.0f, width - 1.0f));
+        triangle.maxX = static_cast<int32>(math::clamp(std::ceil(maxX), 0.0f, width - 1.0f));
+        triangle.minY = static_cast<int32>(math::clamp(std::floor(minY), 0.0f, height - 1.0f));
+        triangle.maxY = static_cast<int32>(math::clamp(std::ceil(maxY), 0.0f, height - 1.0f));
+
+        const int32 triangleIndex = m_Triangles.getSize();
+        m_Triangles.add(triangle);
+        const int32 lastTileX = triangle.maxX / TileSize;
+        const int32 lastTileY = triangle.maxY / TileSize;
+        for (int32 tileY = triangle.minY / TileSize; tileY <= lastTileY; tileY++)
+        {
+            for (int32 tileX = triangle.minX / TileSize; tileX <= lastTileX; tileX++)
+            {
+                m_TileTriangles[tileY * m_TilesCountX + tileX].add(triangleIndex);
+            }
+        }
+    }
+
+    void SoftwareRasterizer::flush(RenderEngine_Software* renderEngine)
+    {
+        m_TilesForRasterize.clear();
+        for (int32 tileIndex = 0; tileIndex < m_TileTriangles.getSize(); tileIndex++)
+        {
+            if (!m_TileTriangles[tileIndex].isEmpty())
+            {
+                m_TilesForRasterize.add(tileIndex);
+            }
+        }
+        if (!m_TilesForRasterize.isEmpty())
+        {
+            renderEngine->rasterizeTiles(this, m_TilesForRasterize);
+        }
+
+        for (auto& tileTriangles : m_TileTriangles)
+        {
+            tileTriangles.clear();
+        }
+        m_Triangles.clear();
+        m_Vertices.clear();
+        m_DrawCalls.clear();
+        m_ColorData = nullptr;
+        m_DepthData = nullptr;
+    }
+
+    void SoftwareRasterizer::rasterizeTile(const int32 tileIndex) const
+    {
+        const int32 tileMinX = (tileIndex % m_TilesCountX) * TileSize;
+        const int32 tileMinY = (tileIndex / m_TilesCountX) * TileSize;
+        const int32 tileMaxX = math::min(tileMinX + TileSize, static_cast<int32>(m_Size.x)) - 1;
+        const int32 tileMaxY = math::min(tileMinY + TileSize, static_cast<int32>(m_Size.y)) - 1;
+        for (const auto& triangleIndex : m_TileTriangles[tileIndex])
+        {
+            const Triangle& triangle = m_Triangles[triangleIndex];
+            const DrawCall& drawCall = m_DrawCalls[triangle.drawIndex];
+            const int32 minX = math::max(triangle.minX, tileMinX);
+            const int32 maxX = math::min(triangle.maxX, tileMaxX);
+            const int32 minY = math::max(triangle.minY, tileMinY);
+            const int32 maxY = math::min(triangle.maxY, tileMaxY);
+            for (int32 y = minY; y <= maxY; y++)
+            {
+                const float pixelY = static_cast<float>(y) + 0.5f;
+                const float rowW0 = triangle.edgeB[0] * pixelY + triangle.edgeC[0];
+                const float rowW1 = triangle.edgeB[1] * pixelY + triangle.edgeC[1];
+                const float rowW2 = triangle.edgeB[2] * pixelY + triangle.edgeC[2];
+                for (int32 x = minX; x <= maxX; x += SpanSize)
+                {
+                    // Fixed size loop without branches, so compiler could vectorize it
+                    float w0[SpanSize], w1[SpanSize], w2[SpanSize];
+                    int32 coverage[SpanSize];
+                    for (int32 index = 0; index < SpanSize; index++)
+                    {
+                        const float pixelX = static_cast<float>(x + index) + 0.5f;
+                        w0[index] = triangle.edgeA[0] * pixelX + rowW0;
+                        w1[index] = triangle.edgeA[1] * pixelX + rowW1;
+                        w2[index] = triangle.edgeA[2] * pixelX + rowW2;
+                        coverage[index] = ((w0[index] > 0.0f) | ((w0[index] == 0.0f) & triangle.includeEdge[0]))
+                            & ((w1[index] > 0.0f) | ((w1[index] == 0.0f) & triangle.includeEdge[1]))
+                            & ((w2[index] > 0.0f) | ((w2[index] == 0.0f) & triangle.includeEdge[2]));
+                    }
+
+                    const int32 spanPixelsCount = math::min(SpanSize, maxX - x + 1);
+                    for (int32 index = 0; index < spanPixelsCount; index++)
+                    {
+                        if (coverage[index] != 0)
+                        {
+                            shadePixel(drawCall, triangle, x + index, y, 
+                                w0[index] * triangle.invArea, w1[index] * triangle.invArea, w2[index] * triangle.invArea
+                            );
+                        }
+                    }
+                }
+            }
+        }
+    }
+    void SoftwareRasterizer::shadePixel(const DrawCall& drawCall, const Triangle& triangle, const int32 x, const int32 y, 
+        const float l0, const float l1, const float l2) const
+    {
+        const float* v0 = &m_Vertices[triangle.vertexOffsets[0]];
+        const float* v1 = &m_Vertices[triangle.vertexOffsets[1]];
+        const float* v2 = &m_Vertices[triangle.vertexOffsets[2]];
+        const float depth = l0 * v0[2] + l1 * v1[2] + l2 * v2[2];
+        if ((depth < 0.0f) || (depth > 1.0f))
+        {
+            return;
+        }
+        const int32 pixelIndex = y * static_cast<int32>(m_Size.x) + x;
+        if (drawCall.depthTest && (depth >= m_DepthData[pixelIndex]))
+        {
+            return;
+        }
+
+        // Varyings are stored divided by W, so interpolation is perspective correct
+        float varyings[SoftwareShaderMaxVaryingsCount];
+        const float w = 1.0f / (l0 * v0[3] + l1 * v1[3] + l2 * v2[3]);
+        for (int32 index = 0; index < drawCall.varyingsCount; index++)
+        {
+            varyings[index] = (l0 * v0[4 + index] + l1 * v1[4 + index] + l2 * v2[4 + index]) * w;
+        }
+        math::vector4 color = (*drawCall.fragmentShader)(varyings, *drawCall.params);
+        if (drawCall.blend)
+        {
+            const math::vector4 dstColor = UnpackSoftwareColor(m_ColorData[pixelIndex]);
+            const float srcAlpha = math::clamp(color.w, 0.0f, 1.0f);
+            color = {
+                color.x * srcAlpha + dstColor.x * (1.0f - srcAlpha),
+                color.y * srcAlpha + dstColor.y * (1.0f - srcAlpha),
+                color.z * srcAlpha + dstColor.z * (1.0f - srcAlpha),
+                srcAlpha + dstColor.w * (1.0f - srcAlpha)
+            };
+        }
+        m_ColorData[pixelIndex] = PackSoftwareColor(color);
+        if (drawCall.depthTest)
+        {
+            m_DepthData[pixelIndex] = depth;
+        }
+    }
+}
+
+#endif
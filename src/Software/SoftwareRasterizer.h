@@ -0,0 +1,105 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+
+#include "JumaRE/core.h"
+
+#include <jutils/jarray.h>
+#include <jutils/math/vector2.h>
+#include <jutils/math/vector4.h>
+
+#include "SoftwareShaderRegistry.h"
+
+namespace JumaRenderEngine
+{
+    class MaterialParamsStorage;
+    class RenderEngine_Software;
+
+    struct SoftwareDrawInfo
+    {
+        const SoftwareVertexShader* vertexShader = nullptr;
+        const SoftwareFragmentShaderFunction* fragmentShader = nullptr;
+        const MaterialParamsStorage* params = nullptr;
+
+        const float* vertices = nullptr;
+        uint32 vertexStride = 0;
+        uint32 vertexCount = 0;
+        const uint32* indices = nullptr;
+        uint32 indexCount = 0;
+
+        const float* instances = nullptr;
+        uint32 instanceStride = 0;
+        uint32 instanceCount = 1;
+
+        bool depthTest = true;
+        bool blend = false;
+        bool cullBackFaces = true;
+    };
+
+    // Triangles are transformed and binned into screen tiles while recording, tiles are rasterized in parallel on flush.
+    // Each tile is owned by one thread and keeps submission order, so result doesn't depend on threads count
+    class SoftwareRasterizer
+    {
+    public:
+        SoftwareRasterizer() = default;
+
+        static constexpr int32 TileSize = 64;
+
+        void begin(uint32* colorData, float* depthData, const math::uvector2& size);
+        void draw(const SoftwareDrawInfo& drawInfo);
+        void flush(RenderEngine_Software* renderEngine);
+
+        void rasterizeTile(int32 tileIndex) const;
+
+    private:
+
+        static constexpr int32 SpanSize = 8;
+
+        struct DrawCall
+        {
+            const SoftwareFragmentShaderFunction* fragmentShader = nullptr;
+            const MaterialParamsStorage* params = nullptr;
+            uint8 varyingsCount = 0;
+            bool depthTest = true;
+            bool blend = false;
+        };
+        struct Triangle
+        {
+            int32 drawIndex = 0;
+            // Offsets in vertices array, each vertex is { x, y, z, 1/w, varyings / w }
+            int32 vertexOffsets[3] = { 0, 0, 0 };
+            // Edge function A * x + B * y + C for each edge, positive inside
+            float edgeA[3] = { 0.0f, 0.0f, 0.0f };
+            float edgeB[3] = { 0.0f, 0.0f, 0.0f };
+            float edgeC[3] = { 0.0f, 0.0f, 0.0f };
+            // Tie-breaking for pixels exactly on the edge, shared edges are drawn only once
+            bool includeEdge[3] = { false, false, false };
+            float invArea = 0.0f;
+            int32 minX = 0;
+            int32 minY = 0;
+            int32 maxX = 0;
+            int32 maxY = 0;
+        };
+
+        uint32* m_ColorData = nullptr;
+        float* m_DepthData = nullptr;
+        math::uvector2 m_Size = { 0, 0 };
+        int32 m_TilesCountX = 0;
+        int32 m_TilesCountY = 0;
+
+        jarray<DrawCall> m_DrawCalls;
+        jarray<float> m_Vertices;
+        jarray<math::vector4> m_ClipPositions;
+        jarray<Triangle> m_Triangles;
+        jarray<jarray<int32>> m_TileTriangles;
+        jarray<int32> m_TilesForRasterize;
+
+
+        void addTriangle(int32 drawIndex, int32 firstVertexOffset, int32 vertexStride, const uint32 (&indices)[3], bool cullBackFaces);
+        void shadePixel(const DrawCall& drawCall, const Triangle& triangle, int32 x, int32 y, float l0, float l1, float l2) const;
+    };
+}
+
+#endif
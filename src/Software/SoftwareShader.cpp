@@ -0,0 +1,85 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#include "SoftwareShaderRegistry.h"
+
+#include <mutex>
+#include <jutils/jmap.h>
+#include <jutils/jstringID.h>
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+#include "RenderTarget_Software.h"
+#include "Texture_Software.h"
+#endif
+
+namespace JumaRenderEngine
+{
+    static std::mutex SoftwareShadersMutex;
+    static jmap<jstringID, SoftwareVertexShader> SoftwareVertexShaders;
+    static jmap<jstringID, SoftwareFragmentShaderFunction> SoftwareFragmentShaders;
+
+    bool RegisterSoftwareVertexShader(const jstring& name, const uint8 varyingsCount, const SoftwareVertexShaderFunction& function)
+    {
+        if ((function == nullptr) || (varyingsCount > SoftwareShaderMaxVaryingsCount))
+        {
+            JUTILS_LOG(error, JSTR("Invalid software vertex shader {}"), name);
+            return false;
+        }
+        std::lock_guard lock(SoftwareShadersMutex);
+        SoftwareVertexShaders[jstringID(name)] = { function, varyingsCount };
+        return true;
+    }
+    bool RegisterSoftwareFragmentShader(const jstring& name, const SoftwareFragmentShaderFunction& function)
+    {
+        if (function == nullptr)
+        {
+            JUTILS_LOG(error, JSTR("Invalid software fragment shader {}"), name);
+            return false;
+        }
+        std::lock_guard lock(SoftwareShadersMutex);
+        SoftwareFragmentShaders[jstringID(name)] = function;
+        return true;
+    }
+
+    bool FindSoftwareVertexShader(const jstring& name, SoftwareVertexShader& outShader)
+    {
+        std::lock_guard lock(SoftwareShadersMutex);
+        const SoftwareVertexShader* shader = SoftwareVertexShaders.find(jstringID(name));
+        if (shader == nullptr)
+        {
+            return false;
+        }
+        outShader = *shader;
+        return true;
+    }
+    bool FindSoftwareFragmentShader(const jstring& name, SoftwareFragmentShaderFunction& outShader)
+    {
+        std::lock_guard lock(SoftwareShadersMutex);
+        const SoftwareFragmentShaderFunction* shader = SoftwareFragmentShaders.find(jstringID(name));
+        if (shader == nullptr)
+        {
+            return false;
+        }
+        outShader = *shader;
+        return true;
+    }
+
+    math::vector4 SampleSoftwareTexture(const TextureBase* texture, const math::vector2& uv)
+    {
+#if defined(JUMARE_ENABLE_SOFTWARE)
+        const SoftwareImage* image = nullptr;
+        if (const Texture_Software* textureSoftware = dynamic_cast<const Texture_Software*>(texture))
+        {
+            image = &textureSoftware->getImage();
+        }
+        else if (const RenderTarget_Software* renderTarget = dynamic_cast<const RenderTarget_Software*>(texture))
+        {
+            image = &renderTarget->getColorImage();
+        }
+        if (image != nullptr)
+        {
+            return image->sample(uv, texture->getSamplerType());
+        }
+#endif
+        return { 0.0f, 0.0f, 0.0f, 0.0f };
+    }
+}
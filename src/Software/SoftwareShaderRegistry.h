@@ -0,0 +1,17 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "JumaRE/material/SoftwareShader.h"
+
+namespace JumaRenderEngine
+{
+    struct SoftwareVertexShader
+    {
+        SoftwareVertexShaderFunction function;
+        uint8 varyingsCount = 0;
+    };
+
+    bool FindSoftwareVertexShader(const jstring& name, SoftwareVertexShader& outShader);
+    bool FindSoftwareFragmentShader(const jstring& name, SoftwareFragmentShaderFunction& outShader);
+}
@@ -0,0 +1,42 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+
+#include "Texture_Software.h"
+
+#include <cstring>
+
+namespace JumaRenderEngine
+{
+    Texture_Software::~Texture_Software()
+    {
+        clearSoftware();
+    }
+
+    bool Texture_Software::initInternal(const math::uvector2& size, const TextureFormat format, const uint8* data)
+    {
+        if ((format != TextureFormat::RGBA8) && (format != TextureFormat::RGBA8_SRGB))
+        {
+            JUTILS_LOG(error, JSTR("Unsupported texture format for software render API"));
+            return false;
+        }
+
+        m_Image.size = size;
+        m_Image.pixels.resize(static_cast<int32>(size.x * size.y));
+        std::memcpy(m_Image.pixels.getData(), data, sizeof(uint32) * m_Image.pixels.getSize());
+        return true;
+    }
+
+    void Texture_Software::onClearAsset()
+    {
+        clearSoftware();
+        Super::onClearAsset();
+    }
+    void Texture_Software::clearSoftware()
+    {
+        m_Image.pixels.clear();
+        m_Image.size = { 0, 0 };
+    }
+}
+
+#endif
@@ -0,0 +1,37 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+
+#include "JumaRE/texture/Texture.h"
+
+#include "SoftwareImage.h"
+
+namespace JumaRenderEngine
+{
+    class Texture_Software final : public Texture
+    {
+        using Super = Texture;
+
+    public:
+        Texture_Software() = default;
+        virtual ~Texture_Software() override;
+
+        const SoftwareImage& getImage() const { return m_Image; }
+
+    protected:
+
+        virtual bool initInternal(const math::uvector2& size, TextureFormat format, const uint8* data) override;
+        virtual void onClearAsset() override;
+
+    private:
+
+        SoftwareImage m_Image;
+
+
+        void clearSoftware();
+    };
+}
+
+#endif
@@ -0,0 +1,92 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+
+#include "VertexBuffer_Software.h"
+
+#include <cstring>
+
+#include "RenderEngine_Software.h"
+#include "RenderTarget_Software.h"
+#include "Shader_Software.h"
+#include "JumaRE/RenderOptions.h"
+#include "JumaRE/material/Material.h"
+
+namespace JumaRenderEngine
+{
+    VertexBuffer_Software::~VertexBuffer_Software()
+    {
+        clearSoftware();
+    }
+
+    bool VertexBuffer_Software::initInternal(const VertexBufferData& data)
+    {
+        const RegisteredVertexDescription* vertexDescription = getRenderEngine()->findVertex(getVertexID());
+        if ((vertexDescription == nullptr) || (data.verticesData == nullptr))
+        {
+            JUTILS_LOG(error, JSTR("Invalid vertex buffer data"));
+            return false;
+        }
+
+        // All vertex component types are made of floats
+        m_VertexStride = vertexDescription->vertexSize / sizeof(float);
+        m_Vertices.resize(static_cast<int32>(m_VertexStride * data.vertexCount));
+        std::memcpy(m_Vertices.getData(), data.verticesData, static_cast<size_t>(vertexDescription->vertexSize) * data.vertexCount);
+        if ((data.indicesData != nullptr) && (data.indexCount > 0))
+        {
+            m_Indices.resize(static_cast<int32>(data.indexCount));
+            std::memcpy(m_Indices.getData(), data.indicesData, sizeof(uint32) * data.indexCount);
+        }
+        return true;
+    }
+
+    void VertexBuffer_Software::onClearAsset()
+    {
+        clearSoftware();
+        Super::onClearAsset();
+    }
+    void VertexBuffer_Software::clearSoftware()
+    {
+        m_Indices.clear();
+        m_Vertices.clear();
+        m_VertexStride = 0;
+    }
+
+    void VertexBuffer_Software::render(const RenderOptions* renderOptions, const RenderPrimitive& primitive)
+    {
+        const Material* material = primitive.material;
+        const Shader_Software* shader = material != nullptr ? dynamic_cast<const Shader_Software*>(material->getShader()) : nullptr;
+        if (shader == nullptr)
+        {
+            return;
+        }
+
+        const MaterialProperties& materialProperties = material->getMaterialProperties();
+        SoftwareDrawInfo drawInfo;
+        drawInfo.vertexShader = &shader->getVertexShader();
+        drawInfo.fragmentShader = &shader->getFragmentShader();
+        drawInfo.params = &material->getMaterialParams();
+        drawInfo.vertices = m_Vertices.getData();
+        drawInfo.vertexStride = m_VertexStride;
+        drawInfo.vertexCount = getVertexCount();
+        drawInfo.indices = !m_Indices.isEmpty() ? m_Indices.getData() : nullptr;
+        drawInfo.indexCount = static_cast<uint32>(m_Indices.getSize());
+        drawInfo.instanceCount = primitive.instanceCount;
+        drawInfo.depthTest = renderOptions->renderStageProperties.depthEnabled && materialProperties.depthEnabled;
+        drawInfo.blend = materialProperties.blendEnabled;
+        drawInfo.cullBackFaces = materialProperties.cullBackFaces;
+
+        const VertexBuffer_Software* instanceBuffer = dynamic_cast<const VertexBuffer_Software*>(primitive.instanceBuffer);
+        if (instanceBuffer != nullptr)
+        {
+            drawInfo.instances = instanceBuffer->m_Vertices.getData();
+            drawInfo.instanceStride = instanceBuffer->m_VertexStride;
+            drawInfo.instanceCount = math::min(drawInfo.instanceCount, instanceBuffer->getVertexCount());
+        }
+
+        reinterpret_cast<RenderTarget_Software*>(renderOptions->renderTarget)->getRasterizer().draw(drawInfo);
+        getRenderEngine()->addFrameCounter(RenderFrameCounter::DrawCalls);
+    }
+}
+
+#endif
@@ -0,0 +1,40 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+
+#include "JumaRE/vertex/VertexBuffer.h"
+
+#include <jutils/jarray.h>
+
+namespace JumaRenderEngine
+{
+    class VertexBuffer_Software final : public VertexBuffer
+    {
+        using Super = VertexBuffer;
+
+    public:
+        VertexBuffer_Software() = default;
+        virtual ~VertexBuffer_Software() override;
+
+        virtual void render(const RenderOptions* renderOptions, const RenderPrimitive& primitive) override;
+
+    protected:
+
+        virtual bool initInternal(const VertexBufferData& data) override;
+        virtual void onClearAsset() override;
+
+    private:
+
+        jarray<float> m_Vertices;
+        jarray<uint32> m_Indices;
+        // Count of floats in one vertex
+        uint32 m_VertexStride = 0;
+
+
+        void clearSoftware();
+    };
+}
+
+#endif
@@ -0,0 +1,25 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+
+#include "JumaRE/window/WindowController.h"
+
+#include "JumaRE/RenderAPI.h"
+
+namespace JumaRenderEngine
+{
+    class WindowController_Software : public WindowController
+    {
+        using Super = WindowController;
+
+    public:
+        WindowController_Software() = default;
+        virtual ~WindowController_Software() override = default;
+
+        static constexpr RenderAPI API = RenderAPI::Software;
+    };
+}
+
+#endif
@@ -0,0 +1,20 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_SOFTWARE)
+
+#include "WindowController_Software.h"
+#include "../../headless/WindowController_Headless.h"
+
+namespace JumaRenderEngine
+{
+    class WindowController_Software_Headless final : public WindowController_Headless<WindowController_Software>
+    {
+    public:
+        WindowController_Software_Headless() = default;
+        virtual ~WindowController_Software_Headless() override = default;
+    };
+}
+
+#endif
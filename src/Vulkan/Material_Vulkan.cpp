@@ -6,13 +6,19 @@
 
 #include "RenderEngine_Vulkan.h"
 #include "RenderOptions_Vulkan.h"
+#include "RenderPipeline_Vulkan.h"
 #include "RenderTarget_Vulkan.h"
 #include "Shader_Vulkan.h"
 #include "Texture_Vulkan.h"
 #include "VertexBuffer_Vulkan.h"
-#include "vulkanObjects/VulkanBuffer.h"
+#include "vulkanObjects/VulkanBindlessTextureTable.h"
 #include "vulkanObjects/VulkanCommandBuffer.h"
+#include "vulkanObjects/VulkanDescriptorAllocator.h"
 #include "vulkanObjects/VulkanImage.h"
+#include "vulkanObjects/VulkanUniformRing.h"
+
+#include <algorithm>
+#include <cstring>
 
 namespace JumaRenderEngine
 {
@@ -28,7 +34,12 @@ namespace JumaRenderEngine
             m_MaterialCreated = true;
             return true;
         }
-
+        // Instance uses descriptor sets of parent, own ones are created after it overrides any param
+        return (getRenderDataParent() != nullptr) || startCreateTask();
+    }
+    bool Material_Vulkan::startCreateTask()
+    {
+        m_CreateTaskStarted = true;
         m_CreateTaskActive = true;
         jasync_task* task = new MaterialCreateTask(this);
         if (!getRenderEngine()->getAsyncAssetTaksQueue().addTask(task))
@@ -40,120 +51,55 @@ namespace JumaRenderEngine
         }
         return true;
     }
-    bool Material_Vulkan::createDescriptorSet()
+    bool Material_Vulkan::createDescriptorSets()
     {
         const Shader_Vulkan* shader = getShader<Shader_Vulkan>();
-        const jmap<jstringID, ShaderUniform>& uniforms = shader->getUniforms();
-        const uint32 bufferUniformCount = static_cast<uint32>(shader->getUniformBufferDescriptions().getSize());
-        uint32 imageUniformCount = 0;
-        for (const auto& uniform : uniforms.values())
+        if (shader->getUniforms().isEmpty())
         {
-            switch (uniform.type)
-            {
-            case ShaderUniformType::Texture: 
-                imageUniformCount++;
-                break;
-            default: ;
-            }
+            return true;
         }
 
-        uint8 poolSizeCount = 0;
-        VkDescriptorPoolSize poolSizes[2];
-        if (bufferUniformCount > 0)
-        {
-            VkDescriptorPoolSize& poolSize = poolSizes[poolSizeCount++];
-            poolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-            poolSize.descriptorCount = bufferUniformCount;
-        }
-        if (imageUniformCount > 0)
-        {
-            VkDescriptorPoolSize& poolSize = poolSizes[poolSizeCount++];
-            poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-            poolSize.descriptorCount = imageUniformCount;
-        }
-        if (poolSizeCount == 0)
+        RenderEngine_Vulkan* renderEngine = getRenderEngine<RenderEngine_Vulkan>();
+        const int32 framesCount = renderEngine->getFramesInFlightCount();
+        jarray<VkDescriptorSet> descriptorSets(framesCount, nullptr);
+        if (!renderEngine->getDescriptorAllocator()->allocate(shader->getDescriptorSetLayout(), static_cast<uint32>(framesCount), descriptorSets.getData()))
         {
-            return true;
+            return false;
         }
 
-        VkDevice device = getRenderEngine<RenderEngine_Vulkan>()->getDevice();
-
-        VkDescriptorPoolCreateInfo poolInfo{};
-        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-        poolInfo.poolSizeCount = poolSizeCount;
-        poolInfo.pPoolSizes = poolSizes;
-        poolInfo.maxSets = 1;
-        poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
-        VkResult result = vkCreateDescriptorPool(device, &poolInfo, nullptr, &m_DescriptorPool);
-        if (result != VK_SUCCESS)
+        // Buffer descriptors are written on main thread, uniform ring could be recreated there
+        const jmap<uint32, ShaderUniformBufferDescription>& uniformBufferDescriptions = shader->getUniformBufferDescriptions();
+        m_UniformBufferLocations.reserve(static_cast<int32>(uniformBufferDescriptions.getSize()));
+        for (const auto& bufferLocation : uniformBufferDescriptions.keys())
         {
-            return false;
+            m_UniformBufferLocations.add(bufferLocation);
         }
+        std::sort(m_UniformBufferLocations.getData(), m_UniformBufferLocations.getData() + m_UniformBufferLocations.getSize());
+        m_UniformRingOffsets.resize(m_UniformBufferLocations.getSize(), 0);
 
-        VkDescriptorSetLayout descriptorSetLayout = shader->getDescriptorSetLayout();
-        VkDescriptorSetAllocateInfo allocateInfo{};
-        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-        allocateInfo.descriptorPool = m_DescriptorPool;
-        allocateInfo.descriptorSetCount = 1;
-        allocateInfo.pSetLayouts = &descriptorSetLayout;
-        result = vkAllocateDescriptorSets(device, &allocateInfo, &m_DescriptorSet);
-        if (result != VK_SUCCESS)
+        m_FramesData.resize(framesCount);
+        for (int32 frameIndex = 0; frameIndex < framesCount; frameIndex++)
         {
-            vkDestroyDescriptorPool(device, m_DescriptorPool, nullptr);
-            m_DescriptorPool = nullptr;
-            return false;
+            m_FramesData[frameIndex].descriptorSet = descriptorSets[frameIndex];
         }
-        if (!initDescriptorSetData())
+        for (auto& frameData : m_FramesData)
         {
-            vkDestroyDescriptorPool(device, m_DescriptorPool, nullptr);
-            m_DescriptorSet = nullptr;
-            m_DescriptorPool = nullptr;
-            return false;
+            if (!initDescriptorSetData(frameData))
+            {
+                freeDescriptorSets();
+                return false;
+            }
         }
         return true;
     }
-    bool Material_Vulkan::initDescriptorSetData()
+    bool Material_Vulkan::initDescriptorSetData(MaterialFrameData& frameData)
     {
-        if (m_DescriptorSet == nullptr)
-        {
-            return true;
-        }
-
         RenderEngine_Vulkan* renderEngine = getRenderEngine<RenderEngine_Vulkan>();
-        const jmap<uint32, ShaderUniformBufferDescription>& uniformBufferDescriptions = getShader()->getUniformBufferDescriptions();
         const jmap<jstringID, ShaderUniform>& uniforms = getShader()->getUniforms();
 
-        jarray<VkDescriptorBufferInfo> bufferInfos;
         jarray<VkDescriptorImageInfo> imageInfos;
         jarray<VkWriteDescriptorSet> descriptorWrites;
         descriptorWrites.reserve(static_cast<int32>(uniforms.getSize()));
-        if (!uniformBufferDescriptions.isEmpty())
-        {
-            bufferInfos.reserve(static_cast<int32>(uniformBufferDescriptions.getSize()));
-            for (const auto& [uniformLocation, bufferDescription] : uniformBufferDescriptions)
-            {
-                VulkanBuffer* buffer = renderEngine->getVulkanBuffer();
-                if (!buffer->initAccessedGPU(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, { VulkanQueueType::Graphics }, bufferDescription.size))
-                {
-                    renderEngine->returnVulkanBuffer(buffer);
-                    return false;
-                }
-                m_UniformBuffers.add(uniformLocation, buffer);
-
-                VkDescriptorBufferInfo& bufferInfo = bufferInfos.addDefault();
-                bufferInfo.buffer = buffer->get();
-                bufferInfo.offset = 0;
-                bufferInfo.range = VK_WHOLE_SIZE;
-                VkWriteDescriptorSet& descriptorWrite = descriptorWrites.addDefault();
-                descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-                descriptorWrite.descriptorCount = 1;
-                descriptorWrite.pBufferInfo = &bufferInfo;
-                descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                descriptorWrite.dstSet = m_DescriptorSet;
-                descriptorWrite.dstBinding = uniformLocation;
-                descriptorWrite.dstArrayElement = 0;
-            }
-        }
         if (!uniforms.isEmpty())
         {
             const Texture_Vulkan* defaultTexture = dynamic_cast<const Texture_Vulkan*>(renderEngine->getDefaultTexture());
@@ -172,7 +118,7 @@ namespace JumaRenderEngine
                 imageInfo.sampler = renderEngine->getTextureSampler(defaultTexture->getSamplerType());
                 VkWriteDescriptorSet& descriptorWrite = descriptorWrites.addDefault();
                 descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                descriptorWrite.dstSet = m_DescriptorSet;
+                descriptorWrite.dstSet = frameData.descriptorSet;
                 descriptorWrite.dstBinding = uniform.shaderLocation;
                 descriptorWrite.dstArrayElement = 0;
                 descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
@@ -186,18 +132,19 @@ namespace JumaRenderEngine
                 static_cast<uint32>(descriptorWrites.getSize()), descriptorWrites.getData(),
                 0, nullptr
             );
+            renderEngine->addFrameCounter(RenderFrameCounter::DescriptorUpdates, static_cast<uint64>(descriptorWrites.getSize()));
         }
         return true;
     }
 
-    bool Material_Vulkan::updateDescriptorSetData()
+    bool Material_Vulkan::updateDescriptorSetData(MaterialFrameData& frameData)
     {
-        if (m_DescriptorSet == nullptr)
+        if (frameData.descriptorSet == nullptr)
         {
             return true;
         }
 
-        const jset<jstringID>& notUpdatedParams = getNotUpdatedParams();
+        const MaterialParamsMask& notUpdatedParams = frameData.notUpdatedParams;
         if (notUpdatedParams.isEmpty())
         {
             return true;
@@ -205,125 +152,117 @@ namespace JumaRenderEngine
 
         RenderEngine_Vulkan* renderEngine = getRenderEngine<RenderEngine_Vulkan>();
         const Texture_Vulkan* defaultTexture = dynamic_cast<const Texture_Vulkan*>(renderEngine->getDefaultTexture());
-        const jmap<jstringID, ShaderUniform>& uniforms = getShader()->getUniforms();
+        const MaterialParamsLayout& paramsLayout = getShader()->getMaterialParamsLayout();
         const MaterialParamsStorage& params = getMaterialParams();
 
-        jarray<VkDescriptorImageInfo> imageInfos;
-        jarray<VkWriteDescriptorSet> descriptorWrites;
-        imageInfos.reserve(static_cast<int32>(uniforms.getSize()));
-        descriptorWrites.reserve(static_cast<int32>(uniforms.getSize()));
-        for (const auto& paramName : notUpdatedParams)
+        // Called only from main thread, so frame arena could be used here
+        FrameArena& frameArena = renderEngine->getFrameArena();
+        FrameArray<VkDescriptorImageInfo> imageInfos(frameArena, notUpdatedParams.getSize());
+        FrameArray<VkWriteDescriptorSet> descriptorWrites(frameArena, notUpdatedParams.getSize());
+        for (const auto& paramIndex : notUpdatedParams)
         {
-            const ShaderUniform* uniformPtr = uniforms.find(paramName);
-            if (uniformPtr == nullptr)
+            const ShaderUniform& uniform = paramsLayout.getParamUniform(paramIndex);
+            if (uniform.type != ShaderUniformType::Texture)
             {
                 continue;
             }
-            const ShaderUniform& uniform = *uniformPtr;
-            switch (uniform.type)
+
+            ShaderUniformInfo<ShaderUniformType::Texture>::value_type value;
+            if (!params.getValue<ShaderUniformType::Texture>(paramsLayout.getParam(paramIndex), value))
             {
-            case ShaderUniformType::Float:
+                continue;
+            }
+            VulkanImage* vulkanImage = nullptr;
+            {
+                const Texture_Vulkan* texture = dynamic_cast<Texture_Vulkan*>(value);
+                if (texture != nullptr)
                 {
-                    ShaderUniformInfo<ShaderUniformType::Float>::value_type value;
-                    if (!params.getValue<ShaderUniformType::Float>(paramName, value))
-                    {
-                        continue;
-                    }
-                    VulkanBuffer* buffer = m_UniformBuffers[uniform.shaderLocation];
-                    buffer->initMappedData();
-                    buffer->setMappedData(&value, sizeof(value), uniform.shaderBlockOffset);
+                    vulkanImage = texture->getVulkanImage();
                 }
-                break;
-            case ShaderUniformType::Vec2:
+                else
                 {
-                    ShaderUniformInfo<ShaderUniformType::Vec2>::value_type value;
-                    if (!params.getValue<ShaderUniformType::Vec2>(paramName, value))
+                    const RenderTarget_Vulkan* renderTarget = dynamic_cast<RenderTarget_Vulkan*>(value);
+                    if (renderTarget != nullptr)
                     {
-                        continue;
+                        vulkanImage = renderTarget->getResultImage();
                     }
-                    VulkanBuffer* buffer = m_UniformBuffers[uniform.shaderLocation];
-                    buffer->initMappedData();
-                    buffer->setMappedData(&value, sizeof(value), uniform.shaderBlockOffset);
-                }
-                break;
-            case ShaderUniformType::Vec4:
-                {
-                    ShaderUniformInfo<ShaderUniformType::Vec4>::value_type value;
-                    if (!params.getValue<ShaderUniformType::Vec4>(paramName, value))
+                    else if (defaultTexture != nullptr)
                     {
-                        continue;
+                        vulkanImage = defaultTexture->getVulkanImage();
                     }
-                    VulkanBuffer* buffer = m_UniformBuffers[uniform.shaderLocation];
-                    buffer->initMappedData();
-                    buffer->setMappedData(&value, sizeof(value), uniform.shaderBlockOffset);
-                }
-                break;
-            case ShaderUniformType::Mat4:
-                {
-                    ShaderUniformInfo<ShaderUniformType::Mat4>::value_type value;
-                    if (!params.getValue<ShaderUniformType::Mat4>(paramName, value))
+                    else
                     {
-                        continue;
+                        throw std::exception("Invalid default texture");
                     }
-                    VulkanBuffer* buffer = m_UniformBuffers[uniform.shaderLocation];
-                    buffer->initMappedData();
-                    buffer->setMappedData(&value, sizeof(value), uniform.shaderBlockOffset);
                 }
-                break;
+            }
+            if (vulkanImage == nullptr)
+            {
+                JUTILS_LOG(error, JSTR("Failed to get vulkan image"));
+                continue;
+            }
 
-            case ShaderUniformType::Texture:
-                {
-                    ShaderUniformInfo<ShaderUniformType::Texture>::value_type value;
-                    if (!params.getValue<ShaderUniformType::Texture>(paramName, value))
-                    {
-                        continue;
-                    }
-                    VulkanImage* vulkanImage = nullptr;
-                    {
-                        const Texture_Vulkan* texture = dynamic_cast<Texture_Vulkan*>(value);
-                        if (texture != nullptr)
-                        {
-                            vulkanImage = texture->getVulkanImage();
-                        }
-                        else
-                        {
-                            const RenderTarget_Vulkan* renderTarget = dynamic_cast<RenderTarget_Vulkan*>(value);
-                            if (renderTarget != nullptr)
-                            {
-                                vulkanImage = renderTarget->getResultImage();
-                            }
-                            else if (defaultTexture != nullptr)
-                            {
-                                vulkanImage = defaultTexture->getVulkanImage();
-                            }
-                            else
-                            {
-                                throw std::exception("Invalid default texture");
-                            }
-                        }
-                    }
-                    if (vulkanImage == nullptr)
-                    {
-                        JUTILS_LOG(error, JSTR("Failed to get vulkan image"));
-                        continue;
-                    }
+            VkDescriptorImageInfo& imageInfo = imageInfos.addDefault();
+            imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+            imageInfo.imageView = vulkanImage->getImageView();
+            imageInfo.sampler = renderEngine->getTextureSampler(value != nullptr ? value->getSamplerType() : TextureSamplerType());
+            VkWriteDescriptorSet& descriptorWrite = descriptorWrites.addDefault();
+            descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrite.dstSet = frameData.descriptorSet;
+            descriptorWrite.dstBinding = uniform.shaderLocation;
+            descriptorWrite.dstArrayElement = 0;
+            descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            descriptorWrite.descriptorCount = 1;
+            descriptorWrite.pImageInfo = &imageInfo;
+        }
+        if (!descriptorWrites.isEmpty())
+        {
+            vkUpdateDescriptorSets(renderEngine->getDevice(), 
+               static_cast<uint32>(descriptorWrites.getSize()), descriptorWrites.getData(),
+               0, nullptr
+            );
+            renderEngine->addFrameCounter(RenderFrameCounter::DescriptorUpdates, static_cast<uint64>(descriptorWrites.getSize()));
+        }
+        frameData.notUpdatedParams.clear();
+        return true;
+    }
+
+    void Material_Vulkan::writeUniformBufferDescriptors(const VulkanUniformRing* uniformRing)
+    {
+        RenderEngine_Vulkan* renderEngine = getRenderEngine<RenderEngine_Vulkan>();
+        const jmap<uint32, ShaderUniformBufferDescription>& uniformBufferDescriptions = getShader()->getUniformBufferDescriptions();
 
-                    VkDescriptorImageInfo& imageInfo = imageInfos.addDefault();
-                    imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-                    imageInfo.imageView = vulkanImage->getImageView();
-                    imageInfo.sampler = renderEngine->getTextureSampler(value != nullptr ? value->getSamplerType() : TextureSamplerType());
-                    VkWriteDescriptorSet& descriptorWrite = descriptorWrites.addDefault();
-                    descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-                    descriptorWrite.dstSet = m_DescriptorSet;
-                    descriptorWrite.dstBinding = uniform.shaderLocation;
-                    descriptorWrite.dstArrayElement = 0;
-                    descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-                    descriptorWrite.descriptorCount = 1;
-                    descriptorWrite.pImageInfo = &imageInfo;
+        // Called only from main thread, so frame arena could be used here
+        FrameArena& frameArena = renderEngine->getFrameArena();
+        const int32 descriptorsCount = m_FramesData.getSize() * m_UniformBufferLocations.getSize();
+        FrameArray<VkDescriptorBufferInfo> bufferInfos(frameArena, descriptorsCount);
+        FrameArray<VkWriteDescriptorSet> descriptorWrites(frameArena, descriptorsCount);
+        for (const auto& frameData : m_FramesData)
+        {
+            if (frameData.descriptorSet == nullptr)
+            {
+                continue;
+            }
+            for (const auto& bufferLocation : m_UniformBufferLocations)
+            {
+                const ShaderUniformBufferDescription* bufferDescription = uniformBufferDescriptions.find(bufferLocation);
+                if (bufferDescription == nullptr)
+                {
+                    continue;
                 }
-                break;
 
-            default: ;
+                VkDescriptorBufferInfo& bufferInfo = bufferInfos.addDefault();
+                bufferInfo.buffer = uniformRing->get();
+                bufferInfo.offset = 0;
+                bufferInfo.range = bufferDescription->size;
+                VkWriteDescriptorSet& descriptorWrite = descriptorWrites.addDefault();
+                descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+                descriptorWrite.dstSet = frameData.descriptorSet;
+                descriptorWrite.dstBinding = bufferLocation;
+                descriptorWrite.dstArrayElement = 0;
+                descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+                descriptorWrite.descriptorCount = 1;
+                descriptorWrite.pBufferInfo = &bufferInfo;
             }
         }
         if (!descriptorWrites.isEmpty())
@@ -332,21 +271,86 @@ namespace JumaRenderEngine
                static_cast<uint32>(descriptorWrites.getSize()), descriptorWrites.getData(),
                0, nullptr
             );
+            renderEngine->addFrameCounter(RenderFrameCounter::DescriptorUpdates, static_cast<uint64>(descriptorWrites.getSize()));
+        }
+    }
+    bool Material_Vulkan::writeUniformRingData()
+    {
+        if (m_UniformBufferLocations.isEmpty())
+        {
+            return true;
         }
-        clearParamsForUpdate();
 
-        if (!m_UniformBuffers.isEmpty())
+        const RenderPipeline_Vulkan* renderPipeline = dynamic_cast<const RenderPipeline_Vulkan*>(getRenderEngine()->getRenderPipeline());
+        VulkanUniformRing* uniformRing = renderPipeline != nullptr ? renderPipeline->getUniformRing() : nullptr;
+        if ((uniformRing == nullptr) || !uniformRing->isValid())
+        {
+            return false;
+        }
+        if (m_UniformRingGeneration != uniformRing->getGeneration())
         {
-            // TODO: Put it into one command buffer
-            bool needToWait = false;
-            for (const auto& buffer : m_UniformBuffers.values())
+            // Descriptor sets are not used by GPU here: either new ones or ring was recreated after all frames finished
+            writeUniformBufferDescriptors(uniformRing);
+            m_UniformRingGeneration = uniformRing->getGeneration();
+        }
+        if (m_UniformRingFrameIndex == uniformRing->getFrameIndex())
+        {
+            return true;
+        }
+
+        // Ring segment is reused every few frames, so data is written every frame the material is rendered
+        const jmap<uint32, ShaderUniformBufferDescription>& uniformBufferDescriptions = getShader()->getUniformBufferDescriptions();
+        const MaterialParamsStorage& params = getMaterialParams();
+        uint64 uploadedBytes = 0;
+        for (int32 index = 0; index < m_UniformBufferLocations.getSize(); index++)
+        {
+            const uint32 bufferLocation = m_UniformBufferLocations[index];
+            const ShaderUniformBufferDescription* bufferDescription = uniformBufferDescriptions.find(bufferLocation);
+            const uint8* bufferData = params.getUniformBufferData(bufferLocation);
+            uint8* ringData = (bufferDescription != nullptr) && (bufferData != nullptr) 
+                ? uniformRing->allocate(bufferDescription->size, m_UniformRingOffsets[index]) : nullptr;
+            if (ringData == nullptr)
             {
-                needToWait |= buffer->flushMappedData(false);
+                m_UniformRingFrameIndex = 0;
+                return false;
             }
-            if (needToWait)
+            std::memcpy(ringData, bufferData, bufferDescription->size);
+            if (getShader()->hasBindlessTextures() && !writeBindlessTextureIndices(bufferLocation, ringData))
             {
-                vkQueueWaitIdle(renderEngine->getQueue(VulkanQueueType::Transfer)->queue);
+                m_UniformRingFrameIndex = 0;
+                return false;
             }
+            uploadedBytes += bufferDescription->size;
+        }
+        m_UniformRingFrameIndex = uniformRing->getFrameIndex();
+        getRenderEngine()->addFrameCounter(RenderFrameCounter::UploadedBytes, uploadedBytes);
+        return true;
+    }
+
+    bool Material_Vulkan::writeBindlessTextureIndices(const uint32 bufferLocation, uint8* data) const
+    {
+        RenderEngine_Vulkan* renderEngine = getRenderEngine<RenderEngine_Vulkan>();
+        const MaterialParamsStorage& params = getMaterialParams();
+        const MaterialParamsLayout& paramsLayout = getShader()->getMaterialParamsLayout();
+        for (int32 paramIndex = 0; paramIndex < paramsLayout.getParamsCount(); paramIndex++)
+        {
+            const ShaderUniform& uniform = paramsLayout.getParamUniform(paramIndex);
+            if ((uniform.type != ShaderUniformType::BindlessTexture) || (uniform.shaderLocation != bufferLocation))
+            {
+                continue;
+            }
+
+            ShaderUniformInfo<ShaderUniformType::BindlessTexture>::value_type value = nullptr;
+            params.getValue<ShaderUniformType::BindlessTexture>(paramsLayout.getParam(paramIndex), value);
+            // Texture pointer is replaced with table index, padded to 8 bytes
+            const int32 tableIndex = renderEngine->getBindlessTextureIndex(value);
+            if (tableIndex < 0)
+            {
+                JUTILS_LOG(error, JSTR("Failed to get bindless texture index for param {}"), paramsLayout.getParamName(paramIndex));
+                return false;
+            }
+            const uint64 index = static_cast<uint64>(tableIndex);
+            std::memcpy(data + uniform.shaderBlockOffset, &index, sizeof(index));
         }
         return true;
     }
@@ -354,39 +358,59 @@ namespace JumaRenderEngine
     void Material_Vulkan::onClearAsset()
     {
         clearVulkan();
+        m_CreateTaskStarted = false;
+        m_MaterialValid = true;
+        m_MaterialCreated = false;
         Super::onClearAsset();
     }
     void Material_Vulkan::clearVulkan()
     {
-        RenderEngine_Vulkan* renderEngine = getRenderEngine<RenderEngine_Vulkan>();
-
-        if (m_DescriptorPool != nullptr)
-        {
-            vkDestroyDescriptorPool(renderEngine->getDevice(), m_DescriptorPool, nullptr);
-            m_DescriptorSet = nullptr;
-            m_DescriptorPool = nullptr;
-        }
+        freeDescriptorSets();
+        m_UniformBufferLocations.clear();
+        m_UniformRingOffsets.clear();
+        m_UniformRingFrameIndex = 0;
+        m_UniformRingGeneration = 0;
+    }
 
-        if (!m_UniformBuffers.isEmpty())
+    void Material_Vulkan::freeDescriptorSets()
+    {
+        if (!m_FramesData.isEmpty())
         {
-            for (const auto& buffer : m_UniformBuffers.values())
+            jarray<VkDescriptorSet> descriptorSets;
+            descriptorSets.reserve(m_FramesData.getSize());
+            for (const auto& frameData : m_FramesData)
             {
-                renderEngine->returnVulkanBuffer(buffer);
+                descriptorSets.add(frameData.descriptorSet);
             }
-            m_UniformBuffers.clear();
+            getRenderEngine<RenderEngine_Vulkan>()->getDescriptorAllocator()->free(
+                getShader<Shader_Vulkan>()->getDescriptorSetLayout(), descriptorSets.getData(), static_cast<uint32>(descriptorSets.getSize())
+            );
+            m_FramesData.clear();
         }
     }
 
-    bool Material_Vulkan::bindMaterial(const RenderOptions* renderOptions, VertexBuffer_Vulkan* vertexBuffer)
+    bool Material_Vulkan::prepareForRender()
     {
-        Shader_Vulkan* shader = getShader<Shader_Vulkan>();
+        Material_Vulkan* renderDataParent = getRenderDataParent<Material_Vulkan>();
+        if (renderDataParent != nullptr)
+        {
+            clearParamsForUpdate();
+            return renderDataParent->prepareForRender();
+        }
+
         if (!m_MaterialCreated)
         {
             if (m_CreateTaskActive)
             {
                 return false;
             }
-            m_MaterialValid = shader->getUniforms().isEmpty() || (m_DescriptorSet != nullptr);
+            if (!m_CreateTaskStarted)
+            {
+                // Instance overrides params of parent, all params are already marked for update
+                m_MaterialValid = startCreateTask();
+                return false;
+            }
+            m_MaterialValid = getShader()->getUniforms().isEmpty() || !m_FramesData.isEmpty();
             m_MaterialCreated = true;
         }
         if (!m_MaterialValid)
@@ -394,29 +418,93 @@ namespace JumaRenderEngine
             return false;
         }
 
-        const RenderOptions_Vulkan* options = reinterpret_cast<const RenderOptions_Vulkan*>(renderOptions);
-        MaterialProperties materialProperties = getMaterialProperties();
-        materialProperties.depthEnabled &= renderOptions->renderStageProperties.depthEnabled;
+        // Changed params should be uploaded to the data of every frame in flight
+        const MaterialParamsMask& notUpdatedParams = getNotUpdatedParams();
+        if (!notUpdatedParams.isEmpty())
+        {
+            for (auto& frameData : m_FramesData)
+            {
+                frameData.notUpdatedParams.add(notUpdatedParams);
+            }
+            clearParamsForUpdate();
+        }
 
-        VkCommandBuffer commandBuffer = options->commandBuffer->get();
-        return shader->bindRenderPipeline(commandBuffer, vertexBuffer->getVertexID(), options->renderPass, materialProperties)
-            && bindDescriptorSet(commandBuffer);
+        const int32 frameIndex = getRenderEngine()->getRenderPipeline()->getFrameInFlightIndex();
+        if (m_FramesData.isValidIndex(frameIndex) && !updateDescriptorSetData(m_FramesData[frameIndex]))
+        {
+            return false;
+        }
+        return writeUniformRingData();
+    }
+    bool Material_Vulkan::isReadyForRender() const
+    {
+        const Material_Vulkan* renderDataParent = getRenderDataParent<Material_Vulkan>();
+        if (renderDataParent != nullptr)
+        {
+            return getNotUpdatedParams().isEmpty() && renderDataParent->isReadyForRender();
+        }
+        if (!m_MaterialCreated || !m_MaterialValid || !getNotUpdatedParams().isEmpty())
+        {
+            return false;
+        }
+        const MaterialFrameData* frameData = getCurrentFrameData();
+        if ((frameData != nullptr) && !frameData->notUpdatedParams.isEmpty())
+        {
+            return false;
+        }
+        if (m_UniformBufferLocations.isEmpty())
+        {
+            return true;
+        }
+        const RenderPipeline_Vulkan* renderPipeline = dynamic_cast<const RenderPipeline_Vulkan*>(getRenderEngine()->getRenderPipeline());
+        const VulkanUniformRing* uniformRing = renderPipeline != nullptr ? renderPipeline->getUniformRing() : nullptr;
+        return (uniformRing != nullptr) && (m_UniformRingFrameIndex == uniformRing->getFrameIndex());
+    }
+
+    const Material_Vulkan::MaterialFrameData* Material_Vulkan::getCurrentFrameData() const
+    {
+        const int32 frameIndex = getRenderEngine()->getRenderPipeline()->getFrameInFlightIndex();
+        return m_FramesData.isValidIndex(frameIndex) ? &m_FramesData[frameIndex] : nullptr;
     }
 
-    bool Material_Vulkan::bindDescriptorSet(VkCommandBuffer commandBuffer)
+    bool Material_Vulkan::bindMaterial(const RenderOptions* renderOptions, VertexBuffer_Vulkan* vertexBuffer, const vertex_id instanceVertexID)
     {
-        if (!updateDescriptorSetData())
+        // Material should be prepared on main thread before recording on worker thread
+        if (renderOptions->recordingOnWorkerThread ? !isReadyForRender() : !prepareForRender())
         {
             return false;
         }
 
-        if (m_DescriptorSet != nullptr)
+        Shader_Vulkan* shader = getShader<Shader_Vulkan>();
+        const RenderOptions_Vulkan* options = reinterpret_cast<const RenderOptions_Vulkan*>(renderOptions);
+        MaterialProperties materialProperties = getMaterialProperties();
+        materialProperties.depthEnabled &= renderOptions->renderStageProperties.depthEnabled;
+
+        VkCommandBuffer commandBuffer = options->commandBuffer->get();
+        const Material_Vulkan* renderDataParent = getRenderDataParent<Material_Vulkan>();
+        return shader->bindRenderPipeline(commandBuffer, vertexBuffer->getVertexID(), instanceVertexID, options->renderPass, materialProperties)
+            && (renderDataParent != nullptr ? renderDataParent->bindDescriptorSet(commandBuffer) : bindDescriptorSet(commandBuffer));
+    }
+
+    bool Material_Vulkan::bindDescriptorSet(VkCommandBuffer commandBuffer) const
+    {
+        const MaterialFrameData* frameData = getCurrentFrameData();
+        if ((frameData != nullptr) && (frameData->descriptorSet != nullptr))
         {
             const Shader_Vulkan* shader = getShader<Shader_Vulkan>();
             vkCmdBindDescriptorSets(commandBuffer, 
                 VK_PIPELINE_BIND_POINT_GRAPHICS, shader->getPipelineLayout(), 
-                0, 1, &m_DescriptorSet, 0, nullptr
+                0, 1, &frameData->descriptorSet, 
+                static_cast<uint32>(m_UniformRingOffsets.getSize()), m_UniformRingOffsets.getData()
             );
+            if (shader->hasBindlessTextures())
+            {
+                const VkDescriptorSet textureTableSet = getRenderEngine<RenderEngine_Vulkan>()->getBindlessTextureTable()->getDescriptorSet();
+                vkCmdBindDescriptorSets(commandBuffer, 
+                    VK_PIPELINE_BIND_POINT_GRAPHICS, shader->getPipelineLayout(), 
+                    1, 1, &textureTableSet, 0, nullptr
+                );
+            }
         }
         return true;
     }
@@ -9,10 +9,12 @@
 #include <jutils/jasync_task_queue.h>
 #include <vulkan/vulkan_core.h>
 
+#include "JumaRE/vertex/VertexDescription.h"
+
 namespace JumaRenderEngine
 {
     class VulkanRenderPass;
-    class VulkanBuffer;
+    class VulkanUniformRing;
     class VertexBuffer_Vulkan;
     struct RenderOptions;
 
@@ -24,14 +26,17 @@ namespace JumaRenderEngine
         Material_Vulkan() = default;
         virtual ~Material_Vulkan() override;
 
-        bool bindMaterial(const RenderOptions* renderOptions, VertexBuffer_Vulkan* vertexBuffer);
+        bool prepareForRender();
+        bool isReadyForRender() const;
+
+        bool bindMaterial(const RenderOptions* renderOptions, VertexBuffer_Vulkan* vertexBuffer, vertex_id instanceVertexID);
         void unbindMaterial(const RenderOptions* renderOptions, VertexBuffer_Vulkan* vertexBuffer) {}
 
     protected:
 
         virtual bool initInternal() override;
 
-        virtual bool isReadyForDestroy() const { return !m_CreateTaskActive; }
+        virtual bool isReadyForDestroy() override { return Super::isReadyForDestroy() && !m_CreateTaskActive; }
         virtual void onClearAsset() override;
 
     private:
@@ -43,30 +48,47 @@ namespace JumaRenderEngine
             MaterialCreateTask(Material_Vulkan* material) : m_Material(material) {}
             virtual ~MaterialCreateTask() override { m_Material->m_CreateTaskActive = false; }
 
-            virtual void run() override { m_Material->createDescriptorSet(); }
+            virtual void run() override { m_Material->createDescriptorSets(); }
 
         private:
 
             Material_Vulkan* m_Material = nullptr;
         };
 
-        jmap<uint32, VulkanBuffer*> m_UniformBuffers;
+        struct MaterialFrameData
+        {
+            VkDescriptorSet descriptorSet = nullptr;
+            MaterialParamsMask notUpdatedParams;
+        };
+
+        // Separate descriptor set for each frame in flight, allocated from shared descriptor allocator
+        jarray<MaterialFrameData> m_FramesData;
 
-        VkDescriptorPool m_DescriptorPool = nullptr;
-        VkDescriptorSet m_DescriptorSet = nullptr;
+        // Sorted by binding, dynamic offsets are passed in the same order
+        jarray<uint32> m_UniformBufferLocations;
+        jarray<uint32> m_UniformRingOffsets;
+        uint64 m_UniformRingFrameIndex = 0;
+        uint32 m_UniformRingGeneration = 0;
 
         std::atomic_bool m_CreateTaskActive = false;
+        bool m_CreateTaskStarted = false;
         bool m_MaterialValid = true;
         bool m_MaterialCreated = false;
 
         
-        bool createDescriptorSet();
-        bool initDescriptorSetData();
-        bool updateDescriptorSetData();
+        bool startCreateTask();
+        bool createDescriptorSets();
+        bool initDescriptorSetData(MaterialFrameData& frameData);
+        bool updateDescriptorSetData(MaterialFrameData& frameData);
+        void writeUniformBufferDescriptors(const VulkanUniformRing* uniformRing);
+        bool writeUniformRingData();
+        bool writeBindlessTextureIndices(uint32 bufferLocation, uint8* data) const;
 
         void clearVulkan();
+        void freeDescriptorSets();
 
-        bool bindDescriptorSet(VkCommandBuffer commandBuffer);
+        const MaterialFrameData* getCurrentFrameData() const;
+        bool bindDescriptorSet(VkCommandBuffer commandBuffer) const;
     };
 }
 
@@ -7,7 +7,9 @@
 #include "RenderEngine_Vulkan.h"
 
 #include "RenderPipeline_Vulkan.h"
+#include "vulkanObjects/VulkanBindlessTextureTable.h"
 #include "vulkanObjects/VulkanCommandPool.h"
+#include "vulkanObjects/VulkanDescriptorAllocator.h"
 #include "window/WindowControllerImpl_Vulkan.h"
 
 namespace JumaRenderEngine
@@ -40,7 +42,7 @@ namespace JumaRenderEngine
 
     WindowController* RenderEngine_Vulkan::createWindowController()
     {
-        return CreateWindowController_Vulkan();
+        return CreateWindowController_Vulkan(isHeadless());
     }
     RenderPipeline* RenderEngine_Vulkan::createRenderPipelineInternal()
     {
@@ -73,6 +75,16 @@ namespace JumaRenderEngine
             JUTILS_LOG(error, JSTR("Failed to create command pools"));
             return false;
         }
+        m_DescriptorAllocator = createObject<VulkanDescriptorAllocator>();
+        if (!m_DescriptorAllocator->init(1024))
+        {
+            JUTILS_LOG(error, JSTR("Failed to create descriptor allocator"));
+            return false;
+        }
+        if (m_DescriptorIndexingSupported && !createBindlessTextureTable())
+        {
+            JUTILS_LOG(warning, JSTR("Failed to create bindless texture table, bindless textures are disabled"));
+        }
         if (!getWindowController<WindowController_Vulkan>()->createWindowSwapchains())
         {
             JUTILS_LOG(error, JSTR("Failed to create vulkan swapchains"));
@@ -186,6 +198,14 @@ namespace JumaRenderEngine
     }
 #endif
 
+    jarray<const char*> RenderEngine_Vulkan::getRequiredDeviceExtensions() const
+    {
+        if (isHeadless())
+        {
+            return {};
+        }
+        return { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    }
     bool RenderEngine_Vulkan::pickPhysicalDevice()
     {
         uint32 deviceCount = 0;
@@ -197,7 +217,7 @@ namespace JumaRenderEngine
 
         WindowController* windowController = getWindowController(); 
         const jarray<window_id> windowIDs = windowController->getWindowIDs();
-        if (windowIDs.isEmpty())
+        if (windowIDs.isEmpty() && !isHeadless())
         {
             return false;
         }
@@ -207,6 +227,7 @@ namespace JumaRenderEngine
             windowSurfaces[index] = windowController->findWindowData<WindowData_Vulkan>(windowIDs[index])->vulkanSurface;
         }
 
+        const jarray<const char*> requiredExtensions = getRequiredDeviceExtensions();
         jarray<VkPhysicalDevice> physicalDevices(static_cast<int32>(deviceCount));
         vkEnumeratePhysicalDevices(m_VulkanInstance, &deviceCount, physicalDevices.getData());
         for (const auto& physicalDevice : physicalDevices)
@@ -217,65 +238,81 @@ namespace JumaRenderEngine
             {
                 continue;
             }
-
-            if constexpr (m_RequiredExtensionCount > 0)
+            if (checkPhysicalDevice(physicalDevice, requiredExtensions, windowSurfaces))
+            {
+                m_PhysicalDevice = physicalDevice;
+                return true;
+            }
+        }
+        if (isHeadless())
+        {
+            // Integrated GPUs and software implementations (lavapipe) are fine for offscreen rendering
+            for (const auto& physicalDevice : physicalDevices)
             {
-                uint32 extensionCount;
-		        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
-		        jarray<VkExtensionProperties> availableExtensions(static_cast<int32>(extensionCount));
-		        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.getData());
+                if (checkPhysicalDevice(physicalDevice, requiredExtensions, windowSurfaces))
+                {
+                    m_PhysicalDevice = physicalDevice;
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+    bool RenderEngine_Vulkan::checkPhysicalDevice(VkPhysicalDevice physicalDevice, const jarray<const char*>& requiredExtensions, 
+        const jarray<VkSurfaceKHR>& surfaces)
+    {
+        if (!requiredExtensions.isEmpty())
+        {
+            uint32 extensionCount;
+	        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, nullptr);
+	        jarray<VkExtensionProperties> availableExtensions(static_cast<int32>(extensionCount));
+	        vkEnumerateDeviceExtensionProperties(physicalDevice, nullptr, &extensionCount, availableExtensions.getData());
 
-                bool allRequiredExtensionAailable = true;
-                for (const auto& requiredExtension : m_RequiredExtensions)
+            for (const auto& requiredExtension : requiredExtensions)
+            {
+                bool extensionAailable = false;
+                for (const auto& availableExtension : availableExtensions)
                 {
-                    bool extensionAailable = false;
-                    for (const auto& availableExtension : availableExtensions)
+                    if (strcmp(requiredExtension, availableExtension.extensionName) == 0)
                     {
-                        if (strcmp(requiredExtension, availableExtension.extensionName) == 0)
-                        {
-                            extensionAailable = true;
-                            break;
-                        }
-                    }
-                    if (!extensionAailable)
-                    {
-                        allRequiredExtensionAailable = false;
+                        extensionAailable = true;
                         break;
                     }
                 }
-                if (!allRequiredExtensionAailable)
+                if (!extensionAailable)
                 {
-                    continue;
+                    return false;
                 }
             }
+        }
+
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+        if (supportedFeatures.samplerAnisotropy != VK_TRUE)
+        {
+            return false;
+        }
 
-            VkPhysicalDeviceFeatures supportedFeatures;
-            vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
-            if (supportedFeatures.samplerAnisotropy != VK_TRUE)
+        if (surfaces.isEmpty())
+        {
+            return getQueueFamilyIndices(physicalDevice, nullptr, m_QueueIndices, m_Queues);
+        }
+        for (const auto& surface : surfaces)
+        {
+            uint32 surfaceFormatCount;
+            vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &surfaceFormatCount, nullptr);
+            if (surfaceFormatCount == 0)
             {
                 continue;
             }
-
-            for (const auto& surface : windowSurfaces)
+            uint32 surfacePresentModeCount;
+            vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &surfacePresentModeCount, nullptr);
+            if (surfacePresentModeCount == 0)
+            {
+                continue;
+            }
+            if (getQueueFamilyIndices(physicalDevice, surface, m_QueueIndices, m_Queues))
             {
-                uint32 surfaceFormatCount;
-                vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice, surface, &surfaceFormatCount, nullptr);
-                if (surfaceFormatCount == 0)
-                {
-                    continue;
-                }
-                uint32 surfacePresentModeCount;
-                vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice, surface, &surfacePresentModeCount, nullptr);
-                if (surfacePresentModeCount == 0)
-                {
-                    continue;
-                }
-                if (!getQueueFamilyIndices(physicalDevice, surface, m_QueueIndices, m_Queues))
-                {
-                    continue;
-                }
-
-                m_PhysicalDevice = physicalDevice;
                 return true;
             }
         }
@@ -361,20 +398,43 @@ namespace JumaRenderEngine
             queueInfos.add(queueInfo);
         }
 
+        // Descriptor indexing is a part of core 1.2, it's optional and used only for bindless textures
+        VkPhysicalDeviceVulkan12Features supportedFeatures_1_2{};
+        supportedFeatures_1_2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        VkPhysicalDeviceFeatures2 supportedFeatures{};
+        supportedFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+        supportedFeatures.pNext = &supportedFeatures_1_2;
+        vkGetPhysicalDeviceFeatures2(m_PhysicalDevice, &supportedFeatures);
+        m_DescriptorIndexingSupported = supportedFeatures_1_2.runtimeDescriptorArray && supportedFeatures_1_2.descriptorBindingPartiallyBound
+            && supportedFeatures_1_2.descriptorBindingSampledImageUpdateAfterBind && supportedFeatures_1_2.descriptorBindingUpdateUnusedWhilePending
+            && supportedFeatures_1_2.shaderSampledImageArrayNonUniformIndexing;
+
+        const jarray<const char*> requiredExtensions = getRequiredDeviceExtensions();
         VkPhysicalDeviceFeatures deviceFeatures{};
         deviceFeatures.samplerAnisotropy = VK_TRUE;
         deviceFeatures.sampleRateShading = VK_TRUE;
         VkPhysicalDeviceVulkan13Features deviceFeatures_1_3{};
         deviceFeatures_1_3.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
         deviceFeatures_1_3.synchronization2 = VK_TRUE;
+        VkPhysicalDeviceVulkan12Features deviceFeatures_1_2{};
+        deviceFeatures_1_2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+        deviceFeatures_1_2.pNext = &deviceFeatures_1_3;
+        if (m_DescriptorIndexingSupported)
+        {
+            deviceFeatures_1_2.runtimeDescriptorArray = VK_TRUE;
+            deviceFeatures_1_2.descriptorBindingPartiallyBound = VK_TRUE;
+            deviceFeatures_1_2.descriptorBindingSampledImageUpdateAfterBind = VK_TRUE;
+            deviceFeatures_1_2.descriptorBindingUpdateUnusedWhilePending = VK_TRUE;
+            deviceFeatures_1_2.shaderSampledImageArrayNonUniformIndexing = VK_TRUE;
+        }
         VkDeviceCreateInfo deviceInfo{};
 	    deviceInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
-        deviceInfo.pNext = &deviceFeatures_1_3;
+        deviceInfo.pNext = &deviceFeatures_1_2;
 	    deviceInfo.queueCreateInfoCount = static_cast<uint32>(queueInfos.getSize());
 	    deviceInfo.pQueueCreateInfos = queueInfos.getData();
 	    deviceInfo.pEnabledFeatures = &deviceFeatures;
-	    deviceInfo.enabledExtensionCount = m_RequiredExtensionCount;
-	    deviceInfo.ppEnabledExtensionNames = m_RequiredExtensions;
+	    deviceInfo.enabledExtensionCount = static_cast<uint32>(requiredExtensions.getSize());
+	    deviceInfo.ppEnabledExtensionNames = requiredExtensions.getData();
 	    deviceInfo.enabledLayerCount = 0;
         VkResult result = vkCreateDevice(m_PhysicalDevice, &deviceInfo, nullptr, &m_Device);
         if (result != VK_SUCCESS)
@@ -397,6 +457,28 @@ namespace JumaRenderEngine
         return true;
     }
 
+    bool RenderEngine_Vulkan::createBindlessTextureTable()
+    {
+        VkPhysicalDeviceVulkan12Properties properties_1_2{};
+        properties_1_2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_PROPERTIES;
+        VkPhysicalDeviceProperties2 properties{};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties.pNext = &properties_1_2;
+        vkGetPhysicalDeviceProperties2(m_PhysicalDevice, &properties);
+        const uint32 maxTexturesCount = math::min(4096u, math::min(
+            properties_1_2.maxPerStageDescriptorUpdateAfterBindSampledImages, properties_1_2.maxDescriptorSetUpdateAfterBindSampledImages
+        ));
+
+        VulkanBindlessTextureTable* textureTable = createObject<VulkanBindlessTextureTable>();
+        if (!textureTable->init(maxTexturesCount))
+        {
+            delete textureTable;
+            return false;
+        }
+        m_BindlessTextureTable = textureTable;
+        return true;
+    }
+
     bool RenderEngine_Vulkan::createCommandPools()
     {
         for (auto& queue : m_Queues)
@@ -466,6 +548,19 @@ namespace JumaRenderEngine
         m_VulkanImagesPool.clear();
         m_VulkanBuffersPool.clear();
 
+        if (m_BindlessTextureTable != nullptr)
+        {
+            delete m_BindlessTextureTable;
+            m_BindlessTextureTable = nullptr;
+        }
+        m_DescriptorIndexingSupported = false;
+
+        if (m_DescriptorAllocator != nullptr)
+        {
+            delete m_DescriptorAllocator;
+            m_DescriptorAllocator = nullptr;
+        }
+
         for (const auto& commandPool : m_CommandPools.values())
         {
             delete commandPool;
@@ -545,10 +640,12 @@ namespace JumaRenderEngine
 
     void RenderEngine_Vulkan::onRegisteredVertex(const vertex_id vertexID, const RegisteredVertexDescription& data)
     {
+        // Per-instance data is always bound as second vertex buffer
+        const bool instanceData = data.inputRate == VertexComponentInputRate::Instance;
         VertexDescription_Vulkan& descriptionVulkan = m_RegisteredVertices_Vulkan[vertexID];
-        descriptionVulkan.binding.binding = 0;
+        descriptionVulkan.binding.binding = instanceData ? 1 : 0;
         descriptionVulkan.binding.stride = data.vertexSize;
-        descriptionVulkan.binding.inputRate = VkVertexInputRate::VK_VERTEX_INPUT_RATE_VERTEX;
+        descriptionVulkan.binding.inputRate = instanceData ? VkVertexInputRate::VK_VERTEX_INPUT_RATE_INSTANCE : VkVertexInputRate::VK_VERTEX_INPUT_RATE_VERTEX;
 
         int32 componentOffset = 0;
         descriptionVulkan.attributes.reserve(data.description.components.getSize());
@@ -672,6 +769,50 @@ namespace JumaRenderEngine
         }
         return m_TextureSamplers[samplerType] = sampler;
     }
+    int32 RenderEngine_Vulkan::getBindlessTextureIndex(const TextureBase* texture)
+    {
+        if (m_BindlessTextureTable == nullptr)
+        {
+            return -1;
+        }
+
+        const Texture_Vulkan* defaultTexture = dynamic_cast<const Texture_Vulkan*>(getDefaultTexture());
+        if (texture != defaultTexture)
+        {
+            const VulkanImage* vulkanImage = nullptr;
+            const Texture_Vulkan* textureVulkan = dynamic_cast<const Texture_Vulkan*>(texture);
+            if (textureVulkan != nullptr)
+            {
+                vulkanImage = textureVulkan->getVulkanImage();
+            }
+            else
+            {
+                const RenderTarget_Vulkan* renderTarget = dynamic_cast<const RenderTarget_Vulkan*>(texture);
+                if (renderTarget != nullptr)
+                {
+                    vulkanImage = renderTarget->getResultImage();
+                }
+            }
+            const int32 index = (vulkanImage != nullptr) && (vulkanImage->getImageView() != nullptr)
+                ? m_BindlessTextureTable->getTextureIndex(vulkanImage->getImageView(), texture->getSamplerType()) : -1;
+            if (index >= 0)
+            {
+                return index;
+            }
+        }
+
+        // Default texture is used for invalid textures and if table is full, it has reserved slot
+        if (!m_BindlessTextureTable->isDefaultTextureSet())
+        {
+            const VulkanImage* defaultImage = defaultTexture != nullptr ? defaultTexture->getVulkanImage() : nullptr;
+            if ((defaultImage == nullptr) || (defaultImage->getImageView() == nullptr))
+            {
+                return -1;
+            }
+            m_BindlessTextureTable->setDefaultTexture(defaultImage->getImageView(), defaultTexture->getSamplerType());
+        }
+        return static_cast<int32>(VulkanBindlessTextureTable::DefaultTextureIndex);
+    }
 }
 
 #endif
@@ -24,6 +24,8 @@ namespace JumaRenderEngine
     class VulkanImage;
     class VulkanBuffer;
     class VulkanCommandPool;
+    class VulkanDescriptorAllocator;
+    class VulkanBindlessTextureTable;
 
     struct VulkanQueueDescription
     {
@@ -55,6 +57,8 @@ namespace JumaRenderEngine
 
         const VulkanQueueDescription* getQueue(const VulkanQueueType type) const { return !m_QueueIndices.isEmpty() ? &m_Queues[m_QueueIndices[type]] : nullptr; }
         VulkanCommandPool* getCommandPool(const VulkanQueueType type) const { return !m_CommandPools.isEmpty() ? m_CommandPools[type] : nullptr; }
+        VulkanDescriptorAllocator* getDescriptorAllocator() const { return m_DescriptorAllocator; }
+        VulkanBindlessTextureTable* getBindlessTextureTable() const { return m_BindlessTextureTable; }
 
         VulkanBuffer* getVulkanBuffer() { return m_VulkanBuffersPool.getPoolObject(); }
         VulkanImage* getVulkanImage() { return m_VulkanImagesPool.getPoolObject(); }
@@ -68,9 +72,16 @@ namespace JumaRenderEngine
 
         VkSampler getTextureSampler(TextureSamplerType samplerType);
 
+        virtual bool isBindlessTexturesSupported() const override { return m_BindlessTextureTable != nullptr; }
+        // Returns index in bindless texture table, default texture is used if it's nullptr or table is full.
+        // Returns -1 only if default texture is not available. Should be called from main thread
+        int32 getBindlessTextureIndex(const TextureBase* texture);
+
     protected:
 
         virtual bool initInternal(const WindowCreateInfo& mainWindowInfo) override;
+        virtual int32 getMaxFramesInFlightCount() const override { return 3; }
+        virtual bool isHeadlessModeSupported() const override { return true; }
         virtual void clearInternal() override;
 
         virtual WindowController* createWindowController() override;
@@ -91,11 +102,6 @@ namespace JumaRenderEngine
 
     private:
 
-        static constexpr uint8 m_RequiredExtensionCount = 1;
-        static constexpr const char* m_RequiredExtensions[m_RequiredExtensionCount] = {
-            VK_KHR_SWAPCHAIN_EXTENSION_NAME
-        };
-
         jpool_simple_async<VulkanBuffer> m_VulkanBuffersPool;
         jpool_simple_async<VulkanImage> m_VulkanImagesPool;
         
@@ -119,6 +125,9 @@ namespace JumaRenderEngine
         jmap<VulkanQueueType, int32> m_QueueIndices;
         jarray<VulkanQueueDescription> m_Queues;
         jmap<VulkanQueueType, VulkanCommandPool*> m_CommandPools;
+        VulkanDescriptorAllocator* m_DescriptorAllocator = nullptr;
+        VulkanBindlessTextureTable* m_BindlessTextureTable = nullptr;
+        bool m_DescriptorIndexingSupported = false;
         
         juid<render_pass_type_id> m_RenderPassTypeIDs;
         jmap<VulkanRenderPassDescription, render_pass_type_id, VulkanRenderPassDescription::compatible_predicate> m_RenderPassTypes;
@@ -132,11 +141,15 @@ namespace JumaRenderEngine
         bool createVulkanInstance();
         jarray<const char*> getRequiredVulkanExtensions() const;
 
+        jarray<const char*> getRequiredDeviceExtensions() const;
         bool pickPhysicalDevice();
+        bool checkPhysicalDevice(VkPhysicalDevice physicalDevice, const jarray<const char*>& requiredExtensions, 
+            const jarray<VkSurfaceKHR>& surfaces);
         static bool getQueueFamilyIndices(VkPhysicalDevice physicalDevice, VkSurfaceKHR surface, 
             jmap<VulkanQueueType, int32>& outQueueIndices, jarray<VulkanQueueDescription>& outQueues);
         bool createDevice();
         bool createCommandPools();
+        bool createBindlessTextureTable();
 
         void clearVulkan();
     };
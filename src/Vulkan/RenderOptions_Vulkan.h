@@ -15,6 +15,9 @@ namespace JumaRenderEngine
     {
         const VulkanRenderPass* renderPass = nullptr;
         VulkanCommandBuffer* commandBuffer = nullptr;
+
+        // Secondary command buffer with recorded render pass content
+        VulkanCommandBuffer* renderPassCommandBuffer = nullptr;
     };
 }
 
@@ -4,10 +4,13 @@
 
 #include "RenderPipeline_Vulkan.h"
 
+#include "Material_Vulkan.h"
 #include "RenderEngine_Vulkan.h"
 #include "RenderOptions_Vulkan.h"
+#include "RenderTarget_Vulkan.h"
 #include "vulkanObjects/VulkanCommandPool.h"
 #include "vulkanObjects/VulkanSwapchain.h"
+#include "vulkanObjects/VulkanUniformRing.h"
 #include "window/WindowController_Vulkan.h"
 
 namespace JumaRenderEngine
@@ -24,52 +27,112 @@ namespace JumaRenderEngine
             return false;
         }
 
-        VkDevice device = getRenderEngine<RenderEngine_Vulkan>()->getDevice();
+        const RenderEngine_Vulkan* renderEngine = getRenderEngine<RenderEngine_Vulkan>();
+        VkDevice device = renderEngine->getDevice();
 
         VkFenceCreateInfo fenceInfo{};
         fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
         fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
-        VkResult result = vkCreateFence(device, &fenceInfo, nullptr, &m_RenderFinishedFence);
-        if (result != VK_SUCCESS)
+        VkSemaphoreCreateInfo semaphoreInfo{};
+        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
+        m_RenderFrames.resize(renderEngine->getFramesInFlightCount());
+        for (auto& renderFrame : m_RenderFrames)
         {
-            JUTILS_ERROR_LOG(result, JSTR("Failed to create vulkan fence"));
-            return false;
+            VkResult result = vkCreateFence(device, &fenceInfo, nullptr, &renderFrame.renderFinishedFence);
+            if (result != VK_SUCCESS)
+            {
+                JUTILS_ERROR_LOG(result, JSTR("Failed to create vulkan fence"));
+                clearVulkan();
+                return false;
+            }
+            result = vkCreateSemaphore(device, &semaphoreInfo, nullptr, &renderFrame.renderFinishedSemaphore);
+            if (result != VK_SUCCESS)
+            {
+                JUTILS_ERROR_LOG(result, JSTR("Failed to create vulkan semaphore"));
+                clearVulkan();
+                return false;
+            }
         }
 
-        VkSemaphoreCreateInfo semaphoreInfo{};
-        semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-        result = vkCreateSemaphore(device, &semaphoreInfo, nullptr, &m_RenderFinishedSemaphore);
-        if (result != VK_SUCCESS)
+        VkPhysicalDeviceProperties deviceProperties;
+        vkGetPhysicalDeviceProperties(renderEngine->getPhysicalDevice(), &deviceProperties);
+        m_TimestampPeriod = deviceProperties.limits.timestampComputeAndGraphics == VK_TRUE ? deviceProperties.limits.timestampPeriod : 0.0f;
+
+        VulkanUniformRing* uniformRing = getRenderEngine()->createObject<VulkanUniformRing>();
+        if (!uniformRing->init(1024 * 1024, renderEngine->getFramesInFlightCount()))
         {
-            JUTILS_ERROR_LOG(result, JSTR("Failed to create vulkan semaphore"));
+            JUTILS_LOG(error, JSTR("Failed to create uniform ring"));
+            delete uniformRing;
             clearVulkan();
             return false;
         }
+        m_UniformRing = uniformRing;
+        return true;
+    }
 
+    bool RenderPipeline_Vulkan::initRenderRecordWorker(const int32 workerIndex)
+    {
+        if (!m_RenderRecordCommandPools.isValidIndex(workerIndex))
+        {
+            m_RenderRecordCommandPools.resize(workerIndex + 1, nullptr);
+        }
+
+        VulkanCommandPool* commandPool = getRenderEngine()->createObject<VulkanCommandPool>();
+        if (!commandPool->init(VulkanQueueType::Graphics, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT))
+        {
+            JUTILS_LOG(error, JSTR("Failed to create command pool for render record worker {}"), workerIndex);
+            delete commandPool;
+            return false;
+        }
+        m_RenderRecordCommandPools[workerIndex] = commandPool;
         return true;
     }
+    void RenderPipeline_Vulkan::clearRenderRecordWorker(const int32 workerIndex)
+    {
+        if (m_RenderRecordCommandPools.isValidIndex(workerIndex) && (m_RenderRecordCommandPools[workerIndex] != nullptr))
+        {
+            delete m_RenderRecordCommandPools[workerIndex];
+            m_RenderRecordCommandPools[workerIndex] = nullptr;
+        }
+    }
 
     void RenderPipeline_Vulkan::clearVulkan()
     {
         VkDevice device = getRenderEngine<RenderEngine_Vulkan>()->getDevice();
 
-        m_SwapchainImageReadySemaphores.clear();
-        m_Swapchains.clear();
-        if (m_RenderCommandBuffer != nullptr)
+        waitForRenderFinished();
+        stopRenderRecordWorkers();
+        m_RenderRecordCommandPools.clear();
+
+        if (m_UniformRing != nullptr)
         {
-            m_RenderCommandBuffer->returnToCommandPool();
-            m_RenderCommandBuffer = nullptr;
+            delete m_UniformRing;
+            m_UniformRing = nullptr;
         }
-        if (m_RenderFinishedSemaphore != nullptr)
+
+        m_SwapchainImageReadySemaphores.clear();
+        m_Swapchains.clear();
+        for (const auto& timestampQueryPool : m_TimestampQueryPools)
         {
-            vkDestroySemaphore(device, m_RenderFinishedSemaphore, nullptr);
-            m_RenderFinishedSemaphore = nullptr;
+            if (timestampQueryPool.queryPool != nullptr)
+            {
+                vkDestroyQueryPool(device, timestampQueryPool.queryPool, nullptr);
+            }
         }
-        if (m_RenderFinishedFence != nullptr)
+        m_TimestampQueryPools.clear();
+        m_TimestampPeriod = 0.0f;
+        for (const auto& renderFrame : m_RenderFrames)
         {
-            vkDestroyFence(device, m_RenderFinishedFence, nullptr);
-            m_RenderFinishedFence = nullptr;
+            if (renderFrame.renderFinishedSemaphore != nullptr)
+            {
+                vkDestroySemaphore(device, renderFrame.renderFinishedSemaphore, nullptr);
+            }
+            if (renderFrame.renderFinishedFence != nullptr)
+            {
+                vkDestroyFence(device, renderFrame.renderFinishedFence, nullptr);
+            }
         }
+        m_RenderFrames.clear();
     }
 
     void RenderPipeline_Vulkan::renderInternal()
@@ -84,8 +147,17 @@ namespace JumaRenderEngine
             return false;
         }
 
-        // Wait for prev render frame finished
-        waitForPreviousRenderFinish();
+        // Wait until GPU finished the frame which used the same resources
+        waitForRenderFrameFinish(getCurrentRenderFrame());
+        if (m_UniformRing->isResizeRequired())
+        {
+            waitForRenderFinished();
+        }
+        if (!m_UniformRing->startFrame(getFrameInFlightIndex()))
+        {
+            JUTILS_LOG(error, JSTR("Failed to start uniform ring frame"));
+            return false;
+        }
 
         // Acquire next swapchain images
         const WindowController* windowController = getRenderEngine()->getWindowController();
@@ -101,13 +173,18 @@ namespace JumaRenderEngine
                 return false;
             }
 
+            if (swapchain->isInvalid())
+            {
+                // Swapchain images could be used by other frames in flight
+                waitForRenderFinished();
+            }
             if (!swapchain->update())
             {
                 JUTILS_LOG(error, JSTR("Failed to update swapchain"));
                 return false;
             }
             bool availableForRender = false;
-            if (!swapchain->acquireNextImage(availableForRender) || !availableForRender)
+            if (!swapchain->acquireNextImage(getFrameInFlightIndex(), availableForRender) || !availableForRender)
             {
                 return false;
             }
@@ -125,18 +202,196 @@ namespace JumaRenderEngine
     }
     void RenderPipeline_Vulkan::waitForRenderFinished()
     {
-        waitForPreviousRenderFinish();
+        for (auto& renderFrame : m_RenderFrames)
+        {
+            waitForRenderFrameFinish(renderFrame);
+        }
+    }
+
+    void RenderPipeline_Vulkan::waitForRenderFrameFinish(RenderFrameData& renderFrame)
+    {
+        if (renderFrame.renderCommandBuffer != nullptr)
+        {
+            vkWaitForFences(getRenderEngine<RenderEngine_Vulkan>()->getDevice(), 1, &renderFrame.renderFinishedFence, VK_TRUE, UINT64_MAX);
+            renderFrame.renderCommandBuffer->returnToCommandPool();
+            renderFrame.renderCommandBuffer = nullptr;
+        }
+        for (const auto& commandBuffer : renderFrame.recordedCommandBuffers)
+        {
+            commandBuffer->returnToCommandPool();
+        }
+        renderFrame.recordedCommandBuffers.clear();
+    }
+    bool RenderPipeline_Vulkan::onStartRecordRenderTarget(RenderOptions* renderOptions, RenderOptions* recordRenderOptions, RenderTarget* renderTarget)
+    {
+        if (!Super::onStartRecordRenderTarget(renderOptions, recordRenderOptions, renderTarget))
+        {
+            return false;
+        }
+
+        // Materials could upload data, so prepare them before recording
+        const int32 stagesCount = renderTarget->getRenderStagesCount();
+        for (int32 index = 0; index < stagesCount; index++)
+        {
+            const RenderStage* renderStage = renderTarget->getRenderStage(index);
+            if (renderStage != nullptr)
+            {
+                for (const auto& renderPrimitive : renderStage->primitivesList)
+                {
+                    Material_Vulkan* material = dynamic_cast<Material_Vulkan*>(renderPrimitive.material);
+                    if (material != nullptr)
+                    {
+                        material->prepareForRender();
+                    }
+                }
+            }
+        }
+
+        reinterpret_cast<RenderOptions_Vulkan*>(recordRenderOptions)->commandBuffer = nullptr;
+        return true;
+    }
+    void RenderPipeline_Vulkan::recordRenderTarget(RenderOptions* recordRenderOptions, RenderTarget* renderTarget)
+    {
+        const int32 workerIndex = getRenderRecordWorkerIndex();
+        VulkanCommandPool* commandPool = m_RenderRecordCommandPools.isValidIndex(workerIndex) ? m_RenderRecordCommandPools[workerIndex] : nullptr;
+        if (commandPool == nullptr)
+        {
+            JUTILS_LOG(error, JSTR("Invalid render record worker"));
+            return;
+        }
+
+        const RenderTarget_Vulkan* renderTargetVulkan = dynamic_cast<const RenderTarget_Vulkan*>(renderTarget);
+        VkCommandBufferInheritanceInfo inheritanceInfo{};
+        if (!renderTargetVulkan->getRenderPassInheritanceInfo(inheritanceInfo))
+        {
+            return;
+        }
+
+        VulkanCommandBuffer* commandBuffer = commandPool->getCommandBuffer(false);
+        if (commandBuffer == nullptr)
+        {
+            JUTILS_LOG(error, JSTR("Failed to create secondary render command buffer"));
+            return;
+        }
+        VkCommandBufferBeginInfo beginInfo{};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+        VkResult result = vkBeginCommandBuffer(commandBuffer->get(), &beginInfo);
+        if (result != VK_SUCCESS)
+        {
+            JUTILS_ERROR_LOG(result, JSTR("Failed to start secondary render command buffer record"));
+            commandBuffer->returnToCommandPool();
+            return;
+        }
+        renderTargetVulkan->bindViewport(commandBuffer->get());
+
+        RenderOptions_Vulkan* renderOptionsVulkan = reinterpret_cast<RenderOptions_Vulkan*>(recordRenderOptions);
+        renderOptionsVulkan->renderPass = renderTargetVulkan->getRenderPass();
+        renderOptionsVulkan->commandBuffer = commandBuffer;
+        Super::recordRenderTarget(recordRenderOptions, renderTarget);
+
+        result = vkEndCommandBuffer(commandBuffer->get());
+        if (result != VK_SUCCESS)
+        {
+            JUTILS_ERROR_LOG(result, JSTR("Failed to finish secondary render command buffer record"));
+            commandBuffer->returnToCommandPool();
+            renderOptionsVulkan->commandBuffer = nullptr;
+        }
+    }
+    bool RenderPipeline_Vulkan::onFinishRecordRenderTarget(RenderOptions* renderOptions, RenderOptions* recordRenderOptions, RenderTarget* renderTarget)
+    {
+        VulkanCommandBuffer* recordedCommandBuffer = reinterpret_cast<RenderOptions_Vulkan*>(recordRenderOptions)->commandBuffer;
+        if (recordedCommandBuffer != nullptr)
+        {
+            getCurrentRenderFrame().recordedCommandBuffers.add(recordedCommandBuffer);
+        }
+
+        RenderOptions_Vulkan* renderOptionsVulkan = reinterpret_cast<RenderOptions_Vulkan*>(renderOptions);
+        renderOptionsVulkan->renderPassCommandBuffer = recordedCommandBuffer;
+        const bool success = Super::onFinishRecordRenderTarget(renderOptions, recordRenderOptions, renderTarget);
+        renderOptionsVulkan->renderPassCommandBuffer = nullptr;
+        return success;
+    }
+    void RenderPipeline_Vulkan::submitRecordedRenderTarget(RenderOptions* renderOptions, RenderOptions* recordRenderOptions, RenderTarget* renderTarget)
+    {
+        const RenderOptions_Vulkan* renderOptionsVulkan = reinterpret_cast<RenderOptions_Vulkan*>(renderOptions);
+        if (renderOptionsVulkan->renderPassCommandBuffer != nullptr)
+        {
+            VkCommandBuffer secondaryCommandBuffer = renderOptionsVulkan->renderPassCommandBuffer->get();
+            vkCmdExecuteCommands(renderOptionsVulkan->commandBuffer->get(), 1, &secondaryCommandBuffer);
+        }
     }
 
-    void RenderPipeline_Vulkan::waitForPreviousRenderFinish()
+    bool RenderPipeline_Vulkan::startGPUTimestamps(RenderOptions* renderOptions, const int32 slotIndex, const uint32 count)
     {
-        if (m_RenderCommandBuffer != nullptr)
+        if (!m_TimestampQueryPools.isValidIndex(slotIndex))
         {
-            vkWaitForFences(getRenderEngine<RenderEngine_Vulkan>()->getDevice(), 1, &m_RenderFinishedFence, VK_TRUE, UINT64_MAX);
-            m_RenderCommandBuffer->returnToCommandPool();
-            m_RenderCommandBuffer = nullptr;
+            m_TimestampQueryPools.resize(slotIndex + 1);
         }
+
+        // Frame which used this slot is already finished, so query pool could be recreated
+        TimestampQueryPool& timestampQueryPool = m_TimestampQueryPools[slotIndex];
+        if (timestampQueryPool.size < count)
+        {
+            VkDevice device = getRenderEngine<RenderEngine_Vulkan>()->getDevice();
+            if (timestampQueryPool.queryPool != nullptr)
+            {
+                vkDestroyQueryPool(device, timestampQueryPool.queryPool, nullptr);
+                timestampQueryPool.queryPool = nullptr;
+                timestampQueryPool.size = 0;
+            }
+
+            VkQueryPoolCreateInfo queryPoolInfo{};
+            queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            queryPoolInfo.queryCount = count;
+            const VkResult result = vkCreateQueryPool(device, &queryPoolInfo, nullptr, &timestampQueryPool.queryPool);
+            if (result != VK_SUCCESS)
+            {
+                JUTILS_ERROR_LOG(result, JSTR("Failed to create vulkan timestamp query pool"));
+                timestampQueryPool.queryPool = nullptr;
+                return false;
+            }
+            timestampQueryPool.size = count;
+        }
+
+        VkCommandBuffer commandBuffer = reinterpret_cast<RenderOptions_Vulkan*>(renderOptions)->commandBuffer->get();
+        vkCmdResetQueryPool(commandBuffer, timestampQueryPool.queryPool, 0, count);
+        return true;
     }
+    void RenderPipeline_Vulkan::writeGPUTimestamp(const RenderOptions* renderOptions, const int32 slotIndex, const uint32 timestampIndex) const
+    {
+        const VulkanCommandBuffer* commandBuffer = reinterpret_cast<const RenderOptions_Vulkan*>(renderOptions)->commandBuffer;
+        if (commandBuffer != nullptr)
+        {
+            // Even timestamps are the start ones
+            const VkPipelineStageFlagBits stage = (timestampIndex % 2) == 0 ? VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT : VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+            vkCmdWriteTimestamp(commandBuffer->get(), stage, m_TimestampQueryPools[slotIndex].queryPool, timestampIndex);
+        }
+    }
+    bool RenderPipeline_Vulkan::readGPUTimestamps(const int32 slotIndex, const uint32 count, jarray<uint64>& outTimestamps)
+    {
+        if (!m_TimestampQueryPools.isValidIndex(slotIndex) || (m_TimestampQueryPools[slotIndex].size < count))
+        {
+            return false;
+        }
+
+        outTimestamps.resize(static_cast<int32>(count));
+        const VkResult result = vkGetQueryPoolResults(getRenderEngine<RenderEngine_Vulkan>()->getDevice(), m_TimestampQueryPools[slotIndex].queryPool,
+            0, count, sizeof(uint64) * count, outTimestamps.getData(), sizeof(uint64), VK_QUERY_RESULT_64_BIT
+        );
+        if (result != VK_SUCCESS)
+        {
+            return false;
+        }
+        for (auto& timestamp : outTimestamps)
+        {
+            timestamp = static_cast<uint64>(static_cast<double>(timestamp) * m_TimestampPeriod);
+        }
+        return true;
+    }
+
     bool RenderPipeline_Vulkan::startRecordingRenderCommandBuffer(RenderOptions* renderOptions)
     {
         VulkanCommandBuffer* commandBuffer = getRenderEngine<RenderEngine_Vulkan>()->getCommandPool(VulkanQueueType::Graphics)->getCommandBuffer();
@@ -173,29 +428,32 @@ namespace JumaRenderEngine
         }
 
         RenderEngine_Vulkan* renderEngine = getRenderEngine<RenderEngine_Vulkan>();
-        vkResetFences(renderEngine->getDevice(), 1, &m_RenderFinishedFence);
+        RenderFrameData& renderFrame = getCurrentRenderFrame();
+        vkResetFences(renderEngine->getDevice(), 1, &renderFrame.renderFinishedFence);
 
-        const jarray<VkPipelineStageFlags> waitStages(m_SwapchainImageReadySemaphores.getSize(), VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
+        FrameArena& frameArena = renderEngine->getFrameArena();
+        const FrameArray<VkPipelineStageFlags> waitStages(frameArena, m_SwapchainImageReadySemaphores.getSize(), VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT);
         VkSubmitInfo submitInfo{};
         submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
         submitInfo.waitSemaphoreCount = m_SwapchainImageReadySemaphores.getSize();
         submitInfo.pWaitSemaphores = m_SwapchainImageReadySemaphores.getData();
         submitInfo.pWaitDstStageMask = waitStages.getData();
-        submitInfo.signalSemaphoreCount = 1;
-        submitInfo.pSignalSemaphores = &m_RenderFinishedSemaphore;
-        if (!commandBuffer->submit(submitInfo, m_RenderFinishedFence, false))
+        // Semaphore is waited only by present, so don't signal it if there is nothing to present
+        submitInfo.signalSemaphoreCount = !m_Swapchains.isEmpty() ? 1 : 0;
+        submitInfo.pSignalSemaphores = &renderFrame.renderFinishedSemaphore;
+        if (!commandBuffer->submit(submitInfo, renderFrame.renderFinishedFence, false))
         {
             JUTILS_LOG(error, JSTR("Failed to submit vulkan render command buffer"));
             commandBuffer->returnToCommandPool();
             return false;
         }
-        m_RenderCommandBuffer = commandBuffer;
+        renderFrame.renderCommandBuffer = commandBuffer;
 
         if (!m_Swapchains.isEmpty())
         {
-            jarray<uint32> swapchainIndicesForPresent(m_Swapchains.getSize());
-            jarray<VkSwapchainKHR> vulkanSwapchainsForPresent(m_Swapchains.getSize());
-            jarray<VkResult> swapchainPresentResults(m_Swapchains.getSize());
+            FrameArray<uint32> swapchainIndicesForPresent(frameArena, m_Swapchains.getSize(), 0);
+            FrameArray<VkSwapchainKHR> vulkanSwapchainsForPresent(frameArena, m_Swapchains.getSize(), nullptr);
+            FrameArray<VkResult> swapchainPresentResults(frameArena, m_Swapchains.getSize(), VK_SUCCESS);
             for (int32 index = 0; index < m_Swapchains.getSize(); index++)
             {
                 vulkanSwapchainsForPresent[index] = m_Swapchains[index]->get();
@@ -205,7 +463,7 @@ namespace JumaRenderEngine
             VkPresentInfoKHR presentInfo{};
             presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
             presentInfo.waitSemaphoreCount = 1;
-            presentInfo.pWaitSemaphores = &m_RenderFinishedSemaphore;
+            presentInfo.pWaitSemaphores = &renderFrame.renderFinishedSemaphore;
             presentInfo.swapchainCount = m_Swapchains.getSize();
             presentInfo.pSwapchains = vulkanSwapchainsForPresent.getData();
             presentInfo.pImageIndices = swapchainIndicesForPresent.getData();
@@ -12,6 +12,8 @@ namespace JumaRenderEngine
 {
     class VulkanSwapchain;
     class VulkanCommandBuffer;
+    class VulkanCommandPool;
+    class VulkanUniformRing;
 
     class RenderPipeline_Vulkan final : public RenderPipeline
     {
@@ -23,28 +25,63 @@ namespace JumaRenderEngine
 
         virtual void waitForRenderFinished() override;
 
+        VulkanUniformRing* getUniformRing() const { return m_UniformRing; }
+
     protected:
 
         virtual bool initInternal() override;
+        virtual bool isParallelRecordingSupported() const override { return true; }
+        virtual bool initRenderRecordWorker(int32 workerIndex) override;
+        virtual void clearRenderRecordWorker(int32 workerIndex) override;
+
+        virtual bool isGPUTimestampsSupported() const override { return m_TimestampPeriod > 0.0f; }
+        virtual bool startGPUTimestamps(RenderOptions* renderOptions, int32 slotIndex, uint32 count) override;
+        virtual void writeGPUTimestamp(const RenderOptions* renderOptions, int32 slotIndex, uint32 timestampIndex) const override;
+        virtual bool readGPUTimestamps(int32 slotIndex, uint32 count, jarray<uint64>& outTimestamps) override;
 
         virtual void renderInternal() override;
 
         virtual bool onStartRender(RenderOptions* renderOptions) override;
         virtual void onFinishRender(RenderOptions* renderOptions) override;
 
-    private:
+        virtual bool onStartRecordRenderTarget(RenderOptions* renderOptions, RenderOptions* recordRenderOptions, RenderTarget* renderTarget) override;
+        virtual void recordRenderTarget(RenderOptions* recordRenderOptions, RenderTarget* renderTarget) override;
+        virtual bool onFinishRecordRenderTarget(RenderOptions* renderOptions, RenderOptions* recordRenderOptions, RenderTarget* renderTarget) override;
+        virtual void submitRecordedRenderTarget(RenderOptions* renderOptions, RenderOptions* recordRenderOptions, RenderTarget* renderTarget) override;
 
-        VkFence m_RenderFinishedFence = nullptr;
-        VkSemaphore m_RenderFinishedSemaphore = nullptr;
+    private:
 
-        VulkanCommandBuffer* m_RenderCommandBuffer = nullptr;
+        struct RenderFrameData
+        {
+            VkFence renderFinishedFence = nullptr;
+            VkSemaphore renderFinishedSemaphore = nullptr;
+
+            VulkanCommandBuffer* renderCommandBuffer = nullptr;
+            jarray<VulkanCommandBuffer*> recordedCommandBuffers;
+        };
+        struct TimestampQueryPool
+        {
+            VkQueryPool queryPool = nullptr;
+            uint32 size = 0;
+        };
+
+        jarray<RenderFrameData> m_RenderFrames;
         jarray<VulkanSwapchain*> m_Swapchains;
         jarray<VkSemaphore> m_SwapchainImageReadySemaphores;
+
+        jarray<VulkanCommandPool*> m_RenderRecordCommandPools;
+
+        VulkanUniformRing* m_UniformRing = nullptr;
+
+        jarray<TimestampQueryPool> m_TimestampQueryPools;
+        // Nanoseconds per timestamp tick, 0 if timestamps are not supported
+        float m_TimestampPeriod = 0.0f;
         
 
         void clearVulkan();
 
-        void waitForPreviousRenderFinish();
+        RenderFrameData& getCurrentRenderFrame() { return m_RenderFrames[getFrameInFlightIndex()]; }
+        void waitForRenderFrameFinish(RenderFrameData& renderFrame);
         bool startRecordingRenderCommandBuffer(RenderOptions* renderOptions);
         bool finishRecordingRenderCommandBuffer(RenderOptions* renderOptions);
     };
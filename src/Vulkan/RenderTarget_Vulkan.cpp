@@ -7,11 +7,13 @@
 #include "RenderEngine_Vulkan.h"
 #include "RenderOptions_Vulkan.h"
 #include "TextureFormat_Vulkan.h"
+#include "vulkanObjects/VulkanBuffer.h"
 #include "vulkanObjects/VulkanCommandBuffer.h"
 #include "vulkanObjects/VulkanImage.h"
 #include "vulkanObjects/VulkanRenderPass.h"
 #include "vulkanObjects/VulkanSwapchain.h"
 #include "window/WindowController_Vulkan.h"
+#include "JumaRE/RenderPipeline.h"
 
 namespace JumaRenderEngine
 {
@@ -148,8 +150,21 @@ namespace JumaRenderEngine
             }
         }
 
+        clearReadbackBuffers();
         clearFramebuffers();
     }
+    void RenderTarget_Vulkan::clearReadbackBuffers()
+    {
+        RenderEngine_Vulkan* renderEngine = getRenderEngine<RenderEngine_Vulkan>();
+        for (const auto& readbackBuffer : m_ReadbackBuffers)
+        {
+            if (readbackBuffer.buffer != nullptr)
+            {
+                renderEngine->returnVulkanBuffer(readbackBuffer.buffer);
+            }
+        }
+        m_ReadbackBuffers.clear();
+    }
     void RenderTarget_Vulkan::clearFramebuffers()
     {
         if (!m_Framebuffers.isEmpty())
@@ -202,6 +217,8 @@ namespace JumaRenderEngine
     }
     bool RenderTarget_Vulkan::recreateRenderTarget()
     {
+        // Framebuffers could be used by any frame in flight
+        getRenderEngine()->getRenderPipeline()->waitForRenderFinished();
         clearFramebuffers();
         return isWindowRenderTarget() ? createWindowFramebuffers() : createFramebuffers();
     }
@@ -249,8 +266,35 @@ namespace JumaRenderEngine
         renderPassInfo.renderArea.extent = { size.x, size.y };
         renderPassInfo.clearValueCount = 2;
         renderPassInfo.pClearValues = clearValues;
-        vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+        if (renderOptionsVulkan->renderPassCommandBuffer != nullptr)
+        {
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+        }
+        else
+        {
+            vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+            bindViewport(commandBuffer);
+        }
+        return true;
+    }
+    bool RenderTarget_Vulkan::getRenderPassInheritanceInfo(VkCommandBufferInheritanceInfo& outInheritanceInfo) const
+    {
+        const int32 framebufferIndex = getRequiredFramebufferIndex();
+        if (!m_Framebuffers.isValidIndex(framebufferIndex))
+        {
+            JUTILS_LOG(error, JSTR("Failed to get vulkan framebuffer"));
+            return false;
+        }
 
+        outInheritanceInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO;
+        outInheritanceInfo.renderPass = m_RenderPass->get();
+        outInheritanceInfo.subpass = 0;
+        outInheritanceInfo.framebuffer = m_Framebuffers[framebufferIndex].framebuffer;
+        return true;
+    }
+    void RenderTarget_Vulkan::bindViewport(VkCommandBuffer commandBuffer) const
+    {
+        const math::uvector2 size = getSize();
         VkViewport viewport;
         viewport.x = 0.0f;
         viewport.y = 0.0f;
@@ -263,7 +307,6 @@ namespace JumaRenderEngine
         scissor.extent = { size.x, size.y };
         vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
         vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-        return true;
     }
     void RenderTarget_Vulkan::onFinishRender(RenderOptions* renderOptions)
     {
@@ -287,6 +330,66 @@ namespace JumaRenderEngine
 
         Super::onFinishRender(renderOptions);
     }
+
+    bool RenderTarget_Vulkan::copyToReadbackBuffer(RenderOptions* renderOptions, const int32 bufferIndex, const math::uvector2& offset, 
+        const math::uvector2& size)
+    {
+        if (m_Framebuffers.isEmpty() || (m_Framebuffers[0].resultImage == nullptr))
+        {
+            return false;
+        }
+        if (!m_ReadbackBuffers.isValidIndex(bufferIndex))
+        {
+            m_ReadbackBuffers.resize(bufferIndex + 1);
+        }
+
+        // Buffer is reused only after previous readback from it is finished
+        RenderEngine_Vulkan* renderEngine = getRenderEngine<RenderEngine_Vulkan>();
+        ReadbackBuffer& readbackBuffer = m_ReadbackBuffers[bufferIndex];
+        const uint32 dataSize = size.x * size.y * 4;
+        if ((readbackBuffer.buffer != nullptr) && (readbackBuffer.buffer->getSize() < dataSize))
+        {
+            renderEngine->returnVulkanBuffer(readbackBuffer.buffer);
+            readbackBuffer.buffer = nullptr;
+        }
+        if (readbackBuffer.buffer == nullptr)
+        {
+            VulkanBuffer* buffer = renderEngine->getVulkanBuffer();
+            if (!buffer->initReadback(dataSize))
+            {
+                JUTILS_LOG(error, JSTR("Failed to create vulkan readback buffer"));
+                renderEngine->returnVulkanBuffer(buffer);
+                return false;
+            }
+            readbackBuffer.buffer = buffer;
+        }
+        readbackBuffer.dataSize = size;
+
+        VulkanCommandBuffer* commandBuffer = reinterpret_cast<RenderOptions_Vulkan*>(renderOptions)->commandBuffer;
+        VulkanImage* resultImage = m_Framebuffers[0].resultImage;
+        commandBuffer->changeImageLayout(resultImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+        commandBuffer->applyBarriers();
+        commandBuffer->copyImageToBuffer(resultImage, readbackBuffer.buffer, offset, size);
+        commandBuffer->changeImageLayout(resultImage, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+        commandBuffer->applyBarriers();
+        return true;
+    }
+    bool RenderTarget_Vulkan::mapReadbackBuffer(const int32 bufferIndex, const uint8*& outData, int32& outRowPitch)
+    {
+        // Frame of the copy is already finished at this point
+        ReadbackBuffer& readbackBuffer = m_ReadbackBuffers[bufferIndex];
+        outData = static_cast<const uint8*>(readbackBuffer.buffer->mapReadbackData());
+        outRowPitch = static_cast<int32>(readbackBuffer.dataSize.x * 4);
+        if (outData == nullptr)
+        {
+            JUTILS_LOG(error, JSTR("Failed to map vulkan readback buffer"));
+        }
+        return true;
+    }
+    void RenderTarget_Vulkan::unmapReadbackBuffer(const int32 bufferIndex)
+    {
+        m_ReadbackBuffers[bufferIndex].buffer->unmapReadbackData();
+    }
 }
 
 #endif
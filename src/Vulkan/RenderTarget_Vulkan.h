@@ -12,6 +12,7 @@
 
 namespace JumaRenderEngine
 {
+    class VulkanBuffer;
     class VulkanSwapchain;
     class VulkanRenderPass;
     class VulkanImage;
@@ -25,6 +26,9 @@ namespace JumaRenderEngine
         virtual ~RenderTarget_Vulkan() override;
 
         VulkanImage* getResultImage() const;
+        const VulkanRenderPass* getRenderPass() const { return m_RenderPass; }
+        bool getRenderPassInheritanceInfo(VkCommandBufferInheritanceInfo& outInheritanceInfo) const;
+        void bindViewport(VkCommandBuffer commandBuffer) const;
 
         virtual bool onStartRender(RenderOptions* renderOptions) override;
         virtual void onFinishRender(RenderOptions* renderOptions) override;
@@ -36,12 +40,25 @@ namespace JumaRenderEngine
 
         virtual bool recreateRenderTarget() override;
 
+        virtual bool isReadbackSupported() const override { return true; }
+        virtual bool copyToReadbackBuffer(RenderOptions* renderOptions, int32 bufferIndex, const math::uvector2& offset, const math::uvector2& size) override;
+        virtual bool mapReadbackBuffer(int32 bufferIndex, const uint8*& outData, int32& outRowPitch) override;
+        virtual void unmapReadbackBuffer(int32 bufferIndex) override;
+
     private:
 
+        struct ReadbackBuffer
+        {
+            VulkanBuffer* buffer = nullptr;
+            math::uvector2 dataSize = { 0, 0 };
+        };
+
         VulkanRenderPass* m_RenderPass = nullptr;
         jarray<VulkanFramebufferData> m_Framebuffers;
         bool m_FramebuffersValidForRender = false;
 
+        jarray<ReadbackBuffer> m_ReadbackBuffers;
+
 
         bool initRenderTarget() { return createFramebuffers(); }
         bool initWindowRenderTarget();
@@ -50,6 +67,7 @@ namespace JumaRenderEngine
 
         void clearVulkan();
         void clearFramebuffers();
+        void clearReadbackBuffers();
 
         int32 getRequiredFramebufferIndex() const;
 
@@ -8,6 +8,8 @@
 
 #include "RenderEngine_Vulkan.h"
 #include "JumaRE/material/ShaderUniformInfo.h"
+#include "vulkanObjects/VulkanBindlessTextureTable.h"
+#include "vulkanObjects/VulkanDescriptorAllocator.h"
 
 namespace JumaRenderEngine
 {
@@ -163,7 +165,8 @@ namespace JumaRenderEngine
             {
                 layoutBinding.stageFlags |= VK_SHADER_STAGE_FRAGMENT_BIT;
             }
-            layoutBinding.descriptorType = IsShaderUniformScalar(uniform.type) ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+            // Uniform buffers are placed in uniform ring, so offsets are set on bind
+            layoutBinding.descriptorType = IsShaderUniformScalar(uniform.type) ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
             layoutBinding.descriptorCount = 1;
         }
 
@@ -181,19 +184,36 @@ namespace JumaRenderEngine
     }
     bool Shader_Vulkan::createPipelineLayout(VkDevice device)
     {
+        // Bindless textures are placed in uniform buffer, so material set is always present and texture table uses set 1
+        const VulkanBindlessTextureTable* textureTable = getRenderEngine<RenderEngine_Vulkan>()->getBindlessTextureTable();
+        const VkDescriptorSetLayout descriptorSetLayouts[2] = {
+            m_DescriptorSetLayout, textureTable != nullptr ? textureTable->getDescriptorSetLayout() : nullptr
+        };
         VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
         pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
         if (m_DescriptorSetLayout != nullptr)
         {
-            pipelineLayoutInfo.setLayoutCount = 1;
-            pipelineLayoutInfo.pSetLayouts = &m_DescriptorSetLayout;
+            pipelineLayoutInfo.setLayoutCount = hasBindlessTextures() ? 2 : 1;
+            pipelineLayoutInfo.pSetLayouts = descriptorSetLayouts;
         }
         else
         {
             pipelineLayoutInfo.setLayoutCount = 0;
             pipelineLayoutInfo.pSetLayouts = nullptr;
         }
-        pipelineLayoutInfo.pushConstantRangeCount = 0;
+        VkPushConstantRange pushConstantRange{};
+        if (hasPrimitiveConstants())
+        {
+            pushConstantRange.stageFlags = getPrimitiveConstantsStages();
+            pushConstantRange.offset = 0;
+            pushConstantRange.size = getPrimitiveConstants().size;
+            pipelineLayoutInfo.pushConstantRangeCount = 1;
+            pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+        }
+        else
+        {
+            pipelineLayoutInfo.pushConstantRangeCount = 0;
+        }
         const VkResult result = vkCreatePipelineLayout(device, &pipelineLayoutInfo, nullptr, &m_PipelineLayout);
         if (result != VK_SUCCESS)
         {
@@ -203,6 +223,28 @@ namespace JumaRenderEngine
         return true;
     }
 
+    VkShaderStageFlags Shader_Vulkan::getPrimitiveConstantsStages() const
+    {
+        const uint8 shaderStages = getPrimitiveConstants().shaderStages;
+        VkShaderStageFlags stageFlags = 0;
+        if (shaderStages & SHADER_STAGE_VERTEX)
+        {
+            stageFlags |= VK_SHADER_STAGE_VERTEX_BIT;
+        }
+        if (shaderStages & SHADER_STAGE_FRAGMENT)
+        {
+            stageFlags |= VK_SHADER_STAGE_FRAGMENT_BIT;
+        }
+        return stageFlags;
+    }
+    void Shader_Vulkan::pushPrimitiveConstants(VkCommandBuffer commandBuffer, const void* data) const
+    {
+        if (hasPrimitiveConstants())
+        {
+            vkCmdPushConstants(commandBuffer, m_PipelineLayout, getPrimitiveConstantsStages(), 0, getPrimitiveConstants().size, data);
+        }
+    }
+
     void Shader_Vulkan::onClearAsset()
     {
         clearVulkan();
@@ -210,7 +252,8 @@ namespace JumaRenderEngine
     }
     void Shader_Vulkan::clearVulkan()
     {
-        VkDevice device = getRenderEngine<RenderEngine_Vulkan>()->getDevice();
+        RenderEngine_Vulkan* renderEngine = getRenderEngine<RenderEngine_Vulkan>();
+        VkDevice device = renderEngine->getDevice();
 
         m_CachedPipelineStageInfos.clear();
 
@@ -226,6 +269,11 @@ namespace JumaRenderEngine
         }
         if (m_DescriptorSetLayout != nullptr)
         {
+            VulkanDescriptorAllocator* descriptorAllocator = renderEngine->getDescriptorAllocator();
+            if (descriptorAllocator != nullptr)
+            {
+                descriptorAllocator->onDescriptorSetLayoutDestroying(m_DescriptorSetLayout);
+            }
             vkDestroyDescriptorSetLayout(device, m_DescriptorSetLayout, nullptr);
             m_DescriptorSetLayout = nullptr;
         }
@@ -239,19 +287,20 @@ namespace JumaRenderEngine
         m_ShaderModules.clear();
     }
 
-    bool Shader_Vulkan::bindRenderPipeline(VkCommandBuffer commandBuffer, const vertex_id vertexID, const VulkanRenderPass* renderPass, 
-        const MaterialProperties& pipelineProperties)
+    bool Shader_Vulkan::bindRenderPipeline(VkCommandBuffer commandBuffer, const vertex_id vertexID, const vertex_id instanceVertexID, 
+        const VulkanRenderPass* renderPass, const MaterialProperties& pipelineProperties)
     {
-        VkPipeline renderPipeline = getRenderPipeline(vertexID, renderPass, pipelineProperties);
+        VkPipeline renderPipeline = getRenderPipeline(vertexID, instanceVertexID, renderPass, pipelineProperties);
         if (renderPipeline == nullptr)
         {
             return false;
         }
         vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, renderPipeline);
+        getRenderEngine()->addFrameCounter(RenderFrameCounter::StateChanges);
         return true;
     }
-    VkPipeline Shader_Vulkan::getRenderPipeline(const vertex_id vertexID, const VulkanRenderPass* renderPass, 
-        const MaterialProperties& pipelineProperties)
+    VkPipeline Shader_Vulkan::getRenderPipeline(const vertex_id vertexID, const vertex_id instanceVertexID, 
+        const VulkanRenderPass* renderPass, const MaterialProperties& pipelineProperties)
     {
         if ((vertexID == vertex_id_NONE) || (renderPass == nullptr))
         {
@@ -260,7 +309,8 @@ namespace JumaRenderEngine
         }
 
         const render_pass_type_id renderPassID = renderPass->getTypeID();
-        const RenderPipelineID pipelineID = { vertexID, renderPassID, pipelineProperties };
+        const RenderPipelineID pipelineID = { vertexID, instanceVertexID, renderPassID, pipelineProperties };
+        std::lock_guard lock(m_RenderPipelinesMutex);
         VkPipeline* existingPipeline = m_RenderPipelines.find(pipelineID);
         if (existingPipeline != nullptr)
         {
@@ -281,13 +331,30 @@ namespace JumaRenderEngine
             return nullptr;
         }
 
+        jarray<VkVertexInputBindingDescription> vertexBindings = { vertexDescription->binding };
+        jarray<VkVertexInputAttributeDescription> vertexAttributes = vertexDescription->attributes;
+        if (instanceVertexID != vertex_id_NONE)
+        {
+            const VertexDescription_Vulkan* instanceDescription = renderEngine->findVertexType_Vulkan(instanceVertexID);
+            if (instanceDescription == nullptr)
+            {
+                JUTILS_LOG(warning, JSTR("Invalid instance vertex type"));
+                return nullptr;
+            }
+            vertexBindings.add(instanceDescription->binding);
+            for (const auto& attribute : instanceDescription->attributes)
+            {
+                vertexAttributes.add(attribute);
+            }
+        }
+
         // Vertex input data
         VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
         vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
-        vertexInputInfo.vertexBindingDescriptionCount = 1;
-        vertexInputInfo.pVertexBindingDescriptions = &vertexDescription->binding;
-        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32>(vertexDescription->attributes.getSize());
-        vertexInputInfo.pVertexAttributeDescriptions = vertexDescription->attributes.getData();
+        vertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32>(vertexBindings.getSize());
+        vertexInputInfo.pVertexBindingDescriptions = vertexBindings.getData();
+        vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32>(vertexAttributes.getSize());
+        vertexInputInfo.pVertexAttributeDescriptions = vertexAttributes.getData();
 
         // Geometry type
         VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
@@ -390,6 +457,7 @@ namespace JumaRenderEngine
             JUTILS_ERROR_LOG(result, JSTR("Failed to create vulkan render pipeline"));
             return nullptr;
         }
+        renderEngine->addFrameCounter(RenderFrameCounter::PipelineCreations);
 
         return m_RenderPipelines[pipelineID] = renderPipeline;
     }
@@ -10,6 +10,8 @@
 #include "JumaRE/material/MaterialProperties.h"
 #include "JumaRE/vertex/VertexDescription.h"
 
+#include <mutex>
+
 namespace JumaRenderEngine
 {
     class VulkanRenderPass;
@@ -25,8 +27,9 @@ namespace JumaRenderEngine
         VkDescriptorSetLayout getDescriptorSetLayout() const { return m_DescriptorSetLayout; }
         VkPipelineLayout getPipelineLayout() const { return m_PipelineLayout; }
 
-        bool bindRenderPipeline(VkCommandBuffer commandBuffer, vertex_id vertexID, const VulkanRenderPass* renderPass, 
-            const MaterialProperties& pipelineProperties);
+        bool bindRenderPipeline(VkCommandBuffer commandBuffer, vertex_id vertexID, vertex_id instanceVertexID, 
+            const VulkanRenderPass* renderPass, const MaterialProperties& pipelineProperties);
+        void pushPrimitiveConstants(VkCommandBuffer commandBuffer, const void* data) const;
 
     protected:
 
@@ -38,6 +41,7 @@ namespace JumaRenderEngine
         struct RenderPipelineID
         {
             vertex_id vertexID = vertex_id_NONE;
+            vertex_id instanceVertexID = vertex_id_NONE;
             render_pass_type_id renderPassID = render_pass_type_id_INVALID;
             MaterialProperties properties;
 
@@ -50,15 +54,18 @@ namespace JumaRenderEngine
 
         jarray<VkPipelineShaderStageCreateInfo> m_CachedPipelineStageInfos;
         jmap<RenderPipelineID, VkPipeline> m_RenderPipelines;
+        std::mutex m_RenderPipelinesMutex;
 
 
         bool createShaderModules(VkDevice device, const jmap<ShaderStageFlags, jstring>& fileNames);
         bool createDescriptorSetLayout(VkDevice device);
         bool createPipelineLayout(VkDevice device);
+        VkShaderStageFlags getPrimitiveConstantsStages() const;
 
         void clearVulkan();
         
-        VkPipeline getRenderPipeline(vertex_id vertexID, const VulkanRenderPass* renderPass, const MaterialProperties& pipelineProperties);
+        VkPipeline getRenderPipeline(vertex_id vertexID, vertex_id instanceVertexID, const VulkanRenderPass* renderPass, 
+            const MaterialProperties& pipelineProperties);
     };
 
     inline bool Shader_Vulkan::RenderPipelineID::operator<(const RenderPipelineID& otherID) const
@@ -67,6 +74,10 @@ namespace JumaRenderEngine
         {
             return vertexID < otherID.vertexID;
         }
+        if (instanceVertexID != otherID.instanceVertexID)
+        {
+            return instanceVertexID < otherID.instanceVertexID;
+        }
         if (renderPassID != otherID.renderPassID)
         {
             return renderPassID < otherID.renderPassID;
@@ -7,8 +7,10 @@
 #include "Material_Vulkan.h"
 #include "RenderEngine_Vulkan.h"
 #include "RenderOptions_Vulkan.h"
+#include "Shader_Vulkan.h"
 #include "vulkanObjects/VulkanBuffer.h"
 #include "vulkanObjects/VulkanCommandBuffer.h"
+#include "JumaRE/RenderPrimitivesList.h"
 #include "JumaRE/vertex/VertexBufferData.h"
 
 namespace JumaRenderEngine
@@ -86,31 +88,35 @@ namespace JumaRenderEngine
         }
     }
 
-    void VertexBuffer_Vulkan::render(const RenderOptions* renderOptions, Material* material)
+    void VertexBuffer_Vulkan::render(const RenderOptions* renderOptions, const RenderPrimitive& primitive)
     {
-        Material_Vulkan* materialVulan = dynamic_cast<Material_Vulkan*>(material);
-        if ((materialVulan == nullptr) || !materialVulan->bindMaterial(renderOptions, this))
+        const VertexBuffer_Vulkan* instanceBuffer = dynamic_cast<const VertexBuffer_Vulkan*>(primitive.instanceBuffer);
+        const vertex_id instanceVertexID = instanceBuffer != nullptr ? instanceBuffer->getVertexID() : vertex_id_NONE;
+        Material_Vulkan* materialVulan = dynamic_cast<Material_Vulkan*>(primitive.material);
+        if ((materialVulan == nullptr) || !materialVulan->bindMaterial(renderOptions, this, instanceVertexID))
         {
             return;
         }
 
         const RenderOptions_Vulkan* optionsVulkan = reinterpret_cast<const RenderOptions_Vulkan*>(renderOptions);
         VkCommandBuffer commandBuffer = optionsVulkan->commandBuffer->get();
+        dynamic_cast<const Shader_Vulkan*>(materialVulan->getShader())->pushPrimitiveConstants(commandBuffer, GetRenderPrimitiveConstants(primitive));
 
-        VkBuffer vertexBuffer = m_VertexBuffer->get();
-        constexpr VkDeviceSize offset = 0;
-        vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+        const VkBuffer vertexBuffers[2] = { m_VertexBuffer->get(), instanceBuffer != nullptr ? instanceBuffer->getVulkanVertexBuffer()->get() : nullptr };
+        constexpr VkDeviceSize offsets[2] = { 0, 0 };
+        vkCmdBindVertexBuffers(commandBuffer, 0, instanceBuffer != nullptr ? 2 : 1, vertexBuffers, offsets);
         if (m_IndexBuffer == nullptr)
         {
-            vkCmdDraw(commandBuffer, m_RenderElementsCount, 1, 0, 0);
+            vkCmdDraw(commandBuffer, m_RenderElementsCount, primitive.instanceCount, 0, 0);
         }
         else
         {
             vkCmdBindIndexBuffer(commandBuffer, m_IndexBuffer->get(), 0, VK_INDEX_TYPE_UINT32);
-            vkCmdDrawIndexed(commandBuffer, m_RenderElementsCount, 1, 0, 0, 0);
+            vkCmdDrawIndexed(commandBuffer, m_RenderElementsCount, primitive.instanceCount, 0, 0, 0);
         }
 
         materialVulan->unbindMaterial(renderOptions, this);
+        getRenderEngine()->addFrameCounter(RenderFrameCounter::DrawCalls);
     }
 }
 
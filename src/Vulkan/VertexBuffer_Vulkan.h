@@ -18,7 +18,9 @@ namespace JumaRenderEngine
         VertexBuffer_Vulkan() = default;
         virtual ~VertexBuffer_Vulkan() override;
 
-        virtual void render(const RenderOptions* renderOptions, Material* material) override;
+        VulkanBuffer* getVulkanVertexBuffer() const { return m_VertexBuffer; }
+
+        virtual void render(const RenderOptions* renderOptions, const RenderPrimitive& primitive) override;
 
     protected:
 
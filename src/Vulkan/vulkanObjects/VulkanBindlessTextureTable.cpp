@@ -0,0 +1,201 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#if defined(JUMARE_ENABLE_VULKAN)
+
+#include "VulkanBindlessTextureTable.h"
+
+#include "../RenderEngine_Vulkan.h"
+
+namespace JumaRenderEngine
+{
+    VulkanBindlessTextureTable::~VulkanBindlessTextureTable()
+    {
+        clearVulkan();
+    }
+
+    bool VulkanBindlessTextureTable::init(const uint32 maxTexturesCount)
+    {
+        if (isValid())
+        {
+            JUTILS_LOG(error, JSTR("Vulkan bindless texture table already initialized"));
+            return false;
+        }
+        if (maxTexturesCount == 0)
+        {
+            return false;
+        }
+
+        VkDevice device = getRenderEngine<RenderEngine_Vulkan>()->getDevice();
+
+        // Not written descriptors are never accessed, new ones are written while command buffers are pending
+        const VkDescriptorBindingFlags bindingFlags = VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT
+            | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT;
+        VkDescriptorSetLayoutBindingFlagsCreateInfo bindingFlagsInfo{};
+        bindingFlagsInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO;
+        bindingFlagsInfo.bindingCount = 1;
+        bindingFlagsInfo.pBindingFlags = &bindingFlags;
+        VkDescriptorSetLayoutBinding binding{};
+        binding.binding = 0;
+        binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        binding.descriptorCount = maxTexturesCount;
+        binding.stageFlags = VK_SHADER_STAGE_ALL_GRAPHICS;
+        binding.pImmutableSamplers = nullptr;
+        VkDescriptorSetLayoutCreateInfo layoutInfo{};
+        layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+        layoutInfo.pNext = &bindingFlagsInfo;
+        layoutInfo.flags = VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT;
+        layoutInfo.bindingCount = 1;
+        layoutInfo.pBindings = &binding;
+        VkResult result = vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &m_DescriptorSetLayout);
+        if (result != VK_SUCCESS)
+        {
+            JUTILS_ERROR_LOG(result, JSTR("Failed to create bindless textures descriptor set layout"));
+            clearVulkan();
+            return false;
+        }
+
+        VkDescriptorPoolSize poolSize;
+        poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSize.descriptorCount = maxTexturesCount;
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT;
+        poolInfo.poolSizeCount = 1;
+        poolInfo.pPoolSizes = &poolSize;
+        poolInfo.maxSets = 1;
+        result = vkCreateDescriptorPool(device, &poolInfo, nullptr, &m_DescriptorPool);
+        if (result != VK_SUCCESS)
+        {
+            JUTILS_ERROR_LOG(result, JSTR("Failed to create bindless textures descriptor pool"));
+            clearVulkan();
+            return false;
+        }
+
+        VkDescriptorSetAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.descriptorPool = m_DescriptorPool;
+        allocateInfo.descriptorSetCount = 1;
+        allocateInfo.pSetLayouts = &m_DescriptorSetLayout;
+        result = vkAllocateDescriptorSets(device, &allocateInfo, &m_DescriptorSet);
+        if (result != VK_SUCCESS)
+        {
+            JUTILS_ERROR_LOG(result, JSTR("Failed to allocate bindless textures descriptor set"));
+            clearVulkan();
+            return false;
+        }
+
+        m_MaxTexturesCount = maxTexturesCount;
+        m_NextIndex = DefaultTextureIndex + 1;
+        markAsInitialized();
+        return true;
+    }
+
+    void VulkanBindlessTextureTable::clearVulkan()
+    {
+        VkDevice device = getRenderEngine<RenderEngine_Vulkan>()->getDevice();
+
+        std::lock_guard lock(m_Mutex);
+        m_DescriptorSet = nullptr;
+        if (m_DescriptorPool != nullptr)
+        {
+            vkDestroyDescriptorPool(device, m_DescriptorPool, nullptr);
+            m_DescriptorPool = nullptr;
+        }
+        if (m_DescriptorSetLayout != nullptr)
+        {
+            vkDestroyDescriptorSetLayout(device, m_DescriptorSetLayout, nullptr);
+            m_DescriptorSetLayout = nullptr;
+        }
+        m_TextureIndices.clear();
+        m_FreeIndices.clear();
+        m_NextIndex = 0;
+        m_MaxTexturesCount = 0;
+        m_DefaultTextureSet = false;
+    }
+
+    int32 VulkanBindlessTextureTable::getTextureIndex(VkImageView imageView, const TextureSamplerType sampler)
+    {
+        if (!isValid() || (imageView == nullptr))
+        {
+            return -1;
+        }
+
+        std::lock_guard lock(m_Mutex);
+        jmap<TextureSamplerType, uint32>& imageViewIndices = m_TextureIndices[imageView];
+        const uint32* indexPtr = imageViewIndices.find(sampler);
+        if (indexPtr != nullptr)
+        {
+            return static_cast<int32>(*indexPtr);
+        }
+
+        uint32 index;
+        if (!m_FreeIndices.isEmpty())
+        {
+            index = m_FreeIndices.getLast();
+            m_FreeIndices.removeLast();
+        }
+        else if (m_NextIndex < m_MaxTexturesCount)
+        {
+            index = m_NextIndex++;
+        }
+        else
+        {
+            JUTILS_LOG(error, JSTR("Bindless texture table is full ({} textures)"), m_MaxTexturesCount);
+            return -1;
+        }
+
+        writeDescriptor(index, imageView, sampler);
+        imageViewIndices.add(sampler, index);
+        return static_cast<int32>(index);
+    }
+    void VulkanBindlessTextureTable::setDefaultTexture(VkImageView imageView, const TextureSamplerType sampler)
+    {
+        if (!isValid() || (imageView == nullptr))
+        {
+            return;
+        }
+
+        std::lock_guard lock(m_Mutex);
+        writeDescriptor(DefaultTextureIndex, imageView, sampler);
+        m_DefaultTextureSet = true;
+    }
+    void VulkanBindlessTextureTable::writeDescriptor(const uint32 index, VkImageView imageView, const TextureSamplerType sampler)
+    {
+        RenderEngine_Vulkan* renderEngine = getRenderEngine<RenderEngine_Vulkan>();
+        VkDescriptorImageInfo imageInfo;
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfo.imageView = imageView;
+        imageInfo.sampler = renderEngine->getTextureSampler(sampler);
+        VkWriteDescriptorSet descriptorWrite{};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = m_DescriptorSet;
+        descriptorWrite.dstBinding = 0;
+        descriptorWrite.dstArrayElement = index;
+        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.pImageInfo = &imageInfo;
+        vkUpdateDescriptorSets(renderEngine->getDevice(), 1, &descriptorWrite, 0, nullptr);
+        renderEngine->addFrameCounter(RenderFrameCounter::DescriptorUpdates);
+    }
+    void VulkanBindlessTextureTable::releaseTextureIndices(VkImageView imageView)
+    {
+        if (!isValid())
+        {
+            return;
+        }
+
+        std::lock_guard lock(m_Mutex);
+        const jmap<TextureSamplerType, uint32>* imageViewIndices = m_TextureIndices.find(imageView);
+        if (imageViewIndices == nullptr)
+        {
+            return;
+        }
+        for (const auto& index : imageViewIndices->values())
+        {
+            m_FreeIndices.add(index);
+        }
+        m_TextureIndices.remove(imageView);
+    }
+}
+
+#endif
@@ -0,0 +1,64 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_VULKAN)
+
+#include "JumaRE/RenderEngineContextObject.h"
+
+#include <jutils/jarray.h>
+#include <jutils/jmap.h>
+#include <mutex>
+#include <vulkan/vulkan_core.h>
+
+#include "JumaRE/texture/TextureSamplerType.h"
+
+namespace JumaRenderEngine
+{
+    // Global array of combined image samplers indexed from shaders, bound as a separate descriptor set.
+    // Descriptors are written once, when texture is requested for the first time
+    class VulkanBindlessTextureTable final : public RenderEngineContextObject
+    {
+    public:
+        // Reserved for default texture, used when texture couldn't be added to the table
+        static constexpr uint32 DefaultTextureIndex = 0;
+
+        VulkanBindlessTextureTable() = default;
+        virtual ~VulkanBindlessTextureTable() override;
+
+        bool init(uint32 maxTexturesCount);
+
+        VkDescriptorSetLayout getDescriptorSetLayout() const { return m_DescriptorSetLayout; }
+        VkDescriptorSet getDescriptorSet() const { return m_DescriptorSet; }
+
+        // Returns -1 if table is full. Should be called from main thread
+        int32 getTextureIndex(VkImageView imageView, TextureSamplerType sampler);
+        bool isDefaultTextureSet() const { return m_DefaultTextureSet; }
+        void setDefaultTexture(VkImageView imageView, TextureSamplerType sampler);
+        // Could be called from any thread, image view should not be used by GPU anymore
+        void releaseTextureIndices(VkImageView imageView);
+
+    protected:
+
+        virtual void clearInternal() override { clearVulkan(); }
+
+    private:
+
+        VkDescriptorSetLayout m_DescriptorSetLayout = nullptr;
+        VkDescriptorPool m_DescriptorPool = nullptr;
+        VkDescriptorSet m_DescriptorSet = nullptr;
+
+        std::mutex m_Mutex;
+        jmap<VkImageView, jmap<TextureSamplerType, uint32>> m_TextureIndices;
+        jarray<uint32> m_FreeIndices;
+        uint32 m_NextIndex = 0;
+        uint32 m_MaxTexturesCount = 0;
+        bool m_DefaultTextureSet = false;
+
+
+        void clearVulkan();
+        void writeDescriptor(uint32 index, VkImageView imageView, TextureSamplerType sampler);
+    };
+}
+
+#endif
@@ -178,11 +178,85 @@ namespace JumaRenderEngine
         return true;
     }
 
+    bool VulkanBuffer::initReadback(const uint32 size)
+    {
+        if (isValid())
+        {
+            return false;
+        }
+        if (size == 0)
+        {
+            return false;
+        }
+
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        bufferInfo.queueFamilyIndexCount = 0;
+        bufferInfo.pQueueFamilyIndices = nullptr;
+        VmaAllocationCreateInfo allocationInfo{};
+        allocationInfo.usage = VMA_MEMORY_USAGE_AUTO;
+        allocationInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT;
+        const VkResult result = vmaCreateBuffer(getRenderEngine<RenderEngine_Vulkan>()->getAllocator(), &bufferInfo, &allocationInfo, &m_Buffer, &m_Allocation, nullptr);
+        if (result != VK_SUCCESS)
+        {
+            return false;
+        }
+
+        m_BufferSize = size;
+        m_Mapable = true;
+        markAsInitialized();
+        return true;
+    }
+
+    bool VulkanBuffer::initPersistentMapped(const VkBufferUsageFlags usage, const uint32 size)
+    {
+        if (isValid())
+        {
+            return false;
+        }
+        if (size == 0)
+        {
+            return false;
+        }
+
+        VkBufferCreateInfo bufferInfo{};
+        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+        bufferInfo.size = size;
+        bufferInfo.usage = usage;
+        bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        bufferInfo.queueFamilyIndexCount = 0;
+        bufferInfo.pQueueFamilyIndices = nullptr;
+        VmaAllocationCreateInfo allocationInfo{};
+        allocationInfo.usage = VMA_MEMORY_USAGE_AUTO;
+        allocationInfo.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT;
+        allocationInfo.requiredFlags = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+        VmaAllocationInfo allocationResultInfo{};
+        const VkResult result = vmaCreateBuffer(getRenderEngine<RenderEngine_Vulkan>()->getAllocator(), &bufferInfo, &allocationInfo, &m_Buffer, &m_Allocation, &allocationResultInfo);
+        if (result != VK_SUCCESS)
+        {
+            return false;
+        }
+        if (allocationResultInfo.pMappedData == nullptr)
+        {
+            clearVulkan();
+            return false;
+        }
+
+        m_BufferSize = size;
+        m_PersistentMappedData = static_cast<uint8*>(allocationResultInfo.pMappedData);
+        markAsInitialized();
+        return true;
+    }
+
     void VulkanBuffer::clearVulkan()
     {
         RenderEngine_Vulkan* renderEngine = getRenderEngine<RenderEngine_Vulkan>();
 
         m_MappedData = nullptr;
+        m_PersistentMappedData = nullptr;
         m_Mapable = false;
         if (m_StagingBuffer != nullptr)
         {
@@ -277,6 +351,25 @@ namespace JumaRenderEngine
         return true;
     }
 
+    const void* VulkanBuffer::mapReadbackData()
+    {
+        if (!initMappedData())
+        {
+            return nullptr;
+        }
+        // Memory could be not host coherent
+        vmaInvalidateAllocation(getRenderEngine<RenderEngine_Vulkan>()->getAllocator(), m_Allocation, 0, VK_WHOLE_SIZE);
+        return m_MappedData;
+    }
+    void VulkanBuffer::unmapReadbackData()
+    {
+        if (m_MappedData != nullptr)
+        {
+            vmaUnmapMemory(getRenderEngine<RenderEngine_Vulkan>()->getAllocator(), m_Allocation);
+            m_MappedData = nullptr;
+        }
+    }
+
     bool VulkanBuffer::setData(const void* data, const uint32 size, const uint32 offset, const bool waitForFinish)
     {
         if (!isValid())
@@ -24,8 +24,13 @@ namespace JumaRenderEngine
         bool initGPU(VkBufferUsageFlags usage, std::initializer_list<VulkanQueueType> accessedQueues, uint32 size, const void* data);
         // GPU buffer, frequently writing from CPU directly. If not possible - it will be GPU with staging buffer
         bool initAccessedGPU(VkBufferUsageFlags usage, std::initializer_list<VulkanQueueType> accessedQueues, uint32 size);
+        // Temp buffer for reading data from GPU
+        bool initReadback(uint32 size);
+        // Host visible buffer, mapped while it's alive
+        bool initPersistentMapped(VkBufferUsageFlags usage, uint32 size);
 
         VkBuffer get() const { return m_Buffer; }
+        uint32 getSize() const { return m_BufferSize; }
 
         bool initMappedData();
         bool setMappedData(const void* data, uint32 size, uint32 offset = 0);
@@ -33,6 +38,11 @@ namespace JumaRenderEngine
         
         bool setData(const void* data, uint32 size, uint32 offset, bool waitForFinish);
 
+        const void* mapReadbackData();
+        void unmapReadbackData();
+
+        uint8* getPersistentMappedData() const { return m_PersistentMappedData; }
+
     protected:
 
         virtual void clearInternal() override { clearVulkan(); }
@@ -46,6 +56,7 @@ namespace JumaRenderEngine
 
         VulkanBuffer* m_StagingBuffer = nullptr;
         void* m_MappedData = nullptr;
+        uint8* m_PersistentMappedData = nullptr;
         bool m_Mapable = false;
 
 
@@ -4,7 +4,9 @@
 
 #include "VulkanCommandBuffer.h"
 
+#include "VulkanBuffer.h"
 #include "VulkanCommandPool.h"
+#include "VulkanImage.h"
 #include "../RenderEngine_Vulkan.h"
 
 namespace JumaRenderEngine
@@ -188,6 +190,34 @@ namespace JumaRenderEngine
         );
     }
 
+    void VulkanCommandBuffer::copyImageToBuffer(VulkanImage* srcImage, const VulkanBuffer* dstBuffer, const math::uvector2& offset, 
+        const math::uvector2& size)
+    {
+        VkBufferImageCopy copyInfo{};
+        copyInfo.bufferOffset = 0;
+        copyInfo.bufferRowLength = 0;
+        copyInfo.bufferImageHeight = 0;
+        copyInfo.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        copyInfo.imageSubresource.baseArrayLayer = 0;
+        copyInfo.imageSubresource.layerCount = 1;
+        copyInfo.imageSubresource.mipLevel = 0;
+        copyInfo.imageOffset = { static_cast<int32>(offset.x), static_cast<int32>(offset.y), 0 };
+        copyInfo.imageExtent = { size.x, size.y, 1 };
+        vkCmdCopyImageToBuffer(m_CommandBuffer, srcImage->get(), getLastImageLayout(srcImage), dstBuffer->get(), 1, &copyInfo);
+
+        VkMemoryBarrier2 barrier{};
+        barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER_2;
+        barrier.srcStageMask = VK_PIPELINE_STAGE_2_TRANSFER_BIT;
+        barrier.srcAccessMask = VK_ACCESS_2_TRANSFER_WRITE_BIT;
+        barrier.dstStageMask = VK_PIPELINE_STAGE_2_HOST_BIT;
+        barrier.dstAccessMask = VK_ACCESS_2_HOST_READ_BIT;
+        VkDependencyInfo dependencyInfo{};
+        dependencyInfo.sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO;
+        dependencyInfo.memoryBarrierCount = 1;
+        dependencyInfo.pMemoryBarriers = &barrier;
+        vkCmdPipelineBarrier2(m_CommandBuffer, &dependencyInfo);
+    }
+
     void VulkanCommandBuffer::generateMipmaps(VulkanImage* image, const VkImageLayout finalLayout)
     {
         if ((image == nullptr) || !image->isValid())
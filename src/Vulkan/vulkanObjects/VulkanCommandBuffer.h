@@ -8,9 +8,11 @@
 
 #include <vulkan/vulkan_core.h>
 #include <jutils/jmap.h>
+#include <jutils/math/vector2.h>
 
 namespace JumaRenderEngine
 {
+    class VulkanBuffer;
     class VulkanImage;
     class VulkanCommandPool;
 
@@ -23,6 +25,7 @@ namespace JumaRenderEngine
         ~VulkanCommandBuffer() = default;
 
         VkCommandBuffer get() const { return m_CommandBuffer; }
+        bool isPrimaryLevel() const { return m_PrimaryLevel; }
 
         bool submit(bool waitForFinish);
         bool submit(VkSubmitInfo submitInfo, VkFence fenceOnFinish, bool waitForFinish);
@@ -33,12 +36,15 @@ namespace JumaRenderEngine
         void applyBarriers();
 
         void copyImage(VulkanImage* srcImage, VulkanImage* dstImage);
+        // Copied data is visible for host after command buffer is finished
+        void copyImageToBuffer(VulkanImage* srcImage, const VulkanBuffer* dstBuffer, const math::uvector2& offset, const math::uvector2& size);
         void generateMipmaps(VulkanImage* image, VkImageLayout finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
 
     private:
 
         VulkanCommandPool* m_CommandPool = nullptr;
         VkCommandBuffer m_CommandBuffer = nullptr;
+        bool m_PrimaryLevel = true;
 
         jarray<VkImageMemoryBarrier2> m_ImageBarriers;
         jmap<VulkanImage*, VkImageLayout> m_LastImageLayouts;
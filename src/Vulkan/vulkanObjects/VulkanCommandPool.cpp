@@ -35,6 +35,7 @@ namespace JumaRenderEngine
     void VulkanCommandPool::clearVulkan()
     {
         m_UnusedCommandBuffers.clear();
+        m_UnusedSecondaryCommandBuffers.clear();
         m_CommandBuffers.clear();
         if (m_CommandPool != nullptr)
         {
@@ -43,23 +44,25 @@ namespace JumaRenderEngine
         }
     }
 
-    VulkanCommandBuffer* VulkanCommandPool::getCommandBuffer()
+    VulkanCommandBuffer* VulkanCommandPool::getCommandBuffer(const bool primaryLevel)
     {
-        if (!m_UnusedCommandBuffers.isEmpty())
+        jlist<VulkanCommandBuffer*>& unusedCommandBuffers = primaryLevel ? m_UnusedCommandBuffers : m_UnusedSecondaryCommandBuffers;
+        if (!unusedCommandBuffers.isEmpty())
         {
-            VulkanCommandBuffer* result = m_UnusedCommandBuffers.getLast();
-            m_UnusedCommandBuffers.removeLast();
+            VulkanCommandBuffer* result = unusedCommandBuffers.getLast();
+            unusedCommandBuffers.removeLast();
             return result;
         }
 
         VulkanCommandBuffer& commandBuffer = m_CommandBuffers.addDefault();
-        if (!createCommandBuffer(true, commandBuffer))
+        if (!createCommandBuffer(primaryLevel, commandBuffer))
         {
             m_CommandBuffers.removeLast();
             return nullptr;
         }
 
         commandBuffer.m_CommandPool = this;
+        commandBuffer.m_PrimaryLevel = primaryLevel;
         return &commandBuffer;
     }
     bool VulkanCommandPool::createCommandBuffer(const bool primaryLevel, VulkanCommandBuffer& outCommandBuffers)
@@ -83,7 +86,14 @@ namespace JumaRenderEngine
         if (commandBuffer != nullptr)
         {
             vkResetCommandBuffer(commandBuffer->get(), VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
-            m_UnusedCommandBuffers.add(commandBuffer);
+            if (commandBuffer->isPrimaryLevel())
+            {
+                m_UnusedCommandBuffers.add(commandBuffer);
+            }
+            else
+            {
+                m_UnusedSecondaryCommandBuffers.add(commandBuffer);
+            }
         }
     }
 }
@@ -14,10 +14,12 @@
 namespace JumaRenderEngine
 {
     class RenderEngine_Vulkan;
+    class RenderPipeline_Vulkan;
 
     class VulkanCommandPool final : public RenderEngineContextObjectBase
     {
         friend RenderEngine_Vulkan;
+        friend RenderPipeline_Vulkan;
 
     public:
         VulkanCommandPool() = default;
@@ -26,7 +28,7 @@ namespace JumaRenderEngine
         VkCommandPool get() const { return m_CommandPool; }
         VulkanQueueType getQueueType() const { return m_QueueType; }
 
-        VulkanCommandBuffer* getCommandBuffer();
+        VulkanCommandBuffer* getCommandBuffer(bool primaryLevel = true);
         void returnCommandBuffer(VulkanCommandBuffer* commandBuffer);
 
     private:
@@ -36,6 +38,7 @@ namespace JumaRenderEngine
 
         jlist<VulkanCommandBuffer> m_CommandBuffers;
         jlist<VulkanCommandBuffer*> m_UnusedCommandBuffers;
+        jlist<VulkanCommandBuffer*> m_UnusedSecondaryCommandBuffers;
 
 
         bool init(VulkanQueueType queueType, VkCommandPoolCreateFlags flags = 0);
@@ -0,0 +1,196 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#if defined(JUMARE_ENABLE_VULKAN)
+
+#include "VulkanDescriptorAllocator.h"
+
+#include "../RenderEngine_Vulkan.h"
+
+namespace JumaRenderEngine
+{
+    VulkanDescriptorAllocator::~VulkanDescriptorAllocator()
+    {
+        clearVulkan();
+    }
+
+    bool VulkanDescriptorAllocator::init(const uint32 setsPerPool)
+    {
+        if (isValid())
+        {
+            JUTILS_LOG(error, JSTR("Vulkan descriptor allocator already initialized"));
+            return false;
+        }
+        if (setsPerPool == 0)
+        {
+            return false;
+        }
+
+        m_SetsPerPool = setsPerPool;
+        markAsInitialized();
+        return true;
+    }
+
+    void VulkanDescriptorAllocator::clearVulkan()
+    {
+        VkDevice device = getRenderEngine<RenderEngine_Vulkan>()->getDevice();
+
+        std::lock_guard lock(m_Mutex);
+        for (const auto& descriptorPool : m_DescriptorPools)
+        {
+            vkDestroyDescriptorPool(device, descriptorPool, nullptr);
+        }
+        m_DescriptorPools.clear();
+        m_ReleasedDescriptorPools.clear();
+        m_DescriptorSetPools.clear();
+        m_FreeDescriptorSets.clear();
+        m_SetsPerPool = 0;
+    }
+
+    bool VulkanDescriptorAllocator::createDescriptorPool()
+    {
+        // Material descriptor sets contain uniform buffers and textures only
+        VkDescriptorPoolSize poolSizes[2];
+        poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+        poolSizes[0].descriptorCount = m_SetsPerPool * 4;
+        poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        poolSizes[1].descriptorCount = m_SetsPerPool * 8;
+
+        VkDescriptorPoolCreateInfo poolInfo{};
+        poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+        poolInfo.poolSizeCount = 2;
+        poolInfo.pPoolSizes = poolSizes;
+        poolInfo.maxSets = m_SetsPerPool;
+        poolInfo.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
+        VkDescriptorPool descriptorPool = nullptr;
+        const VkResult result = vkCreateDescriptorPool(getRenderEngine<RenderEngine_Vulkan>()->getDevice(), &poolInfo, nullptr, &descriptorPool);
+        if (result != VK_SUCCESS)
+        {
+            JUTILS_ERROR_LOG(result, JSTR("Failed to create vulkan descriptor pool"));
+            return false;
+        }
+        m_DescriptorPools.add(descriptorPool);
+        return true;
+    }
+    bool VulkanDescriptorAllocator::allocateFromPool(VkDescriptorPool descriptorPool, VkDescriptorSetLayout layout, const uint32 count, 
+        VkDescriptorSet* outDescriptorSets)
+    {
+        const jarray<VkDescriptorSetLayout> descriptorSetLayouts(static_cast<int32>(count), layout);
+        VkDescriptorSetAllocateInfo allocateInfo{};
+        allocateInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+        allocateInfo.descriptorPool = descriptorPool;
+        allocateInfo.descriptorSetCount = count;
+        allocateInfo.pSetLayouts = descriptorSetLayouts.getData();
+        if (vkAllocateDescriptorSets(getRenderEngine<RenderEngine_Vulkan>()->getDevice(), &allocateInfo, outDescriptorSets) != VK_SUCCESS)
+        {
+            return false;
+        }
+        for (uint32 index = 0; index < count; index++)
+        {
+            m_DescriptorSetPools.add(outDescriptorSets[index], descriptorPool);
+        }
+        return true;
+    }
+
+    bool VulkanDescriptorAllocator::allocate(VkDescriptorSetLayout layout, const uint32 count, VkDescriptorSet* outDescriptorSets)
+    {
+        if (!isValid() || (layout == nullptr) || (count == 0) || (outDescriptorSets == nullptr))
+        {
+            return false;
+        }
+
+        std::lock_guard lock(m_Mutex);
+        uint32 allocatedCount = 0;
+        jarray<VkDescriptorSet>* freeDescriptorSets = m_FreeDescriptorSets.find(layout);
+        if (freeDescriptorSets != nullptr)
+        {
+            while ((allocatedCount < count) && !freeDescriptorSets->isEmpty())
+            {
+                outDescriptorSets[allocatedCount++] = freeDescriptorSets->getLast();
+                freeDescriptorSets->removeLast();
+            }
+        }
+        if (allocatedCount == count)
+        {
+            return true;
+        }
+
+        const uint32 leftCount = count - allocatedCount;
+        if (!allocateFromPools(layout, leftCount, outDescriptorSets + allocatedCount))
+        {
+            JUTILS_LOG(error, JSTR("Failed to allocate {} vulkan descriptor sets"), leftCount);
+            // Don't lose already taken sets
+            for (uint32 index = 0; index < allocatedCount; index++)
+            {
+                m_FreeDescriptorSets[layout].add(outDescriptorSets[index]);
+            }
+            return false;
+        }
+        return true;
+    }
+    bool VulkanDescriptorAllocator::allocateFromPools(VkDescriptorSetLayout layout, const uint32 count, VkDescriptorSet* outDescriptorSets)
+    {
+        while (!m_ReleasedDescriptorPools.isEmpty())
+        {
+            if (allocateFromPool(m_ReleasedDescriptorPools.getLast(), layout, count, outDescriptorSets))
+            {
+                return true;
+            }
+            m_ReleasedDescriptorPools.removeLast();
+        }
+        // Other pools were filled before the last one was created
+        if (!m_DescriptorPools.isEmpty() && allocateFromPool(m_DescriptorPools.getLast(), layout, count, outDescriptorSets))
+        {
+            return true;
+        }
+        return createDescriptorPool() && allocateFromPool(m_DescriptorPools.getLast(), layout, count, outDescriptorSets);
+    }
+    void VulkanDescriptorAllocator::free(VkDescriptorSetLayout layout, const VkDescriptorSet* descriptorSets, const uint32 count)
+    {
+        if (!isValid() || (layout == nullptr) || (descriptorSets == nullptr))
+        {
+            return;
+        }
+
+        std::lock_guard lock(m_Mutex);
+        jarray<VkDescriptorSet>& freeDescriptorSets = m_FreeDescriptorSets[layout];
+        for (uint32 index = 0; index < count; index++)
+        {
+            if (descriptorSets[index] != nullptr)
+            {
+                freeDescriptorSets.add(descriptorSets[index]);
+            }
+        }
+    }
+
+    void VulkanDescriptorAllocator::onDescriptorSetLayoutDestroying(VkDescriptorSetLayout layout)
+    {
+        if (!isValid())
+        {
+            return;
+        }
+
+        VkDevice device = getRenderEngine<RenderEngine_Vulkan>()->getDevice();
+        std::lock_guard lock(m_Mutex);
+        const jarray<VkDescriptorSet>* freeDescriptorSets = m_FreeDescriptorSets.find(layout);
+        if (freeDescriptorSets == nullptr)
+        {
+            return;
+        }
+        for (const auto& descriptorSet : *freeDescriptorSets)
+        {
+            const VkDescriptorPool* descriptorPool = m_DescriptorSetPools.find(descriptorSet);
+            if (descriptorPool != nullptr)
+            {
+                vkFreeDescriptorSets(device, *descriptorPool, 1, &descriptorSet);
+                if (*descriptorPool != m_DescriptorPools.getLast())
+                {
+                    m_ReleasedDescriptorPools.addUnique(*descriptorPool);
+                }
+                m_DescriptorSetPools.remove(descriptorSet);
+            }
+        }
+        m_FreeDescriptorSets.remove(layout);
+    }
+}
+
+#endif
@@ -0,0 +1,58 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_VULKAN)
+
+#include "JumaRE/RenderEngineContextObject.h"
+
+#include <jutils/jarray.h>
+#include <jutils/jmap.h>
+#include <mutex>
+#include <vulkan/vulkan_core.h>
+
+namespace JumaRenderEngine
+{
+    // Allocates descriptor sets from shared pools, freed sets are reused by sets with the same layout.
+    // Thread safe
+    class VulkanDescriptorAllocator final : public RenderEngineContextObject
+    {
+    public:
+        VulkanDescriptorAllocator() = default;
+        virtual ~VulkanDescriptorAllocator() override;
+
+        bool init(uint32 setsPerPool);
+
+        bool allocate(VkDescriptorSetLayout layout, uint32 count, VkDescriptorSet* outDescriptorSets);
+        // Descriptor sets should not be used by GPU anymore
+        void free(VkDescriptorSetLayout layout, const VkDescriptorSet* descriptorSets, uint32 count);
+
+        // Free sets of this layout are returned to their pools, so they couldn't be reused with another layout
+        void onDescriptorSetLayoutDestroying(VkDescriptorSetLayout layout);
+
+    protected:
+
+        virtual void clearInternal() override { clearVulkan(); }
+
+    private:
+
+        std::mutex m_Mutex;
+
+        jarray<VkDescriptorPool> m_DescriptorPools;
+        // Filled pools which got free space after sets were returned to them
+        jarray<VkDescriptorPool> m_ReleasedDescriptorPools;
+        jmap<VkDescriptorSet, VkDescriptorPool> m_DescriptorSetPools;
+        jmap<VkDescriptorSetLayout, jarray<VkDescriptorSet>> m_FreeDescriptorSets;
+
+        uint32 m_SetsPerPool = 0;
+
+
+        void clearVulkan();
+
+        bool createDescriptorPool();
+        bool allocateFromPool(VkDescriptorPool descriptorPool, VkDescriptorSetLayout layout, uint32 count, VkDescriptorSet* outDescriptorSets);
+        bool allocateFromPools(VkDescriptorSetLayout layout, uint32 count, VkDescriptorSet* outDescriptorSets);
+    };
+}
+
+#endif
@@ -4,6 +4,7 @@
 
 #include "VulkanImage.h"
 
+#include "VulkanBindlessTextureTable.h"
 #include "VulkanBuffer.h"
 #include "VulkanCommandPool.h"
 #include "../RenderEngine_Vulkan.h"
@@ -23,6 +24,11 @@ namespace JumaRenderEngine
 
         if (m_ImageView != nullptr)
         {
+            VulkanBindlessTextureTable* textureTable = renderEngine->getBindlessTextureTable();
+            if (textureTable != nullptr)
+            {
+                textureTable->releaseTextureIndices(m_ImageView);
+            }
             vkDestroyImageView(renderEngine->getDevice(), m_ImageView, nullptr);
             m_ImageView = nullptr;
         }
@@ -24,14 +24,19 @@ namespace JumaRenderEngine
             return false;
         }
 
+        const RenderEngine_Vulkan* renderEngine = getRenderEngine<RenderEngine_Vulkan>();
         VkSemaphoreCreateInfo semaphoreInfo{};
         semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-        const VkResult result = vkCreateSemaphore(getRenderEngine<RenderEngine_Vulkan>()->getDevice(), &semaphoreInfo, nullptr, &m_RenderAvailableSemaphore);
-        if (result != VK_SUCCESS)
+        m_RenderAvailableSemaphores.resize(renderEngine->getFramesInFlightCount(), nullptr);
+        for (auto& semaphore : m_RenderAvailableSemaphores)
         {
-            JUTILS_ERROR_LOG(result, JSTR("Failed to create RenderAvailableSemaphore"));
-            clearVulkan();
-            return false;
+            const VkResult result = vkCreateSemaphore(renderEngine->getDevice(), &semaphoreInfo, nullptr, &semaphore);
+            if (result != VK_SUCCESS)
+            {
+                JUTILS_ERROR_LOG(result, JSTR("Failed to create RenderAvailableSemaphore"));
+                clearVulkan();
+                return false;
+            }
         }
 
         getRenderEngine()->getWindowController()->onWindowPropertiesChanged.bind(this, &VulkanSwapchain::onWindowPropertiesChanged);
@@ -149,11 +154,15 @@ namespace JumaRenderEngine
 
         VkDevice device = renderEngine->getDevice();
 
-        if (m_RenderAvailableSemaphore != nullptr)
+        for (const auto& semaphore : m_RenderAvailableSemaphores)
         {
-            vkDestroySemaphore(device, m_RenderAvailableSemaphore, nullptr);
-            m_RenderAvailableSemaphore = nullptr;
+            if (semaphore != nullptr)
+            {
+                vkDestroySemaphore(device, semaphore, nullptr);
+            }
         }
+        m_RenderAvailableSemaphores.clear();
+        m_RenderAvailableSemaphoreIndex = -1;
 
         m_SwapchainImages.clear();
         if (m_Swapchain != nullptr)
@@ -169,16 +178,23 @@ namespace JumaRenderEngine
         m_WindowID = window_id_INVALID;
     }
 
-    bool VulkanSwapchain::acquireNextImage(bool& availableForRender)
+    bool VulkanSwapchain::acquireNextImage(const int32 frameIndex, bool& availableForRender)
     {
         if (m_SwapchainInvalid)
         {
             availableForRender = false;
             return true;
         }
+        if (!m_RenderAvailableSemaphores.isValidIndex(frameIndex))
+        {
+            JUTILS_LOG(error, JSTR("Invalid frame index {}"), frameIndex);
+            availableForRender = false;
+            return false;
+        }
 
         uint32 renderImageIndex = 0;
-        const VkResult result = vkAcquireNextImageKHR(getRenderEngine<RenderEngine_Vulkan>()->getDevice(), m_Swapchain, UINT64_MAX, m_RenderAvailableSemaphore, nullptr, &renderImageIndex);
+        VkSemaphore renderAvailableSemaphore = m_RenderAvailableSemaphores[frameIndex];
+        const VkResult result = vkAcquireNextImageKHR(getRenderEngine<RenderEngine_Vulkan>()->getDevice(), m_Swapchain, UINT64_MAX, renderAvailableSemaphore, nullptr, &renderImageIndex);
         if ((result != VK_SUCCESS) && (result != VK_SUBOPTIMAL_KHR))
         {
             availableForRender = false;
@@ -193,6 +209,7 @@ namespace JumaRenderEngine
         }
         
         m_AcquiredSwapchainImageIndex = static_cast<int8>(renderImageIndex);
+        m_RenderAvailableSemaphoreIndex = frameIndex;
         availableForRender = true;
         return true;
     }
@@ -40,11 +40,15 @@ namespace JumaRenderEngine
         VkFormat getImagesFormat() const { return m_SwapchainImagesFormat; }
         const math::uvector2& getImagesSize() const { return m_SwapchainImagesSize; }
 
-        VkSemaphore getRenderAvailableSemaphore() const { return m_RenderAvailableSemaphore; }
+        VkSemaphore getRenderAvailableSemaphore() const
+        {
+            return m_RenderAvailableSemaphores.isValidIndex(m_RenderAvailableSemaphoreIndex) ? m_RenderAvailableSemaphores[m_RenderAvailableSemaphoreIndex] : nullptr;
+        }
         int8 getAcquiredImageIndex() const { return m_AcquiredSwapchainImageIndex; }
 
-        bool acquireNextImage(bool& availableForRender);
+        bool acquireNextImage(int32 frameIndex, bool& availableForRender);
 
+        bool isInvalid() const { return m_SwapchainInvalid; }
         void invalidate() { m_SwapchainInvalid = true; }
         bool update();
 
@@ -57,7 +61,9 @@ namespace JumaRenderEngine
         VkFormat m_SwapchainImagesFormat = VK_FORMAT_UNDEFINED;
         math::uvector2 m_SwapchainImagesSize = { 0, 0 };
 
-        VkSemaphore m_RenderAvailableSemaphore = nullptr;
+        // One semaphore for each frame in flight
+        jarray<VkSemaphore> m_RenderAvailableSemaphores;
+        int32 m_RenderAvailableSemaphoreIndex = -1;
         int8 m_AcquiredSwapchainImageIndex = -1;
         
         bool m_SwapchainInvalid = false;
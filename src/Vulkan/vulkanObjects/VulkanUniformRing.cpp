@@ -0,0 +1,125 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#if defined(JUMARE_ENABLE_VULKAN)
+
+#include "VulkanUniformRing.h"
+
+#include "VulkanBuffer.h"
+#include "../RenderEngine_Vulkan.h"
+
+namespace JumaRenderEngine
+{
+    VulkanUniformRing::~VulkanUniformRing()
+    {
+        clearVulkan();
+    }
+
+    bool VulkanUniformRing::init(const uint32 segmentSize, const int32 segmentsCount)
+    {
+        if (isValid())
+        {
+            JUTILS_LOG(error, JSTR("Uniform ring already initialized"));
+            return false;
+        }
+        if ((segmentSize == 0) || (segmentsCount <= 0))
+        {
+            return false;
+        }
+
+        VkPhysicalDeviceProperties deviceProperties;
+        vkGetPhysicalDeviceProperties(getRenderEngine<RenderEngine_Vulkan>()->getPhysicalDevice(), &deviceProperties);
+        m_Alignment = math::max(static_cast<uint32>(deviceProperties.limits.minUniformBufferOffsetAlignment), 1u);
+        m_SegmentsCount = segmentsCount;
+        if (!createBuffer(segmentSize))
+        {
+            m_SegmentsCount = 0;
+            return false;
+        }
+
+        markAsInitialized();
+        return true;
+    }
+    bool VulkanUniformRing::createBuffer(const uint32 segmentSize)
+    {
+        RenderEngine_Vulkan* renderEngine = getRenderEngine<RenderEngine_Vulkan>();
+        const uint32 alignedSegmentSize = (segmentSize + m_Alignment - 1) / m_Alignment * m_Alignment;
+        VulkanBuffer* buffer = renderEngine->getVulkanBuffer();
+        if (!buffer->initPersistentMapped(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, alignedSegmentSize * static_cast<uint32>(m_SegmentsCount)))
+        {
+            JUTILS_LOG(error, JSTR("Failed to create uniform ring buffer"));
+            renderEngine->returnVulkanBuffer(buffer);
+            return false;
+        }
+
+        m_Buffer = buffer;
+        m_SegmentSize = alignedSegmentSize;
+        m_Offset = m_SegmentEnd = 0;
+        m_Generation++;
+        return true;
+    }
+
+    void VulkanUniformRing::clearVulkan()
+    {
+        clearBuffer();
+        m_SegmentsCount = 0;
+        m_Alignment = 0;
+        m_RequiredSegmentSize = 0;
+        m_FrameIndex = 0;
+    }
+    void VulkanUniformRing::clearBuffer()
+    {
+        if (m_Buffer != nullptr)
+        {
+            getRenderEngine<RenderEngine_Vulkan>()->returnVulkanBuffer(m_Buffer);
+            m_Buffer = nullptr;
+        }
+        m_SegmentSize = 0;
+        m_Offset = m_SegmentEnd = 0;
+    }
+
+    VkBuffer VulkanUniformRing::get() const
+    {
+        return m_Buffer != nullptr ? m_Buffer->get() : nullptr;
+    }
+
+    bool VulkanUniformRing::startFrame(const int32 frameInFlightIndex)
+    {
+        if (!isValid() || (frameInFlightIndex < 0) || (frameInFlightIndex >= m_SegmentsCount))
+        {
+            return false;
+        }
+
+        if (isResizeRequired())
+        {
+            const uint32 segmentSize = math::max(m_SegmentSize * 2, m_RequiredSegmentSize);
+            JUTILS_LOG(warning, JSTR("Uniform ring is full, enlarging segment to {} bytes"), segmentSize);
+            clearBuffer();
+            if (!createBuffer(segmentSize))
+            {
+                clear();
+                return false;
+            }
+        }
+
+        m_Offset = m_SegmentSize * static_cast<uint32>(frameInFlightIndex);
+        m_SegmentEnd = m_Offset + m_SegmentSize;
+        m_RequiredSegmentSize = 0;
+        m_FrameIndex++;
+        return true;
+    }
+
+    uint8* VulkanUniformRing::allocate(const uint32 size, uint32& outOffset)
+    {
+        const uint32 alignedSize = (size + m_Alignment - 1) / m_Alignment * m_Alignment;
+        m_RequiredSegmentSize += alignedSize;
+        if ((m_Buffer == nullptr) || (size == 0) || ((m_Offset + alignedSize) > m_SegmentEnd))
+        {
+            return nullptr;
+        }
+        outOffset = m_Offset;
+        m_Offset += alignedSize;
+        return m_Buffer->getPersistentMappedData() + outOffset;
+    }
+}
+
+#endif
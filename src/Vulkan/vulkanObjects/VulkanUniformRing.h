@@ -0,0 +1,61 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_VULKAN)
+
+#include "JumaRE/RenderEngineContextObject.h"
+
+#include <vulkan/vulkan_core.h>
+
+namespace JumaRenderEngine
+{
+    class VulkanBuffer;
+
+    // Uniform buffer with a segment for each frame in flight, bound with dynamic offsets
+    class VulkanUniformRing final : public RenderEngineContextObject
+    {
+    public:
+        VulkanUniformRing() = default;
+        virtual ~VulkanUniformRing() override;
+
+        bool init(uint32 segmentSize, int32 segmentsCount);
+
+        VkBuffer get() const;
+        // Changed every time the buffer is recreated, descriptors should be updated then
+        uint32 getGeneration() const { return m_Generation; }
+        uint64 getFrameIndex() const { return m_FrameIndex; }
+
+        // Buffer should be recreated, so all frames in flight should be finished before startFrame()
+        bool isResizeRequired() const { return m_RequiredSegmentSize > m_SegmentSize; }
+        // Called from main thread after GPU finished the previous frame with the same index
+        bool startFrame(int32 frameInFlightIndex);
+
+        // Main thread only. Returns nullptr if segment is full, it will be enlarged in the next frame
+        uint8* allocate(uint32 size, uint32& outOffset);
+
+    protected:
+
+        virtual void clearInternal() override { clearVulkan(); }
+
+    private:
+
+        VulkanBuffer* m_Buffer = nullptr;
+        int32 m_SegmentsCount = 0;
+
+        uint32 m_SegmentSize = 0;
+        uint32 m_Alignment = 0;
+        uint32 m_Offset = 0;
+        uint32 m_SegmentEnd = 0;
+        uint32 m_RequiredSegmentSize = 0;
+        uint64 m_FrameIndex = 0;
+        uint32 m_Generation = 0;
+
+
+        bool createBuffer(uint32 segmentSize);
+        void clearBuffer();
+        void clearVulkan();
+    };
+}
+
+#endif
@@ -5,11 +5,16 @@
 #include "WindowControllerImpl_Vulkan.h"
 
 #include "WindowController_Vulkan_GLFW.h"
+#include "WindowController_Vulkan_Headless.h"
 
 namespace JumaRenderEngine
 {
-    WindowController_Vulkan* CreateWindowController_Vulkan()
+    WindowController_Vulkan* CreateWindowController_Vulkan(const bool headless)
     {
+        if (headless)
+        {
+            return new WindowController_Vulkan_Headless();
+        }
 #if defined(GLFW_ENABLED)
         return new WindowController_Vulkan_GLFW();
 #else
@@ -8,7 +8,7 @@
 
 namespace JumaRenderEngine
 {
-    extern WindowController_Vulkan* CreateWindowController_Vulkan();
+    extern WindowController_Vulkan* CreateWindowController_Vulkan(bool headless);
 }
 
 #endif
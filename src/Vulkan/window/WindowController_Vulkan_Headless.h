@@ -0,0 +1,25 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#if defined(JUMARE_ENABLE_VULKAN)
+
+#include "WindowController_Vulkan.h"
+#include "../../headless/WindowController_Headless.h"
+
+namespace JumaRenderEngine
+{
+    class WindowController_Vulkan_Headless final : public WindowController_Headless<WindowController_Vulkan>
+    {
+        using Super = WindowController_Headless<WindowController_Vulkan>;
+
+    public:
+        WindowController_Vulkan_Headless() = default;
+        virtual ~WindowController_Vulkan_Headless() override = default;
+
+        // Surface extensions are not needed without windows
+        virtual jarray<const char*> getVulkanInstanceExtensions() const override { return {}; }
+    };
+}
+
+#endif
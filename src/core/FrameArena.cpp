@@ -0,0 +1,105 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#include "JumaRE/FrameArena.h"
+
+#include <algorithm>
+
+namespace JumaRenderEngine
+{
+    FrameArena::~FrameArena()
+    {
+        clearBlocks();
+    }
+
+    void FrameArena::init(const size_t blockSize)
+    {
+        clear();
+        m_BlockSize = std::max<size_t>(blockSize, 1024);
+        addBlock(m_BlockSize);
+    }
+    void FrameArena::clear()
+    {
+        clearBlocks();
+        m_UsedSize = 0;
+        m_HighWaterMark = 0;
+    }
+    void FrameArena::clearBlocks()
+    {
+        for (const auto& block : m_Blocks)
+        {
+            delete[] block.data;
+        }
+        m_Blocks.clear();
+        m_BlockIndex = 0;
+        m_BlockOffset = 0;
+    }
+
+    bool FrameArena::addBlock(const size_t minSize)
+    {
+        const size_t size = std::max(m_BlockSize, minSize);
+        uint8* data = new (std::nothrow) uint8[size];
+        if (data == nullptr)
+        {
+            JUTILS_LOG(error, JSTR("Failed to allocate frame arena block of {} bytes"), size);
+            return false;
+        }
+        m_Blocks.add({ data, size });
+        return true;
+    }
+
+    size_t FrameArena::getReservedSize() const
+    {
+        size_t size = 0;
+        for (const auto& block : m_Blocks)
+        {
+            size += block.size;
+        }
+        return size;
+    }
+
+    void* FrameArena::allocate(const size_t size, const size_t alignment)
+    {
+        if (size == 0)
+        {
+            return nullptr;
+        }
+        while (true)
+        {
+            if (m_Blocks.isValidIndex(m_BlockIndex))
+            {
+                const Block& block = m_Blocks[m_BlockIndex];
+                const uintptr_t blockAddress = reinterpret_cast<uintptr_t>(block.data);
+                const uintptr_t address = (blockAddress + m_BlockOffset + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+                const size_t endOffset = static_cast<size_t>(address - blockAddress) + size;
+                if (endOffset <= block.size)
+                {
+                    m_UsedSize += endOffset - m_BlockOffset;
+                    m_BlockOffset = endOffset;
+                    return reinterpret_cast<void*>(address);
+                }
+
+                m_BlockIndex++;
+                m_BlockOffset = 0;
+            }
+            else if (!addBlock(size + alignment))
+            {
+                return nullptr;
+            }
+        }
+    }
+
+    void FrameArena::reset()
+    {
+        m_HighWaterMark = std::max(m_HighWaterMark, m_UsedSize);
+        if (m_Blocks.getSize() > 1)
+        {
+            // Frame didn't fit into one block, replace them by one big enough block
+            const size_t size = getReservedSize();
+            clearBlocks();
+            addBlock(size);
+        }
+        m_BlockIndex = 0;
+        m_BlockOffset = 0;
+        m_UsedSize = 0;
+    }
+}
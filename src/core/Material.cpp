@@ -2,6 +2,7 @@
 
 #include "JumaRE/material/Material.h"
 
+#include "JumaRE/RenderTrace.h"
 #include "JumaRE/material/Shader.h"
 
 namespace JumaRenderEngine
@@ -11,20 +12,36 @@ namespace JumaRenderEngine
         clearData();
     }
 
-    bool Material::init(Shader* shader)
+    bool Material::init(Shader* shader, Material* parentMaterial)
     {
+        JUMARE_TRACE_SCOPE("Material::init", "asset");
         if (shader == nullptr)
         {
             JUTILS_LOG(error, JSTR("Invalid shader"));
             return false;
         }
+        if ((parentMaterial != nullptr) && (parentMaterial->getShader() != shader))
+        {
+            JUTILS_LOG(error, JSTR("Parent material uses different shader"));
+            return false;
+        }
 
         m_Shader = shader;
-        for (const auto& [uniformID, uniform] : m_Shader->getUniforms())
+        if (parentMaterial != nullptr)
+        {
+            m_ParentMaterial = parentMaterial;
+            m_Properties = parentMaterial->getMaterialProperties();
+            m_MaterialParams.initInstance(&parentMaterial->m_MaterialParams);
+
+            std::lock_guard lock(parentMaterial->m_ChildMaterialsMutex);
+            parentMaterial->m_ChildMaterials.add(this);
+            ++parentMaterial->m_ChildMaterialsCount;
+        }
+        else
         {
-            m_MaterialParams.setDefaultValue(uniformID, uniform.type);
-            m_MaterialParamsForUpdate.add(uniformID);
+            m_MaterialParams.init(&m_Shader->getMaterialParamsLayout());
         }
+        markAllParamsForUpdate();
 
         if (!initInternal())
         {
@@ -42,6 +59,25 @@ namespace JumaRenderEngine
     }
     void Material::clearData()
     {
+        if (m_ParentMaterial != nullptr)
+        {
+            std::lock_guard lock(m_ParentMaterial->m_ChildMaterialsMutex);
+            jarray<Material*>& parentChildMaterials = m_ParentMaterial->m_ChildMaterials;
+            for (int32 index = 0; index < parentChildMaterials.getSize(); index++)
+            {
+                if (parentChildMaterials[index] == this)
+                {
+                    parentChildMaterials[index] = parentChildMaterials.getLast();
+                    parentChildMaterials.removeLast();
+                    break;
+                }
+            }
+            --m_ParentMaterial->m_ChildMaterialsCount;
+            m_ParentMaterial = nullptr;
+        }
+        m_ParamsOverridden = false;
+        m_UniformDataOverridden = false;
+        m_MaterialParamsForUpdate.clear();
         m_MaterialParams.clear();
         if (m_Shader != nullptr)
         {
@@ -50,19 +86,103 @@ namespace JumaRenderEngine
         }
     }
 
-    bool Material::checkParamType(const jstringID& name, const ShaderUniformType type) const
+    Material* Material::getUniformDataParent() const
+    {
+        if (m_UniformDataOverridden || (m_ParentMaterial == nullptr))
+        {
+            return nullptr;
+        }
+        Material* material = m_ParentMaterial;
+        while (!material->m_UniformDataOverridden && (material->m_ParentMaterial != nullptr))
+        {
+            material = material->m_ParentMaterial;
+        }
+        return material;
+    }
+    Material* Material::getRenderDataParent() const
     {
-        const ShaderUniform* uniform = m_Shader->getUniforms().find(name);
-        return (uniform != nullptr) && (uniform->type == type);
+        if (m_ParamsOverridden || (m_ParentMaterial == nullptr))
+        {
+            return nullptr;
+        }
+        Material* material = m_ParentMaterial;
+        while (!material->m_ParamsOverridden && (material->m_ParentMaterial != nullptr))
+        {
+            material = material->m_ParentMaterial;
+        }
+        return material;
     }
-    bool Material::resetParamValue(const jstringID& name)
+
+    bool Material::isUniformBufferChanged(const MaterialParamsMask& notUpdatedParams, const uint32 shaderLocation) const
     {
-        const ShaderUniform* uniform = m_Shader->getUniforms().find(name);
-        if ((uniform != nullptr) && m_MaterialParams.setDefaultValue(name, uniform->type))
+        const MaterialParamsLayout& paramsLayout = m_Shader->getMaterialParamsLayout();
+        for (const auto& paramIndex : notUpdatedParams)
         {
-            m_MaterialParamsForUpdate.add(name);
-            return true;
+            const ShaderUniform& uniform = paramsLayout.getParamUniform(paramIndex);
+            if (IsShaderUniformScalar(uniform.type) && (uniform.shaderLocation == shaderLocation))
+            {
+                return true;
+            }
         }
         return false;
     }
+    bool Material::resetParamValue(const jstringID& name)
+    {
+        const MaterialParamsLayoutEntry* entry = findParamEntry(name);
+        return (entry != nullptr) && resetParamValue(*entry);
+    }
+    bool Material::resetParamValue(const MaterialParamHandle& handle)
+    {
+        return (handle.layout == m_MaterialParams.getLayout()) && resetParamValue(handle.entry);
+    }
+    bool Material::resetParamValue(const MaterialParamsLayoutEntry& entry)
+    {
+        if (!m_MaterialParams.setDefaultValue(entry))
+        {
+            return false;
+        }
+        onParamValueChanged(entry);
+        return true;
+    }
+
+    void Material::onParamValueChanged(const MaterialParamsLayoutEntry& entry)
+    {
+        if (m_ParentMaterial != nullptr)
+        {
+            const bool uniformDataOverridden = m_MaterialParams.hasOwnUniformData();
+            if (!m_ParamsOverridden || (m_UniformDataOverridden != uniformDataOverridden))
+            {
+                // Instance stops using parent's render data, all of own data should be uploaded
+                m_ParamsOverridden = true;
+                m_UniformDataOverridden = uniformDataOverridden;
+                markAllParamsForUpdate();
+            }
+        }
+        m_MaterialParamsForUpdate.add(entry.index);
+        updateChildMaterialsParam(entry);
+    }
+    void Material::onParentParamValueChanged(const MaterialParamsLayoutEntry& entry)
+    {
+        if (m_MaterialParams.updateInheritedValue(entry))
+        {
+            m_MaterialParamsForUpdate.add(entry.index);
+            updateChildMaterialsParam(entry);
+        }
+    }
+    void Material::updateChildMaterialsParam(const MaterialParamsLayoutEntry& entry)
+    {
+        if (m_ChildMaterialsCount == 0)
+        {
+            return;
+        }
+        std::lock_guard lock(m_ChildMaterialsMutex);
+        for (const auto& childMaterial : m_ChildMaterials)
+        {
+            childMaterial->onParentParamValueChanged(entry);
+        }
+    }
+    void Material::markAllParamsForUpdate()
+    {
+        m_MaterialParamsForUpdate.addAll(m_Shader->getMaterialParamsLayout().getParamsCount());
+    }
 }
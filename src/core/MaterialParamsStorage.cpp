@@ -4,59 +4,227 @@
 
 namespace JumaRenderEngine
 {
+    constexpr uint32 UniformBufferOffsetAlignment = 16;
+
+    void MaterialParamsLayout::init(const jmap<jstringID, ShaderUniform>& uniforms, const jmap<uint32, ShaderUniformBufferDescription>& uniformBuffers)
+    {
+        clear();
+
+        uint32 dataSize = 0;
+        for (const auto& [shaderLocation, uniformBuffer] : uniformBuffers)
+        {
+            m_UniformBufferOffsets.add(shaderLocation, dataSize);
+            dataSize += (uniformBuffer.size + UniformBufferOffsetAlignment - 1) & ~(UniformBufferOffsetAlignment - 1);
+        }
+        m_DefaultUniformData.resize(static_cast<int32>(dataSize), 0);
+
+        for (const auto& [uniformID, uniform] : uniforms)
+        {
+            if (uniform.type == ShaderUniformType::Texture)
+            {
+                const MaterialParamsLayoutEntry& entry = m_ParamEntries.add({ uniform.type, static_cast<uint32>(m_TexturesCount++), static_cast<uint32>(m_Params.getSize()) });
+                m_Params.add(uniformID, entry);
+                m_TextureParamIndices.add(entry.index);
+                m_ParamNames.add(uniformID);
+                m_ParamUniforms.add(uniform);
+                continue;
+            }
+
+            const uint32* bufferOffset = m_UniformBufferOffsets.find(uniform.shaderLocation);
+            if (bufferOffset == nullptr)
+            {
+                continue;
+            }
+            const uint32 offset = *bufferOffset + uniform.shaderBlockOffset;
+            m_Params.add(uniformID, m_ParamEntries.add({ uniform.type, offset, static_cast<uint32>(m_Params.getSize()) }));
+            m_ParamNames.add(uniformID);
+            m_ParamUniforms.add(uniform);
+            if (uniform.type == ShaderUniformType::Mat4)
+            {
+                const ShaderUniformInfo<ShaderUniformType::Mat4>::value_type identity(1);
+                std::memcpy(m_DefaultUniformData.getData() + offset, &identity, sizeof(identity));
+            }
+        }
+    }
+    void MaterialParamsLayout::clear()
+    {
+        m_Params.clear();
+        m_ParamEntries.clear();
+        m_ParamNames.clear();
+        m_ParamUniforms.clear();
+        m_UniformBufferOffsets.clear();
+        m_DefaultUniformData.clear();
+        m_TextureParamIndices.clear();
+        m_TexturesCount = 0;
+    }
+
+    void MaterialParamsMask::add(const MaterialParamsMask& mask)
+    {
+        if (mask.isEmpty())
+        {
+            return;
+        }
+        if (m_Bits.getSize() < mask.m_Bits.getSize())
+        {
+            m_Bits.resize(mask.m_Bits.getSize(), 0);
+        }
+        m_Count = 0;
+        for (int32 index = 0; index < m_Bits.getSize(); index++)
+        {
+            if (mask.m_Bits.isValidIndex(index))
+            {
+                m_Bits[index] |= mask.m_Bits[index];
+            }
+            m_Count += std::popcount(m_Bits[index]);
+        }
+    }
+    void MaterialParamsMask::addAll(const int32 paramsCount)
+    {
+        if (paramsCount <= 0)
+        {
+            return;
+        }
+        const int32 wordsCount = (paramsCount + 63) / 64;
+        if (m_Bits.getSize() < wordsCount)
+        {
+            m_Bits.resize(wordsCount, 0);
+        }
+        for (int32 index = 0; index < wordsCount - 1; index++)
+        {
+            m_Bits[index] = ~static_cast<uint64>(0);
+        }
+        const int32 lastWordBitsCount = paramsCount - (wordsCount - 1) * 64;
+        m_Bits[wordsCount - 1] |= lastWordBitsCount < 64 ? (static_cast<uint64>(1) << lastWordBitsCount) - 1 : ~static_cast<uint64>(0);
+        m_Count = 0;
+        for (const auto& word : m_Bits)
+        {
+            m_Count += std::popcount(word);
+        }
+    }
+    void MaterialParamsMask::clear()
+    {
+        if (m_Count > 0)
+        {
+            // Words are kept to avoid reallocation on next change
+            std::memset(m_Bits.getData(), 0, m_Bits.getSize() * sizeof(uint64));
+            m_Count = 0;
+        }
+    }
+
     MaterialParamsStorage::~MaterialParamsStorage()
     {
         clear();
     }
 
-    bool MaterialParamsStorage::setDefaultValue(const jstringID& name, const ShaderUniformType type)
+    void MaterialParamsStorage::init(const MaterialParamsLayout* layout)
     {
-        switch (type)
+        clear();
+        m_Layout = layout;
+        if (m_Layout != nullptr)
+        {
+            m_UniformData = m_Layout->getDefaultUniformData();
+            m_Textures.resize(m_Layout->getTexturesCount(), nullptr);
+        }
+    }
+    void MaterialParamsStorage::initInstance(const MaterialParamsStorage* parentParams)
+    {
+        clear();
+        if ((parentParams != nullptr) && (parentParams->getLayout() != nullptr))
         {
-        case ShaderUniformType::Float: return setValue<ShaderUniformType::Float>(name, 0.0f);
-        case ShaderUniformType::Vec2: return setValue<ShaderUniformType::Vec2>(name, math::vector2(0));
-        case ShaderUniformType::Vec4: return setValue<ShaderUniformType::Vec4>(name, math::vector4(0));
-        case ShaderUniformType::Mat4: return setValue<ShaderUniformType::Mat4>(name, math::matrix4(1));
-        case ShaderUniformType::Texture: return setValue<ShaderUniformType::Texture>(name, nullptr);
-        default: ;
+            m_Layout = parentParams->getLayout();
+            m_Parent = parentParams;
+            m_OverriddenParams.resize((m_Layout->getParamsCount() + 63) / 64, 0);
         }
-        return false;
     }
 
-    bool MaterialParamsStorage::removeValue(const jstringID& name, const ShaderUniformType type)
+    const MaterialParamsLayoutEntry* MaterialParamsStorage::findParam(const jstringID& name, const ShaderUniformType type) const
     {
-        switch (type)
+        const MaterialParamsLayoutEntry* entry = m_Layout != nullptr ? m_Layout->findParam(name) : nullptr;
+        return (entry != nullptr) && (entry->type == type) ? entry : nullptr;
+    }
+    bool MaterialParamsStorage::isOverridden(const jstringID& name) const
+    {
+        const MaterialParamsLayoutEntry* entry = m_Layout != nullptr ? m_Layout->findParam(name) : nullptr;
+        return (entry != nullptr) && (m_Parent != nullptr) && isOverridden(*entry);
+    }
+    void MaterialParamsStorage::markAsOverridden(const MaterialParamsLayoutEntry& entry, const bool overridden)
+    {
+        if (m_Parent == nullptr)
         {
-        case ShaderUniformType::Float: return m_MaterialParams_Float.remove(name);
-        case ShaderUniformType::Vec2: return m_MaterialParams_Vec2.remove(name);
-        case ShaderUniformType::Vec4: return m_MaterialParams_Vec4.remove(name);
-        case ShaderUniformType::Mat4: return m_MaterialParams_Mat4.remove(name);
-        case ShaderUniformType::Texture: return m_MaterialParams_Texture.remove(name);
-        default: ;
+            return;
         }
-        return false;
+        uint64& mask = m_OverriddenParams[static_cast<int32>(entry.index / 64)];
+        const uint64 bit = static_cast<uint64>(1) << (entry.index % 64);
+        mask = overridden ? (mask | bit) : (mask & ~bit);
     }
 
-    bool MaterialParamsStorage::contains(const jstringID& name, const ShaderUniformType type) const
+    bool MaterialParamsStorage::setDefaultValue(const jstringID& name, const ShaderUniformType type)
     {
-        switch (type)
+        const MaterialParamsLayoutEntry* entry = findParam(name, type);
+        return (entry != nullptr) && setDefaultValue(*entry);
+    }
+    bool MaterialParamsStorage::setDefaultValue(const MaterialParamsLayoutEntry& entry)
+    {
+        if (m_Layout == nullptr)
+        {
+            return false;
+        }
+        if (m_Parent != nullptr)
         {
-        case ShaderUniformType::Float: return m_MaterialParams_Float.contains(name);
-        case ShaderUniformType::Vec2: return m_MaterialParams_Vec2.contains(name);
-        case ShaderUniformType::Vec4: return m_MaterialParams_Vec4.contains(name);
-        case ShaderUniformType::Mat4: return m_MaterialParams_Mat4.contains(name);
-        case ShaderUniformType::Texture: return m_MaterialParams_Texture.contains(name);
-        default: ;
+            if (!isOverridden(entry))
+            {
+                return false;
+            }
+            markAsOverridden(entry, false);
+            updateInheritedValue(entry);
+            return true;
         }
-        return false;
+        if (entry.type == ShaderUniformType::Texture)
+        {
+            return setValue<ShaderUniformType::Texture>(entry, nullptr);
+        }
+
+        const uint32 size = GetShaderUniformValueSize(entry.type);
+        uint8* data = m_UniformData.getData() + entry.offset;
+        const uint8* defaultData = m_Layout->getDefaultUniformData().getData() + entry.offset;
+        if (std::memcmp(data, defaultData, size) == 0)
+        {
+            return false;
+        }
+        std::memcpy(data, defaultData, size);
+        return true;
+    }
+
+    bool MaterialParamsStorage::updateInheritedValue(const jstringID& name)
+    {
+        const MaterialParamsLayoutEntry* entry = m_Layout != nullptr ? m_Layout->findParam(name) : nullptr;
+        return (entry != nullptr) && updateInheritedValue(*entry);
+    }
+    bool MaterialParamsStorage::updateInheritedValue(const MaterialParamsLayoutEntry& entry)
+    {
+        if ((m_Parent == nullptr) || isOverridden(entry))
+        {
+            return false;
+        }
+        if (IsShaderUniformScalar(entry.type) && !m_UniformData.isEmpty())
+        {
+            std::memcpy(m_UniformData.getData() + entry.offset, m_Parent->getUniformData() + entry.offset, GetShaderUniformValueSize(entry.type));
+        }
+        return true;
+    }
+
+    const uint8* MaterialParamsStorage::getUniformBufferData(const uint32 shaderLocation) const
+    {
+        const int32 offset = m_Layout != nullptr ? m_Layout->getUniformBufferOffset(shaderLocation) : -1;
+        return offset >= 0 ? getUniformData() + offset : nullptr;
     }
 
     void MaterialParamsStorage::clear()
     {
-        m_MaterialParams_Texture.clear();
-        m_MaterialParams_Mat4.clear();
-        m_MaterialParams_Vec4.clear();
-        m_MaterialParams_Vec2.clear();
-        m_MaterialParams_Float.clear();
+        m_OverriddenParams.clear();
+        m_Textures.clear();
+        m_UniformData.clear();
+        m_Parent = nullptr;
+        m_Layout = nullptr;
     }
-}
\ No newline at end of file
+}
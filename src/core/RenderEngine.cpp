@@ -2,6 +2,7 @@
 
 #include "JumaRE/RenderEngine.h"
 
+#include "JumaRE/RenderFrameOutput.h"
 #include "JumaRE/RenderPipeline.h"
 #include "JumaRE/RenderTarget.h"
 #include "JumaRE/material/Material.h"
@@ -27,8 +28,20 @@ namespace JumaRenderEngine
             JUTILS_LOG(warning, JSTR("Render engine already initialized"));
             return false;
         }
+        if (createInfo.headless && !isHeadlessModeSupported())
+        {
+            JUTILS_LOG(error, JSTR("Headless mode is not supported by {} render API"), getRenderAPI());
+            return false;
+        }
 
         RenderEngineContextObjectBase::s_RenderEngine = this;
+        m_Headless = createInfo.headless;
+        m_FramesInFlightCount = math::clamp(createInfo.framesInFlightCount, 1, getMaxFramesInFlightCount());
+        // Assets marked during frame N could be destroyed only after frame N + FramesInFlightCount started
+        m_RenderAssets_MarkedForDestroy.resize(m_FramesInFlightCount + 1);
+        m_FrameArena.init(createInfo.frameArenaBlockSize);
+        m_FrameStatsHistory.init(createInfo.frameStatsHistorySize);
+        SetRenderTraceThreadName("Main");
 
         WindowController* windowController = createWindowController();
         if (!windowController->initWindowController())
@@ -48,7 +61,7 @@ namespace JumaRenderEngine
         }
         m_Initialized = true;
 
-        if (!createRenderAssets())
+        if (!createRenderAssets(createInfo))
         {
             JUTILS_LOG(error, JSTR("Failed to initialize render assets"));
             clear();
@@ -64,13 +77,17 @@ namespace JumaRenderEngine
     }
     bool RenderEngine::initInternal(const WindowCreateInfo& mainWindowInfo)
     {
+        if (isHeadless())
+        {
+            return true;
+        }
         return m_WindowController->createMainWindow(mainWindowInfo);
     }
 
-    bool RenderEngine::createRenderAssets()
+    bool RenderEngine::createRenderAssets(const RenderEngineCreateInfo& createInfo)
     {
         RenderPipeline* renderPipeline = createRenderPipelineInternal();
-        if (!renderPipeline->init())
+        if (!renderPipeline->init(createInfo.renderRecordWorkerCount))
         {
             JUTILS_LOG(error, JSTR("Failed to init render pipeline"));
             delete renderPipeline;
@@ -114,6 +131,10 @@ namespace JumaRenderEngine
         {
             onDestroying.call(this);
 
+            for (const auto& frameOutput : m_FrameOutputs)
+            {
+                frameOutput->m_Stopping = true;
+            }
             m_AsyncAssetTaskQueue.stop();
             for (const auto& task : m_RenderAssets_DestroyTasks)
             {
@@ -122,18 +143,32 @@ namespace JumaRenderEngine
                     task.m_Asset->clearAsset();
                 }
             }
-            for (const auto& asset : m_RenderAssets_MarkedForDestroy)
+            for (const auto& assets : m_RenderAssets_MarkedForDestroy)
             {
-                if (asset.first != nullptr)
+                for (const auto& asset : assets)
                 {
-                    asset.first->clearAsset();
+                    asset->clearAsset();
                 }
             }
+            for (const auto& asset : m_RenderAssets_NotReadyForDestroy)
+            {
+                asset->clearAsset();
+            }
             m_RenderAssets_DestroyTasks.clear();
             m_RenderAssets_MarkedForDestroy.clear();
+            m_RenderAssets_DestroyedPrimitiveAssets.clear();
+            m_RenderAssets_NotReadyForDestroy.clear();
 
             clearInternal();
+            // Pending readbacks of frame outputs are failed when render targets are cleared
+            clearFrameOutputs();
 
+            m_FrameArena.clear();
+            m_FrameStatsHistory.clear();
+            m_LastFrameStats = {};
+            m_RenderedFramesCount = 0;
+            m_FramesInFlightCount = 1;
+            m_Headless = false;
             m_Initialized = false;
             RenderEngineContextObjectBase::s_RenderEngine = nullptr;
         }
@@ -250,6 +285,23 @@ namespace JumaRenderEngine
         }
         return material;
     }
+    Material* RenderEngine::createMaterialInstance(Material* parentMaterial)
+    {
+        Shader* shader = parentMaterial != nullptr ? parentMaterial->getShader() : nullptr;
+        if (shader == nullptr)
+        {
+            return nullptr;
+        }
+        Material* material = allocateMaterial();
+        ++shader->m_ChildMaterialsCount;
+        if (!material->init(shader, parentMaterial))
+        {
+            --shader->m_ChildMaterialsCount;
+            deallocateMaterial(material);
+            return nullptr;
+        }
+        return material;
+    }
     void RenderEngine::destroyMaterial(Material* material)
     {
         if (material != nullptr)
@@ -279,6 +331,8 @@ namespace JumaRenderEngine
         }
 
         uint32 vertexSize = 0;
+        const VertexComponentDescription* firstComponentDescription = findVertexComponent(description.components[0]);
+        const VertexComponentInputRate inputRate = firstComponentDescription != nullptr ? firstComponentDescription->inputRate : VertexComponentInputRate::Vertex;
         for (const auto& componentID : description.components)
         {
             const VertexComponentDescription* componentDescription = findVertexComponent(componentID);
@@ -287,6 +341,11 @@ namespace JumaRenderEngine
                 JUTILS_LOG(error, JSTR("Invalid vertex component {}"), componentID.toString());
                 return vertex_id_NONE;
             }
+            if (componentDescription->inputRate != inputRate)
+            {
+                JUTILS_LOG(error, JSTR("Vertex component {} has different input rate, per-vertex and per-instance components should be in different vertex buffers"), componentID.toString());
+                return vertex_id_NONE;
+            }
             vertexSize += GetVertexComponentSize(componentDescription->type);
         }
 
@@ -296,7 +355,7 @@ namespace JumaRenderEngine
             return vertex_id_NONE;
         }
         m_VertexIDGenerator.generateUID();
-        onRegisteredVertex(vertexID, m_RegisteredVerticesData.add(vertexID, { description, vertexSize }));
+        onRegisteredVertex(vertexID, m_RegisteredVerticesData.add(vertexID, { description, vertexSize, inputRate }));
         return vertexID;
     }
 
@@ -393,27 +452,113 @@ namespace JumaRenderEngine
 	        return;
         }
 
-        // TODO: Get amount of rendered frames
-        constexpr uint8 framesDelay = 1;
+        const RenderEngineAssetType assetType = asset->getType();
         m_RenderAssets_MarkedForDestroyMutex.lock();
-        m_RenderAssets_MarkedForDestroy.add({ asset, framesDelay });
+        getMarkedForDestroyAssets(m_RenderedFramesCount).add(asset);
+        if ((assetType == RenderEngineAssetType::Material) || (assetType == RenderEngineAssetType::VertexBuffer))
+        {
+            m_RenderAssets_DestroyedPrimitiveAssets.add(asset);
+        }
         m_RenderAssets_MarkedForDestroyMutex.unlock();
     }
     
+    RenderFrameOutput* RenderEngine::createFrameOutput(const RenderFrameOutputCreateInfo& createInfo)
+    {
+        const RenderTarget* renderTarget = getRenderTarget(createInfo.renderTargetID);
+        if (renderTarget == nullptr)
+        {
+            JUTILS_LOG(error, JSTR("Invalid render target {} for frame output"), createInfo.renderTargetID);
+            return nullptr;
+        }
+        if (renderTarget->isWindowRenderTarget())
+        {
+            JUTILS_LOG(error, JSTR("Frame output is not supported for window render target {}"), createInfo.renderTargetID);
+            return nullptr;
+        }
+
+        RenderFrameOutput* frameOutput = new RenderFrameOutput();
+        if (!frameOutput->init(createInfo))
+        {
+            JUTILS_LOG(error, JSTR("Failed to initialize frame output of render target {}"), createInfo.renderTargetID);
+            delete frameOutput;
+            return nullptr;
+        }
+        m_FrameOutputs.add(frameOutput);
+        return frameOutput;
+    }
+    void RenderEngine::destroyFrameOutput(RenderFrameOutput* frameOutput)
+    {
+        if (frameOutput == nullptr)
+        {
+            return;
+        }
+        for (int32 index = 0; index < m_FrameOutputs.getSize(); index++)
+        {
+            if (m_FrameOutputs[index] == frameOutput)
+            {
+                m_FrameOutputs[index] = m_FrameOutputs.getLast();
+                m_FrameOutputs.removeLast();
+                frameOutput->m_Stopping = true;
+                m_FrameOutputs_Destroying.add(frameOutput);
+                return;
+            }
+        }
+    }
+    void RenderEngine::processDestroyingFrameOutputs()
+    {
+        int32 destroyingCount = 0;
+        for (const auto& frameOutput : m_FrameOutputs_Destroying)
+        {
+            if (frameOutput->hasPendingReadbacks())
+            {
+                m_FrameOutputs_Destroying[destroyingCount++] = frameOutput;
+            }
+            else
+            {
+                delete frameOutput;
+            }
+        }
+        m_FrameOutputs_Destroying.resize(destroyingCount);
+    }
+    void RenderEngine::clearFrameOutputs()
+    {
+        for (const auto& frameOutput : m_FrameOutputs)
+        {
+            delete frameOutput;
+        }
+        for (const auto& frameOutput : m_FrameOutputs_Destroying)
+        {
+            delete frameOutput;
+        }
+        m_FrameOutputs.clear();
+        m_FrameOutputs_Destroying.clear();
+    }
+
     bool RenderEngine::render()
     {
+        JUMARE_TRACE_SCOPE("RenderEngine::render", "frame");
+        startFrameStats();
+        for (const auto& frameOutput : m_FrameOutputs)
+        {
+            frameOutput->requestFrame(this);
+        }
         if (!m_RenderPipeline->buildRenderTargetsQueue())
         {
             JUTILS_LOG(error, JSTR("Failed to build render targets queue"));
+            m_FrameArena.reset();
             return false;
         }
 
         if (!m_RenderPipeline->render())
         {
             JUTILS_LOG(error, JSTR("Render failed"));
+            m_FrameArena.reset();
             return false;
         }
-        m_WindowController->updateWindows();
+        {
+            JUMARE_TRACE_SCOPE("WindowController::updateWindows", "frame");
+            m_WindowController->updateWindows();
+        }
         for (const auto& renderTarget : m_RenderTargets.values())
         {
             renderTarget->clearPrimitivesList();
@@ -421,31 +566,95 @@ namespace JumaRenderEngine
 
         processMarkedForDestroyAssets();
         processFinishedDestroyAssetTasks();
+        processDestroyingFrameOutputs();
+        m_FrameArena.reset();
+        finishFramePhase(RenderFramePhase::PostRender);
+        finishFrameStats();
+        // Frames count selects destroy bucket in destroyAsset, which could be called from any thread
+        m_RenderAssets_MarkedForDestroyMutex.lock();
+        m_RenderedFramesCount++;
+        m_RenderAssets_MarkedForDestroyMutex.unlock();
         return true;
     }
 
+    void RenderEngine::startFrameStats()
+    {
+        for (auto& phaseTime : m_FramePhaseTimes)
+        {
+            phaseTime = 0.0f;
+        }
+        m_FrameStartTime = m_FramePhaseStartTime = std::chrono::steady_clock::now();
+    }
+    void RenderEngine::finishFramePhase(const RenderFramePhase phase)
+    {
+        const std::chrono::steady_clock::time_point time = std::chrono::steady_clock::now();
+        m_FramePhaseTimes[static_cast<uint8>(phase)] += std::chrono::duration<float, std::milli>(time - m_FramePhaseStartTime).count();
+        m_FramePhaseStartTime = time;
+    }
+    void RenderEngine::finishFrameStats()
+    {
+        RenderFrameStats& stats = m_LastFrameStats;
+        stats.frameIndex = m_RenderedFramesCount;
+        for (uint8 index = 0; index < RenderFrameCounterCount; index++)
+        {
+            stats.counters[index] = m_FrameCounters[index].exchange(0, std::memory_order_relaxed);
+        }
+        for (uint8 index = 0; index < RenderFramePhaseCount; index++)
+        {
+            stats.phaseTimes[index] = m_FramePhaseTimes[index];
+        }
+        stats.phaseTimes[static_cast<uint8>(RenderFramePhase::Total)] = std::chrono::duration<float, std::milli>(
+            std::chrono::steady_clock::now() - m_FrameStartTime
+        ).count();
+        m_FrameStatsHistory.add(stats);
+    }
+
     void RenderEngine::processMarkedForDestroyAssets()
     {
+        JUMARE_TRACE_SCOPE("RenderEngine::processMarkedForDestroyAssets", "asset");
+        // Bucket of the next frame contains assets marked FramesInFlightCount frames ago,
+        // all of the frames which could use them are finished at this point
         m_RenderAssets_MarkedForDestroyMutex.lock();
-        auto iter = m_RenderAssets_MarkedForDestroy.begin();
-        while (iter.isValid())
+        std::swap(m_RenderAssets_DestroyedPrimitiveAssetsTemp, m_RenderAssets_DestroyedPrimitiveAssets);
+        std::swap(m_RenderAssets_RetiredTemp, getMarkedForDestroyAssets(m_RenderedFramesCount + 1));
+        m_RenderAssets_MarkedForDestroyMutex.unlock();
+
+        // Retained primitives keep pointers to assets, drop them before assets could be cleared
+        if (!m_RenderAssets_DestroyedPrimitiveAssetsTemp.isEmpty())
         {
-            if (iter->second == 0)
+            for (const auto& renderTarget : m_RenderTargets.values())
             {
-                RenderEngineAsset* asset = iter->first;
-                if (asset->isReadyForDestroy())
-                {
-                    m_RenderAssets_DestroyTasksTemp.add(&m_RenderAssets_DestroyTasks.put(asset));
-                    m_RenderAssets_MarkedForDestroy.removeAt(iter);
-                }
+                renderTarget->removeRetainedPrimitivesWithAssets(m_RenderAssets_DestroyedPrimitiveAssetsTemp);
+            }
+            m_RenderAssets_DestroyedPrimitiveAssetsTemp.clear();
+        }
+
+        int32 notReadyAssetsCount = 0;
+        for (const auto& asset : m_RenderAssets_NotReadyForDestroy)
+        {
+            if (asset->isReadyForDestroy())
+            {
+                m_RenderAssets_DestroyTasksTemp.add(&m_RenderAssets_DestroyTasks.put(asset));
             }
             else
             {
-                iter->second--;
-                ++iter;
+                m_RenderAssets_NotReadyForDestroy[notReadyAssetsCount++] = asset;
             }
         }
-        m_RenderAssets_MarkedForDestroyMutex.unlock();
+        m_RenderAssets_NotReadyForDestroy.resize(notReadyAssetsCount);
+        for (const auto& asset : m_RenderAssets_RetiredTemp)
+        {
+            if (asset->isReadyForDestroy())
+            {
+                m_RenderAssets_DestroyTasksTemp.add(&m_RenderAssets_DestroyTasks.put(asset));
+            }
+            else
+            {
+                m_RenderAssets_NotReadyForDestroy.add(asset);
+            }
+        }
+        m_RenderAssets_RetiredTemp.clear();
+
         if (!m_RenderAssets_DestroyTasksTemp.isEmpty())
         {
             m_AsyncAssetTaskQueue.addTasks(m_RenderAssets_DestroyTasksTemp);
@@ -479,6 +688,7 @@ namespace JumaRenderEngine
     {
         if (m_Asset != nullptr)
         {
+            JUMARE_TRACE_SCOPE("RenderEngine::AsyncAssetDestroyTask", "asset");
             m_Asset->clearAsset();
         }
         m_TaskFinished = true;
@@ -2,8 +2,51 @@
 
 #include "JumaRE/RenderEngineAsset.h"
 
+#include <jutils/jarray.h>
+#include <mutex>
+
 namespace JumaRenderEngine
 {
+	struct AssetIndicesPool
+	{
+		std::mutex mutex;
+		uint32 nextIndex = 0;
+		jarray<uint32> freeIndices;
+	};
+	static AssetIndicesPool& GetAssetIndicesPool(const RenderEngineAssetType type)
+	{
+		static AssetIndicesPool pools[static_cast<uint8>(RenderEngineAssetType::VertexBuffer) + 1];
+		return pools[static_cast<uint8>(type)];
+	}
+
+	RenderEngineAsset::~RenderEngineAsset()
+	{
+		if (m_AssetType != RenderEngineAssetType::None)
+		{
+			ReleaseAssetIndex(m_AssetType, m_AssetIndex);
+		}
+	}
+
+	uint32 RenderEngineAsset::GenerateAssetIndex(const RenderEngineAssetType type)
+	{
+		// Indices are recycled to keep them compact, so truncated indices in sort keys don't alias
+		AssetIndicesPool& pool = GetAssetIndicesPool(type);
+		std::lock_guard lock(pool.mutex);
+		if (!pool.freeIndices.isEmpty())
+		{
+			const uint32 index = pool.freeIndices.getLast();
+			pool.freeIndices.removeLast();
+			return index;
+		}
+		return pool.nextIndex++;
+	}
+	void RenderEngineAsset::ReleaseAssetIndex(const RenderEngineAssetType type, const uint32 index)
+	{
+		AssetIndicesPool& pool = GetAssetIndicesPool(type);
+		std::lock_guard lock(pool.mutex);
+		pool.freeIndices.add(index);
+	}
+
 	void RenderEngineAsset::clearAsset()
 	{
 		onDestroying.call(this);
@@ -0,0 +1,396 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#include "JumaRE/RenderFrameOutput.h"
+
+#include "JumaRE/RenderEngine.h"
+#include "JumaRE/RenderTarget.h"
+
+#include <cstring>
+#include <string>
+
+namespace JumaRenderEngine
+{
+    constexpr uint32 FrameOutputPixelSize = GetRenderTargetReadbackFormatSize(RenderTargetReadbackFormat::RGBA8);
+
+    RenderFrameOutput::~RenderFrameOutput()
+    {
+        clear();
+    }
+
+    bool RenderFrameOutput::init(const RenderFrameOutputCreateInfo& createInfo)
+    {
+        if (isValid())
+        {
+            JUTILS_LOG(warning, JSTR("Frame output already initialized"));
+            return false;
+        }
+        if (createInfo.format == RenderFrameOutputFormat::Custom)
+        {
+            if (!createInfo.encoder)
+            {
+                JUTILS_LOG(error, JSTR("Encoder callback is required for custom frame output format"));
+                return false;
+            }
+        }
+        else if (createInfo.path.isEmpty())
+        {
+            JUTILS_LOG(error, JSTR("Empty frame output path"));
+            return false;
+        }
+        if (createInfo.frameRate == 0)
+        {
+            JUTILS_LOG(error, JSTR("Invalid frame output frame rate"));
+            return false;
+        }
+
+        m_CreateInfo = createInfo;
+        m_CreateInfo.workerCount = math::max(1, createInfo.workerCount);
+        m_CreateInfo.maxQueuedFrames = math::max(1, createInfo.maxQueuedFrames);
+        m_PathHasSequenceIndex = (m_CreateInfo.format == RenderFrameOutputFormat::PPM) 
+            && (std::string(*m_CreateInfo.path).find("{}") != std::string::npos);
+        if ((m_CreateInfo.format != RenderFrameOutputFormat::Custom) && !m_PathHasSequenceIndex)
+        {
+            m_OutputFile = openOutputFile(*m_CreateInfo.path);
+            if (m_OutputFile == nullptr)
+            {
+                return false;
+            }
+        }
+
+        m_FrameSlots.resize(m_CreateInfo.maxQueuedFrames);
+        if (!m_TaskQueue.init(m_CreateInfo.workerCount, this))
+        {
+            JUTILS_LOG(error, JSTR("Failed to start frame output workers"));
+            closeOutputFile(m_OutputFile);
+            m_OutputFile = nullptr;
+            m_FrameSlots.clear();
+            return false;
+        }
+
+        m_Initialized = true;
+        return true;
+    }
+
+    void RenderFrameOutput::clear()
+    {
+        if (!m_Initialized)
+        {
+            return;
+        }
+
+        m_Stopping = true;
+        flush();
+        m_TaskQueue.stop();
+        closeOutputFile(m_OutputFile);
+        m_OutputFile = nullptr;
+
+        m_FrameSlots.clear();
+        m_StreamFrameSize = { 0, 0 };
+        m_StreamHeaderWritten = false;
+        m_Stopping = false;
+        m_Initialized = false;
+    }
+
+    uint64 RenderFrameOutput::getSubmittedFramesCount() const
+    {
+        std::lock_guard lock(m_FrameSlotsMutex);
+        return m_SubmittedFramesCount;
+    }
+    uint64 RenderFrameOutput::getWrittenFramesCount() const
+    {
+        std::lock_guard lock(m_FrameSlotsMutex);
+        return m_WrittenFramesCount;
+    }
+    uint64 RenderFrameOutput::getDroppedFramesCount() const
+    {
+        std::lock_guard lock(m_FrameSlotsMutex);
+        return m_DroppedFramesCount;
+    }
+    bool RenderFrameOutput::hasPendingReadbacks() const
+    {
+        std::lock_guard lock(m_FrameSlotsMutex);
+        return m_PendingReadbacksCount > 0;
+    }
+
+    void RenderFrameOutput::flush()
+    {
+        JUMARE_TRACE_SCOPE("RenderFrameOutput::flush", "frame");
+        std::unique_lock lock(m_FrameSlotsMutex);
+        m_FrameSlotsCondition.wait(lock, [this]() { return m_FinishedFramesCount == m_SubmittedFramesCount; });
+    }
+
+    void RenderFrameOutput::requestFrame(const RenderEngine* renderEngine)
+    {
+        if (!m_Initialized || m_Stopping)
+        {
+            return;
+        }
+        RenderTarget* renderTarget = renderEngine->getRenderTarget(m_CreateInfo.renderTargetID);
+        if ((renderTarget == nullptr) || !renderTarget->isValid())
+        {
+            return;
+        }
+        if (renderTarget->requestReadback([this](const RenderTargetReadbackData& data) { onFrameReadback(data); }))
+        {
+            std::lock_guard lock(m_FrameSlotsMutex);
+            m_PendingReadbacksCount++;
+        }
+    }
+    void RenderFrameOutput::onFrameReadback(const RenderTargetReadbackData& data)
+    {
+        std::unique_lock lock(m_FrameSlotsMutex);
+        m_PendingReadbacksCount--;
+        // Failed readbacks could be reported from render target destroy task
+        if ((data.pixels == nullptr) || !m_Initialized || (data.size.x == 0) || (data.size.y == 0))
+        {
+            m_DroppedFramesCount++;
+            return;
+        }
+
+        const uint64 sequenceIndex = m_SubmittedFramesCount;
+        const uint64 slotsCount = static_cast<uint64>(m_FrameSlots.getSize());
+        if ((sequenceIndex - m_FinishedFramesCount) >= slotsCount)
+        {
+            // Backpressure, render waits until workers catch up
+            JUMARE_TRACE_SCOPE("RenderFrameOutput::waitForFreeSlot", "frame");
+            m_FrameSlotsCondition.wait(lock, [this, sequenceIndex, slotsCount]()
+            {
+                return (sequenceIndex - m_FinishedFramesCount) < slotsCount;
+            });
+        }
+        lock.unlock();
+
+        const int32 slotIndex = static_cast<int32>(sequenceIndex % slotsCount);
+        FrameSlot& slot = m_FrameSlots[slotIndex];
+        const uint32 rowSize = data.size.x * FrameOutputPixelSize;
+        slot.pixels.resize(static_cast<int32>(rowSize * data.size.y));
+        for (uint32 row = 0; row < data.size.y; row++)
+        {
+            std::memcpy(slot.pixels.getData() + row * rowSize, data.pixels + row * data.rowPitch, rowSize);
+        }
+        slot.frame.renderTargetID = data.renderTargetID;
+        slot.frame.frameIndex = data.frameIndex;
+        slot.frame.sequenceIndex = sequenceIndex;
+        slot.frame.size = data.size;
+        slot.frame.pixels = slot.pixels.getData();
+        slot.converted = false;
+        slot.valid = true;
+
+        lock.lock();
+        m_SubmittedFramesCount++;
+        lock.unlock();
+
+        if (!m_TaskQueue.addTask(new FrameOutputTask(this, slotIndex)))
+        {
+            JUTILS_LOG(warning, JSTR("Failed to start frame output task, frame {} dropped"), data.frameIndex);
+            slot.valid = false;
+            onFrameConverted(slotIndex);
+        }
+    }
+
+    void RenderFrameOutput::FrameOutputTask::run()
+    {
+        JUMARE_TRACE_SCOPE("RenderFrameOutput::convertFrame", "frame");
+        FrameSlot& slot = m_FrameOutput->m_FrameSlots[m_SlotIndex];
+        m_FrameOutput->convertFrame(slot);
+        m_FrameOutput->onFrameConverted(m_SlotIndex);
+    }
+    void RenderFrameOutput::onFrameConverted(const int32 slotIndex)
+    {
+        std::unique_lock lock(m_FrameSlotsMutex);
+        m_FrameSlots[slotIndex].converted = true;
+        if (m_Writing)
+        {
+            // Active writer will write this frame after the previous ones
+            return;
+        }
+
+        m_Writing = true;
+        const uint64 slotsCount = static_cast<uint64>(m_FrameSlots.getSize());
+        while (m_FinishedFramesCount < m_SubmittedFramesCount)
+        {
+            FrameSlot& slot = m_FrameSlots[static_cast<int32>(m_FinishedFramesCount % slotsCount)];
+            if (!slot.converted)
+            {
+                break;
+            }
+            lock.unlock();
+
+            bool written = false;
+            if (slot.valid)
+            {
+                JUMARE_TRACE_SCOPE("RenderFrameOutput::writeFrame", "frame");
+                written = writeFrame(slot);
+            }
+            slot.converted = false;
+            slot.valid = false;
+
+            lock.lock();
+            if (written)
+            {
+                m_WrittenFramesCount++;
+            }
+            else
+            {
+                m_DroppedFramesCount++;
+            }
+            m_FinishedFramesCount++;
+            m_FrameSlotsCondition.notify_all();
+        }
+        m_Writing = false;
+    }
+
+    void RenderFrameOutput::convertFrame(FrameSlot& slot) const
+    {
+        const uint32 width = slot.frame.size.x;
+        const uint32 height = slot.frame.size.y;
+        const uint8* pixels = slot.pixels.getData();
+        switch (m_CreateInfo.format)
+        {
+        case RenderFrameOutputFormat::PPM:
+            {
+                char header[64];
+                const int32 headerSize = std::snprintf(header, sizeof(header), "P6\n%u %u\n255\n", width, height);
+                slot.encodedData.resize(headerSize + static_cast<int32>(width * height * 3));
+                uint8* data = slot.encodedData.getData();
+                std::memcpy(data, header, headerSize);
+                data += headerSize;
+                const uint32 pixelsCount = width * height;
+                for (uint32 index = 0; index < pixelsCount; index++)
+                {
+                    data[index * 3 + 0] = pixels[index * FrameOutputPixelSize + 0];
+                    data[index * 3 + 1] = pixels[index * FrameOutputPixelSize + 1];
+                    data[index * 3 + 2] = pixels[index * FrameOutputPixelSize + 2];
+                }
+            }
+            break;
+
+        case RenderFrameOutputFormat::Y4M:
+            {
+                // BT.601 limited range in 8-bit fixed point, chroma is averaged over 2x2 blocks
+                constexpr char frameHeader[] = "FRAME\n";
+                constexpr int32 frameHeaderSize = sizeof(frameHeader) - 1;
+                const uint32 chromaWidth = (width + 1) / 2;
+                const uint32 chromaHeight = (height + 1) / 2;
+                slot.encodedData.resize(frameHeaderSize + static_cast<int32>(width * height + chromaWidth * chromaHeight * 2));
+                uint8* data = slot.encodedData.getData();
+                std::memcpy(data, frameHeader, frameHeaderSize);
+
+                uint8* planeY = data + frameHeaderSize;
+                uint8* planeU = planeY + width * height;
+                uint8* planeV = planeU + chromaWidth * chromaHeight;
+                for (uint32 row = 0; row < height; row++)
+                {
+                    const uint8* rowPixels = pixels + row * width * FrameOutputPixelSize;
+                    uint8* rowY = planeY + row * width;
+                    for (uint32 column = 0; column < width; column++)
+                    {
+                        const int32 r = rowPixels[column * FrameOutputPixelSize + 0];
+                        const int32 g = rowPixels[column * FrameOutputPixelSize + 1];
+                        const int32 b = rowPixels[column * FrameOutputPixelSize + 2];
+                        rowY[column] = static_cast<uint8>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+                    }
+                }
+                for (uint32 chromaRow = 0; chromaRow < chromaHeight; chromaRow++)
+                {
+                    const uint32 row0 = chromaRow * 2;
+                    const uint32 row1 = math::min(row0 + 1, height - 1);
+                    const uint8* rowPixels0 = pixels + row0 * width * FrameOutputPixelSize;
+                    const uint8* rowPixels1 = pixels + row1 * width * FrameOutputPixelSize;
+                    uint8* rowU = planeU + chromaRow * chromaWidth;
+                    uint8* rowV = planeV + chromaRow * chromaWidth;
+                    for (uint32 chromaColumn = 0; chromaColumn < chromaWidth; chromaColumn++)
+                    {
+                        const uint32 offset0 = chromaColumn * 2 * FrameOutputPixelSize;
+                        const uint32 offset1 = math::min(chromaColumn * 2 + 1, width - 1) * FrameOutputPixelSize;
+                        const int32 r = (rowPixels0[offset0 + 0] + rowPixels0[offset1 + 0] + rowPixels1[offset0 + 0] + rowPixels1[offset1 + 0] + 2) >> 2;
+                        const int32 g = (rowPixels0[offset0 + 1] + rowPixels0[offset1 + 1] + rowPixels1[offset0 + 1] + rowPixels1[offset1 + 1] + 2) >> 2;
+                        const int32 b = (rowPixels0[offset0 + 2] + rowPixels0[offset1 + 2] + rowPixels1[offset0 + 2] + rowPixels1[offset1 + 2] + 2) >> 2;
+                        rowU[chromaColumn] = static_cast<uint8>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+                        rowV[chromaColumn] = static_cast<uint8>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+                    }
+                }
+            }
+            break;
+
+        default: ;
+        }
+    }
+    bool RenderFrameOutput::writeFrame(FrameSlot& slot)
+    {
+        switch (m_CreateInfo.format)
+        {
+        case RenderFrameOutputFormat::Custom:
+            return m_CreateInfo.encoder(slot.frame);
+
+        case RenderFrameOutputFormat::Y4M:
+            if (!m_StreamHeaderWritten)
+            {
+                m_StreamFrameSize = slot.frame.size;
+                if (std::fprintf(m_OutputFile, "YUV4MPEG2 W%u H%u F%u:1 Ip A1:1 C420jpeg\n", m_StreamFrameSize.x, m_StreamFrameSize.y, m_CreateInfo.frameRate) < 0)
+                {
+                    JUTILS_LOG(error, JSTR("Failed to write Y4M header to {}"), m_CreateInfo.path);
+                    return false;
+                }
+                m_StreamHeaderWritten = true;
+            }
+            else if (m_StreamFrameSize != slot.frame.size)
+            {
+                JUTILS_LOG(warning, JSTR("Render target {} size changed, frame {} is not written to Y4M stream"), slot.frame.renderTargetID, slot.frame.frameIndex);
+                return false;
+            }
+            break;
+
+        default: ;
+        }
+
+        std::FILE* file = m_OutputFile;
+        if (m_PathHasSequenceIndex)
+        {
+            std::string path = *m_CreateInfo.path;
+            const std::string sequenceIndex = std::to_string(slot.frame.sequenceIndex);
+            path.replace(path.find("{}"), 2, std::string(sequenceIndex.size() < 6 ? 6 - sequenceIndex.size() : 0, '0') + sequenceIndex);
+            file = openOutputFile(path.c_str());
+            if (file == nullptr)
+            {
+                return false;
+            }
+        }
+        const size_t dataSize = static_cast<size_t>(slot.encodedData.getSize());
+        const bool success = std::fwrite(slot.encodedData.getData(), 1, dataSize, file) == dataSize;
+        if (!success)
+        {
+            JUTILS_LOG(error, JSTR("Failed to write frame {} to {}"), slot.frame.frameIndex, m_CreateInfo.path);
+        }
+        if (m_PathHasSequenceIndex)
+        {
+            closeOutputFile(file);
+        }
+        return success;
+    }
+
+    std::FILE* RenderFrameOutput::openOutputFile(const char* path) const
+    {
+        if (std::strcmp(path, "-") == 0)
+        {
+            return stdout;
+        }
+        std::FILE* file = std::fopen(path, "wb");
+        if (file == nullptr)
+        {
+            JUTILS_LOG(error, JSTR("Failed to open frame output file {}"), path);
+        }
+        return file;
+    }
+    void RenderFrameOutput::closeOutputFile(std::FILE* file) const
+    {
+        if (file == stdout)
+        {
+            std::fflush(file);
+        }
+        else if (file != nullptr)
+        {
+            std::fclose(file);
+        }
+    }
+}
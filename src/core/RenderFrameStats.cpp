@@ -0,0 +1,68 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#include "JumaRE/RenderFrameStats.h"
+
+#include <algorithm>
+
+namespace JumaRenderEngine
+{
+    void RenderFrameStatsHistory::init(const int32 capacity)
+    {
+        clear();
+        m_Capacity = std::max(capacity, 1);
+    }
+    void RenderFrameStatsHistory::clear()
+    {
+        m_Stats.clear();
+        m_NextIndex = 0;
+    }
+
+    void RenderFrameStatsHistory::add(const RenderFrameStats& stats)
+    {
+        if (m_Capacity <= 0)
+        {
+            return;
+        }
+        if (m_Stats.getSize() < m_Capacity)
+        {
+            m_Stats.add(stats);
+        }
+        else
+        {
+            m_Stats[m_NextIndex] = stats;
+        }
+        m_NextIndex = (m_NextIndex + 1) % m_Capacity;
+    }
+
+    const RenderFrameStats& RenderFrameStatsHistory::getStats(const int32 index) const
+    {
+        if (m_Stats.getSize() < m_Capacity)
+        {
+            return m_Stats[index];
+        }
+        return m_Stats[(m_NextIndex + index) % m_Capacity];
+    }
+
+    RenderFramePhaseTimings RenderFrameStatsHistory::getPhaseTimings(const RenderFramePhase phase) const
+    {
+        const int32 count = m_Stats.getSize();
+        if (count == 0)
+        {
+            return {};
+        }
+
+        jarray<float> times;
+        times.resize(count);
+        float sum = 0.0f;
+        for (int32 index = 0; index < count; index++)
+        {
+            times[index] = m_Stats[index].getPhaseTime(phase);
+            sum += times[index];
+        }
+        std::sort(times.getData(), times.getData() + count);
+
+        // Nearest-rank percentile
+        const int32 p99Index = std::clamp((count * 99 + 99) / 100 - 1, 0, count - 1);
+        return { times[0], sum / static_cast<float>(count), times[p99Index] };
+    }
+}
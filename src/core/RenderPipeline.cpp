@@ -10,12 +10,14 @@
 
 namespace JumaRenderEngine
 {
+    thread_local int32 RenderPipeline::s_RenderRecordWorkerIndex = -1;
+
     RenderPipeline::~RenderPipeline()
     {
         clearData();
     }
 
-    bool RenderPipeline::init()
+    bool RenderPipeline::init(const int32 recordWorkerCount)
     {
         if (!initInternal())
         {
@@ -23,6 +25,16 @@ namespace JumaRenderEngine
             clearData();
             return false;
         }
+        if ((recordWorkerCount > 0) && isParallelRecordingSupported())
+        {
+            if (!m_RenderRecordTaskQueue.init(recordWorkerCount, this))
+            {
+                JUTILS_LOG(error, JSTR("Failed to initialize render record task queue"));
+                clearData();
+                return false;
+            }
+            m_RenderRecordWorkersStarted = true;
+        }
         return true;
     }
     bool RenderPipeline::initInternal()
@@ -32,9 +44,26 @@ namespace JumaRenderEngine
 
     void RenderPipeline::clearData()
     {
+        stopRenderRecordWorkers();
+
         m_RenderTargetsQueueValid = false;
         m_RenderTargetsDependecies.clear();
         m_RenderTargetsQueue.clear();
+        m_RenderTargetsQueueLevels.clear();
+
+        m_GPUTimestampsSlots.clear();
+        m_GPUFrameTimings = {};
+        m_GPUTimestampsSlotIndex = -1;
+        m_GPUProfilingEnabled = false;
+        m_GPUTimestampsActive = false;
+    }
+    void RenderPipeline::stopRenderRecordWorkers()
+    {
+        if (m_RenderRecordWorkersStarted)
+        {
+            m_RenderRecordTaskQueue.stop();
+            m_RenderRecordWorkersStarted = false;
+        }
     }
 
     void RenderPipeline::onRenderTargetCreated(RenderTarget* renderTarget)
@@ -113,7 +142,9 @@ namespace JumaRenderEngine
             return true;
         }
 
+        JUMARE_TRACE_SCOPE("RenderPipeline::buildRenderTargetsQueue", "render");
         m_RenderTargetsQueue.clear();
+        m_RenderTargetsQueueLevels.clear();
         jmap<render_target_id, jset<render_target_id>> cachedDependencies = m_RenderTargetsDependecies;
         jarray<render_target_id> handledStages;
         jarray<render_target_id> stagesForSync;
@@ -138,6 +169,7 @@ namespace JumaRenderEngine
             }
 
             // Add them to queue
+            m_RenderTargetsQueueLevels.add({ m_RenderTargetsQueue.getSize(), handledStages.getSize() });
             for (const auto& stage : handledStages)
             {
                 cachedDependencies.remove(stage);
@@ -175,49 +207,285 @@ namespace JumaRenderEngine
             return false;
         }
         renderInternal();
+        m_FrameInFlightIndex = (m_FrameInFlightIndex + 1) % getRenderEngine()->getFramesInFlightCount();
         return true;
     }
     void RenderPipeline::renderInternal()
     {
         callRender<RenderOptions>();
     }
-    void RenderPipeline::callRender(RenderOptions* renderOptions)
+
+    bool RenderPipeline::startRender(RenderOptions* renderOptions)
     {
         renderOptions->renderPipeline = this;
-        if (onStartRender(renderOptions))
+        if (!onStartRender(renderOptions))
         {
-            const RenderEngine* renderEngine = getRenderEngine();
-            for (const auto& renderQueueEntry : m_RenderTargetsQueue)
+            return false;
+        }
+        startGPUTimestamps(renderOptions);
+        return true;
+    }
+    bool RenderPipeline::shouldRecordInParallel(const RenderTargetsQueueLevel& queueLevel) const
+    {
+        return isParallelRecordingEnabled() && (queueLevel.entriesCount > 1);
+    }
+    bool RenderPipeline::renderQueueLevel(RenderOptions* renderOptions, const RenderTargetsQueueLevel& queueLevel)
+    {
+        const RenderEngine* renderEngine = getRenderEngine();
+        for (int32 index = 0; index < queueLevel.entriesCount; index++)
+        {
+            const render_target_id renderTargetID = m_RenderTargetsQueue[queueLevel.firstEntryIndex + index].renderTargetID;
+            RenderTarget* renderTarget = renderEngine->getRenderTarget(renderTargetID);
+            renderOptions->gpuTimingIndex = getQueueEntryGPUTimingIndex(queueLevel.firstEntryIndex + index);
+            writeRenderTargetGPUTimestamp(renderOptions, false);
+            if (!onStartRenderToRenderTarget(renderOptions, renderTarget))
+            {
+                JUTILS_LOG(warning, JSTR("Failed to start render to render target {}"), renderTargetID);
+                return false;
+            }
+            renderTarget->sortPrimitivesLists();
+            renderPrimitives(renderOptions, renderTarget);
+            onFinishRenderToRenderTarget(renderOptions, renderTarget);
+            writeRenderTargetGPUTimestamp(renderOptions, true);
+        }
+        return true;
+    }
+    bool RenderPipeline::recordQueueLevel(RenderOptions* renderOptions, const RenderTargetsQueueLevel& queueLevel, 
+        const FrameArray<RenderOptions*>& levelRenderOptions)
+    {
+        const RenderEngine* renderEngine = getRenderEngine();
+        m_RenderRecordTasksTemp.clear();
+        for (int32 index = 0; index < queueLevel.entriesCount; index++)
+        {
+            const render_target_id renderTargetID = m_RenderTargetsQueue[queueLevel.firstEntryIndex + index].renderTargetID;
+            RenderTarget* renderTarget = renderEngine->getRenderTarget(renderTargetID);
+            RenderOptions* recordRenderOptions = levelRenderOptions[index];
+            recordRenderOptions->renderTarget = renderTarget;
+            recordRenderOptions->gpuTimingIndex = getQueueEntryGPUTimingIndex(queueLevel.firstEntryIndex + index);
+            recordRenderOptions->recordingOnWorkerThread = true;
+            if (!onStartRecordRenderTarget(renderOptions, recordRenderOptions, renderTarget))
             {
-                RenderTarget* renderTarget = renderEngine->getRenderTarget(renderQueueEntry.renderTargetID);
-                if (!onStartRenderToRenderTarget(renderOptions, renderTarget))
+                JUTILS_LOG(warning, JSTR("Failed to start recording render target {}"), renderTargetID);
+                for (const auto& task : m_RenderRecordTasksTemp)
                 {
-                    JUTILS_LOG(warning, JSTR("Failed to start render to render target {}"), renderQueueEntry.renderTargetID);
-                    break;
+                    delete task;
                 }
+                m_RenderRecordTasksTemp.clear();
+                return false;
+            }
+            m_RenderRecordTasksTemp.add(new RenderRecordTask(this, recordRenderOptions, renderTarget));
+        }
+
+        m_RenderRecordTasksLeft = m_RenderRecordTasksTemp.getSize();
+        if (!m_RenderRecordTaskQueue.addTasks(m_RenderRecordTasksTemp))
+        {
+            JUTILS_LOG(error, JSTR("Failed to start render record tasks"));
+            for (const auto& task : m_RenderRecordTasksTemp)
+            {
+                delete task;
+            }
+            m_RenderRecordTasksTemp.clear();
+            m_RenderRecordTasksLeft = 0;
+            return false;
+        }
+        m_RenderRecordTasksTemp.clear();
+        {
+            std::unique_lock lock(m_RenderRecordTasksMutex);
+            m_RenderRecordTasksCondition.wait(lock, [this]() { return m_RenderRecordTasksLeft == 0; });
+        }
 
-                const int32 stagesCount = renderTarget->getRenderStagesCount();
-                for (int32 index = 0; index < stagesCount; index++)
+        for (int32 index = 0; index < queueLevel.entriesCount; index++)
+        {
+            RenderOptions* recordRenderOptions = levelRenderOptions[index];
+            if (!onFinishRecordRenderTarget(renderOptions, recordRenderOptions, recordRenderOptions->renderTarget))
+            {
+                JUTILS_LOG(warning, JSTR("Failed to submit recorded render target {}"), recordRenderOptions->renderTarget->getID());
+                return false;
+            }
+        }
+        return true;
+    }
+    void RenderPipeline::finishRender(RenderOptions* renderOptions)
+    {
+        onFinishRender(renderOptions);
+    }
+
+    void RenderPipeline::RenderRecordTask::run()
+    {
+        {
+            JUMARE_TRACE_SCOPE("RenderPipeline::recordRenderTarget", "render");
+            m_RenderPipeline->recordRenderTarget(m_RenderOptions, m_RenderTarget);
+        }
+        m_RenderPipeline->onRenderRecordTaskFinished();
+    }
+    void RenderPipeline::onRenderRecordTaskFinished()
+    {
+        std::lock_guard lock(m_RenderRecordTasksMutex);
+        if (--m_RenderRecordTasksLeft == 0)
+        {
+            m_RenderRecordTasksCondition.notify_all();
+        }
+    }
+
+    void RenderPipeline::renderPrimitives(RenderOptions* renderOptions, const RenderTarget* renderTarget) const
+    {
+        const int32 stagesCount = renderTarget->getRenderStagesCount();
+        for (int32 index = 0; index < stagesCount; index++)
+        {
+            const RenderStage* renderStage = renderTarget->getRenderStage(index);
+            if (renderStage != nullptr)
+            {
+                writeRenderStageGPUTimestamp(renderOptions, index, false);
+                renderOptions->renderStageProperties = renderStage->properties;
+                for (const auto& renderPrimitive : renderStage->primitivesList)
                 {
-	                const RenderStage* renderStage = renderTarget->getRenderStage(index);
-                    if (renderStage != nullptr)
+                    if (renderPrimitive.material != nullptr)
                     {
-                        renderOptions->renderStageProperties = renderStage->properties;
-	                    for (const auto& renderPrimitive : renderStage->primitivesList)
-	                    {
-		                    if (renderPrimitive.material != nullptr)
-		                    {
-		                        renderPrimitive.vertexBuffer->render(renderOptions, renderPrimitive.material);
-		                    }
-	                    }
+                        renderPrimitive.vertexBuffer->render(renderOptions, renderPrimitive);
                     }
                 }
+                writeRenderStageGPUTimestamp(renderOptions, index, true);
+            }
+        }
+    }
 
-                onFinishRenderToRenderTarget(renderOptions, renderTarget);
+    bool RenderPipeline::setGPUProfilingEnabled(const bool enabled)
+    {
+        if (enabled == m_GPUProfilingEnabled)
+        {
+            return true;
+        }
+        if (enabled)
+        {
+            if (!isGPUTimestampsSupported())
+            {
+                JUTILS_LOG(warning, JSTR("GPU profiling is not supported by {} render API"), getRenderEngine()->getRenderAPI());
+                return false;
+            }
+            if (m_GPUTimestampsSlots.isEmpty())
+            {
+                // Slot is reused only after the frame which used it is finished on GPU, extra slots give GPU time to finish it
+                m_GPUTimestampsSlots.resize(getRenderEngine()->getFramesInFlightCount() + 2);
             }
+        }
+        m_GPUProfilingEnabled = enabled;
+        return true;
+    }
 
-            onFinishRender(renderOptions);
+    void RenderPipeline::startGPUTimestamps(RenderOptions* renderOptions)
+    {
+        m_GPUTimestampsActive = false;
+        if (m_GPUTimestampsSlots.isEmpty())
+        {
+            return;
+        }
+
+        resolveGPUTimestamps();
+        if (!m_GPUProfilingEnabled)
+        {
+            return;
+        }
+
+        m_GPUTimestampsSlotIndex = (m_GPUTimestampsSlotIndex + 1) % m_GPUTimestampsSlots.getSize();
+        GPUTimestampsSlot& slot = m_GPUTimestampsSlots[m_GPUTimestampsSlotIndex];
+        // Not resolved timings of the slot are dropped, waiting for them would stall the frame
+        slot.pending = false;
+        slot.frameIndex = getRenderEngine()->getRenderedFramesCount();
+        slot.timings.clear();
+        slot.queueEntryTimingIndices.clear();
+
+        const RenderEngine* renderEngine = getRenderEngine();
+        for (const auto& queueEntry : m_RenderTargetsQueue)
+        {
+            const RenderTarget* renderTarget = renderEngine->getRenderTarget(queueEntry.renderTargetID);
+            const int32 stagesCount = renderTarget != nullptr ? renderTarget->getRenderStagesCount() : 0;
+            slot.queueEntryTimingIndices.add(slot.timings.getSize());
+            slot.timings.add({ queueEntry.renderTargetID, -1 });
+            for (int32 stageIndex = 0; stageIndex < stagesCount; stageIndex++)
+            {
+                slot.timings.add({ queueEntry.renderTargetID, stageIndex });
+            }
         }
+        if (slot.timings.isEmpty())
+        {
+            return;
+        }
+
+        const uint32 timestampsCount = static_cast<uint32>(slot.timings.getSize()) * 2;
+        if (!startGPUTimestamps(renderOptions, m_GPUTimestampsSlotIndex, timestampsCount))
+        {
+            JUTILS_LOG(warning, JSTR("Failed to start GPU timestamps"));
+            return;
+        }
+        slot.pending = true;
+        m_GPUTimestampsActive = true;
+    }
+    void RenderPipeline::resolveGPUTimestamps()
+    {
+        // Check slots from the oldest one, so the latest available timings are kept
+        const int32 slotsCount = m_GPUTimestampsSlots.getSize();
+        for (int32 offset = 1; offset <= slotsCount; offset++)
+        {
+            const int32 slotIndex = (m_GPUTimestampsSlotIndex + offset) % slotsCount;
+            GPUTimestampsSlot& slot = m_GPUTimestampsSlots[slotIndex];
+            if (!slot.pending)
+            {
+                continue;
+            }
+
+            const uint32 timestampsCount = static_cast<uint32>(slot.timings.getSize()) * 2;
+            if (!readGPUTimestamps(slotIndex, timestampsCount, m_GPUTimestampsTemp) || (m_GPUTimestampsTemp.getSize() < static_cast<int32>(timestampsCount)))
+            {
+                continue;
+            }
+            slot.pending = false;
+
+            for (int32 index = 0; index < slot.timings.getSize(); index++)
+            {
+                const uint64 startTime = m_GPUTimestampsTemp[index * 2];
+                const uint64 finishTime = m_GPUTimestampsTemp[index * 2 + 1];
+                slot.timings[index].time = finishTime > startTime ? static_cast<float>(static_cast<double>(finishTime - startTime) / 1000000.0) : 0.0f;
+            }
+            if ((m_GPUFrameTimings.timings.isEmpty()) || (slot.frameIndex >= m_GPUFrameTimings.frameIndex))
+            {
+                m_GPUFrameTimings.frameIndex = slot.frameIndex;
+                m_GPUFrameTimings.timings = slot.timings;
+            }
+        }
+    }
+
+    int32 RenderPipeline::getQueueEntryGPUTimingIndex(const int32 queueEntryIndex) const
+    {
+        if (!m_GPUTimestampsActive)
+        {
+            return -1;
+        }
+        const jarray<int32>& timingIndices = m_GPUTimestampsSlots[m_GPUTimestampsSlotIndex].queueEntryTimingIndices;
+        return timingIndices.isValidIndex(queueEntryIndex) ? timingIndices[queueEntryIndex] : -1;
+    }
+    void RenderPipeline::writeRenderTargetGPUTimestamp(const RenderOptions* renderOptions, const bool finished) const
+    {
+        if (m_GPUTimestampsActive && (renderOptions->gpuTimingIndex >= 0))
+        {
+            writeGPUTimestamp(renderOptions, m_GPUTimestampsSlotIndex, static_cast<uint32>(renderOptions->gpuTimingIndex * 2 + (finished ? 1 : 0)));
+        }
+    }
+    void RenderPipeline::writeRenderStageGPUTimestamp(const RenderOptions* renderOptions, const int32 renderStageIndex, const bool finished) const
+    {
+        if (m_GPUTimestampsActive && (renderOptions->gpuTimingIndex >= 0))
+        {
+            const int32 timingIndex = renderOptions->gpuTimingIndex + 1 + renderStageIndex;
+            writeGPUTimestamp(renderOptions, m_GPUTimestampsSlotIndex, static_cast<uint32>(timingIndex * 2 + (finished ? 1 : 0)));
+        }
+    }
+
+    FrameArena& RenderPipeline::getFrameArena() const
+    {
+        return getRenderEngine()->getFrameArena();
+    }
+    void RenderPipeline::finishFramePhase(const RenderFramePhase phase) const
+    {
+        getRenderEngine()->finishFramePhase(phase);
     }
 
     bool RenderPipeline::onStartRender(RenderOptions* renderOptions)
@@ -237,4 +505,27 @@ namespace JumaRenderEngine
     {
         getRenderEngine()->getWindowController()->onFinishRender();
     }
+
+    bool RenderPipeline::onStartRecordRenderTarget(RenderOptions* renderOptions, RenderOptions* recordRenderOptions, RenderTarget* renderTarget)
+    {
+        return renderTarget->update();
+    }
+    void RenderPipeline::recordRenderTarget(RenderOptions* recordRenderOptions, RenderTarget* renderTarget)
+    {
+        renderTarget->sortPrimitivesLists();
+        renderPrimitives(recordRenderOptions, renderTarget);
+    }
+    bool RenderPipeline::onFinishRecordRenderTarget(RenderOptions* renderOptions, RenderOptions* recordRenderOptions, RenderTarget* renderTarget)
+    {
+        renderOptions->gpuTimingIndex = recordRenderOptions->gpuTimingIndex;
+        writeRenderTargetGPUTimestamp(renderOptions, false);
+        if (!onStartRenderToRenderTarget(renderOptions, renderTarget))
+        {
+            return false;
+        }
+        submitRecordedRenderTarget(renderOptions, recordRenderOptions, renderTarget);
+        onFinishRenderToRenderTarget(renderOptions, renderTarget);
+        writeRenderTargetGPUTimestamp(renderOptions, true);
+        return true;
+    }
 }
@@ -0,0 +1,124 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#include "JumaRE/RenderPrimitivesList.h"
+
+#include <bit>
+
+#include "JumaRE/material/Material.h"
+#include "JumaRE/material/Shader.h"
+#include "JumaRE/vertex/VertexBuffer.h"
+
+namespace JumaRenderEngine
+{
+    const void* GetRenderPrimitiveConstants(const RenderPrimitive& primitive)
+    {
+        static constexpr uint8 emptyConstants[ShaderPrimitiveConstantsMaxSize] = {};
+        return primitive.constants != nullptr ? primitive.constants : emptyConstants;
+    }
+
+    uint64 MakeRenderPrimitiveSortKey(const RenderPrimitive& primitive, const RenderStageSortMode sortMode)
+    {
+        if (sortMode == RenderStageSortMode::None)
+        {
+            return 0;
+        }
+
+        const Material* material = primitive.material;
+        const MaterialProperties& properties = material->getMaterialProperties();
+        // Asset indices are recycled, so truncated values alias only with a lot of existing assets
+        const uint64 shaderIndex = material->getShader()->getAssetIndex();
+        const uint64 propertiesBits = (properties.depthEnabled ? 1 : 0) | (properties.stencilEnabled ? 2 : 0) 
+            | (properties.wireframe ? 4 : 0) | (properties.cullBackFaces ? 8 : 0) | (properties.blendEnabled ? 16 : 0);
+        const uint64 materialIndex = material->getAssetIndex();
+        const uint64 vertexID = primitive.vertexBuffer->getVertexID();
+        const uint64 vertexBufferIndex = primitive.vertexBuffer->getAssetIndex();
+        if (sortMode == RenderStageSortMode::State)
+        {
+            // | shader 16 | properties 5 | material 16 | vertex 11 | vertex buffer 16 |
+            return ((shaderIndex & 0xFFFF) << 48) | (propertiesBits << 43) | ((materialIndex & 0xFFFF) << 27) 
+                | ((vertexID & 0x7FF) << 16) | (vertexBufferIndex & 0xFFFF);
+        }
+
+        // Flip float bits to get the same order for unsigned integers
+        uint32 depthBits = std::bit_cast<uint32>(primitive.sortDepth);
+        depthBits = (depthBits & 0x80000000) != 0 ? ~depthBits : (depthBits | 0x80000000);
+        if (sortMode == RenderStageSortMode::BackToFront)
+        {
+            depthBits = ~depthBits;
+        }
+        // | depth 32 | shader 10 | properties 5 | material 10 | vertex 7 |
+        return (static_cast<uint64>(depthBits) << 32) | ((shaderIndex & 0x3FF) << 22) | (propertiesBits << 17) 
+            | ((materialIndex & 0x3FF) << 7) | (vertexID & 0x7F);
+    }
+
+    void SortRenderPrimitives(jarray<RenderPrimitive>& primitives, jarray<RenderPrimitive>& tempBuffer)
+    {
+        const int32 count = primitives.getSize();
+        if (count < 2)
+        {
+            return;
+        }
+        if (count <= 32)
+        {
+            // Insertion sort is faster for small lists
+            RenderPrimitive* data = primitives.getData();
+            for (int32 index = 1; index < count; index++)
+            {
+                const RenderPrimitive primitive = data[index];
+                int32 insertIndex = index;
+                while ((insertIndex > 0) && (data[insertIndex - 1].sortKey > primitive.sortKey))
+                {
+                    data[insertIndex] = data[insertIndex - 1];
+                    insertIndex--;
+                }
+                data[insertIndex] = primitive;
+            }
+            return;
+        }
+
+        // LSD radix sort, 8 bits per pass
+        uint32 histograms[8][256] = {};
+        for (const auto& primitive : primitives)
+        {
+            for (int32 byteIndex = 0; byteIndex < 8; byteIndex++)
+            {
+                histograms[byteIndex][(primitive.sortKey >> (byteIndex * 8)) & 0xFF]++;
+            }
+        }
+
+        tempBuffer.resize(count);
+        RenderPrimitive* src = primitives.getData();
+        RenderPrimitive* dst = tempBuffer.getData();
+        for (int32 byteIndex = 0; byteIndex < 8; byteIndex++)
+        {
+            const int32 shift = byteIndex * 8;
+            uint32* histogram = histograms[byteIndex];
+            if (histogram[(src[0].sortKey >> shift) & 0xFF] == static_cast<uint32>(count))
+            {
+                // All keys have the same byte
+                continue;
+            }
+
+            uint32 offset = 0;
+            for (int32 index = 0; index < 256; index++)
+            {
+                const uint32 bucketSize = histogram[index];
+                histogram[index] = offset;
+                offset += bucketSize;
+            }
+            for (int32 index = 0; index < count; index++)
+            {
+                dst[histogram[(src[index].sortKey >> shift) & 0xFF]++] = src[index];
+            }
+            std::swap(src, dst);
+        }
+        if (src != primitives.getData())
+        {
+            RenderPrimitive* data = primitives.getData();
+            for (int32 index = 0; index < count; index++)
+            {
+                data[index] = src[index];
+            }
+        }
+    }
+}
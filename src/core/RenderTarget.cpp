@@ -3,6 +3,10 @@
 #include "JumaRE/RenderTarget.h"
 
 #include "JumaRE/RenderEngine.h"
+#include "JumaRE/material/Material.h"
+#include "JumaRE/vertex/VertexBuffer.h"
+
+#include <cstring>
 
 namespace JumaRenderEngine
 {
@@ -63,7 +67,11 @@ namespace JumaRenderEngine
 
     void RenderTarget::clearData()
     {
+        failReadbacks();
+
         m_RenderStages.clear();
+        m_SortBuffer.clear();
+        m_PrimitivesListsSorted = true;
 
         if (isWindowRenderTarget())
         {
@@ -149,7 +157,41 @@ namespace JumaRenderEngine
         {
 	        m_RenderStages[index].properties = stages[index];
 	        m_RenderStages[index].primitivesList.clear();
+	        m_RenderStages[index].retainedPrimitiveIndices.clear();
+	        m_RenderStages[index].freeRetainedPrimitiveIDs.clear();
+	        m_RenderStages[index].removedRetainedPrimitivesCount = 0;
+	        m_RenderStages[index].primitivesListSorted = true;
+        }
+        m_PrimitivesListsSorted = true;
+    }
+    bool RenderTarget::isPrimitiveValid(const RenderPrimitive& primitive) const
+    {
+        if ((primitive.vertexBuffer == nullptr) || (primitive.material == nullptr) || (primitive.instanceCount == 0))
+        {
+            JUTILS_LOG(warning, JSTR("Invalid primitive"));
+            return false;
+        }
+        const RegisteredVertexDescription* vertexDescription = getRenderEngine()->findVertex(primitive.vertexBuffer->getVertexID());
+        if ((vertexDescription == nullptr) || (vertexDescription->inputRate == VertexComponentInputRate::Instance))
+        {
+            JUTILS_LOG(warning, JSTR("Vertex buffer shouldn't contain per-instance vertex components"));
+            return false;
         }
+        if (primitive.instanceBuffer != nullptr)
+        {
+            const RegisteredVertexDescription* instanceDescription = getRenderEngine()->findVertex(primitive.instanceBuffer->getVertexID());
+            if ((instanceDescription == nullptr) || (instanceDescription->inputRate != VertexComponentInputRate::Instance))
+            {
+                JUTILS_LOG(warning, JSTR("Instance buffer should contain only per-instance vertex components"));
+                return false;
+            }
+            if (primitive.instanceCount > primitive.instanceBuffer->getVertexCount())
+            {
+                JUTILS_LOG(warning, JSTR("Instance buffer is too small for {} instances"), primitive.instanceCount);
+                return false;
+            }
+        }
+        return true;
     }
     bool RenderTarget::addPrimitiveToRenderStage(const int32 renderStageIndex, const RenderPrimitive& primitive)
     {
@@ -158,19 +200,252 @@ namespace JumaRenderEngine
 	        JUTILS_LOG(warning, JSTR("Invalid render stage index {}"), renderStageIndex);
             return false;
         }
-        if ((primitive.vertexBuffer == nullptr) || (primitive.material == nullptr))
+        RenderStage& renderStage = m_RenderStages[renderStageIndex];
+        if (renderStage.properties.retained)
+        {
+	        JUTILS_LOG(warning, JSTR("Render stage {} is retained, use addRetainedPrimitive()"), renderStageIndex);
+            return false;
+        }
+        if (!isPrimitiveValid(primitive))
         {
-            JUTILS_LOG(warning, JSTR("Invalid primitive"));
             return false;
         }
-        m_RenderStages[renderStageIndex].primitivesList.add(primitive);
+
+        if (renderStage.properties.sortMode == RenderStageSortMode::None)
+        {
+            renderStage.primitivesList.add(primitive);
+        }
+        else
+        {
+            RenderPrimitive sortedPrimitive = primitive;
+            sortedPrimitive.sortKey = MakeRenderPrimitiveSortKey(primitive, renderStage.properties.sortMode);
+            renderStage.primitivesList.add(sortedPrimitive);
+            renderStage.primitivesListSorted = false;
+            m_PrimitivesListsSorted = false;
+        }
         return true;
     }
     void RenderTarget::clearPrimitivesList()
     {
+        m_PrimitivesListsSorted = true;
+        for (auto& stage : m_RenderStages)
+        {
+            if (!stage.properties.retained)
+            {
+	            stage.primitivesList.clear();
+                stage.primitivesListSorted = true;
+            }
+            m_PrimitivesListsSorted &= stage.primitivesListSorted && (stage.removedRetainedPrimitivesCount == 0);
+        }
+    }
+    void RenderTarget::sortPrimitivesLists()
+    {
+        if (m_PrimitivesListsSorted)
+        {
+            return;
+        }
         for (auto& stage : m_RenderStages)
         {
-	        stage.primitivesList.clear();
+            if (stage.removedRetainedPrimitivesCount > 0)
+            {
+                compactRetainedPrimitives(stage);
+            }
+            if (stage.primitivesListSorted)
+            {
+                continue;
+            }
+
+            if (stage.properties.retained)
+            {
+                // Retained keys could be outdated if material or vertex buffer was changed since adding
+                for (auto& primitive : stage.primitivesList)
+                {
+                    primitive.sortKey = MakeRenderPrimitiveSortKey(primitive, stage.properties.sortMode);
+                }
+            }
+            SortRenderPrimitives(stage.primitivesList, m_SortBuffer);
+            if (stage.properties.retained)
+            {
+                for (int32 index = 0; index < stage.primitivesList.getSize(); index++)
+                {
+                    stage.retainedPrimitiveIndices[GetRenderPrimitiveSlot(stage.primitivesList[index].primitiveID)] = index;
+                }
+            }
+            stage.primitivesListSorted = true;
+        }
+        m_PrimitivesListsSorted = true;
+    }
+
+    RenderStage* RenderTarget::findRetainedRenderStage(const int32 renderStageIndex)
+    {
+        if (!m_RenderStages.isValidIndex(renderStageIndex))
+        {
+	        JUTILS_LOG(warning, JSTR("Invalid render stage index {}"), renderStageIndex);
+            return nullptr;
+        }
+        RenderStage& renderStage = m_RenderStages[renderStageIndex];
+        if (!renderStage.properties.retained)
+        {
+	        JUTILS_LOG(warning, JSTR("Render stage {} is not retained"), renderStageIndex);
+            return nullptr;
+        }
+        return &renderStage;
+    }
+    int32* RenderTarget::findRetainedPrimitiveIndex(RenderStage& renderStage, const render_primitive_id primitiveID) const
+    {
+        // Primitive in the slot should have the same generation
+        const int32 slot = GetRenderPrimitiveSlot(primitiveID);
+        const int32 index = (primitiveID != render_primitive_id_INVALID) && renderStage.retainedPrimitiveIndices.isValidIndex(slot) 
+            ? renderStage.retainedPrimitiveIndices[slot] : -1;
+        if ((index < 0) || (renderStage.primitivesList[index].primitiveID != primitiveID))
+        {
+	        JUTILS_LOG(warning, JSTR("Invalid render primitive {}"), primitiveID);
+            return nullptr;
+        }
+        return &renderStage.retainedPrimitiveIndices[slot];
+    }
+    render_primitive_id RenderTarget::addRetainedPrimitive(const int32 renderStageIndex, const RenderPrimitive& primitive)
+    {
+        RenderStage* renderStage = findRetainedRenderStage(renderStageIndex);
+        if ((renderStage == nullptr) || !isPrimitiveValid(primitive))
+        {
+            return render_primitive_id_INVALID;
+        }
+
+        render_primitive_id primitiveID;
+        if (!renderStage->freeRetainedPrimitiveIDs.isEmpty())
+        {
+            primitiveID = renderStage->freeRetainedPrimitiveIDs.getLast();
+            renderStage->freeRetainedPrimitiveIDs.removeLast();
+        }
+        else if (renderStage->retainedPrimitiveIndices.getSize() < render_primitive_id_MAX_SLOTS)
+        {
+            primitiveID = static_cast<render_primitive_id>(renderStage->retainedPrimitiveIndices.getSize());
+            renderStage->retainedPrimitiveIndices.add(-1);
+        }
+        else
+        {
+	        JUTILS_LOG(warning, JSTR("Too many primitives in render stage {}"), renderStageIndex);
+            return render_primitive_id_INVALID;
+        }
+
+        RenderPrimitive retainedPrimitive = primitive;
+        retainedPrimitive.sortKey = MakeRenderPrimitiveSortKey(primitive, renderStage->properties.sortMode);
+        retainedPrimitive.primitiveID = primitiveID;
+        renderStage->retainedPrimitiveIndices[GetRenderPrimitiveSlot(primitiveID)] = renderStage->primitivesList.getSize();
+        renderStage->primitivesList.add(retainedPrimitive);
+        if (renderStage->properties.sortMode != RenderStageSortMode::None)
+        {
+            renderStage->primitivesListSorted = false;
+            m_PrimitivesListsSorted = false;
+        }
+        return primitiveID;
+    }
+    bool RenderTarget::updateRetainedPrimitive(const int32 renderStageIndex, const render_primitive_id primitiveID, const RenderPrimitive& primitive)
+    {
+        RenderStage* renderStage = findRetainedRenderStage(renderStageIndex);
+        const int32* primitiveIndex = renderStage != nullptr ? findRetainedPrimitiveIndex(*renderStage, primitiveID) : nullptr;
+        if ((primitiveIndex == nullptr) || !isPrimitiveValid(primitive))
+        {
+            return false;
+        }
+
+        RenderPrimitive& retainedPrimitive = renderStage->primitivesList[*primitiveIndex];
+        const uint64 prevSortKey = retainedPrimitive.sortKey;
+        retainedPrimitive = primitive;
+        retainedPrimitive.sortKey = MakeRenderPrimitiveSortKey(primitive, renderStage->properties.sortMode);
+        retainedPrimitive.primitiveID = primitiveID;
+        if (retainedPrimitive.sortKey != prevSortKey)
+        {
+            renderStage->primitivesListSorted = false;
+            m_PrimitivesListsSorted = false;
+        }
+        return true;
+    }
+    bool RenderTarget::removeRetainedPrimitive(const int32 renderStageIndex, const render_primitive_id primitiveID)
+    {
+        RenderStage* renderStage = findRetainedRenderStage(renderStageIndex);
+        const int32* primitiveIndexPtr = renderStage != nullptr ? findRetainedPrimitiveIndex(*renderStage, primitiveID) : nullptr;
+        if (primitiveIndexPtr == nullptr)
+        {
+            return false;
+        }
+
+        const int32 primitiveIndex = *primitiveIndexPtr;
+        freeRetainedPrimitive(*renderStage, renderStage->primitivesList[primitiveIndex]);
+        if (renderStage->properties.sortMode == RenderStageSortMode::None)
+        {
+            // Unsorted stages are submitted in adding order, so primitive is removed from list while compacting before render
+            renderStage->removedRetainedPrimitivesCount++;
+            m_PrimitivesListsSorted = false;
+            return true;
+        }
+
+        // Move last primitive into the free slot, stage will be resorted
+        const int32 lastIndex = renderStage->primitivesList.getSize() - 1;
+        if (primitiveIndex != lastIndex)
+        {
+            const RenderPrimitive& lastPrimitive = renderStage->primitivesList[lastIndex];
+            renderStage->retainedPrimitiveIndices[GetRenderPrimitiveSlot(lastPrimitive.primitiveID)] = primitiveIndex;
+            renderStage->primitivesList[primitiveIndex] = lastPrimitive;
+            renderStage->primitivesListSorted = false;
+            m_PrimitivesListsSorted = false;
+        }
+        renderStage->primitivesList.removeLast();
+        return true;
+    }
+    void RenderTarget::freeRetainedPrimitive(RenderStage& renderStage, RenderPrimitive& primitive)
+    {
+        renderStage.retainedPrimitiveIndices[GetRenderPrimitiveSlot(primitive.primitiveID)] = -1;
+        renderStage.freeRetainedPrimitiveIDs.add(GetNextRenderPrimitiveGeneration(primitive.primitiveID));
+        // Render pipelines skip primitives without material, so removed primitive is not rendered before compacting
+        primitive.primitiveID = render_primitive_id_INVALID;
+        primitive.material = nullptr;
+    }
+    void RenderTarget::compactRetainedPrimitives(RenderStage& renderStage)
+    {
+        // Order preserving, so sorted state is not changed
+        int32 writeIndex = 0;
+        for (int32 index = 0; index < renderStage.primitivesList.getSize(); index++)
+        {
+            const RenderPrimitive& primitive = renderStage.primitivesList[index];
+            if (primitive.primitiveID == render_primitive_id_INVALID)
+            {
+                continue;
+            }
+            if (writeIndex != index)
+            {
+                renderStage.retainedPrimitiveIndices[GetRenderPrimitiveSlot(primitive.primitiveID)] = writeIndex;
+                renderStage.primitivesList[writeIndex] = primitive;
+            }
+            writeIndex++;
+        }
+        renderStage.primitivesList.resize(writeIndex);
+        renderStage.removedRetainedPrimitivesCount = 0;
+    }
+    void RenderTarget::removeRetainedPrimitivesWithAssets(const jset<const RenderEngineAsset*>& assets)
+    {
+        for (auto& renderStage : m_RenderStages)
+        {
+            if (!renderStage.properties.retained)
+            {
+                continue;
+            }
+
+            int32 removedCount = 0;
+            for (auto& primitive : renderStage.primitivesList)
+            {
+                if ((primitive.primitiveID != render_primitive_id_INVALID) && (assets.contains(primitive.material) 
+                    || assets.contains(primitive.vertexBuffer) || ((primitive.instanceBuffer != nullptr) && assets.contains(primitive.instanceBuffer))))
+                {
+                    freeRetainedPrimitive(renderStage, primitive);
+                    removedCount++;
+                }
+            }
+            if ((removedCount > 0) || (renderStage.removedRetainedPrimitivesCount > 0))
+            {
+                compactRetainedPrimitives(renderStage);
+            }
         }
     }
 
@@ -192,5 +467,183 @@ namespace JumaRenderEngine
         {
             getRenderEngine()->getWindowController()->onFinishWindowRender(getWindowID());
         }
+        finishReadbacks();
+        startReadbacks(renderOptions);
+    }
+
+    bool RenderTarget::requestReadback(const RenderTargetReadbackCallback& callback, const RenderTargetReadbackFormat format, 
+        const RenderTargetReadbackRegion& region)
+    {
+        if (!callback)
+        {
+            JUTILS_LOG(error, JSTR("Invalid readback callback"));
+            return false;
+        }
+        if (isWindowRenderTarget() || !isReadbackSupported())
+        {
+            JUTILS_LOG(warning, JSTR("Readback is not supported by render target {}"), m_RenderTargetID);
+            return false;
+        }
+        m_ReadbackRequests.add({ callback, format, region });
+        return true;
+    }
+    void RenderTarget::startReadbacks(RenderOptions* renderOptions)
+    {
+        if (m_ReadbackRequests.isEmpty())
+        {
+            return;
+        }
+
+        // Callbacks could request new readbacks
+        jarray<ReadbackRequest> requests;
+        std::swap(requests, m_ReadbackRequests);
+        const uint64 frameIndex = getRenderEngine()->getRenderedFramesCount();
+        const math::uvector2 size = getSize();
+        for (auto& request : requests)
+        {
+            RenderTargetReadbackRegion& region = request.region;
+            if ((region.size.x == 0) || (region.size.y == 0))
+            {
+                region = { { 0, 0 }, size };
+            }
+            if (((region.offset.x + region.size.x) > size.x) || ((region.offset.y + region.size.y) > size.y))
+            {
+                JUTILS_LOG(warning, JSTR("Invalid readback region of render target {}"), m_RenderTargetID);
+                finishReadback(request, nullptr, 0);
+                continue;
+            }
+
+            int32 bufferIndex;
+            if (!m_FreeReadbackBuffers.isEmpty())
+            {
+                bufferIndex = m_FreeReadbackBuffers.getLast();
+                m_FreeReadbackBuffers.removeLast();
+            }
+            else
+            {
+                bufferIndex = m_ReadbackBuffersCount++;
+            }
+            if (!copyToReadbackBuffer(renderOptions, bufferIndex, region.offset, region.size))
+            {
+                JUTILS_LOG(warning, JSTR("Failed to copy pixels of render target {} for readback"), m_RenderTargetID);
+                m_FreeReadbackBuffers.add(bufferIndex);
+                finishReadback(request, nullptr, 0);
+                continue;
+            }
+            request.frameIndex = frameIndex;
+            request.bufferIndex = bufferIndex;
+            m_ReadbacksInFlight.add(std::move(request));
+        }
+    }
+    void RenderTarget::finishReadbacks()
+    {
+        if (m_ReadbacksInFlight.isEmpty())
+        {
+            return;
+        }
+
+        // Frame resources are reused only after GPU finished the frame, so older readbacks are finished too
+        const RenderEngine* renderEngine = getRenderEngine();
+        const uint64 frameIndex = renderEngine->getRenderedFramesCount();
+        const uint64 framesInFlightCount = static_cast<uint64>(renderEngine->getFramesInFlightCount());
+        int32 finishedCount = 0;
+        for (const auto& readback : m_ReadbacksInFlight)
+        {
+            if (frameIndex < (readback.frameIndex + framesInFlightCount))
+            {
+                break;
+            }
+            const uint8* data = nullptr;
+            int32 rowPitch = 0;
+            if (!mapReadbackBuffer(readback.bufferIndex, data, rowPitch))
+            {
+                break;
+            }
+            finishReadback(readback, data, rowPitch);
+            if (data != nullptr)
+            {
+                unmapReadbackBuffer(readback.bufferIndex);
+            }
+            m_FreeReadbackBuffers.add(readback.bufferIndex);
+            finishedCount++;
+        }
+        if (finishedCount > 0)
+        {
+            const int32 readbacksCount = m_ReadbacksInFlight.getSize();
+            for (int32 index = finishedCount; index < readbacksCount; index++)
+            {
+                m_ReadbacksInFlight[index - finishedCount] = std::move(m_ReadbacksInFlight[index]);
+            }
+            m_ReadbacksInFlight.resize(readbacksCount - finishedCount);
+        }
+    }
+    void RenderTarget::finishReadback(const ReadbackRequest& readback, const uint8* data, const int32 rowPitch)
+    {
+        RenderTargetReadbackData readbackData;
+        readbackData.renderTargetID = m_RenderTargetID;
+        readbackData.frameIndex = readback.frameIndex;
+        readbackData.format = readback.format;
+        readbackData.size = readback.region.size;
+        readbackData.rowPitch = readbackData.size.x * GetRenderTargetReadbackFormatSize(readback.format);
+        if (data != nullptr)
+        {
+            if ((readback.format == RenderTargetReadbackFormat::RGBA8) && (rowPitch == static_cast<int32>(readbackData.rowPitch)))
+            {
+                readbackData.pixels = data;
+            }
+            else
+            {
+                m_ReadbackPixels.resize(static_cast<int32>(readbackData.rowPitch * readbackData.size.y));
+                for (uint32 y = 0; y < readbackData.size.y; y++)
+                {
+                    const uint8* srcRow = data + static_cast<int64>(y) * rowPitch;
+                    uint8* dstRow = m_ReadbackPixels.getData() + y * readbackData.rowPitch;
+                    switch (readback.format)
+                    {
+                    case RenderTargetReadbackFormat::RGBA8:
+                        std::memcpy(dstRow, srcRow, readbackData.rowPitch);
+                        break;
+                    case RenderTargetReadbackFormat::BGRA8:
+                        for (uint32 x = 0; x < readbackData.size.x; x++)
+                        {
+                            const uint8* srcPixel = srcRow + x * 4;
+                            uint8* dstPixel = dstRow + x * 4;
+                            dstPixel[0] = srcPixel[2];
+                            dstPixel[1] = srcPixel[1];
+                            dstPixel[2] = srcPixel[0];
+                            dstPixel[3] = srcPixel[3];
+                        }
+                        break;
+                    case RenderTargetReadbackFormat::RGB8:
+                        for (uint32 x = 0; x < readbackData.size.x; x++)
+                        {
+                            std::memcpy(dstRow + x * 3, srcRow + x * 4, 3);
+                        }
+                        break;
+                    default: ;
+                    }
+                }
+                readbackData.pixels = m_ReadbackPixels.getData();
+            }
+        }
+        readback.callback(readbackData);
+    }
+    void RenderTarget::failReadbacks()
+    {
+        jarray<ReadbackRequest> readbacks;
+        std::swap(readbacks, m_ReadbacksInFlight);
+        for (const auto& readback : readbacks)
+        {
+            finishReadback(readback, nullptr, 0);
+        }
+        readbacks.clear();
+        std::swap(readbacks, m_ReadbackRequests);
+        for (const auto& request : readbacks)
+        {
+            finishReadback(request, nullptr, 0);
+        }
+        m_FreeReadbackBuffers.clear();
+        m_ReadbackBuffersCount = 0;
+        m_ReadbackPixels.clear();
     }
 }
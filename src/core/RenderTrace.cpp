@@ -0,0 +1,196 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#include "JumaRE/RenderTrace.h"
+
+#ifdef JUMARE_ENABLE_TRACE
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+
+namespace JumaRenderEngine
+{
+    struct RenderTraceEvent
+    {
+        const char* name = nullptr;
+        const char* category = nullptr;
+        uint64 startTime = 0;
+        uint64 duration = 0;
+    };
+    constexpr int32 RenderTraceBlockSize = 4096;
+    struct RenderTraceBlock
+    {
+        RenderTraceEvent events[RenderTraceBlockSize];
+        // Written only by owner thread, published with release
+        std::atomic<int32> count = 0;
+        std::atomic<RenderTraceBlock*> nextBlock = nullptr;
+    };
+    struct RenderTraceThreadBuffer
+    {
+        int32 threadIndex = 0;
+        std::atomic<const char*> threadName = nullptr;
+        RenderTraceBlock firstBlock;
+        // Used only by owner thread and ClearRenderTrace
+        RenderTraceBlock* writeBlock = &firstBlock;
+    };
+
+    static const std::chrono::steady_clock::time_point RenderTraceStartTime = std::chrono::steady_clock::now();
+    static std::atomic<bool> RenderTraceActive = false;
+    // Buffers are kept until process exit, so events of finished threads are still exported
+    static std::mutex RenderTraceThreadsMutex;
+    static jarray<RenderTraceThreadBuffer*> RenderTraceThreads;
+    static thread_local RenderTraceThreadBuffer* RenderTraceCurrentThread = nullptr;
+
+    static uint64 GetRenderTraceTime()
+    {
+        // +1 so 0 stays invalid time
+        return static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - RenderTraceStartTime
+        ).count()) + 1;
+    }
+    static RenderTraceThreadBuffer* GetRenderTraceThreadBuffer()
+    {
+        if (RenderTraceCurrentThread == nullptr)
+        {
+            RenderTraceThreadBuffer* buffer = new RenderTraceThreadBuffer();
+            std::lock_guard lock(RenderTraceThreadsMutex);
+            buffer->threadIndex = RenderTraceThreads.getSize() + 1;
+            RenderTraceThreads.add(buffer);
+            RenderTraceCurrentThread = buffer;
+        }
+        return RenderTraceCurrentThread;
+    }
+    static void AddRenderTraceEvent(const RenderTraceEvent& event)
+    {
+        RenderTraceThreadBuffer* buffer = GetRenderTraceThreadBuffer();
+        RenderTraceBlock* block = buffer->writeBlock;
+        int32 eventIndex = block->count.load(std::memory_order_relaxed);
+        if (eventIndex >= RenderTraceBlockSize)
+        {
+            // Blocks are reused after clear
+            RenderTraceBlock* nextBlock = block->nextBlock.load(std::memory_order_acquire);
+            if (nextBlock == nullptr)
+            {
+                nextBlock = new RenderTraceBlock();
+                block->nextBlock.store(nextBlock, std::memory_order_release);
+            }
+            buffer->writeBlock = block = nextBlock;
+            eventIndex = 0;
+        }
+        block->events[eventIndex] = event;
+        block->count.store(eventIndex + 1, std::memory_order_release);
+    }
+
+    RenderTraceScope::RenderTraceScope(const char* name, const char* category)
+        : m_Name(name), m_Category(category)
+    {
+        if (RenderTraceActive.load(std::memory_order_relaxed))
+        {
+            m_StartTime = GetRenderTraceTime();
+        }
+    }
+    RenderTraceScope::~RenderTraceScope()
+    {
+        if ((m_StartTime != 0) && RenderTraceActive.load(std::memory_order_relaxed))
+        {
+            AddRenderTraceEvent({ m_Name, m_Category, m_StartTime, GetRenderTraceTime() - m_StartTime });
+        }
+    }
+
+    void StartRenderTrace()
+    {
+        GetRenderTraceThreadBuffer();
+        RenderTraceActive.store(true, std::memory_order_relaxed);
+    }
+    void StopRenderTrace()
+    {
+        RenderTraceActive.store(false, std::memory_order_relaxed);
+    }
+    bool IsRenderTraceActive()
+    {
+        return RenderTraceActive.load(std::memory_order_relaxed);
+    }
+    void ClearRenderTrace()
+    {
+        std::lock_guard lock(RenderTraceThreadsMutex);
+        for (const auto& buffer : RenderTraceThreads)
+        {
+            for (RenderTraceBlock* block = &buffer->firstBlock; block != nullptr; block = block->nextBlock.load(std::memory_order_acquire))
+            {
+                block->count.store(0, std::memory_order_release);
+            }
+            buffer->writeBlock = &buffer->firstBlock;
+        }
+    }
+
+    bool ExportRenderTrace(const jstring& fileName)
+    {
+        std::ofstream file(*fileName);
+        if (!file.is_open())
+        {
+            JUTILS_LOG(error, JSTR("Failed to open file {}"), fileName);
+            return false;
+        }
+
+        // Default precision would round timestamps of long sessions
+        file << std::fixed << std::setprecision(3);
+        file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+        bool firstEvent = true;
+        std::lock_guard lock(RenderTraceThreadsMutex);
+        for (const auto& buffer : RenderTraceThreads)
+        {
+            const char* threadName = buffer->threadName.load(std::memory_order_acquire);
+            if (threadName != nullptr)
+            {
+                file << (firstEvent ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->threadIndex
+                    << ",\"args\":{\"name\":\"" << threadName << "\"}}";
+                firstEvent = false;
+            }
+            for (const RenderTraceBlock* block = &buffer->firstBlock; block != nullptr; block = block->nextBlock.load(std::memory_order_acquire))
+            {
+                const int32 eventsCount = block->count.load(std::memory_order_acquire);
+                for (int32 eventIndex = 0; eventIndex < eventsCount; eventIndex++)
+                {
+                    // Chrome trace timestamps are in microseconds
+                    const RenderTraceEvent& event = block->events[eventIndex];
+                    file << (firstEvent ? "\n" : ",\n") << "{\"name\":\"" << event.name << "\",\"cat\":\"" << event.category 
+                        << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->threadIndex
+                        << ",\"ts\":" << static_cast<double>(event.startTime) / 1000.0 << ",\"dur\":" << static_cast<double>(event.duration) / 1000.0 << "}";
+                    firstEvent = false;
+                }
+            }
+        }
+        file << "\n]}\n";
+        if (!file.good())
+        {
+            JUTILS_LOG(error, JSTR("Failed to write render trace to file {}"), fileName);
+            return false;
+        }
+        return true;
+    }
+
+    void SetRenderTraceThreadName(const char* name)
+    {
+        GetRenderTraceThreadBuffer()->threadName.store(name, std::memory_order_release);
+    }
+}
+
+#else
+
+namespace JumaRenderEngine
+{
+    void StartRenderTrace() {}
+    void StopRenderTrace() {}
+    bool IsRenderTraceActive() { return false; }
+    void ClearRenderTrace() {}
+    bool ExportRenderTrace(const jstring& fileName)
+    {
+        JUTILS_LOG(warning, JSTR("Render trace is disabled, build engine with JUMARE_ENABLE_TRACE"));
+        return false;
+    }
+    void SetRenderTraceThreadName(const char* name) {}
+}
+
+#endif
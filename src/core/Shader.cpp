@@ -2,6 +2,8 @@
 
 #include "JumaRE/material/Shader.h"
 
+#include "JumaRE/RenderEngine.h"
+#include "JumaRE/RenderTrace.h"
 #include "JumaRE/material/ShaderUniformInfo.h"
 
 namespace JumaRenderEngine
@@ -13,11 +15,23 @@ namespace JumaRenderEngine
 
     bool Shader::init(const ShaderCreateInfo& createInfo)
     {
+        JUMARE_TRACE_SCOPE("Shader::init", "asset");
         m_VertexComponents = createInfo.vertexComponents;
 
         m_ShaderUniforms = createInfo.uniforms;
         for (const auto& uniform : m_ShaderUniforms.values())
         {
+            if (uniform.type == ShaderUniformType::BindlessTexture)
+            {
+                if (!getRenderEngine()->isBindlessTexturesSupported())
+                {
+                    JUTILS_LOG(error, JSTR("Bindless textures are not supported by render API"));
+                    clearData();
+                    return false;
+                }
+                m_BindlessTexturesUsed = true;
+            }
+
             const uint32 size = GetShaderUniformValueSize(uniform.type);
             if (size == 0)
             {
@@ -28,6 +42,26 @@ namespace JumaRenderEngine
             uniformBuffer.size = math::max(uniformBuffer.size, uniform.shaderBlockOffset + size);
             uniformBuffer.shaderStages |= uniform.shaderStages;
         }
+        m_MaterialParamsLayout.init(m_ShaderUniforms, m_CachedUniformBufferDescriptions);
+
+        const ShaderPrimitiveConstants& primitiveConstants = createInfo.primitiveConstants;
+        if (primitiveConstants.size > 0)
+        {
+            if ((primitiveConstants.size > ShaderPrimitiveConstantsMaxSize) || ((primitiveConstants.size % 4) != 0) || (primitiveConstants.shaderStages == 0))
+            {
+                JUTILS_LOG(error, JSTR("Invalid primitive constants, size should be a multiple of 4 and not greater than {} bytes"), 
+                    ShaderPrimitiveConstantsMaxSize);
+                clearData();
+                return false;
+            }
+            if (m_CachedUniformBufferDescriptions.contains(primitiveConstants.shaderLocation))
+            {
+                JUTILS_LOG(error, JSTR("Primitive constants location {} is already used by uniform buffer"), primitiveConstants.shaderLocation);
+                clearData();
+                return false;
+            }
+            m_PrimitiveConstants = primitiveConstants;
+        }
 
         if (!initInternal(createInfo.fileNames))
         {
@@ -45,6 +79,9 @@ namespace JumaRenderEngine
     }
     void Shader::clearData()
     {
+        m_MaterialParamsLayout.clear();
+        m_BindlessTexturesUsed = false;
+        m_PrimitiveConstants = ShaderPrimitiveConstants();
         m_CachedUniformBufferDescriptions.clear();
         m_ShaderUniforms.clear();
         m_VertexComponents.clear();
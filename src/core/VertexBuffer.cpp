@@ -14,6 +14,7 @@ namespace JumaRenderEngine
     bool VertexBuffer::init(const vertex_id vertexID, const VertexBufferData& data)
     {
         m_VertexID = vertexID;
+        m_VertexCount = data.vertexCount;
         if (!initInternal(data))
         {
             JUTILS_LOG(error, JSTR("Failed to initialize vertex buffer"));
@@ -31,5 +32,6 @@ namespace JumaRenderEngine
     void VertexBuffer::clearData()
     {
         m_VertexID = vertex_id_NONE;
+        m_VertexCount = 0;
     }
 }
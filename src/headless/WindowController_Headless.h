@@ -0,0 +1,37 @@
+﻿// Copyright © 2023 Leonov Maksim. All Rights Reserved.
+
+#pragma once
+
+#include "JumaRE/window/WindowController.h"
+
+namespace JumaRenderEngine
+{
+    // Window controller without windows, could render only to offscreen render targets
+    template<typename BaseWindowController> requires is_derived_from_class<WindowController, BaseWindowController>
+    class WindowController_Headless : public BaseWindowController
+    {
+        using Super = BaseWindowController;
+
+    public:
+        WindowController_Headless() = default;
+        virtual ~WindowController_Headless() override = default;
+
+        virtual const WindowData* findWindowData(const window_id windowID) const override { return nullptr; }
+
+        virtual bool shouldCloseWindow(const window_id windowID) const override { return false; }
+
+    protected:
+
+        virtual WindowData* createWindowInternal(const window_id windowID, const WindowCreateInfo& createInfo) override
+        {
+            JUTILS_LOG(error, JSTR("Can't create window in headless mode"));
+            return nullptr;
+        }
+        virtual void markWindowShouldClose(WindowData* windowData) override {}
+        virtual void destroyWindowInternal(const window_id windowID, WindowData* windowData) override {}
+
+        virtual WindowData* getWindowData(const window_id windowID) override { return nullptr; }
+
+        virtual bool setMainWindowModeInternal(const WindowMode windowMode) override { return false; }
+    };
+}